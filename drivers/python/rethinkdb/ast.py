@@ -797,14 +797,14 @@ class DB(RqlTopLevelQuery):
     def table_list(self):
         return TableList(self)
 
-    def table_create(self, table_name, primary_key=(), datacenter=(), cache_size=(), durability=()):
-        return TableCreate(self, table_name, primary_key=primary_key, datacenter=datacenter, cache_size=cache_size, durability=durability)
+    def table_create(self, table_name, primary_key=(), datacenter=(), cache_size=(), block_size=(), durability=()):
+        return TableCreate(self, table_name, primary_key=primary_key, datacenter=datacenter, cache_size=cache_size, block_size=block_size, durability=durability)
 
     def table_drop(self, table_name):
         return TableDrop(self, table_name)
 
-    def table(self, table_name, use_outdated=()):
-        return Table(self, table_name, use_outdated=use_outdated)
+    def table(self, table_name, use_outdated=(), max_staleness=()):
+        return Table(self, table_name, use_outdated=use_outdated, max_staleness=max_staleness)
 
 class FunCall(RqlQuery):
     tt = p.Term.FUNCALL
@@ -852,6 +852,9 @@ class Table(RqlQuery):
     def sync(self):
         return Sync(self)
 
+    def changes(self):
+        return Changes(self)
+
     def compose(self, args, optargs):
         if isinstance(self.args[0], DB):
             return T(args[0], '.table(', args[1], ')')
@@ -1024,6 +1027,10 @@ class Sync(RqlMethodQuery):
     tt = p.Term.SYNC
     st = 'sync'
 
+class Changes(RqlMethodQuery):
+    tt = p.Term.CHANGES
+    st = 'changes'
+
 class Branch(RqlTopLevelQuery):
     tt = p.Term.BRANCH
     st = "branch"
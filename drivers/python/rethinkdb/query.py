@@ -20,8 +20,8 @@ def do(arg0, *args):
 
 row = ImplicitVar()
 
-def table(tbl_name, use_outdated=False):
-    return Table(tbl_name, use_outdated=use_outdated)
+def table(tbl_name, use_outdated=False, max_staleness=()):
+    return Table(tbl_name, use_outdated=use_outdated, max_staleness=max_staleness)
 
 def db(db_name):
     return DB(db_name)
@@ -35,8 +35,8 @@ def db_drop(db_name):
 def db_list():
     return DbList()
 
-def table_create(table_name, primary_key=(), datacenter=(), cache_size=(), durability=()):
-    return TableCreateTL(table_name, primary_key=primary_key, datacenter=datacenter, cache_size=cache_size, durability=durability)
+def table_create(table_name, primary_key=(), datacenter=(), cache_size=(), block_size=(), durability=()):
+    return TableCreateTL(table_name, primary_key=primary_key, datacenter=datacenter, cache_size=cache_size, block_size=block_size, durability=durability)
 
 def table_drop(table_name):
     return TableDropTL(table_name)
@@ -53,7 +53,7 @@ else
 endif
 
 DEB_BUILD_DEPENDS := g++, libboost-dev, libssl-dev, curl, exuberant-ctags, m4, debhelper
-DEB_BUILD_DEPENDS += , fakeroot, python, libncurses5-dev
+DEB_BUILD_DEPENDS += , fakeroot, python, libncurses5-dev, zlib1g-dev
 ifneq ($(shell echo $(UBUNTU_RELEASE) | grep '^[q-zQ-Z]'),)
   DEB_BUILD_DEPENDS += , nodejs-legacy
 endif
@@ -23,6 +23,19 @@ def generate_make_semilattice_joinable_macro(nfields):
     # Putting this here makes us require a semicolon after macro invocation.
     print "    extern int semilattice_joinable_force_semicolon_declaration"
 
+def generate_make_semilattice_delta_macro(nfields):
+    print "#define RDB_MAKE_SEMILATTICE_DELTA_%d(type_t%s) \\" % \
+        (nfields, "".join(", field%d" % (i+1) for i in xrange(nfields)))
+    unused = "UNUSED " if nfields == 0 else ""
+    print "    inline type_t semilattice_delta(%sconst type_t &_base_, %sconst type_t &_updated_) { \\" % (unused, unused)
+    print "        type_t _delta_; \\"
+    for i in xrange(nfields):
+        print "        _delta_.field%d = semilattice_delta(_base_.field%d, _updated_.field%d); \\" % (i + 1, i + 1, i + 1)
+    print "        return _delta_; \\"
+    print "    } \\"
+    # Putting this here makes us require a semicolon after macro invocation.
+    print "    extern int semilattice_joinable_force_semicolon_declaration"
+
 def generate_make_equality_comparable_macro(nfields):
     print "#define RDB_MAKE_EQUALITY_COMPARABLE_%d(type_t%s) \\" % \
         (nfields, "".join(", field%d" % (i+1) for i in xrange(nfields)))
@@ -68,12 +81,21 @@ You can also use this with templated types, but it's pretty hacky:
     };
     template<class T>
     RDB_MAKE_SEMILATTICE_JOINABLE_2(pair_t<T>, a, b)
+
+If the type is big and usually changes only a little at a time, you can also
+call `RDB_MAKE_SEMILATTICE_DELTA_[n]()` with the same parameters. It defines
+`semilattice_delta()` for the type field by field (see
+"rpc/semilattice/joins/delta.hpp"); the type must be default-constructible.
 */
     """.strip()
     print
 
+    print "#include \"rpc/semilattice/joins/delta.hpp\""
+    print
+
     for nfields in xrange(0, 20):
         generate_make_semilattice_joinable_macro(nfields)
+        generate_make_semilattice_delta_macro(nfields)
         generate_make_equality_comparable_macro(nfields)
         print
 
@@ -1,11 +1,19 @@
 #include "arch/io/disk/stats.hpp"
 
+#include "perfmon/perfmon.hpp"
+
 stats_diskmgr_t::stats_diskmgr_t(perfmon_collection_t *stats, const std::string &name) :
-    read_sampler(secs_to_ticks(1)),
-    write_sampler(secs_to_ticks(1)),
+    /* Disk operations are slow enough that timing every one of them is
+    cheap, and the latency histograms are useless without the timings. */
+    read_sampler(secs_to_ticks(1), true),
+    write_sampler(secs_to_ticks(1), true),
+    read_latency(secs_to_ticks(1)),
+    write_latency(secs_to_ticks(1)),
     stats_membership(stats,
                      &read_sampler, (name + "_read").c_str(),
                      &write_sampler, (name + "_write").c_str(),
+                     &read_latency, (name + "_read_latency").c_str(),
+                     &write_latency, (name + "_write_latency").c_str(),
                      NULLPTR) { }
 
 
@@ -22,8 +30,10 @@ void stats_diskmgr_t::done(conflict_resolving_diskmgr_action_t *p) {
     action_t *a = static_cast<action_t *>(p);
     if (a->get_is_read()) {
         read_sampler.end(&a->start_time);
+        read_latency.record(ticks_to_secs(get_ticks() - a->start_time));
     } else {
         write_sampler.end(&a->start_time);
+        write_latency.record(ticks_to_secs(get_ticks() - a->start_time));
     }
     done_fun(a);
 }
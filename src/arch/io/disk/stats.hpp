@@ -32,6 +32,7 @@ struct stats_diskmgr_t {
 
 private:
     perfmon_duration_sampler_t read_sampler, write_sampler;
+    perfmon_histogram_t read_latency, write_latency;
     perfmon_multi_membership_t stats_membership;
 };
 
@@ -1,10 +1,17 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "btree/btree_store.hpp"
 
+#include "errors.hpp"
+#include <boost/bind.hpp>
+
+#include "arch/runtime/coroutines.hpp"
+#include "btree/key_filter.hpp"
 #include "btree/operations.hpp"
 #include "btree/secondary_operations.hpp"
+#include "btree/write_ahead_log.hpp"
 #include "concurrency/wait_any.hpp"
 #include "containers/archive/vector_stream.hpp"
+#include "logger.hpp"
 #include "serializer/config.hpp"
 #include "stl_utils.hpp"
 
@@ -32,7 +39,8 @@ btree_store_t<protocol_t>::btree_store_t(serializer_t *serializer,
     : store_view_t<protocol_t>(protocol_t::region_t::universe()),
       perfmon_collection(),
       io_backender_(io_backender), base_path_(base_path),
-      perfmon_collection_membership(parent_perfmon_collection, &perfmon_collection, perfmon_name)
+      perfmon_collection_membership(parent_perfmon_collection, &perfmon_collection, perfmon_name),
+      last_log_seqno(0)
 {
     if (create) {
         cache_t::create(serializer);
@@ -115,6 +123,8 @@ void btree_store_t<protocol_t>::read(
     superblock2.init(superblock.release());
 
     protocol_read(read, response, btree.get(), txn.get(), superblock2.get(), token_pair, interruptor);
+
+    maybe_rebuild_key_filter();
 }
 
 template <class protocol_t>
@@ -131,14 +141,303 @@ void btree_store_t<protocol_t>::write(
         THROWS_ONLY(interrupted_exc_t) {
     assert_thread();
 
+    const bool log_write = write_ahead_log.has() && durability == WRITE_DURABILITY_SOFT;
+    uint64_t log_seqno = 0;
+    {
+        scoped_ptr_t<transaction_t> txn;
+        scoped_ptr_t<real_superblock_t> real_superblock;
+        const int expected_change_count = 2; // FIXME: this is incorrect, but will do for now
+        acquire_superblock_for_write(timestamp.to_repli_timestamp(), expected_change_count, durability, token_pair, &txn, &real_superblock, interruptor);
+
+        check_and_update_metainfo(DEBUG_ONLY(metainfo_checker, ) new_metainfo, txn.get(), real_superblock.get());
+
+        if (log_write) {
+            // A write that gets interrupted halfway through will be replayed in
+            // full after a crash, which is indistinguishable from it having
+            // completed before the crash.
+            write_message_t msg;
+            msg << LOGGED_WRITE << new_metainfo << write << timestamp.timestamp_before();
+            log_seqno = append_to_write_ahead_log(msg, real_superblock.get());
+        }
+
+        scoped_ptr_t<superblock_t> superblock(real_superblock.release());
+        protocol_write(write, response, timestamp, btree.get(), txn.get(), &superblock, token_pair, interruptor);
+    }
+
+    maybe_rebuild_key_filter();
+
+    if (log_write) {
+        maybe_checkpoint_write_ahead_log();
+        write_ahead_log->wait_durable(log_seqno, interruptor);
+    }
+}
+
+template <class protocol_t>
+uint64_t btree_store_t<protocol_t>::append_to_write_ahead_log(
+        const write_message_t &msg,
+        real_superblock_t *superblock) {
+    const uint64_t log_seqno = ++last_log_seqno;
+    superblock->set_applied_log_seqno(log_seqno);
+
+    vector_stream_t payload;
+    int res = send_write_message(&payload, &msg);
+    guarantee(!res);
+    write_ahead_log->append(log_seqno, payload.vector());
+    return log_seqno;
+}
+
+template <class protocol_t>
+void btree_store_t<protocol_t>::maybe_checkpoint_write_ahead_log() {
+    if (write_ahead_log->needs_checkpoint()) {
+        write_ahead_log->retire_active_file();
+        coro_t::spawn_sometime(boost::bind(&btree_store_t<protocol_t>::checkpoint_write_ahead_log,
+                                           this, auto_drainer_t::lock_t(&drainer)));
+    }
+}
+
+template <class protocol_t>
+void btree_store_t<protocol_t>::enable_write_ahead_log(const std::string &path) {
+    assert_thread();
+    guarantee(!write_ahead_log.has());
+
+    std::vector<write_ahead_log_t::record_t> records;
+    write_ahead_log.init(new write_ahead_log_t(path, &records));
+
+    // Once everything up to `last_log_seqno` is on disk, the log can start
+    // over from scratch.
+    replay_write_ahead_log_records(path, records);
+    write_ahead_log->discard_all();
+
+    cache->set_flush_timer_ms(WRITE_AHEAD_LOG_FLUSH_TIMER_MS);
+}
+
+template <class protocol_t>
+void btree_store_t<protocol_t>::recover_write_ahead_log(const std::string &path) {
+    assert_thread();
+    guarantee(!write_ahead_log.has());
+
+    if (!write_ahead_log_t::exists(path)) {
+        return;
+    }
+
+    {
+        std::vector<write_ahead_log_t::record_t> records;
+        write_ahead_log_t log(path, &records);
+        replay_write_ahead_log_records(path, records);
+    }
+
+    // The superblock now says that every record we had is in the btree, so
+    // the files can go; if we crash before they do, the next startup replays
+    // nothing and removes them.
+    write_ahead_log_t::remove(path);
+}
+
+template <class protocol_t>
+void btree_store_t<protocol_t>::replay_write_ahead_log_records(
+        const std::string &path,
+        const std::vector<write_ahead_log_t::record_t> &records) {
+    cond_t dummy_interruptor;
+    {
+        read_token_pair_t token_pair;
+        new_read_token_pair(&token_pair);
+
+        scoped_ptr_t<transaction_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        acquire_superblock_for_read(rwi_read, &token_pair.main_read_token, &txn,
+                                    &superblock, &dummy_interruptor, false);
+        last_log_seqno = superblock->get_applied_log_seqno();
+    }
+
+    // `records` is sorted by sequence number.  Records are synced in order, so
+    // anything following a gap was never acknowledged and is dropped.
+    size_t num_replayed = 0;
+    for (auto it = records.begin(); it != records.end(); ++it) {
+        if (it->seqno <= last_log_seqno) {
+            continue;
+        } else if (it->seqno != last_log_seqno + 1) {
+            break;
+        }
+        replay_logged_mutation(it->seqno, it->payload, &dummy_interruptor);
+        last_log_seqno = it->seqno;
+        ++num_replayed;
+    }
+    if (num_replayed > 0) {
+        logINF("Replayed %zu writes from the write-ahead log %s.\n",
+               num_replayed, path.c_str());
+    }
+
+    persist_applied_log_seqno(&dummy_interruptor);
+}
+
+template <class protocol_t>
+void btree_store_t<protocol_t>::replay_logged_mutation(
+        uint64_t seqno,
+        const std::vector<char> &payload,
+        signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    vector_read_stream_t read_stream(&payload);
+    logged_mutation_type_t type;
+    archive_result_t success = deserialize(&read_stream, &type);
+    guarantee_deserialization(success, "write-ahead log record");
+    switch (type) {
+    case LOGGED_WRITE:
+        replay_logged_write(seqno, &read_stream, interruptor);
+        break;
+    case LOGGED_BACKFILL_CHUNK:
+        replay_logged_backfill_chunk(seqno, &read_stream, interruptor);
+        break;
+    default:
+        unreachable();
+    }
+}
+
+template <class protocol_t>
+void btree_store_t<protocol_t>::replay_logged_write(
+        uint64_t seqno,
+        read_stream_t *payload,
+        signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    metainfo_t new_metainfo;
+    typename protocol_t::write_t write;
+    state_timestamp_t timestamp_before;
+    archive_result_t success = deserialize(payload, &new_metainfo);
+    guarantee_deserialization(success, "write-ahead log record");
+    success = deserialize(payload, &write);
+    guarantee_deserialization(success, "write-ahead log record");
+    success = deserialize(payload, &timestamp_before);
+    guarantee_deserialization(success, "write-ahead log record");
+    const transition_timestamp_t timestamp
+        = transition_timestamp_t::starting_from(timestamp_before);
+
+    write_token_pair_t token_pair;
+    new_write_token_pair(&token_pair);
+
     scoped_ptr_t<transaction_t> txn;
     scoped_ptr_t<real_superblock_t> real_superblock;
-    const int expected_change_count = 2; // FIXME: this is incorrect, but will do for now
-    acquire_superblock_for_write(timestamp.to_repli_timestamp(), expected_change_count, durability, token_pair, &txn, &real_superblock, interruptor);
+    const int expected_change_count = 2;
+    acquire_superblock_for_write(timestamp.to_repli_timestamp(), expected_change_count,
+                                 WRITE_DURABILITY_SOFT, &token_pair, &txn,
+                                 &real_superblock, interruptor);
+
+    metainfo_t old_metainfo;
+    get_metainfo_internal(txn.get(), real_superblock->get(), &old_metainfo);
+    update_metainfo(old_metainfo, new_metainfo, txn.get(), real_superblock.get());
+    real_superblock->set_applied_log_seqno(seqno);
 
-    check_and_update_metainfo(DEBUG_ONLY(metainfo_checker, ) new_metainfo, txn.get(), real_superblock.get());
     scoped_ptr_t<superblock_t> superblock(real_superblock.release());
-    protocol_write(write, response, timestamp, btree.get(), txn.get(), &superblock, token_pair, interruptor);
+    typename protocol_t::write_response_t response;
+    protocol_write(write, &response, timestamp, btree.get(), txn.get(), &superblock,
+                   &token_pair, interruptor);
+}
+
+template <class protocol_t>
+void btree_store_t<protocol_t>::replay_logged_backfill_chunk(
+        uint64_t seqno,
+        read_stream_t *payload,
+        signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    typename protocol_t::backfill_chunk_t chunk;
+    archive_result_t success = deserialize(payload, &chunk);
+    guarantee_deserialization(success, "write-ahead log record");
+
+    write_token_pair_t token_pair;
+    new_write_token_pair(&token_pair);
+
+    scoped_ptr_t<transaction_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    const int expected_change_count = 1;
+    acquire_superblock_for_write(chunk.get_btree_repli_timestamp(), expected_change_count,
+                                 WRITE_DURABILITY_SOFT, &token_pair, &txn,
+                                 &superblock, interruptor);
+    superblock->set_applied_log_seqno(seqno);
+
+    protocol_receive_backfill(btree.get(), txn.get(), superblock.get(), &token_pair,
+                              interruptor, chunk);
+}
+
+template <class protocol_t>
+void btree_store_t<protocol_t>::persist_applied_log_seqno(signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    object_buffer_t<fifo_enforcer_sink_t::exit_write_t> token;
+    new_write_token(&token);
+
+    scoped_ptr_t<transaction_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    acquire_superblock_for_write(rwi_write, rwi_write,
+                                 repli_timestamp_t::invalid,
+                                 1,
+                                 WRITE_DURABILITY_HARD,
+                                 &token,
+                                 &txn,
+                                 &superblock,
+                                 interruptor);
+    superblock->set_applied_log_seqno(last_log_seqno);
+}
+
+template <class protocol_t>
+void btree_store_t<protocol_t>::checkpoint_write_ahead_log(auto_drainer_t::lock_t keepalive) {
+    try {
+        // Our superblock acquisition is ordered after every write that went
+        // into the retired log file, so once the hard-durability transaction
+        // commits, none of the retired records are needed anymore.
+        persist_applied_log_seqno(keepalive.get_drain_signal());
+        write_ahead_log->truncate_retired_file(keepalive.get_drain_signal());
+    } catch (const interrupted_exc_t &) {
+        // We are shutting down; the retired file simply gets replayed from
+        // (and discarded) on the next startup.
+    }
+}
+
+template <class protocol_t>
+void btree_store_t<protocol_t>::enable_key_filter() {
+    assert_thread();
+    guarantee(!btree->key_filter.has());
+    btree->key_filter.init(new key_filter_t(&btree->stats));
+    maybe_rebuild_key_filter();
+}
+
+template <class protocol_t>
+void btree_store_t<protocol_t>::maybe_rebuild_key_filter() {
+    if (btree->key_filter.has() && btree->key_filter->needs_rebuild()) {
+        btree->key_filter->begin_rebuild();
+        coro_t::spawn_sometime(boost::bind(&btree_store_t<protocol_t>::rebuild_key_filter,
+                                           this, auto_drainer_t::lock_t(&drainer)));
+    }
+}
+
+template <class protocol_t>
+void btree_store_t<protocol_t>::rebuild_key_filter(auto_drainer_t::lock_t keepalive) {
+    assert_thread();
+    key_filter_t *key_filter = btree->key_filter.get();
+    try {
+        int64_t population;
+        {
+            object_buffer_t<fifo_enforcer_sink_t::exit_read_t> token;
+            new_read_token(&token);
+            scoped_ptr_t<transaction_t> txn;
+            scoped_ptr_t<real_superblock_t> superblock;
+            acquire_superblock_for_read(rwi_read, &token, &txn, &superblock,
+                                        keepalive.get_drain_signal(), false);
+            population = get_btree_population(txn.get(), superblock.get());
+        }
+
+        // Every key inserted from here on goes into the new filter, so the
+        // snapshot only has to cover the keys that are there already.
+        key_filter->start_collecting(population);
+
+        object_buffer_t<fifo_enforcer_sink_t::exit_read_t> token;
+        new_read_token(&token);
+        scoped_ptr_t<transaction_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        acquire_superblock_for_read(rwi_read, &token, &txn, &superblock,
+                                    keepalive.get_drain_signal(), true);
+        build_key_filter(key_filter, btree.get(), txn.get(), superblock.get(),
+                         keepalive.get_drain_signal());
+        key_filter->finish_rebuild();
+    } catch (const interrupted_exc_t &) {
+        // We are shutting down; the filter gets built again on the next startup.
+        key_filter->abandon_rebuild();
+    }
 }
 
 // TODO: Figure out wtf does the backfill filtering, figure out wtf constricts delete range operations to hit only a certain hash-interval, figure out what filters keys.
@@ -194,12 +493,30 @@ void btree_store_t<protocol_t>::receive_backfill(
                                  &superblock,
                                  interruptor);
 
+    // With a write-ahead log, the btree may lag behind logged writes that
+    // come after this chunk, so the chunk has to be logged too or replaying
+    // them after a crash would skip it.  We don't wait for the record to
+    // reach the disk: the log is synced in order, so it is durable once any
+    // later write has been acknowledged, and the backfillee's hard-durability
+    // metainfo update covers the rest.
+    if (write_ahead_log.has()) {
+        write_message_t msg;
+        msg << LOGGED_BACKFILL_CHUNK << chunk;
+        append_to_write_ahead_log(msg, superblock.get());
+    }
+
     protocol_receive_backfill(btree.get(),
                               txn.get(),
                               superblock.get(),
                               token_pair,
                               interruptor,
                               chunk);
+
+    maybe_rebuild_key_filter();
+
+    if (write_ahead_log.has()) {
+        maybe_checkpoint_write_ahead_log();
+    }
 }
 
 template <class protocol_t>
@@ -225,9 +542,12 @@ void btree_store_t<protocol_t>::reset_data(
     // TOnDO that's not reasonable; reset_data() is sometimes used to wipe out
     // entire databases.
     const int expected_change_count = 2;
+    // Resets are not logged, so with a write-ahead log they have to reach
+    // the disk before any logged write that comes after them can be
+    // acknowledged.
     acquire_superblock_for_write(repli_timestamp_t::invalid,
                                  expected_change_count,
-                                 durability,
+                                 write_ahead_log.has() ? WRITE_DURABILITY_HARD : durability,
                                  token_pair,
                                  &txn,
                                  &superblock,
@@ -320,6 +640,15 @@ progress_completion_fraction_t btree_store_t<protocol_t>::get_progress(uuid_u id
     }
 }
 
+template <class protocol_t>
+double btree_store_t<protocol_t>::get_seconds_remaining(uuid_u id) {
+    if (!std_contains(progress_trackers, id)) {
+        return -1;
+    } else {
+        return progress_trackers[id]->guess_seconds_remaining();
+    }
+}
+
 template <class protocol_t>
 void btree_store_t<protocol_t>::acquire_sindex_block_for_read(
         read_token_pair_t *token_pair,
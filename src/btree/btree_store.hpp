@@ -14,6 +14,7 @@
 
 #include "btree/erase_range.hpp"
 #include "btree/secondary_operations.hpp"
+#include "btree/write_ahead_log.hpp"
 #include "buffer_cache/mirrored/config.hpp"  // TODO: Move to buffer_cache/config.hpp or something.
 #include "buffer_cache/types.hpp"
 #include "concurrency/auto_drainer.hpp"
@@ -31,6 +32,11 @@ class io_backender_t;
 class superblock_t;
 class real_superblock_t;
 
+// The first field of every record in a `btree_store_t`'s write-ahead log.
+enum logged_mutation_type_t { LOGGED_WRITE = 0, LOGGED_BACKFILL_CHUNK = 1 };
+ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(logged_mutation_type_t, int8_t,
+                                      LOGGED_WRITE, LOGGED_BACKFILL_CHUNK);
+
 class sindex_not_post_constructed_exc_t : public std::exception {
 public:
     explicit sindex_not_post_constructed_exc_t(std::string sindex_name);
@@ -123,6 +129,27 @@ public:
             signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t);
 
+    /* Makes writes with soft durability wait until they have been appended to
+    the write-ahead log at `path` instead of relying on the cache to flush
+    them soon.  Backfill chunks are logged as well, so that replaying later
+    writes never skips over them.  Any records the log holds that did not make
+    it into the btree before the server went down are replayed first.  Must be
+    called before the store is used. */
+    void enable_write_ahead_log(const std::string &path);
+
+    /* Used instead of `enable_write_ahead_log()` when the store doesn't keep a
+    log.  If a log was left at `path` by an earlier run, its writes are
+    replayed, made durable and the log files are removed, so that they can't
+    be lost or replayed over newer data later on. */
+    void recover_write_ahead_log(const std::string &path);
+
+    /* Keeps a Bloom filter over the primary keys in memory, so that point
+    reads of missing keys usually don't have to walk the btree.  The filter is
+    built in the background, and rebuilt whenever it has grown too full or
+    lets through too many missing keys.  Must be called before the store is
+    used. */
+    void enable_key_filter();
+
     void lock_sindex_queue(buf_lock_t *sindex_block, mutex_t::acq_t *acq);
 
     void register_sindex_queue(
@@ -146,6 +173,9 @@ public:
 
     progress_completion_fraction_t get_progress(uuid_u id);
 
+    /* Returns a negative number if there's no estimate. */
+    double get_seconds_remaining(uuid_u id);
+
     void acquire_sindex_block_for_read(
             read_token_pair_t *token_pair,
             transaction_t *txn,
@@ -426,6 +456,45 @@ public:
 
     void update_metainfo(const metainfo_t &old_metainfo, const metainfo_t &new_metainfo, transaction_t *txn, real_superblock_t *superbloc) const THROWS_NOTHING;
 
+private:
+    // Replays the records that aren't in the btree yet and makes them durable.
+    void replay_write_ahead_log_records(
+            const std::string &path,
+            const std::vector<write_ahead_log_t::record_t> &records);
+
+    void replay_logged_mutation(uint64_t seqno, const std::vector<char> &payload,
+                                signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
+
+    void replay_logged_write(uint64_t seqno, read_stream_t *payload,
+                             signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
+
+    void replay_logged_backfill_chunk(uint64_t seqno, read_stream_t *payload,
+                                      signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
+
+    // Gives the mutation that is about to be applied under `superblock` the
+    // next log sequence number and appends `msg` to the log.  The caller must
+    // still hold the superblock, so that records are in the order in which
+    // their mutations are applied.
+    uint64_t append_to_write_ahead_log(const write_message_t &msg,
+                                       real_superblock_t *superblock);
+
+    void maybe_checkpoint_write_ahead_log();
+
+    // Writes the current log sequence number to the superblock with hard
+    // durability, so that every logged write up to it is in the btree on disk.
+    void persist_applied_log_seqno(signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
+
+    void checkpoint_write_ahead_log(auto_drainer_t::lock_t keepalive);
+
+    void maybe_rebuild_key_filter();
+    void rebuild_key_filter(auto_drainer_t::lock_t keepalive);
+
+public:
+
     mirrored_cache_config_t cache_dynamic_config;
     order_source_t order_source;
 
@@ -447,6 +516,10 @@ public:
     mutex_t sindex_queue_mutex;
     std::map<uuid_u, const parallel_traversal_progress_t *> progress_trackers;
 
+    // Only set up if `enable_write_ahead_log()` was called.
+    scoped_ptr_t<write_ahead_log_t> write_ahead_log;
+    uint64_t last_log_seqno;
+
     // Mind the constructor ordering. We must destruct drainer before destructing
     // many of the other structures.
     auto_drainer_t drainer;
@@ -1,23 +1,303 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "btree/erase_range.hpp"
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "arch/runtime/coroutines.hpp"
+#include "btree/internal_node.hpp"
+#include "btree/key_sample.hpp"
 #include "btree/leaf_node.hpp"
 #include "btree/node.hpp"
+#include "btree/operations.hpp"
 #include "btree/parallel_traversal.hpp"
 #include "btree/slice.hpp"
 #include "buffer_cache/buffer_cache.hpp"
+#include "concurrency/cond_var.hpp"
 #include "concurrency/fifo_checker.hpp"
+#include "config/args.hpp"
+
+/* Takes `keys_freed` off the population in the stat block, and the keys that
+`sample_eraser` saw out of the key sample. */
+static void update_stat_block_after_erase(transaction_t *txn, block_id_t stat_block_id,
+                                          int64_t keys_freed,
+                                          const key_sample_eraser_t &sample_eraser) {
+    guarantee(stat_block_id != NULL_BLOCK_ID);
+    buf_lock_t stat_block(txn, stat_block_id, rwi_write, buffer_cache_order_mode_ignore);
+    btree_statblock_t *stat_block_data = static_cast<btree_statblock_t *>(stat_block.get_data_write());
+    stat_block_data->population -= keys_freed;
+    sample_eraser.apply(stat_block_data);
+}
+
+/* Frees `block_id`, which is in a subtree that has been unlinked from the
+btree: deletes the values if it's a leaf, or appends its children to
+`children_out` if it isn't, and marks it deleted.  Returns the number of keys
+that were in the block. */
+static int64_t free_detached_block(transaction_t *txn, block_id_t block_id,
+                                   value_deleter_t *deleter,
+                                   key_sample_eraser_t *sample_eraser,
+                                   std::vector<block_id_t> *children_out) {
+    int64_t keys_freed = 0;
+    buf_lock_t buf(txn, block_id, rwi_write);
+    const node_t *node = static_cast<const node_t *>(buf.get_data_read());
+    if (node::is_leaf(node)) {
+        // The values are deleted in place; the block is going away anyway.
+        leaf_node_t *leaf_node = static_cast<leaf_node_t *>(buf.get_data_write());
+        for (auto it = leaf::begin(*leaf_node); it != leaf::end(*leaf_node); ++it) {
+            deleter->delete_value(txn, const_cast<void *>((*it).second));
+            sample_eraser->on_erase((*it).first);
+            ++keys_freed;
+        }
+    } else {
+        const internal_node_t *internal_node = static_cast<const internal_node_t *>(buf.get_data_read());
+        for (int i = 0; i < internal_node->npairs; ++i) {
+            children_out->push_back(internal_node::get_pair_by_index(internal_node, i)->lnode);
+        }
+    }
+    buf.mark_deleted();
+    return keys_freed;
+}
+
+/* Frees subtrees that have been unlinked from the btree within the
+transaction that unlinked them, with up to `ERASE_RANGE_FREE_CONCURRENCY`
+blocks worked on at once. */
+class detached_subtree_freer_t {
+public:
+    detached_subtree_freer_t(value_deleter_t *deleter, key_sample_eraser_t *sample_eraser,
+                             transaction_t *txn)
+        : deleter_(deleter), sample_eraser_(sample_eraser), txn_(txn),
+          active_workers_(0), keys_freed_(0) { }
+
+    // Returns the number of keys that were in the subtrees.
+    int64_t free_subtrees(const std::vector<block_id_t> &roots) {
+        to_free_ = roots;
+        spawn_workers();
+        if (active_workers_ > 0) {
+            done_.wait();
+        }
+        return keys_freed_;
+    }
+
+private:
+    void spawn_workers() {
+        while (active_workers_ < ERASE_RANGE_FREE_CONCURRENCY
+               && static_cast<size_t>(active_workers_) < to_free_.size()) {
+            ++active_workers_;
+            coro_t::spawn_sometime(boost::bind(&detached_subtree_freer_t::work, this));
+        }
+    }
+
+    void work() {
+        while (!to_free_.empty()) {
+            const block_id_t block_id = to_free_.back();
+            to_free_.pop_back();
+            keys_freed_ += free_detached_block(txn_, block_id, deleter_, sample_eraser_,
+                                               &to_free_);
+            spawn_workers();
+        }
+        --active_workers_;
+        if (active_workers_ == 0) {
+            done_.pulse();
+        }
+    }
+
+    value_deleter_t *deleter_;
+    key_sample_eraser_t *sample_eraser_;
+    transaction_t *txn_;
+
+    std::vector<block_id_t> to_free_;
+    int active_workers_;
+    int64_t keys_freed_;
+    cond_t done_;
+
+    DISABLE_COPYING(detached_subtree_freer_t);
+};
+
+/* Returns the first block of the btree's `btree_detached_list_t`, creating the
+list if it doesn't exist yet. */
+static block_id_t get_or_create_detached_list(transaction_t *txn, superblock_t *superblock) {
+    block_id_t list_block_id = superblock->get_detached_list_block_id();
+    if (list_block_id == NULL_BLOCK_ID) {
+        buf_lock_t list_buf(txn);
+        btree_detached_list_t *list = static_cast<btree_detached_list_t *>(list_buf.get_data_write());
+        list->magic = btree_detached_list_t::expected_magic;
+        list->next = NULL_BLOCK_ID;
+        list->num_blocks = 0;
+        list_block_id = list_buf.get_block_id();
+        superblock->set_detached_list_block_id(list_block_id);
+    }
+    return list_block_id;
+}
+
+static void push_detached_blocks(transaction_t *txn, block_id_t list_block_id,
+                                 const std::vector<block_id_t> &block_ids) {
+    const block_size_t block_size = txn->get_cache()->get_block_size();
+    buf_lock_t list_buf(txn, list_block_id, rwi_write, buffer_cache_order_mode_ignore);
+    btree_detached_list_t *list = static_cast<btree_detached_list_t *>(list_buf.get_data_write());
+    rassert(list->magic == btree_detached_list_t::expected_magic);
+    for (auto it = block_ids.begin(); it != block_ids.end(); ++it) {
+        if (list->num_blocks == btree_detached_list_t::capacity(block_size)) {
+            buf_lock_t overflow_buf(txn);
+            memcpy(overflow_buf.get_data_write(), list, block_size.value());
+            list->next = overflow_buf.get_block_id();
+            list->num_blocks = 0;
+        }
+        list->blocks[list->num_blocks++] = *it;
+    }
+}
+
+// Returns `NULL_BLOCK_ID` if the list is empty.
+static block_id_t pop_detached_block(transaction_t *txn, block_id_t list_block_id) {
+    const block_size_t block_size = txn->get_cache()->get_block_size();
+    buf_lock_t list_buf(txn, list_block_id, rwi_write, buffer_cache_order_mode_ignore);
+    const btree_detached_list_t *list = static_cast<const btree_detached_list_t *>(list_buf.get_data_read());
+    rassert(list->magic == btree_detached_list_t::expected_magic);
+    if (list->num_blocks == 0 && list->next == NULL_BLOCK_ID) {
+        return NULL_BLOCK_ID;
+    }
+    btree_detached_list_t *list_w = static_cast<btree_detached_list_t *>(list_buf.get_data_write());
+    if (list_w->num_blocks == 0) {
+        buf_lock_t next_buf(txn, list_w->next, rwi_write);
+        memcpy(list_w, next_buf.get_data_read(), block_size.value());
+        next_buf.mark_deleted();
+    }
+    return list_w->blocks[--list_w->num_blocks];
+}
+
+/* Frees the subtrees on a `btree_detached_list_t` with up to
+`ERASE_RANGE_FREE_CONCURRENCY` workers.  Each block is taken off the list,
+freed, and replaced on the list by its children in one transaction, which also
+updates the stat block.  The cache only ever writes out whole transactions, and
+one that starts after the transaction that put a block on the list did can't be
+written out before it, so what's on the list on disk is exactly what still has
+to be freed.  A worker stops when it finds the list empty or `stop` is pulsed. */
+class background_subtree_freer_t {
+public:
+    background_subtree_freer_t(btree_slice_t *slice, value_deleter_t *deleter,
+                               block_id_t list_block_id, block_id_t stat_block_id,
+                               signal_t *stop)
+        : slice_(slice), deleter_(deleter), list_block_id_(list_block_id),
+          stat_block_id_(stat_block_id), stop_(stop), active_workers_(0) { }
+
+    void run() {
+        for (int i = 0; i < ERASE_RANGE_FREE_CONCURRENCY; ++i) {
+            ++active_workers_;
+            coro_t::spawn_sometime(boost::bind(&background_subtree_freer_t::work, this));
+        }
+        done_.wait();
+    }
+
+private:
+    void work() {
+        while (!stop_->is_pulsed() && free_next_block()) { }
+        --active_workers_;
+        if (active_workers_ == 0) {
+            done_.pulse();
+        }
+    }
+
+    // Returns false if the list was empty.
+    bool free_next_block() {
+        transaction_t txn(slice_->cache(), rwi_write, 1, repli_timestamp_t::distant_past,
+                          order_token_t::ignore, WRITE_DURABILITY_SOFT);
+        const block_id_t block_id = pop_detached_block(&txn, list_block_id_);
+        if (block_id == NULL_BLOCK_ID) {
+            return false;
+        }
+        key_sample_eraser_t sample_eraser;
+        {
+            buf_lock_t stat_block(&txn, stat_block_id_, rwi_read, buffer_cache_order_mode_ignore);
+            sample_eraser.init(static_cast<const btree_statblock_t *>(stat_block.get_data_read()));
+        }
+        std::vector<block_id_t> children;
+        const int64_t keys_freed = free_detached_block(&txn, block_id, deleter_,
+                                                       &sample_eraser, &children);
+        // The stat block comes before the list, like in the erase.
+        if (keys_freed != 0) {
+            update_stat_block_after_erase(&txn, stat_block_id_, keys_freed, sample_eraser);
+        }
+        if (!children.empty()) {
+            push_detached_blocks(&txn, list_block_id_, children);
+        }
+        return true;
+    }
+
+    btree_slice_t *slice_;
+    value_deleter_t *deleter_;
+    block_id_t list_block_id_;
+    block_id_t stat_block_id_;
+    signal_t *stop_;
+
+    int active_workers_;
+    cond_t done_;
+
+    DISABLE_COPYING(background_subtree_freer_t);
+};
+
+static void free_detached_subtrees_in_background(
+        btree_slice_t *slice,
+        const boost::shared_ptr<value_deleter_t> &deleter,
+        auto_drainer_t::lock_t keepalive) {
+    keepalive.assert_is_holding(&slice->drainer);
+    while (slice->detached_subtrees_pending && !keepalive.get_drain_signal()->is_pulsed()) {
+        slice->detached_subtrees_pending = false;
+
+        block_id_t list_block_id;
+        block_id_t stat_block_id;
+        {
+            transaction_t txn(slice->cache(), rwi_read, order_token_t::ignore);
+            buf_lock_t superblock_buf(&txn, slice->get_superblock_id(), rwi_read);
+            real_superblock_t superblock(&superblock_buf);
+            list_block_id = superblock.get_detached_list_block_id();
+            stat_block_id = superblock.get_stat_block_id();
+        }
+
+        if (list_block_id != NULL_BLOCK_ID) {
+            background_subtree_freer_t freer(slice, deleter.get(), list_block_id,
+                                             stat_block_id, keepalive.get_drain_signal());
+            freer.run();
+        }
+    }
+    slice->freeing_detached_subtrees = false;
+}
+
+void start_freeing_detached_subtrees(btree_slice_t *slice, const value_deleter_t *deleter) {
+    slice->assert_thread();
+    slice->detached_subtrees_pending = true;
+    if (!slice->freeing_detached_subtrees) {
+        boost::shared_ptr<value_deleter_t> clone(deleter->clone());
+        guarantee(clone);
+        slice->freeing_detached_subtrees = true;
+        coro_t::spawn_sometime(boost::bind(&free_detached_subtrees_in_background,
+                                           slice, clone,
+                                           auto_drainer_t::lock_t(&slice->drainer)));
+    }
+}
 
 class erase_range_helper_t : public btree_traversal_helper_t {
 public:
-    erase_range_helper_t(value_sizer_t<void> *sizer, key_tester_t *tester,
-                         value_deleter_t *deleter,
+    erase_range_helper_t(value_sizer_t<void> *sizer, btree_slice_t *slice,
+                         key_tester_t *tester, value_deleter_t *deleter,
                          const btree_key_t *left_exclusive_or_null,
-                         const btree_key_t *right_inclusive_or_null)
-        : sizer_(sizer), tester_(tester), deleter_(deleter),
+                         const btree_key_t *right_inclusive_or_null,
+                         block_id_t detached_list_block_id)
+        : sizer_(sizer), slice_(slice), tester_(tester), deleter_(deleter),
           left_exclusive_or_null_(left_exclusive_or_null),
-          right_inclusive_or_null_(right_inclusive_or_null)
+          right_inclusive_or_null_(right_inclusive_or_null),
+          detach_subtrees_(tester->erases_every_key()),
+          detached_list_block_id_(detached_list_block_id),
+          stat_block_id_(NULL_BLOCK_ID), keys_erased_(0)
     { }
 
+    void read_stat_block(buf_lock_t *stat_block) {
+        if (stat_block == NULL) {
+            stat_block_id_ = NULL_BLOCK_ID;
+        } else {
+            stat_block_id_ = stat_block->get_block_id();
+            sample_eraser_.init(static_cast<const btree_statblock_t *>(stat_block->get_data_read()));
+        }
+    }
+
     void process_a_leaf(transaction_t *txn, buf_lock_t *leaf_node_buf,
                         const btree_key_t *l_excl,
                         const btree_key_t *r_incl,
@@ -50,13 +330,39 @@ public:
             deleter_->delete_value(txn, value.get());
             leaf::erase_presence(sizer_, node, keys_to_delete[i].btree_key(),
                                  key_modification_proof_t::real_proof());
+            sample_eraser_.on_erase(keys_to_delete[i].btree_key());
         }
 
+        keys_erased_ += keys_to_delete.size();
         *population_change_out = -static_cast<int>(keys_to_delete.size());
     }
 
-    void postprocess_internal_node(UNUSED buf_lock_t *internal_node_buf) {
-        // We don't want to do anything here.
+    void postprocess_internal_node(buf_lock_t *internal_node_buf) {
+        if (!detach_subtrees_) {
+            return;
+        }
+
+        /* Unlink the children that `filter_interesting_children()` skipped.
+        Removing the pair of a middle child just widens the range of the next
+        child, so the node stays valid; if it ends up underfull, the next
+        write that passes through it merges or levels it. */
+        const internal_node_t *node = static_cast<const internal_node_t *>(internal_node_buf->get_data_read());
+        std::vector<store_key_t> keys_to_remove;
+        for (int i = 1; i < node->npairs - 1; ++i) {
+            const btree_internal_pair *pair = internal_node::get_pair_by_index(node, i);
+            if (is_detachable(i, node->npairs,
+                              &internal_node::get_pair_by_index(node, i - 1)->key, &pair->key)) {
+                keys_to_remove.push_back(store_key_t(&pair->key));
+                detached_roots_.push_back(pair->lnode);
+            }
+        }
+
+        if (!keys_to_remove.empty()) {
+            internal_node_t *node_w = static_cast<internal_node_t *>(internal_node_buf->get_data_write());
+            for (auto it = keys_to_remove.begin(); it != keys_to_remove.end(); ++it) {
+                internal_node::remove(sizer_->block_size(), node_w, it->btree_key());
+            }
+        }
     }
 
     void filter_interesting_children(UNUSED transaction_t *txn, ranged_block_ids_t *ids_source, interesting_children_callback_t *cb) {
@@ -65,7 +371,9 @@ public:
             const btree_key_t *left, *right;
             ids_source->get_block_id_and_bounding_interval(i, &block_id, &left, &right);
 
-            if (overlaps(left, right, left_exclusive_or_null_, right_inclusive_or_null_)) {
+            // Subtrees we are going to unlink don't need to be traversed.
+            if (overlaps(left, right, left_exclusive_or_null_, right_inclusive_or_null_)
+                && !is_detachable(i, e, left, right)) {
                 cb->receive_interesting_child(i);
             }
         }
@@ -73,6 +381,29 @@ public:
         cb->no_more_interesting_children();
     }
 
+    /* Frees the subtrees `postprocess_internal_node()` unlinked right away, or
+    puts them on the `btree_detached_list_t` and starts freeing them in the
+    background if there is one.  Brings the stat block up to date with the key
+    sample and with the subtrees that were freed right away.  Call this after
+    the traversal. */
+    void finish(transaction_t *txn) {
+        int64_t keys_freed = 0;
+        if (!detached_roots_.empty() && detached_list_block_id_ == NULL_BLOCK_ID) {
+            detached_subtree_freer_t freer(deleter_, &sample_eraser_, txn);
+            keys_freed = freer.free_subtrees(detached_roots_);
+            detached_roots_.clear();
+        }
+        if (keys_erased_ + keys_freed != 0) {
+            // The traversal already took `keys_erased_` off the population.
+            update_stat_block_after_erase(txn, stat_block_id_, keys_freed, sample_eraser_);
+        }
+        if (!detached_roots_.empty()) {
+            push_detached_blocks(txn, detached_list_block_id_, detached_roots_);
+            detached_roots_.clear();
+            start_freeing_detached_subtrees(slice_, deleter_);
+        }
+    }
+
     access_t btree_superblock_mode() { return rwi_write; }
     access_t btree_node_mode() { return rwi_write; }
 
@@ -88,6 +419,24 @@ public:
         return true;
     }
 
+    /* True if the `index`th of `count` children of an internal node, with the
+    range `(left_excl, right_incl]`, lies entirely within the erased range and
+    can be unlinked as a whole.  Only children with keys on both sides in the
+    node itself qualify, so `postprocess_internal_node()` can come to the
+    same decision from the node alone, and the node keeps its first and last
+    child. */
+    bool is_detachable(int index, int count,
+                       const btree_key_t *left_excl, const btree_key_t *right_incl) const {
+        if (!detach_subtrees_ || index == 0 || index >= count - 1) {
+            return false;
+        }
+        rassert(left_excl != NULL && right_incl != NULL);
+        return (left_exclusive_or_null_ == NULL
+                || btree_key_cmp(left_exclusive_or_null_, left_excl) <= 0)
+            && (right_inclusive_or_null_ == NULL
+                || btree_key_cmp(right_incl, right_inclusive_or_null_) <= 0);
+    }
+
     static void assert_key_in_range(DEBUG_VAR const btree_key_t *k, DEBUG_VAR const btree_key_t *left_excl, DEBUG_VAR const btree_key_t *right_incl) {
         rassert(key_in_range(k, left_excl, right_incl));
     }
@@ -101,14 +450,57 @@ public:
 
 private:
     value_sizer_t<void> *sizer_;
+    btree_slice_t *slice_;
     key_tester_t *tester_;
     value_deleter_t *deleter_;
     const btree_key_t *left_exclusive_or_null_;
     const btree_key_t *right_inclusive_or_null_;
 
+    const bool detach_subtrees_;
+    // `NULL_BLOCK_ID` if detached subtrees are freed within the transaction.
+    const block_id_t detached_list_block_id_;
+    block_id_t stat_block_id_;
+    // Roots of the subtrees that have been unlinked from their parents.
+    std::vector<block_id_t> detached_roots_;
+    // Keys erased from the leaves the traversal went through.
+    int64_t keys_erased_;
+    key_sample_eraser_t sample_eraser_;
+
     DISABLE_COPYING(erase_range_helper_t);
 };
 
+static void erase_range(value_sizer_t<void> *sizer, btree_slice_t *slice,
+                        key_tester_t *tester,
+                        value_deleter_t *deleter,
+                        const btree_key_t *left_exclusive_or_null,
+                        const btree_key_t *right_inclusive_or_null,
+                        transaction_t *txn, superblock_t *superblock,
+                        signal_t *interruptor,
+                        bool release_superblock,
+                        bool free_in_background) {
+    // The list has to be set up while we still hold the superblock.
+    block_id_t detached_list_block_id = NULL_BLOCK_ID;
+    if (free_in_background && tester->erases_every_key()) {
+        scoped_ptr_t<value_deleter_t> clone(deleter->clone());
+        if (clone.has()) {
+            detached_list_block_id = get_or_create_detached_list(txn, superblock);
+        }
+    }
+
+    erase_range_helper_t helper(sizer, slice, tester, deleter,
+                                left_exclusive_or_null, right_inclusive_or_null,
+                                detached_list_block_id);
+    try {
+        btree_parallel_traversal(txn, superblock, slice, &helper, interruptor, release_superblock);
+    } catch (const interrupted_exc_t &) {
+        // Subtrees that have been unlinked already must be freed or put on
+        // the list anyway, or their blocks would leak.
+        helper.finish(txn);
+        throw;
+    }
+    helper.finish(txn);
+}
+
 void btree_erase_range_generic(value_sizer_t<void> *sizer, btree_slice_t *slice,
                                key_tester_t *tester,
                                value_deleter_t *deleter,
@@ -117,8 +509,9 @@ void btree_erase_range_generic(value_sizer_t<void> *sizer, btree_slice_t *slice,
                                transaction_t *txn, superblock_t *superblock,
                                signal_t *interruptor,
                                bool release_superblock) {
-    erase_range_helper_t helper(sizer, tester, deleter, left_exclusive_or_null, right_inclusive_or_null);
-    btree_parallel_traversal(txn, superblock, slice, &helper, interruptor, release_superblock);
+    erase_range(sizer, slice, tester, deleter, left_exclusive_or_null,
+                right_inclusive_or_null, txn, superblock, interruptor,
+                release_superblock, true);
 }
 
 void erase_all(value_sizer_t<void> *sizer, btree_slice_t *slice,
@@ -128,9 +521,11 @@ void erase_all(value_sizer_t<void> *sizer, btree_slice_t *slice,
                bool release_superblock) {
     struct always_true_tester_t : public key_tester_t {
         bool key_should_be_erased(const btree_key_t *) { return true; }
+        bool erases_every_key() { return true; }
     } always_true_tester;
 
-    btree_erase_range_generic(sizer, slice, &always_true_tester,
-                              deleter, NULL, NULL, txn, superblock,
-                              interruptor, release_superblock);
+    // The btree may be destroyed along with the transaction (when a
+    // secondary index is dropped), so nothing can be left for later.
+    erase_range(sizer, slice, &always_true_tester, deleter, NULL, NULL, txn,
+                superblock, interruptor, release_superblock, false);
 }
@@ -18,6 +18,11 @@ public:
     key_tester_t() { }
     virtual bool key_should_be_erased(const btree_key_t *key) = 0;
 
+    /* True if `key_should_be_erased()` is true for every key.  This lets range
+    erases unlink whole subtrees that lie within the range instead of looking
+    at their keys one by one. */
+    virtual bool erases_every_key() { return false; }
+
 protected:
     virtual ~key_tester_t() { }
 private:
@@ -28,19 +33,28 @@ struct always_true_key_tester_t : public key_tester_t {
     bool key_should_be_erased(UNUSED const btree_key_t *key) {
         return true;
     }
+    bool erases_every_key() { return true; }
 };
 
 class value_deleter_t {
 public:
     value_deleter_t() { }
+    virtual ~value_deleter_t() { }
     virtual void delete_value(transaction_t *txn, void *value) = 0;
 
-protected:
-    virtual ~value_deleter_t() { }
+    /* Returns a new deleter that does the same thing, or NULL.  If there is
+    one, subtrees that `btree_erase_range_generic()` unlinks are put on the
+    btree's `btree_detached_list_t` and freed by it in the background instead
+    of within the erase's transaction. */
+    virtual value_deleter_t *clone() const { return NULL; }
 
+protected:
     DISABLE_COPYING(value_deleter_t);
 };
 
+/* Subtrees that lie entirely within the range are unlinked rather than erased key
+by key.  If `deleter->clone()` isn't NULL, they are freed in the background (see
+`start_freeing_detached_subtrees()`), so the erase doesn't wait for them. */
 void btree_erase_range_generic(value_sizer_t<void> *sizer, btree_slice_t *slice,
                                key_tester_t *tester,
                                value_deleter_t *deleter,
@@ -56,4 +70,13 @@ void erase_all(value_sizer_t<void> *sizer, btree_slice_t *slice,
                signal_t *interruptor,
                bool release_superblock = true);
 
+/* Frees the subtrees on `slice`'s `btree_detached_list_t` with a clone of
+`deleter`, in a coroutine that holds `slice->drainer`.  Each block is freed in
+a transaction of its own that also takes it off the list, so if the coroutine
+is drained or the server crashes, whatever is left is still on the list.  Call
+this when a store starts, to finish what was left; range erases call it when
+they put subtrees on the list.  If a coroutine is freeing the list already, it
+goes on to the new subtrees instead of a second one starting. */
+void start_freeing_detached_subtrees(btree_slice_t *slice, const value_deleter_t *deleter);
+
 #endif  // BTREE_ERASE_RANGE_HPP_
@@ -1,5 +1,16 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include "btree/get_distribution.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "errors.hpp"
+#include <boost/bind.hpp>
+
+#include "arch/runtime/coroutines.hpp"
+#include "btree/key_sample.hpp"
+#include "btree/operations.hpp"
 #include "btree/parallel_traversal.hpp"
 #include "btree/node.hpp"
 #include "btree/leaf_node.hpp"
@@ -79,10 +90,116 @@ public:
     std::vector<store_key_t> *keys;
 };
 
-void get_btree_key_distribution(btree_slice_t *slice, transaction_t *txn, superblock_t *superblock, int depth_limit, int64_t *key_count_out, std::vector<store_key_t> *keys_out) {
-    get_distribution_traversal_helper_t helper(depth_limit, keys_out);
+class key_sample_seeding_helper_t : public btree_traversal_helper_t, public home_thread_mixin_debug_only_t {
+public:
+    explicit key_sample_seeding_helper_t(key_sample_seeder_t *_seeder) : seeder(_seeder) { }
+
+    void process_a_leaf(transaction_t *, buf_lock_t *leaf_node_buf,
+                        const btree_key_t *,
+                        const btree_key_t *,
+                        signal_t * /*interruptor*/,
+                        int * /*population_change_out*/) THROWS_ONLY(interrupted_exc_t) {
+        const leaf_node_t *node = reinterpret_cast<const leaf_node_t *>(leaf_node_buf->get_data_read());
+
+        for (auto it = leaf::begin(*node); it != leaf::end(*node); ++it) {
+            seeder->add((*it).first);
+        }
+    }
+
+    void postprocess_internal_node(buf_lock_t *) { }
+
+    void filter_interesting_children(transaction_t *, ranged_block_ids_t *ids_source, interesting_children_callback_t *cb) {
+        for (int i = 0, e = ids_source->num_block_ids(); i < e; ++i) {
+            cb->receive_interesting_child(i);
+        }
+        cb->no_more_interesting_children();
+    }
+
+    access_t btree_superblock_mode() {
+        return rwi_read;
+    }
+
+    access_t btree_node_mode() {
+        return rwi_read;
+    }
+
+private:
+    key_sample_seeder_t *seeder;
+};
+
+// Reads a snapshot of the whole btree to seed the key sample of a stat block
+// that predates it.  Until it's done, distribution reads walk the tree.
+static void seed_key_sample(btree_slice_t *slice, auto_drainer_t::lock_t keepalive) {
+    keepalive.assert_is_holding(&slice->drainer);
+    key_sample_seeder_t seeder;
+    try {
+        scoped_ptr_t<real_superblock_t> superblock;
+        scoped_ptr_t<transaction_t> txn;
+        get_btree_superblock_and_txn_for_reading(slice, rwi_read, order_token_t::ignore,
+                                                 CACHE_SNAPSHOTTED_YES, &superblock, &txn);
+        key_sample_seeding_helper_t helper(&seeder);
+        btree_parallel_traversal(txn.get(), superblock.get(), slice, &helper,
+                                 keepalive.get_drain_signal());
+    } catch (const interrupted_exc_t &) {
+        slice->key_sample_seeding = false;
+        return;
+    }
+
+    {
+        scoped_ptr_t<real_superblock_t> superblock;
+        scoped_ptr_t<transaction_t> txn;
+        get_btree_superblock_and_txn(slice, rwi_write, rwi_write, 1, repli_timestamp_t::distant_past,
+                                     order_token_t::ignore, WRITE_DURABILITY_SOFT, &superblock, &txn);
+        const block_id_t stat_block_id = superblock->get_stat_block_id();
+        if (stat_block_id != NULL_BLOCK_ID) {
+            buf_lock_t stat_block(txn.get(), stat_block_id, rwi_write, buffer_cache_order_mode_ignore);
+            superblock->release();
+            seeder.apply(static_cast<btree_statblock_t *>(stat_block.get_data_write()));
+        }
+    }
+    slice->key_sample_seeding = false;
+}
+
+size_t key_sample_size_for_distribution(size_t result_limit, const hash_region_t<key_range_t> &region) {
+    if (result_limit == 0) {
+        return 0;
+    }
+    const double share = static_cast<double>(region.end - region.beg) / HASH_REGION_HASH_SIZE;
+    return std::max<size_t>(1, static_cast<size_t>(ceil(result_limit * share)));
+}
+
+void get_btree_key_distribution(btree_slice_t *slice, transaction_t *txn, superblock_t *superblock, int depth_limit, size_t min_sample_size, int64_t *key_count_out, std::vector<store_key_t> *keys_out) {
     rassert(keys_out->empty(), "Why is this output parameter not an empty vector\n");
 
+    // The key sample doesn't need any I/O beyond the stat block, but it only
+    // has so many keys.  It's used when it has as many as the caller needs, or
+    // all of the keys in the btree; otherwise the walk gives a finer
+    // distribution.  Stat blocks that predate the sample get one seeded in
+    // the background, and meanwhile fall back to the walk.
+    const block_id_t stat_block_id = superblock->get_stat_block_id();
+    if (stat_block_id != NULL_BLOCK_ID && min_sample_size != 0) {
+        buf_lock_t stat_block(txn, stat_block_id, rwi_read, buffer_cache_order_mode_ignore);
+        const btree_statblock_t *stat_block_data = static_cast<const btree_statblock_t *>(stat_block.get_data_read());
+        if (!key_sample_is_valid(stat_block_data)) {
+            if (!slice->key_sample_seeding) {
+                slice->key_sample_seeding = true;
+                coro_t::spawn_sometime(boost::bind(&seed_key_sample, slice,
+                                                   auto_drainer_t::lock_t(&slice->drainer)));
+            }
+        } else {
+            get_key_sample(stat_block_data, keys_out);
+            if (keys_out->size() >= min_sample_size
+                || stat_block_data->key_sample.num_keys >= stat_block_data->population) {
+                superblock->release();
+                *key_count_out = stat_block_data->population;
+                return;
+            }
+            keys_out->clear();
+        }
+    }
+
+    get_distribution_traversal_helper_t helper(depth_limit, keys_out);
+
     cond_t non_interruptor;
     btree_parallel_traversal(txn, superblock, slice, &helper, &non_interruptor);
     *key_count_out = helper.key_count;
@@ -7,9 +7,18 @@
 #include "btree/keys.hpp"
 #include "btree/slice.hpp"
 #include "buffer_cache/types.hpp"
+#include "hash_region.hpp"
 
 class superblock_t;
 
-void get_btree_key_distribution(btree_slice_t *slice, transaction_t *txn, superblock_t *superblock, int depth_limit, int64_t *key_count_out, std::vector<store_key_t> *keys_out);
+/* The split points a distribution read asking for `result_limit` buckets can
+use from the store that holds `region`, which gets its share of the buckets of
+every hash shard.  Zero if there is no limit. */
+size_t key_sample_size_for_distribution(size_t result_limit, const hash_region_t<key_range_t> &region);
+
+/* Uses the key sample in the stat block if it has at least `min_sample_size`
+distinct keys, and walks the btree down to `depth_limit` otherwise.  Zero
+means the walk is always used. */
+void get_btree_key_distribution(btree_slice_t *slice, transaction_t *txn, superblock_t *superblock, int depth_limit, size_t min_sample_size, int64_t *key_count_out, std::vector<store_key_t> *keys_out);
 
 #endif /* BTREE_GET_DISTRIBUTION_HPP_ */
@@ -338,7 +338,33 @@ btree_internal_pair *get_pair_by_index(internal_node_t *node, int index) {
 }
 
 int get_offset_index(const internal_node_t *node, const btree_key_t *key) {
-    return std::lower_bound(node->pair_offsets, node->pair_offsets+node->npairs-1, (uint16_t) internal_key_comp::faux_offset, internal_key_comp(node, key)) - node->pair_offsets;
+    // This is `std::lower_bound()` over all pairs but the last one, except
+    // that comparisons skip the prefix that the keys at both ends of the
+    // remaining range share with `key`, and that the pairs for both possible
+    // next probes are prefetched while the current one is compared.
+    int beg = 0;
+    int end = node->npairs - 1;
+    int beg_common = 0;
+    int end_common = 0;
+    while (beg < end) {
+        const int mid = beg + (end - beg) / 2;
+        __builtin_prefetch(get_pair_by_index(node, beg + (mid - beg) / 2));
+        if (mid + 1 < end) {
+            __builtin_prefetch(get_pair_by_index(node, mid + 1 + (end - mid - 1) / 2));
+        }
+
+        int common;
+        const int res = btree_key_cmp_skip_prefix(&get_pair_by_index(node, mid)->key, key,
+                                                  std::min(beg_common, end_common), &common);
+        if (res < 0) {
+            beg = mid + 1;
+            beg_common = common;
+        } else {
+            end = mid;
+            end_common = common;
+        }
+    }
+    return beg;
 }
 
 int nodecmp(const internal_node_t *node1, const internal_node_t *node2) {
@@ -0,0 +1,202 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "btree/key_filter.hpp"
+
+#include <algorithm>
+
+#include "btree/leaf_node.hpp"
+#include "btree/node.hpp"
+#include "btree/operations.hpp"
+#include "btree/parallel_traversal.hpp"
+#include "btree/slice.hpp"
+#include "buffer_cache/buffer_cache.hpp"
+#include "config/args.hpp"
+
+// The finalizer of MurmurHash3, which spreads every input bit over the output.
+static uint64_t key_filter_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// We can't use `hash_region_hasher()`, because all the keys of a store hash to
+// the same hash shard.
+static void key_filter_hash(const btree_key_t *key, uint64_t *block_hash_out,
+                            uint64_t *bits_hash_out) {
+    *block_hash_out = btree_key_hash(key);
+    *bits_hash_out = key_filter_mix(*block_hash_out ^ 0x9e3779b97f4a7c15ULL);
+}
+
+bloom_filter_t::bloom_filter_t(int64_t capacity)
+    : capacity_(capacity), num_added_(0) {
+    guarantee(capacity > 0);
+    const int64_t bits_per_block = words_per_block * 64;
+    num_blocks = (capacity * KEY_FILTER_BITS_PER_KEY + bits_per_block - 1) / bits_per_block;
+    words.resize(num_blocks * words_per_block, 0);
+}
+
+void bloom_filter_t::add(const btree_key_t *key) {
+    uint64_t block_hash, bits_hash;
+    key_filter_hash(key, &block_hash, &bits_hash);
+    uint64_t *block = words.data() + block_offset(block_hash);
+    // Every hash picks one of the 512 bits of the block.
+    for (int i = 0; i < num_hashes; ++i) {
+        const uint64_t bit = (bits_hash >> (9 * i)) & 511;
+        block[bit / 64] |= 1ULL << (bit % 64);
+    }
+    ++num_added_;
+}
+
+bool bloom_filter_t::may_contain(const btree_key_t *key) const {
+    uint64_t block_hash, bits_hash;
+    key_filter_hash(key, &block_hash, &bits_hash);
+    const uint64_t *block = words.data() + block_offset(block_hash);
+    for (int i = 0; i < num_hashes; ++i) {
+        const uint64_t bit = (bits_hash >> (9 * i)) & 511;
+        if ((block[bit / 64] & (1ULL << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t bloom_filter_t::block_offset(uint64_t hash) const {
+    return (hash % num_blocks) * words_per_block;
+}
+
+key_filter_t::key_filter_t(btree_stats_t *_stats)
+    : stats(_stats), rebuilding(false), negative_lookups(0), false_positives(0) { }
+
+key_filter_t::~key_filter_t() {
+    assert_thread();
+}
+
+bool key_filter_t::may_contain(const btree_key_t *key) {
+    assert_thread();
+    if (!active.has() || active->may_contain(key)) {
+        return true;
+    }
+    ++negative_lookups;
+    stats->pm_keys_filtered.record();
+    stats->pm_key_filter_false_positives.record(0);
+    return false;
+}
+
+void key_filter_t::on_lookup(bool found) {
+    assert_thread();
+    if (!found && active.has()) {
+        ++negative_lookups;
+        ++false_positives;
+        stats->pm_key_filter_false_positives.record(1);
+    }
+}
+
+void key_filter_t::on_insert(const btree_key_t *key) {
+    assert_thread();
+    if (active.has()) {
+        active->add(key);
+    }
+    if (building.has()) {
+        building->add(key);
+    }
+}
+
+bool key_filter_t::needs_rebuild() const {
+    assert_thread();
+    if (rebuilding) {
+        return false;
+    }
+    return !active.has()
+        || active->num_added() > active->capacity()
+        || (negative_lookups >= KEY_FILTER_MIN_NEGATIVE_LOOKUPS
+            && false_positives > negative_lookups * KEY_FILTER_MAX_FALSE_POSITIVE_RATE);
+}
+
+bool key_filter_t::is_rebuilding() const {
+    assert_thread();
+    return rebuilding;
+}
+
+void key_filter_t::begin_rebuild() {
+    assert_thread();
+    guarantee(!rebuilding);
+    rebuilding = true;
+}
+
+void key_filter_t::start_collecting(int64_t expected_keys) {
+    assert_thread();
+    guarantee(rebuilding && !building.has());
+    building.init(new bloom_filter_t(std::max<int64_t>(KEY_FILTER_MIN_CAPACITY,
+                                                       expected_keys * KEY_FILTER_HEADROOM_FACTOR)));
+}
+
+void key_filter_t::add_scanned_key(const btree_key_t *key) {
+    assert_thread();
+    building->add(key);
+}
+
+void key_filter_t::finish_rebuild() {
+    assert_thread();
+    guarantee(rebuilding && building.has());
+    active.reset();
+    active.init(building.release());
+    rebuilding = false;
+    negative_lookups = 0;
+    false_positives = 0;
+}
+
+void key_filter_t::abandon_rebuild() {
+    assert_thread();
+    guarantee(rebuilding);
+    building.reset();
+    rebuilding = false;
+}
+
+int64_t get_btree_population(transaction_t *txn, superblock_t *superblock) {
+    const block_id_t stat_block_id = superblock->get_stat_block_id();
+    if (stat_block_id == NULL_BLOCK_ID) {
+        return 0;
+    }
+    buf_lock_t stat_block(txn, stat_block_id, rwi_read, buffer_cache_order_mode_ignore);
+    return static_cast<const btree_statblock_t *>(stat_block.get_data_read())->population;
+}
+
+class key_filter_traversal_helper_t : public btree_traversal_helper_t {
+public:
+    explicit key_filter_traversal_helper_t(key_filter_t *_key_filter)
+        : key_filter(_key_filter) { }
+
+    void process_a_leaf(transaction_t *, buf_lock_t *leaf_node_buf,
+                        const btree_key_t *, const btree_key_t *,
+                        signal_t *, int *) THROWS_ONLY(interrupted_exc_t) {
+        const leaf_node_t *node = static_cast<const leaf_node_t *>(leaf_node_buf->get_data_read());
+        for (auto it = leaf::begin(*node); it != leaf::end(*node); ++it) {
+            key_filter->add_scanned_key((*it).first);
+        }
+    }
+
+    void postprocess_internal_node(buf_lock_t *) { }
+
+    void filter_interesting_children(transaction_t *, ranged_block_ids_t *ids_source, interesting_children_callback_t *cb) {
+        for (int i = 0, e = ids_source->num_block_ids(); i < e; ++i) {
+            cb->receive_interesting_child(i);
+        }
+        cb->no_more_interesting_children();
+    }
+
+    access_t btree_superblock_mode() { return rwi_read; }
+    access_t btree_node_mode() { return rwi_read; }
+
+private:
+    key_filter_t *key_filter;
+};
+
+void build_key_filter(key_filter_t *key_filter, btree_slice_t *slice,
+                      transaction_t *txn, superblock_t *superblock,
+                      signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t) {
+    key_filter_traversal_helper_t helper(key_filter);
+    btree_parallel_traversal(txn, superblock, slice, &helper, interruptor);
+}
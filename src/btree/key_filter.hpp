@@ -0,0 +1,111 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef BTREE_KEY_FILTER_HPP_
+#define BTREE_KEY_FILTER_HPP_
+
+#include <vector>
+
+#include "buffer_cache/types.hpp"
+#include "containers/scoped.hpp"
+#include "utils.hpp"
+
+struct btree_key_t;
+class btree_slice_t;
+class btree_stats_t;
+class signal_t;
+class superblock_t;
+
+/* `bloom_filter_t` is a blocked Bloom filter: every key sets seven bits within
+a single 512-bit block, so a lookup touches one cache line. Keys can't be
+removed. */
+class bloom_filter_t {
+public:
+    // Sized for `capacity` keys at `KEY_FILTER_BITS_PER_KEY` bits per key.
+    explicit bloom_filter_t(int64_t capacity);
+
+    void add(const btree_key_t *key);
+    // False if `key` was certainly never added.
+    bool may_contain(const btree_key_t *key) const;
+
+    int64_t capacity() const { return capacity_; }
+    // How many times `add()` was called.
+    int64_t num_added() const { return num_added_; }
+
+private:
+    static const int num_hashes = 7;
+    static const int words_per_block = 8;
+
+    // The index in `words` of the block the key with this hash goes in.
+    size_t block_offset(uint64_t hash) const;
+
+    std::vector<uint64_t> words;
+    uint64_t num_blocks;
+    int64_t capacity_;
+    int64_t num_added_;
+
+    DISABLE_COPYING(bloom_filter_t);
+};
+
+/* `key_filter_t` holds a Bloom filter over the keys of a primary btree, which
+point reads use to skip walking the tree for keys that aren't there.
+
+The filter is (re)built by `build_key_filter()` from a snapshot of the tree,
+while every key inserted into the tree in the meantime is added to both the
+filter in use and the one being built. Until the first build has finished, the
+filter lets every key through. */
+class key_filter_t : public home_thread_mixin_debug_only_t {
+public:
+    explicit key_filter_t(btree_stats_t *stats);
+    ~key_filter_t();
+
+    /* Returns false if `key` is certainly not in the btree, in which case the
+    lookup can be skipped. */
+    bool may_contain(const btree_key_t *key);
+    /* Call this after looking up a key that `may_contain()` let through, so
+    that the false positive rate can be tracked. */
+    void on_lookup(bool found);
+    /* Call this when inserting a key that wasn't in the btree yet. */
+    void on_insert(const btree_key_t *key);
+
+    /* True if there is no usable filter yet, or the filter has seen so many
+    inserts or false positives that it should be rebuilt, and no rebuild is
+    running. */
+    bool needs_rebuild() const;
+    // True between `begin_rebuild()` and `finish_rebuild()`/`abandon_rebuild()`.
+    bool is_rebuilding() const;
+
+    /* A rebuild goes `begin_rebuild()`, `start_collecting()` (after which
+    inserts are recorded in the new filter), `add_scanned_key()` for every key
+    in a snapshot acquired after `start_collecting()`, and finally
+    `finish_rebuild()`, or `abandon_rebuild()` if it gets interrupted. */
+    void begin_rebuild();
+    void start_collecting(int64_t expected_keys);
+    void add_scanned_key(const btree_key_t *key);
+    void finish_rebuild();
+    void abandon_rebuild();
+
+private:
+    btree_stats_t *stats;
+
+    scoped_ptr_t<bloom_filter_t> active;
+    scoped_ptr_t<bloom_filter_t> building;
+    bool rebuilding;
+
+    // Lookups of missing keys since `active` was built, and how many of them
+    // `active` let through.
+    int64_t negative_lookups;
+    int64_t false_positives;
+
+    DISABLE_COPYING(key_filter_t);
+};
+
+/* Returns the number of keys the stat block of the tree records. */
+int64_t get_btree_population(transaction_t *txn, superblock_t *superblock);
+
+/* Adds every key in the tree to the filter that `key_filter` is building.
+`superblock` should have been acquired with a snapshot. */
+void build_key_filter(key_filter_t *key_filter, btree_slice_t *slice,
+                      transaction_t *txn, superblock_t *superblock,
+                      signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t);
+
+#endif  // BTREE_KEY_FILTER_HPP_
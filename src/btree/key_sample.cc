@@ -0,0 +1,150 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "btree/key_sample.hpp"
+
+#include <algorithm>
+
+#include "serializer/types.hpp"
+
+bool key_sample_is_valid(const btree_statblock_t *stat_block) {
+    // The stat block must fit in the smallest block a table can have, with
+    // room to spare for whatever it needs to hold next.
+    CT_ASSERT(sizeof(btree_statblock_t) + sizeof(ls_buf_data_t) + 768 <= MIN_BTREE_BLOCK_SIZE);
+    return stat_block->key_sample.magic == btree_key_sample_t::expected_magic;
+}
+
+static void add_to_key_sample(btree_key_sample_t *sample, int index, const btree_key_t *key) {
+    rassert(index < btree_key_sample_t::max_keys);
+    btree_key_sample_t::entry_t *entry = &sample->entries[index];
+    entry->key_hash = btree_key_hash(key);
+    entry->prefix_length = std::min<int>(key->size, btree_key_sample_t::prefix_size);
+    memcpy(entry->prefix, key->contents, entry->prefix_length);
+}
+
+void key_sample_on_insert(btree_statblock_t *stat_block, const btree_key_t *key) {
+    btree_key_sample_t *sample = &stat_block->key_sample;
+    if (!key_sample_is_valid(stat_block)) {
+        // Only an empty tree can start a sample that covers all of its keys.
+        if (stat_block->population != 1) {
+            return;
+        }
+        *sample = btree_key_sample_t();
+    }
+
+    const int64_t uncompensated = sample->deleted_from_sample + sample->deleted_outside_sample;
+    if (uncompensated == 0) {
+        // Plain reservoir sampling.
+        if (sample->num_keys < btree_key_sample_t::max_keys) {
+            add_to_key_sample(sample, sample->num_keys, key);
+            ++sample->num_keys;
+        } else if (randdouble() * stat_block->population < btree_key_sample_t::max_keys) {
+            add_to_key_sample(sample, randint(btree_key_sample_t::max_keys), key);
+        }
+    } else if (randdouble() * uncompensated < sample->deleted_from_sample) {
+        // The new key takes the place of a deleted key that was sampled.
+        add_to_key_sample(sample, sample->num_keys, key);
+        ++sample->num_keys;
+        --sample->deleted_from_sample;
+    } else {
+        --sample->deleted_outside_sample;
+    }
+}
+
+static void remove_from_key_sample(btree_key_sample_t *sample, int index) {
+    rassert(index < sample->num_keys);
+    sample->entries[index] = sample->entries[sample->num_keys - 1];
+    --sample->num_keys;
+}
+
+void key_sample_on_delete(btree_statblock_t *stat_block, const btree_key_t *key) {
+    if (stat_block->population == 0) {
+        stat_block->key_sample = btree_key_sample_t();
+        return;
+    }
+    if (!key_sample_is_valid(stat_block)) {
+        return;
+    }
+
+    btree_key_sample_t *sample = &stat_block->key_sample;
+    const uint64_t key_hash = btree_key_hash(key);
+    for (int i = 0; i < sample->num_keys; ++i) {
+        if (sample->entries[i].key_hash == key_hash) {
+            remove_from_key_sample(sample, i);
+            ++sample->deleted_from_sample;
+            return;
+        }
+    }
+    ++sample->deleted_outside_sample;
+}
+
+void get_key_sample(const btree_statblock_t *stat_block, std::vector<store_key_t> *keys_out) {
+    rassert(key_sample_is_valid(stat_block));
+    const btree_key_sample_t *sample = &stat_block->key_sample;
+    for (int i = 0; i < sample->num_keys; ++i) {
+        const btree_key_sample_t::entry_t *entry = &sample->entries[i];
+        keys_out->push_back(store_key_t(entry->prefix_length,
+                                        reinterpret_cast<const uint8_t *>(entry->prefix)));
+    }
+    std::sort(keys_out->begin(), keys_out->end());
+    keys_out->erase(std::unique(keys_out->begin(), keys_out->end()), keys_out->end());
+}
+
+key_sample_seeder_t::key_sample_seeder_t() : num_keys_seen(0) { }
+
+void key_sample_seeder_t::add(const btree_key_t *key) {
+    ++num_keys_seen;
+    if (sample.num_keys < btree_key_sample_t::max_keys) {
+        add_to_key_sample(&sample, sample.num_keys, key);
+        ++sample.num_keys;
+    } else if (randdouble() * num_keys_seen < btree_key_sample_t::max_keys) {
+        add_to_key_sample(&sample, randint(btree_key_sample_t::max_keys), key);
+    }
+}
+
+void key_sample_seeder_t::apply(btree_statblock_t *stat_block) const {
+    if (!key_sample_is_valid(stat_block)) {
+        stat_block->key_sample = sample;
+    }
+}
+
+key_sample_eraser_t::key_sample_eraser_t() : num_erased(0) { }
+
+void key_sample_eraser_t::init(const btree_statblock_t *stat_block) {
+    if (!key_sample_is_valid(stat_block)) {
+        return;
+    }
+    const btree_key_sample_t *sample = &stat_block->key_sample;
+    for (int i = 0; i < sample->num_keys; ++i) {
+        sampled_hashes.insert(sample->entries[i].key_hash);
+    }
+}
+
+void key_sample_eraser_t::on_erase(const btree_key_t *key) {
+    ++num_erased;
+    const uint64_t key_hash = btree_key_hash(key);
+    if (sampled_hashes.count(key_hash) != 0) {
+        erased_sampled_hashes.insert(key_hash);
+    }
+}
+
+void key_sample_eraser_t::apply(btree_statblock_t *stat_block) const {
+    if (stat_block->population == 0) {
+        stat_block->key_sample = btree_key_sample_t();
+        return;
+    }
+    if (!key_sample_is_valid(stat_block)) {
+        return;
+    }
+
+    btree_key_sample_t *sample = &stat_block->key_sample;
+    int64_t removed = 0;
+    for (int i = 0; i < sample->num_keys;) {
+        if (erased_sampled_hashes.count(sample->entries[i].key_hash) != 0) {
+            remove_from_key_sample(sample, i);
+            ++removed;
+        } else {
+            ++i;
+        }
+    }
+    sample->deleted_from_sample += removed;
+    sample->deleted_outside_sample += num_erased - removed;
+}
@@ -0,0 +1,69 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef BTREE_KEY_SAMPLE_HPP_
+#define BTREE_KEY_SAMPLE_HPP_
+
+#include <set>
+#include <vector>
+
+#include "btree/keys.hpp"
+#include "btree/node.hpp"
+
+/* These maintain the key sample in the stat block of a btree (see
+`btree_key_sample_t`).  Deletions are made up for by later insertions with
+random pairing (Gemulla, Lehner and Haas, "A dip in the reservoir"), so the
+sample stays uniform under any mix of insertions and deletions, instead of
+filling up with recently inserted keys. */
+
+/* False if the stat block predates the key sample, in which case the sample
+must not be used. */
+bool key_sample_is_valid(const btree_statblock_t *stat_block);
+
+/* Call these after updating `stat_block->population` for a key that was
+inserted into or deleted from the btree. */
+void key_sample_on_insert(btree_statblock_t *stat_block, const btree_key_t *key);
+void key_sample_on_delete(btree_statblock_t *stat_block, const btree_key_t *key);
+
+/* The distinct prefixes of the sampled keys, in order. */
+void get_key_sample(const btree_statblock_t *stat_block, std::vector<store_key_t> *keys_out);
+
+/* Stat blocks written before there was a key sample get one from a pass over
+the whole btree, which passes every key to `add()`, in any order.  Keys that
+are written while the pass goes on may be missed, or stay in the sample after
+they are deleted, which skews the sample a little. */
+class key_sample_seeder_t {
+public:
+    key_sample_seeder_t();
+
+    void add(const btree_key_t *key);
+    // Does nothing if `stat_block` got a valid sample in the meantime.
+    void apply(btree_statblock_t *stat_block) const;
+
+private:
+    btree_key_sample_t sample;
+    int64_t num_keys_seen;
+
+    DISABLE_COPYING(key_sample_seeder_t);
+};
+
+/* Range erases delete too many keys to update the stat block for each of
+them.  `key_sample_eraser_t` remembers which of the erased keys were in the
+sample, and `apply()` then updates the sample all at once. */
+class key_sample_eraser_t {
+public:
+    key_sample_eraser_t();
+
+    // Call this with the stat block as it was before the erase.
+    void init(const btree_statblock_t *stat_block);
+    void on_erase(const btree_key_t *key);
+    // Call this after the population of `stat_block` has been updated.
+    void apply(btree_statblock_t *stat_block) const;
+
+private:
+    std::set<uint64_t> sampled_hashes;
+    std::set<uint64_t> erased_sampled_hashes;
+    int64_t num_erased;
+
+    DISABLE_COPYING(key_sample_eraser_t);
+};
+
+#endif  // BTREE_KEY_SAMPLE_HPP_
@@ -1,6 +1,62 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include "btree/keys.hpp"
 
+#include <endian.h>
+
+#include <algorithm>
+
+int btree_key_cmp_skip_prefix(const btree_key_t *left, const btree_key_t *right,
+                              int known_common, int *common_out) {
+    const int min_size = std::min(left->size, right->size);
+    rassert(known_common <= min_size);
+    int i = known_common;
+
+    // Compare eight bytes at a time; the first differing byte is found from
+    // the lowest set bit of the XOR on little-endian machines and the highest
+    // one on big-endian machines.
+    while (i + static_cast<int>(sizeof(uint64_t)) <= min_size) {
+        uint64_t l, r;
+        memcpy(&l, left->contents + i, sizeof(l));
+        memcpy(&r, right->contents + i, sizeof(r));
+        const uint64_t diff = l ^ r;
+        if (diff != 0) {
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+            i += __builtin_ctzll(diff) / 8;
+#else
+            i += __builtin_clzll(diff) / 8;
+#endif
+            *common_out = i;
+            return static_cast<int>(left->contents[i]) - static_cast<int>(right->contents[i]);
+        }
+        i += sizeof(uint64_t);
+    }
+    while (i < min_size) {
+        if (left->contents[i] != right->contents[i]) {
+            *common_out = i;
+            return static_cast<int>(left->contents[i]) - static_cast<int>(right->contents[i]);
+        }
+        ++i;
+    }
+    *common_out = min_size;
+    return static_cast<int>(left->size) - static_cast<int>(right->size);
+}
+
+uint64_t btree_key_hash(const btree_key_t *key) {
+    // FNV-1a, followed by the finalizer of MurmurHash3 to spread every input
+    // bit over the output.
+    uint64_t h = 14695981039346656037ULL;
+    for (int i = 0; i < key->size; ++i) {
+        h ^= key->contents[i];
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
 bool unescaped_str_to_key(const char *str, int len, store_key_t *buf) {
     if (len <= MAX_KEY_SIZE) {
         memcpy(buf->contents(), str, len);
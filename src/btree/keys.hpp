@@ -34,6 +34,17 @@ inline int btree_key_cmp(const btree_key_t *left, const btree_key_t *right) {
     return sized_strcmp(left->contents, left->size, right->contents, right->size);
 }
 
+/* Compares `left` and `right` like `btree_key_cmp()`, given that their first
+`known_common` bytes are already known to be equal, and sets `*common_out` to the
+length of their longest common prefix. Binary searches use this to skip the
+prefix that every key between their current bounds shares with the search key. */
+int btree_key_cmp_skip_prefix(const btree_key_t *left, const btree_key_t *right,
+                              int known_common, int *common_out);
+
+/* A 64-bit hash of the contents of `key`.  It is stored on disk, so it must
+not change. */
+uint64_t btree_key_hash(const btree_key_t *key);
+
 struct store_key_t {
 public:
     store_key_t() {
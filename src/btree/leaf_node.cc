@@ -913,6 +913,31 @@ void move_elements(value_sizer_t<void> *sizer, leaf_node_t *fro, int beg, int en
     validate(sizer, tow);
 }
 
+// Sets `*separator_out` to the shortest key that is greater than or equal to
+// `left` and less than `right`.  The parent node only needs some key that
+// tells the two nodes apart, and a short one leaves more room in the internal
+// nodes.  Keys with long common prefixes (such as secondary index keys) shrink
+// to their common prefix plus one byte.
+void shortest_separator(const btree_key_t *left, const btree_key_t *right, btree_key_t *separator_out) {
+    rassert(sized_strcmp(left->contents, left->size, right->contents, right->size) < 0);
+
+    int common = 0;
+    while (common < left->size && common < right->size
+           && left->contents[common] == right->contents[common]) {
+        ++common;
+    }
+
+    // `right` is longer than `common`, since it's greater than `left`.  Its
+    // first `common + 1` bytes are greater than `left` and, unless they make up
+    // all of `right`, less than `right`.
+    if (common + 1 < right->size) {
+        separator_out->size = common + 1;
+        memcpy(separator_out->contents, right->contents, common + 1);
+    } else {
+        keycpy(separator_out, left);
+    }
+}
+
 void split(value_sizer_t<void> *sizer, leaf_node_t *node, leaf_node_t *rnode, btree_key_t *median_out) {
     int tstamp_back_offset;
     int mandatory = mandatory_cost(sizer, node, MANDATORY_TIMESTAMPS, &tstamp_back_offset);
@@ -985,7 +1010,9 @@ void split(value_sizer_t<void> *sizer, leaf_node_t *node, leaf_node_t *rnode, bt
     int node_copysize = end_rcost - num_mandatories * sizeof(uint16_t);
     move_elements(sizer, node, s, node->num_pairs, 0, rnode, node_copysize, tstamp_back_offset);
 
-    keycpy(median_out, entry_key(get_entry(node, node->pair_offsets[s - 1])));
+    shortest_separator(entry_key(get_entry(node, node->pair_offsets[node->num_pairs - 1])),
+                       entry_key(get_entry(rnode, rnode->pair_offsets[0])),
+                       median_out);
 }
 
 void merge(value_sizer_t<void> *sizer, leaf_node_t *left, leaf_node_t *right) {
@@ -1106,9 +1133,13 @@ bool level(value_sizer_t<void> *sizer, int nodecmp_node_with_sib, leaf_node_t *n
     guarantee(sibling->num_pairs > 0);
 
     if (nodecmp_node_with_sib < 0) {
-        keycpy(replacement_key_out, entry_key(get_entry(node, node->pair_offsets[node->num_pairs - 1])));
+        shortest_separator(entry_key(get_entry(node, node->pair_offsets[node->num_pairs - 1])),
+                           entry_key(get_entry(sibling, sibling->pair_offsets[0])),
+                           replacement_key_out);
     } else {
-        keycpy(replacement_key_out, entry_key(get_entry(sibling, sibling->pair_offsets[sibling->num_pairs - 1])));
+        shortest_separator(entry_key(get_entry(sibling, sibling->pair_offsets[sibling->num_pairs - 1])),
+                           entry_key(get_entry(node, node->pair_offsets[0])),
+                           replacement_key_out);
     }
 
     return true;
@@ -1128,20 +1159,36 @@ bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
     // beg == 0 or key > *(beg - 1).
     // end == num_pairs or key < *end.
 
+    // The lengths of the common prefixes of key with *(beg - 1) and *end.
+    // Every key in between shares the shorter of these prefixes with key, so
+    // comparisons can skip it.
+    int beg_common = 0;
+    int end_common = 0;
+
     while (beg < end) {
         // when (end - beg) > 0, (end - beg) / 2 is always less than (end - beg).  So beg <= test_point < end.
         int test_point = beg + (end - beg) / 2;
 
+        // Each probe is a dependent cache miss into the node body, so start
+        // loading both candidates for the next probe while we compare.
+        __builtin_prefetch(get_entry(node, node->pair_offsets[beg + (test_point - beg) / 2]));
+        if (test_point + 1 < end) {
+            __builtin_prefetch(get_entry(node, node->pair_offsets[test_point + 1 + (end - test_point - 1) / 2]));
+        }
+
         const btree_key_t *ek = entry_key(get_entry(node, node->pair_offsets[test_point]));
 
-        int res = sized_strcmp(key->contents, key->size, ek->contents, ek->size);
+        int common;
+        int res = btree_key_cmp_skip_prefix(key, ek, std::min(beg_common, end_common), &common);
 
         if (res < 0) {
             // key < *test_point.
             end = test_point;
+            end_common = common;
         } else if (res > 0) {
             // key > *test_point.  Since test_point < end, we have test_point + 1 <= end.
             beg = test_point + 1;
+            beg_common = common;
         } else {
             // We found the key!
             *index_out = test_point;
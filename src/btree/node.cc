@@ -8,6 +8,10 @@
 const block_magic_t btree_superblock_t::expected_magic = { { 's', 'u', 'p', 'e' } };
 const block_magic_t internal_node_t::expected_magic = { { 'i', 'n', 't', 'e' } };
 const block_magic_t btree_sindex_block_t::expected_magic = { { 's', 'i', 'n', 'd' } };
+const block_magic_t btree_key_sample_t::expected_magic = { { 'k', 's', 'm', 'p' } };
+const block_magic_t btree_detached_list_t::expected_magic = { { 'd', 'e', 't', 'l' } };
+const int btree_key_sample_t::max_keys;
+const int btree_key_sample_t::prefix_size;
 
 namespace node {
 
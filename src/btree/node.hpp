@@ -49,6 +49,48 @@ struct btree_superblock_t {
 
     char metainfo_blob[METAINFO_BLOB_MAXREFLEN];
 
+    // The sequence number of the last write-ahead log record whose write is
+    // reflected in this btree, or zero.  Superblocks are zeroed when they are
+    // created, so this is zero in stores that never had a log.
+    uint64_t applied_log_seqno;
+
+    // The first block of the btree's `btree_detached_list_t`, or zero if it
+    // doesn't have one yet.  (Block zero is always the main superblock.)
+    block_id_t detached_list_block;
+
+    static const block_magic_t expected_magic;
+} __attribute__((packed));
+
+/* A uniform random sample of the keys in the btree, which is kept up to date
+as keys are inserted and deleted so that the key distribution can be estimated
+without walking the tree.  See `btree/key_sample.hpp`.  Stat blocks written
+before there was a sample don't have the right `magic`; their sample is
+ignored until a background pass seeds it.  Entries take 32 bytes, which
+leaves about 1 KB of the smallest stat block for other fields. */
+struct btree_key_sample_t {
+    static const int max_keys = 96;
+    static const int prefix_size = 23;
+
+    struct entry_t {
+        // Identifies the key, since `prefix` may be truncated.
+        uint64_t key_hash;
+        uint8_t prefix_length;
+        char prefix[prefix_size];
+    } __attribute__((packed));
+
+    block_magic_t magic;
+    int32_t num_keys;
+    // Deletions that later insertions haven't made up for yet, of keys that
+    // were in the sample and of keys that weren't.
+    int64_t deleted_from_sample;
+    int64_t deleted_outside_sample;
+    entry_t entries[max_keys];
+
+    btree_key_sample_t()
+        : magic(expected_magic), num_keys(0),
+          deleted_from_sample(0), deleted_outside_sample(0)
+    { }
+
     static const block_magic_t expected_magic;
 } __attribute__((packed));
 
@@ -56,10 +98,12 @@ struct btree_statblock_t {
     //The total number of keys in the btree
     int64_t population;
 
+    btree_key_sample_t key_sample;
+
     btree_statblock_t()
         : population(0)
     { }
-};
+} __attribute__((packed));
 
 struct btree_sindex_block_t {
     static const int SINDEX_BLOB_MAXREFLEN = 4076;
@@ -70,6 +114,24 @@ struct btree_sindex_block_t {
     static const block_magic_t expected_magic;
 };
 
+/* The roots of subtrees that range erases have unlinked from the btree but
+not freed yet, kept on disk so that freeing them can pick up where it left off
+after a restart.  Blocks past the first one are chained through `next`; the
+first one is filled up before its entries are moved to a new block behind it,
+and refilled from the block behind it once it's empty. */
+struct btree_detached_list_t {
+    block_magic_t magic;
+    block_id_t next;
+    int32_t num_blocks;
+    block_id_t blocks[0];
+
+    static int capacity(block_size_t block_size) {
+        return (block_size.value() - sizeof(btree_detached_list_t)) / sizeof(block_id_t);
+    }
+
+    static const block_magic_t expected_magic;
+} __attribute__((packed));
+
 //Note: This struct is stored directly on disk.  Changing it invalidates old data.
 struct internal_node_t {
     block_magic_t magic;
@@ -52,6 +52,31 @@ void real_superblock_t::set_sindex_block_id(const block_id_t new_sindex_block) {
     sb_data->sindex_block = new_sindex_block;
 }
 
+block_id_t real_superblock_t::get_detached_list_block_id() const {
+    rassert(sb_buf_.is_acquired());
+    // Superblocks are zeroed when they are created.
+    const block_id_t block_id = static_cast<const btree_superblock_t *>(sb_buf_.get_data_read())->detached_list_block;
+    return block_id == 0 ? NULL_BLOCK_ID : block_id;
+}
+
+void real_superblock_t::set_detached_list_block_id(const block_id_t new_block_id) {
+    rassert(sb_buf_.is_acquired());
+    rassert(new_block_id != 0 && new_block_id != NULL_BLOCK_ID);
+    btree_superblock_t *sb_data = static_cast<btree_superblock_t *>(sb_buf_.get_data_write());
+    sb_data->detached_list_block = new_block_id;
+}
+
+uint64_t real_superblock_t::get_applied_log_seqno() const {
+    rassert(sb_buf_.is_acquired());
+    return static_cast<const btree_superblock_t *>(sb_buf_.get_data_read())->applied_log_seqno;
+}
+
+void real_superblock_t::set_applied_log_seqno(uint64_t seqno) {
+    rassert(sb_buf_.is_acquired());
+    btree_superblock_t *sb_data = static_cast<btree_superblock_t *>(sb_buf_.get_data_write());
+    sb_data->applied_log_seqno = seqno;
+}
+
 void real_superblock_t::set_eviction_priority(eviction_priority_t eviction_priority) {
     rassert(sb_buf_.is_acquired());
     sb_buf_.set_eviction_priority(eviction_priority);
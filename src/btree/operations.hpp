@@ -39,6 +39,10 @@ public:
     virtual block_id_t get_sindex_block_id() const = 0;
     virtual void set_sindex_block_id(block_id_t new_block_id) = 0;
 
+    // `NULL_BLOCK_ID` if there is no `btree_detached_list_t` yet.
+    virtual block_id_t get_detached_list_block_id() const = 0;
+    virtual void set_detached_list_block_id(block_id_t new_block_id) = 0;
+
     virtual void set_eviction_priority(eviction_priority_t eviction_priority) = 0;
     virtual eviction_priority_t get_eviction_priority() = 0;
 
@@ -64,6 +68,12 @@ public:
     block_id_t get_sindex_block_id() const;
     void set_sindex_block_id(block_id_t new_block_id);
 
+    block_id_t get_detached_list_block_id() const;
+    void set_detached_list_block_id(block_id_t new_block_id);
+
+    uint64_t get_applied_log_seqno() const;
+    void set_applied_log_seqno(uint64_t seqno);
+
     void set_eviction_priority(eviction_priority_t eviction_priority);
     eviction_priority_t get_eviction_priority();
 
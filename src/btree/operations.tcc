@@ -2,6 +2,7 @@
 #include "btree/operations.hpp"
 
 #include "btree/internal_node.hpp"
+#include "btree/key_sample.hpp"
 #include "btree/leaf_node.hpp"
 #include "btree/node.hpp"
 #include "btree/slice.hpp"
@@ -237,7 +238,13 @@ void apply_keyvalue_change(transaction_t *txn, keyvalue_location_t<Value> *kv_lo
 
     //Modify the stats block
     buf_lock_t stat_block(txn, kv_loc->stat_block, rwi_write, buffer_cache_order_mode_ignore);
-    reinterpret_cast<btree_statblock_t *>(stat_block.get_data_write())->population += population_change;
+    btree_statblock_t *stat_block_data = reinterpret_cast<btree_statblock_t *>(stat_block.get_data_write());
+    stat_block_data->population += population_change;
+    if (population_change > 0) {
+        key_sample_on_insert(stat_block_data, key);
+    } else if (population_change < 0) {
+        key_sample_on_delete(stat_block_data, key);
+    }
 }
 
 template <class Value>
@@ -635,3 +635,15 @@ progress_completion_fraction_t parallel_traversal_progress_t::guess_completion()
     return progress_completion_fraction_t(total_released_nodes, estimate_of_total_nodes);
 }
 
+double parallel_traversal_progress_t::guess_seconds_remaining() const {
+    assert_thread();
+    progress_completion_fraction_t fraction = guess_completion();
+    if (fraction.estimate_of_released_nodes <= 0
+        || fraction.estimate_of_total_nodes < fraction.estimate_of_released_nodes) {
+        return -1;
+    }
+
+    const double elapsed = ticks_to_secs(get_ticks() - start_time);
+    return elapsed * (fraction.estimate_of_total_nodes - fraction.estimate_of_released_nodes)
+        / fraction.estimate_of_released_nodes;
+}
@@ -137,7 +137,7 @@ void btree_parallel_traversal(transaction_t *txn,
 
 class parallel_traversal_progress_t : public traversal_progress_t {
 public:
-    parallel_traversal_progress_t() : height(-1) { }
+    parallel_traversal_progress_t() : height(-1), start_time(get_ticks()) { }
 
     enum action_t {
         LEARN,
@@ -155,6 +155,10 @@ public:
 
     progress_completion_fraction_t guess_completion() const;
 
+    /* Extrapolates the time the traversal has taken so far over the nodes it
+    hasn't released yet. Returns a negative number if there's no estimate. */
+    double guess_seconds_remaining() const;
+
 private:
     std::vector<int> learned; //How many nodes at each level we believe exist
     std::vector<int> acquired; //How many nodes at each level we've acquired
@@ -162,6 +166,8 @@ private:
 
     int height; //The height we've learned the tree has. Or -1 if we're still unsure;
 
+    ticks_t start_time;
+
     DISABLE_COPYING(parallel_traversal_progress_t);
 };
 
@@ -50,6 +50,9 @@ void btree_slice_t::create(cache_t *cache, block_id_t superblock_id, transaction
 
 btree_slice_t::btree_slice_t(cache_t *c, perfmon_collection_t *parent, const std::string &identifier, block_id_t _superblock_id)
     : stats(parent, identifier),
+      key_sample_seeding(false),
+      freeing_detached_subtrees(false),
+      detached_subtrees_pending(false),
       cache_(c),
       superblock_id_(_superblock_id),
       root_eviction_priority(INITIAL_ROOT_EVICTION_PRIORITY) {
@@ -59,3 +62,7 @@ btree_slice_t::btree_slice_t(cache_t *c, perfmon_collection_t *parent, const std
 }
 
 btree_slice_t::~btree_slice_t() { }
+
+block_id_t btree_slice_t::get_superblock_id() {
+    return superblock_id_;
+}
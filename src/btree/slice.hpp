@@ -5,7 +5,9 @@
 #include <string>
 #include <vector>
 
+#include "btree/key_filter.hpp"
 #include "buffer_cache/types.hpp"
+#include "concurrency/auto_drainer.hpp"
 #include "concurrency/fifo_checker.hpp"
 #include "containers/scoped.hpp"
 #include "perfmon/perfmon.hpp"
@@ -23,10 +25,14 @@ public:
           pm_keys_read(secs_to_ticks(1)),
           pm_keys_set(secs_to_ticks(1)),
           pm_keys_expired(secs_to_ticks(1)),
+          pm_keys_filtered(secs_to_ticks(1)),
+          pm_key_filter_false_positives(secs_to_ticks(1), false),
           pm_keys_membership(&btree_collection,
               &pm_keys_read, "keys_read",
               &pm_keys_set, "keys_set",
               &pm_keys_expired, "keys_expired",
+              &pm_keys_filtered, "keys_filtered",
+              &pm_key_filter_false_positives, "key_filter_false_positive_rate",
               NULLPTR)
     { }
 
@@ -35,7 +41,13 @@ public:
     perfmon_rate_monitor_t
         pm_keys_read,
         pm_keys_set,
-        pm_keys_expired;
+        pm_keys_expired,
+        // Lookups the key filter answered without walking the tree.
+        pm_keys_filtered;
+    // Records 1 for every lookup of a missing key that got past the key
+    // filter and 0 for every one it answered, so the mean is the false
+    // positive rate.
+    perfmon_sampler_t pm_key_filter_false_positives;
     perfmon_multi_membership_t pm_keys_membership;
 };
 
@@ -69,6 +81,18 @@ public:
     btree_stats_t stats;
 
     block_id_t get_superblock_id();
+
+    // Only set up for primary btrees of stores that use key filters.
+    scoped_ptr_t<key_filter_t> key_filter;
+
+    // Set while a background pass seeds the key sample in the stat block.
+    bool key_sample_seeding;
+
+    // Set while subtrees on the `btree_detached_list_t` are being freed in the
+    // background, and when more have been added since the freeing started;
+    // see `start_freeing_detached_subtrees()`.
+    bool freeing_detached_subtrees;
+    bool detached_subtrees_pending;
 private:
     cache_t *cache_;
 
@@ -82,6 +106,11 @@ private:
     //Information for cache eviction
 public:
     eviction_priority_t root_eviction_priority;
+
+    // Held by work that goes on in the background after the operation that
+    // started it, like freeing the subtrees a range erase unlinked.  It's
+    // destroyed first, so the cache is still there while it drains.
+    auto_drainer_t drainer;
 };
 
 #endif /* BTREE_SLICE_HPP_ */
@@ -42,6 +42,14 @@ public:
         sub_superblock->set_stat_block_id(new_stat_block);
     }
 
+    block_id_t get_detached_list_block_id() const {
+        return sub_superblock->get_detached_list_block_id();
+    }
+
+    void set_detached_list_block_id(block_id_t new_block_id) {
+        sub_superblock->set_detached_list_block_id(new_block_id);
+    }
+
     void set_eviction_priority(eviction_priority_t eviction_priority) {
         sub_superblock->set_eviction_priority(eviction_priority);
     }
@@ -0,0 +1,277 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "btree/write_ahead_log.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/crc.hpp>
+
+#include "arch/io/disk.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/thread_pool.hpp"
+#include "concurrency/wait_any.hpp"
+#include "config/args.hpp"
+
+static bool record_seqno_less(const write_ahead_log_t::record_t &a,
+                              const write_ahead_log_t::record_t &b) {
+    return a.seqno < b.seqno;
+}
+
+write_ahead_log_t::write_ahead_log_t(const std::string &_path,
+                                     std::vector<record_t> *records_out)
+    : path(_path), active_file(0), active_file_size(0),
+      retired_file_is_empty(true), retired_seqno(0),
+      last_appended_seqno(0), durable_seqno(0), flush_running(false) {
+    records_out->clear();
+    for (int i = 0; i < 2; ++i) {
+        const std::string filename = file_name(path, i);
+        int res;
+        do {
+            res = ::open(filename.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        } while (res == -1 && errno == EINTR);
+        guarantee_err(res != -1, "Could not open the write-ahead log file %s",
+                      filename.c_str());
+        files[i].reset(res);
+
+        int errsv;
+        thread_pool_t::run_in_blocker_pool(boost::bind(&write_ahead_log_t::load_file_blocking,
+                                                       files[i].get(), records_out, &errsv));
+        guarantee_xerr(errsv == 0, errsv, "Could not read the write-ahead log file %s",
+                       filename.c_str());
+    }
+    std::sort(records_out->begin(), records_out->end(), &record_seqno_less);
+}
+
+write_ahead_log_t::~write_ahead_log_t() {
+    assert_thread();
+}
+
+bool write_ahead_log_t::exists(const std::string &path) {
+    for (int i = 0; i < 2; ++i) {
+        if (::access(file_name(path, i).c_str(), F_OK) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void write_ahead_log_t::remove(const std::string &path) {
+    for (int i = 0; i < 2; ++i) {
+        const std::string filename = file_name(path, i);
+        const int res = ::unlink(filename.c_str());
+        guarantee_err(res == 0 || errno == ENOENT,
+                      "Could not remove the write-ahead log file %s", filename.c_str());
+    }
+}
+
+void write_ahead_log_t::discard_all() {
+    assert_thread();
+    rassert(!flush_running && pending.empty());
+    truncate_file(0);
+    truncate_file(1);
+    active_file = 0;
+    active_file_size = 0;
+    retired_file_is_empty = true;
+}
+
+void write_ahead_log_t::append(uint64_t seqno, const std::vector<char> &payload) {
+    assert_thread();
+    rassert(seqno > last_appended_seqno);
+
+    record_header_t header;
+    header.seqno = seqno;
+    header.payload_size = payload.size();
+    header.crc = compute_crc(seqno, payload.data(), payload.size());
+
+    const char *header_bytes = reinterpret_cast<const char *>(&header);
+    pending.insert(pending.end(), header_bytes, header_bytes + sizeof(header));
+    pending.insert(pending.end(), payload.begin(), payload.end());
+    active_file_size += sizeof(header) + payload.size();
+    last_appended_seqno = seqno;
+
+    if (!flush_running) {
+        flush_running = true;
+        coro_t::spawn_sometime(boost::bind(&write_ahead_log_t::flush, this,
+                                           auto_drainer_t::lock_t(&drainer)));
+    }
+}
+
+void write_ahead_log_t::wait_durable(uint64_t seqno, signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t) {
+    assert_thread();
+    if (seqno <= durable_seqno) {
+        return;
+    }
+
+    cond_t durable;
+    std::multimap<uint64_t, cond_t *>::iterator it
+        = durable_waiters.insert(std::make_pair(seqno, &durable));
+    try {
+        wait_interruptible(&durable, interruptor);
+    } catch (const interrupted_exc_t &) {
+        if (!durable.is_pulsed()) {
+            durable_waiters.erase(it);
+        }
+        throw;
+    }
+}
+
+bool write_ahead_log_t::needs_checkpoint() const {
+    return retired_file_is_empty && active_file_size >= WRITE_AHEAD_LOG_CHECKPOINT_SIZE;
+}
+
+uint64_t write_ahead_log_t::retire_active_file() {
+    assert_thread();
+    guarantee(retired_file_is_empty);
+    active_file = 1 - active_file;
+    active_file_size = 0;
+    retired_file_is_empty = false;
+    retired_seqno = last_appended_seqno;
+    return retired_seqno;
+}
+
+void write_ahead_log_t::truncate_retired_file(signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t) {
+    assert_thread();
+    rassert(!retired_file_is_empty);
+
+    // Batches are written one at a time, so once the last retired record is
+    // durable, nothing is being written to the retired file anymore.
+    wait_durable(retired_seqno, interruptor);
+    truncate_file(1 - active_file);
+    retired_file_is_empty = true;
+}
+
+std::string write_ahead_log_t::file_name(const std::string &path, int index) {
+    return strprintf("%s.%d", path.c_str(), index);
+}
+
+uint32_t write_ahead_log_t::compute_crc(uint64_t seqno, const char *payload, size_t size) {
+    boost::crc_32_type crc_computer;
+    crc_computer.process_bytes(&seqno, sizeof(seqno));
+    crc_computer.process_bytes(payload, size);
+    return crc_computer.checksum();
+}
+
+void write_ahead_log_t::load_file_blocking(fd_t fd, std::vector<record_t> *records_out,
+                                           int *errsv_out) {
+    std::vector<char> contents;
+    char buf[64 * KILOBYTE];
+    for (;;) {
+        ssize_t res = ::pread(fd, buf, sizeof(buf), contents.size());
+        if (res == -1 && errno == EINTR) {
+            continue;
+        } else if (res == -1) {
+            *errsv_out = errno;
+            return;
+        } else if (res == 0) {
+            break;
+        }
+        contents.insert(contents.end(), buf, buf + res);
+    }
+
+    size_t offset = 0;
+    while (contents.size() - offset >= sizeof(record_header_t)) {
+        record_header_t header;
+        memcpy(&header, contents.data() + offset, sizeof(header));
+        const char *payload = contents.data() + offset + sizeof(header);
+        if (contents.size() - offset - sizeof(header) < header.payload_size
+            || compute_crc(header.seqno, payload, header.payload_size) != header.crc) {
+            break;
+        }
+        record_t record;
+        record.seqno = header.seqno;
+        record.payload.assign(payload, payload + header.payload_size);
+        records_out->push_back(record);
+        offset += sizeof(header) + header.payload_size;
+    }
+
+    // Cut off a torn tail, so that records appended later on are not hidden
+    // behind it.
+    if (offset != contents.size()) {
+        int res;
+        do {
+            res = ::ftruncate(fd, offset);
+        } while (res == -1 && errno == EINTR);
+        if (res == -1) {
+            *errsv_out = errno;
+            return;
+        }
+    }
+    *errsv_out = 0;
+}
+
+void write_ahead_log_t::write_blocking(fd_t fd, const std::vector<char> *data,
+                                       int *errsv_out) {
+    size_t written = 0;
+    while (written < data->size()) {
+        ssize_t res = ::write(fd, data->data() + written, data->size() - written);
+        if (res == -1 && errno == EINTR) {
+            continue;
+        } else if (res == -1) {
+            *errsv_out = errno;
+            return;
+        }
+        written += res;
+    }
+    *errsv_out = perform_datasync(fd);
+}
+
+void write_ahead_log_t::truncate_blocking(fd_t fd, int *errsv_out) {
+    int res;
+    do {
+        res = ::ftruncate(fd, 0);
+    } while (res == -1 && errno == EINTR);
+    if (res == -1) {
+        *errsv_out = errno;
+        return;
+    }
+    *errsv_out = perform_datasync(fd);
+}
+
+void write_ahead_log_t::truncate_file(int index) {
+    int errsv;
+    thread_pool_t::run_in_blocker_pool(boost::bind(&write_ahead_log_t::truncate_blocking,
+                                                   files[index].get(), &errsv));
+    guarantee_xerr(errsv == 0, errsv, "Could not truncate the write-ahead log file %s.%d",
+                   path.c_str(), index);
+}
+
+void write_ahead_log_t::flush(UNUSED auto_drainer_t::lock_t keepalive) {
+    assert_thread();
+    rassert(flush_running);
+
+    // Everything appended while a batch is being written goes out with the
+    // next batch.
+    while (!pending.empty()) {
+        std::vector<char> batch;
+        batch.swap(pending);
+        const uint64_t batch_seqno = last_appended_seqno;
+        const int batch_file = active_file;
+
+        int errsv;
+        thread_pool_t::run_in_blocker_pool(boost::bind(&write_ahead_log_t::write_blocking,
+                                                       files[batch_file].get(), &batch, &errsv));
+        guarantee_xerr(errsv == 0, errsv, "Could not write to the write-ahead log file %s.%d",
+                       path.c_str(), batch_file);
+
+        durable_seqno = batch_seqno;
+        pulse_durable_waiters();
+    }
+
+    flush_running = false;
+}
+
+void write_ahead_log_t::pulse_durable_waiters() {
+    std::multimap<uint64_t, cond_t *>::iterator end
+        = durable_waiters.upper_bound(durable_seqno);
+    for (std::multimap<uint64_t, cond_t *>::iterator it = durable_waiters.begin();
+         it != end; ++it) {
+        it->second->pulse();
+    }
+    durable_waiters.erase(durable_waiters.begin(), end);
+}
@@ -0,0 +1,106 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef BTREE_WRITE_AHEAD_LOG_HPP_
+#define BTREE_WRITE_AHEAD_LOG_HPP_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "arch/io/io_utils.hpp"
+#include "concurrency/auto_drainer.hpp"
+#include "concurrency/cond_var.hpp"
+#include "containers/scoped.hpp"
+#include "utils.hpp"
+
+/* `write_ahead_log_t` is an append-only log of the logical writes a store has
+applied with soft durability. Appended records are buffered in memory and
+written out by a single flusher coroutine, which appends everything buffered
+so far with one `write()` and one `fdatasync()`, so concurrent writers share
+the cost of the sync.
+
+The log alternates between two files, `<path>.0` and `<path>.1`. Once the
+active file grows past `WRITE_AHEAD_LOG_CHECKPOINT_SIZE`, the owner calls
+`retire_active_file()`, makes sure every retired record is reflected in a
+durable btree, and then calls `truncate_retired_file()`.
+
+Every record is stored as a `record_header_t` followed by its payload. Records
+whose checksum doesn't match (e.g. a write torn by a crash) end the file. */
+class write_ahead_log_t : public home_thread_mixin_t {
+public:
+    struct record_t {
+        uint64_t seqno;
+        std::vector<char> payload;
+    };
+
+    /* Opens (or creates) the log files and returns every intact record they
+    hold in `*records_out`, sorted by sequence number. */
+    write_ahead_log_t(const std::string &path, std::vector<record_t> *records_out);
+    ~write_ahead_log_t();
+
+    /* Whether any of the log files at `path` exist. */
+    static bool exists(const std::string &path);
+
+    /* Deletes the log files at `path`, if there are any. */
+    static void remove(const std::string &path);
+
+    /* Empties both log files. Only call this while nothing is appended. */
+    void discard_all();
+
+    /* Buffers a record; sequence numbers must be appended in increasing order.
+    Use `wait_durable()` to find out when it has reached the disk. */
+    void append(uint64_t seqno, const std::vector<char> &payload);
+
+    void wait_durable(uint64_t seqno, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t);
+
+    /* True if the active file has grown large enough that the log should be
+    checkpointed and no checkpoint is in progress. */
+    bool needs_checkpoint() const;
+
+    /* Directs further appends to the other log file. Returns the greatest
+    sequence number appended to the file that was just retired. */
+    uint64_t retire_active_file();
+
+    /* Empties the retired file once all of its records have reached the disk. */
+    void truncate_retired_file(signal_t *interruptor) THROWS_ONLY(interrupted_exc_t);
+
+private:
+    struct record_header_t {
+        uint64_t seqno;
+        uint32_t payload_size;
+        uint32_t crc;
+    } __attribute__((packed));
+
+    static std::string file_name(const std::string &path, int index);
+
+    static uint32_t compute_crc(uint64_t seqno, const char *payload, size_t size);
+
+    static void load_file_blocking(fd_t fd, std::vector<record_t> *records_out,
+                                   int *errsv_out);
+    static void write_blocking(fd_t fd, const std::vector<char> *data, int *errsv_out);
+    static void truncate_blocking(fd_t fd, int *errsv_out);
+
+    void truncate_file(int index);
+    void flush(auto_drainer_t::lock_t keepalive);
+    void pulse_durable_waiters();
+
+    const std::string path;
+    scoped_fd_t files[2];
+    int active_file;
+    int64_t active_file_size;
+    bool retired_file_is_empty;
+    uint64_t retired_seqno;
+
+    // Records appended since the flusher last took the buffer.
+    std::vector<char> pending;
+    uint64_t last_appended_seqno;
+    uint64_t durable_seqno;
+    bool flush_running;
+
+    std::multimap<uint64_t, cond_t *> durable_waiters;
+
+    auto_drainer_t drainer;
+
+    DISABLE_COPYING(write_ahead_log_t);
+};
+
+#endif  // BTREE_WRITE_AHEAD_LOG_HPP_
@@ -15,6 +15,11 @@ flush_time_randomizer_t::flush_time_randomizer_t(int _flush_timer_ms)
     guarantee(flush_timer_ms > 0 || flush_timer_ms == NEVER_FLUSH);
 }
 
+void flush_time_randomizer_t::set_flush_timer_ms(int _flush_timer_ms) {
+    guarantee(_flush_timer_ms > 0 || _flush_timer_ms == NEVER_FLUSH);
+    flush_timer_ms = _flush_timer_ms;
+}
+
 int flush_time_randomizer_t::next_time_interval() {
     guarantee(flush_timer_ms != NEVER_FLUSH);
 
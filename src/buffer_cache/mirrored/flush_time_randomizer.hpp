@@ -20,10 +20,13 @@ public:
 
     // returns flush_timer_ms == 0, meaning we flush immediately.
     inline bool is_zero() const { return flush_timer_ms == 0; }
+
+    // Changes the flush interval used from now on.
+    void set_flush_timer_ms(int _flush_timer_ms);
 private:
     rng_t rng;
 
-    const int flush_timer_ms;
+    int flush_timer_ms;
     const int first_time_interval;
     bool done_first_time_interval;
 
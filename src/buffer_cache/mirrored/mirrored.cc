@@ -613,6 +613,11 @@ void mc_buf_lock_t::initialize(file_account_t *io_account,
         inner_buf->cache->stats->pm_bufs_acquiring.begin(&lock_start_time);
         inner_buf->lock.co_lock(mode == rwi_read_outdated_ok ? rwi_read : mode, call_when_in_line);
         inner_buf->cache->stats->pm_bufs_acquiring.end(&lock_start_time);
+        if (lock_start_time != 0) {
+            // Only timed when full perfmon is on, like `pm_bufs_acquiring`.
+            inner_buf->cache->stats->pm_bufs_acquiring_latency.record(
+                ticks_to_secs(get_ticks() - lock_start_time));
+        }
 
         // Update version_to_access since the callback might have modified it:
         version_to_access = parent_transaction->snapshot_version;
@@ -1306,6 +1311,12 @@ block_size_t mc_cache_t::get_block_size() const {
     return serializer->get_block_size();
 }
 
+void mc_cache_t::set_flush_timer_ms(int flush_timer_ms) {
+    assert_thread();
+    dynamic_config.flush_timer_ms = flush_timer_ms;
+    writeback.set_flush_timer_ms(flush_timer_ms);
+}
+
 void mc_cache_t::register_snapshot(mc_transaction_t *txn) {
     ++stats->pm_registered_snapshots;
     rassert(txn->snapshot_version == mc_inner_buf_t::faux_version_id, "Snapshot has been already created for this transaction");
@@ -331,6 +331,10 @@ public:
 
     block_size_t get_block_size() const;
 
+    // Overrides the `flush_timer_ms` of the configuration the cache was
+    // created with.
+    void set_flush_timer_ms(int flush_timer_ms);
+
     // TODO: Come up with a consistent priority scheme, i.e. define a "default" priority etc.
     // TODO: As soon as we can support it, we might consider supporting a mem_cap paremeter.
     void create_cache_account(int priority, scoped_ptr_t<mc_cache_account_t> *out);
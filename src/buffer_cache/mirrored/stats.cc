@@ -31,6 +31,7 @@ mc_cache_stats_t::mc_cache_stats_t(perfmon_collection_t *parent)
       pm_cache_misses(),
       pm_bufs_acquiring(secs_to_ticks(1)),
       pm_bufs_held(secs_to_ticks(1)),
+      pm_bufs_acquiring_latency(secs_to_ticks(1)),
       pm_transactions_starting(secs_to_ticks(1)),
       pm_transactions_active(secs_to_ticks(1)),
       pm_transactions_committing(secs_to_ticks(1)),
@@ -38,7 +39,12 @@ mc_cache_stats_t::mc_cache_stats_t(perfmon_collection_t *parent)
       pm_flushes_writing(secs_to_ticks(60)),
       pm_flushes_blocks(secs_to_ticks(1), true),
       pm_flushes_blocks_dirty(secs_to_ticks(1), true),
+      pm_flushes_commits(secs_to_ticks(1), true),
+      pm_flushes_lag(secs_to_ticks(60), false),
+      pm_flushes_bandwidth(secs_to_ticks(60), false),
+      pm_blocks_dirtied(secs_to_ticks(1)),
       pm_throttling_waiting(secs_to_ticks(10)),
+      pm_throttling_delay(secs_to_ticks(1), true),
       pm_n_blocks_in_memory(),
       pm_n_blocks_dirty(),
       pm_n_blocks_total(),
@@ -52,14 +58,20 @@ mc_cache_stats_t::mc_cache_stats_t(perfmon_collection_t *parent)
           &pm_cache_misses, "cache_misses",
           &pm_bufs_acquiring, "bufs_acquiring",
           &pm_bufs_held, "bufs_held",
+          &pm_bufs_acquiring_latency, "bufs_acquiring_latency",
           &pm_transactions_starting, "transactions_starting",
           &pm_transactions_active, "transactions_active",
           &pm_transactions_committing, "transactions_committing",
           &pm_throttling_waiting, "throttling_waiting",
+          &pm_throttling_delay, "throttling_delay",
           &pm_flushes_locking, "flushes_locking",
           &pm_flushes_writing, "flushes_writing",
           &pm_flushes_blocks, "flushes_blocks",
           &pm_flushes_blocks_dirty, "flushes_blocks_need_flush",
+          &pm_flushes_commits, "flushes_commits",
+          &pm_flushes_lag, "flushes_lag",
+          &pm_flushes_bandwidth, "flushes_bandwidth",
+          &pm_blocks_dirtied, "blocks_dirtied",
           &pm_n_blocks_in_memory, "blocks_in_memory",
           &pm_n_blocks_dirty, "blocks_dirty",
           &pm_n_blocks_total, "blocks_total",
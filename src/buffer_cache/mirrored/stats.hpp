@@ -25,6 +25,8 @@ struct mc_cache_stats_t {
         pm_bufs_acquiring,
         pm_bufs_held;
 
+    perfmon_histogram_t pm_bufs_acquiring_latency;
+
     perfmon_duration_sampler_t
         pm_transactions_starting,
         pm_transactions_active,
@@ -39,10 +41,25 @@ struct mc_cache_stats_t {
     perfmon_sampler_t
         pm_flushes_blocks,
         pm_flushes_blocks_dirty;
+
+    // How many waiting commits (mostly hard-durability writes) each flush that
+    // had any served
+    perfmon_sampler_t pm_flushes_commits;
     
+    // How long (in seconds) the oldest change a flush wrote had been waiting in memory
+    perfmon_sampler_t pm_flushes_lag;
+    // How fast flushes wrote out blocks (in blocks per second)
+    perfmon_sampler_t pm_flushes_bandwidth;
+    // How many blocks per second became dirty
+    perfmon_rate_monitor_t pm_blocks_dirtied;
+
     perfmon_duration_sampler_t
         pm_throttling_waiting;
 
+    // How long (in milliseconds) write transactions were delayed because of
+    // the amount of dirty data
+    perfmon_sampler_t pm_throttling_delay;
+
     perfmon_counter_t
         pm_n_blocks_in_memory,
         pm_n_blocks_dirty,
@@ -8,6 +8,7 @@
 
 #include "arch/runtime/coroutines.hpp"
 #include "arch/runtime/runtime.hpp"
+#include "arch/timing.hpp"
 #include "buffer_cache/mirrored/mirrored.hpp"
 #include "containers/scoped.hpp"
 #include "perfmon/perfmon.hpp"
@@ -29,6 +30,10 @@ writeback_t::writeback_t(
     flush_time_randomizer(_flush_timer_ms),
     flush_threshold(_flush_threshold),
     flush_timer(NULL),
+    group_commit_timer(NULL),
+    avg_flush_write_ms(0),
+    avg_flush_blocks_per_ms(0),
+    oldest_dirty_time(0),
     writeback_in_progress(false),
     active_flushes(0),
     dirty_block_semaphore(_max_dirty_blocks),
@@ -38,6 +43,7 @@ writeback_t::writeback_t(
 
     rassert(max_dirty_blocks >= 10); // sanity check: you really don't want to have less than this.
                                      // 10 is rather arbitrary.
+    group_commit_callback.parent = this;
 }
 
 writeback_t::~writeback_t() {
@@ -48,6 +54,10 @@ writeback_t::~writeback_t() {
         cancel_timer(flush_timer);
         flush_timer = NULL;
     }
+    if (group_commit_timer != NULL) {
+        cancel_timer(group_commit_timer);
+        group_commit_timer = NULL;
+    }
 }
 
 writeback_t::local_buf_t::local_buf_t() {
@@ -103,6 +113,16 @@ void writeback_t::begin_transaction(mc_transaction_t *txn) {
         {
             ticks_t start_time;
             cache->stats->pm_throttling_waiting.begin(&start_time);
+            mutex_t::acq_t throttle_acq(&throttle_mutex);
+            const int64_t delay_ms = throttling_delay_ms();
+            if (delay_ms > 0) {
+                // Don't hold up everyone else (in particular `rwi_read_sync`
+                // transactions, which never nap) while we sleep.
+                throttle_acq.reset();
+                cache->stats->pm_throttling_delay.record(delay_ms);
+                nap(delay_ms);
+                throttle_acq.reset(&throttle_mutex);
+            }
             txn->throttling_acq.init(
                     new semaphore_acq_t(&dirty_block_semaphore, txn->expected_change_count));
             cache->stats->pm_throttling_waiting.end(&start_time);
@@ -115,8 +135,11 @@ void writeback_t::begin_transaction(mc_transaction_t *txn) {
         /* Throttling */
         // This 1 is just a dummy thing, so we go through the throttling queue and thereby
         // guarantee that write transactions do not get re-ordered relative to us.
-        txn->throttling_acq.init(
-                new semaphore_acq_t(&dirty_block_semaphore, 1));
+        {
+            mutex_t::acq_t throttle_acq(&throttle_mutex);
+            txn->throttling_acq.init(
+                    new semaphore_acq_t(&dirty_block_semaphore, 1));
+        }
 
         /* Acquire flush lock in non-exclusive mode */
         flush_lock.co_lock(rwi_read);
@@ -132,6 +155,10 @@ void writeback_t::begin_transaction(mc_transaction_t *txn) {
     }
 }
 
+void writeback_t::set_flush_timer_ms(unsigned int flush_timer_ms) {
+    flush_time_randomizer.set_flush_timer_ms(flush_timer_ms);
+}
+
 void writeback_t::on_transaction_commit(mc_transaction_t *txn) {
     if (txn->get_access() == rwi_write) {
         txn->throttling_acq.reset();
@@ -144,8 +171,11 @@ void writeback_t::on_transaction_commit(mc_transaction_t *txn) {
             sync(NULL);
         } else if (num_dirty_blocks() > 0 && flush_time_randomizer.is_zero()) {
             sync(NULL);
-        } else if (!sync_callbacks.empty()) {
+        } else if (num_dirty_blocks() >= trickle_threshold() && !writeback_in_progress
+                   && !flush_time_randomizer.is_never_flush()) {
             sync(NULL);
+        } else if (!sync_callbacks.empty()) {
+            start_group_commit();
         }
 
         if (flush_timer == NULL
@@ -172,6 +202,10 @@ void writeback_t::local_buf_t::set_dirty(bool _dirty) {
                 1,
                 true));
         ++gbuf->cache->stats->pm_n_blocks_dirty;
+        gbuf->cache->stats->pm_blocks_dirtied.record();
+        if (gbuf->cache->writeback.oldest_dirty_time == 0) {
+            gbuf->cache->writeback.oldest_dirty_time = get_ticks();
+        }
     }
     if (dirty && !_dirty) {
         // We need to "unmark" the buf
@@ -231,6 +265,62 @@ void writeback_t::on_timer() {
     }
 }
 
+int64_t writeback_t::group_commit_window_ms() const {
+    int64_t window = static_cast<int64_t>(avg_flush_write_ms * GROUP_COMMIT_WINDOW_FRACTION);
+    if (window < TIMER_TICKS_IN_MS) {
+        // The timer can't wait that briefly, and the disk is fast enough that
+        // flushing right away doesn't hurt much.
+        return 0;
+    }
+    return std::min<int64_t>(window, MAX_GROUP_COMMIT_WINDOW_MS);
+}
+
+void writeback_t::start_group_commit() {
+    if (group_commit_timer != NULL) {
+        // A group commit is already pending, and it will include us.
+        return;
+    }
+    const int64_t window = group_commit_window_ms();
+    if (window == 0 || writeback_in_progress) {
+        /* If a flush is in progress, `sync()` queues up the next one, which
+        will include every transaction that commits until then anyway. */
+        sync(NULL);
+    } else {
+        group_commit_timer = fire_timer_once(window, &group_commit_callback);
+    }
+}
+
+unsigned int writeback_t::trickle_threshold() const {
+    if (avg_flush_blocks_per_ms == 0) {
+        // We don't know how fast the disk is yet.
+        return flush_threshold;
+    }
+    const double blocks = avg_flush_blocks_per_ms * WRITEBACK_TRICKLE_FLUSH_MS;
+    return std::min<unsigned int>(flush_threshold,
+                                  std::max<double>(blocks, WRITEBACK_TRICKLE_MIN_BLOCKS));
+}
+
+int64_t writeback_t::throttling_delay_ms() const {
+    const double capacity = dirty_block_semaphore.get_capacity();
+    const double soft_limit = capacity * WRITEBACK_THROTTLE_START_FRACTION;
+    const double used = dirty_block_semaphore.get_current();
+    if (used <= soft_limit || capacity <= soft_limit) {
+        return 0;
+    }
+    const double pressure = std::min(1.0, (used - soft_limit) / (capacity - soft_limit));
+    return static_cast<int64_t>(pressure * pressure * MAX_WRITEBACK_THROTTLE_DELAY_MS);
+}
+
+void writeback_t::on_group_commit_timer() {
+    group_commit_timer = NULL;
+
+    cache->assert_thread();
+
+    if (!cache->shutting_down && !sync_callbacks.empty()) {
+        sync(NULL);
+    }
+}
+
 class writeback_t::buf_writer_t :
     public iocallback_t,
     public thread_message_t,
@@ -353,6 +443,15 @@ void writeback_t::do_concurrent_flush() {
         // That way callbacks coming in while waiting for the flush lock
         // can still go into this flush.
         current_sync_callbacks.append_and_clear(&sync_callbacks);
+        if (!current_sync_callbacks.empty()) {
+            cache->stats->pm_flushes_commits.record(current_sync_callbacks.size());
+        }
+
+        // This flush takes care of any pending group commit.
+        if (group_commit_timer != NULL) {
+            cancel_timer(group_commit_timer);
+            group_commit_timer = NULL;
+        }
 
         // Also, at this point we can still clear the start_next_sync_immediately...
         start_next_sync_immediately = false;
@@ -364,8 +463,24 @@ void writeback_t::do_concurrent_flush() {
 
     // Now that preparations are complete, send the writes to the serializer
     if (!state.serializer_writes.empty()) {
-        on_thread_t switcher(cache->serializer->home_thread());
-        do_writes(cache->serializer, state.serializer_writes, cache->writes_io_account.get());
+        const ticks_t write_start_time = get_ticks();
+        {
+            on_thread_t switcher(cache->serializer->home_thread());
+            do_writes(cache->serializer, state.serializer_writes, cache->writes_io_account.get());
+        }
+        const double write_ms = ticks_to_secs(get_ticks() - write_start_time) * 1000.0;
+        avg_flush_write_ms = avg_flush_write_ms == 0
+            ? write_ms
+            : 0.8 * avg_flush_write_ms + 0.2 * write_ms;
+
+        const size_t blocks_written = state.buf_writers.size();
+        if (blocks_written > 0 && write_ms > 0) {
+            const double blocks_per_ms = blocks_written / write_ms;
+            avg_flush_blocks_per_ms = avg_flush_blocks_per_ms == 0
+                ? blocks_per_ms
+                : 0.8 * avg_flush_blocks_per_ms + 0.2 * blocks_per_ms;
+            cache->stats->pm_flushes_bandwidth.record(blocks_per_ms * 1000.0);
+        }
     }
 
     // Once transaction has completed, perform cleanup.
@@ -444,6 +559,12 @@ void writeback_t::flush_acquire_bufs(mc_transaction_t *transaction, flush_state_
     // Log the size of this flush
     cache->stats->pm_flushes_blocks.record(dirty_bufs.size());
 
+    // Changes made from now on are left for the next flush.
+    if (oldest_dirty_time != 0) {
+        cache->stats->pm_flushes_lag.record(ticks_to_secs(get_ticks() - oldest_dirty_time));
+        oldest_dirty_time = 0;
+    }
+
     // Request read locks on all of the blocks we need to flush.
     state->serializer_writes.reserve(deleted_blocks.size() + dirty_bufs.size());
 
@@ -9,6 +9,7 @@
 #include "buffer_cache/mirrored/flush_time_randomizer.hpp"
 #include "buffer_cache/types.hpp"
 #include "concurrency/cond_var.hpp"
+#include "concurrency/mutex.hpp"
 #include "concurrency/rwi_lock.hpp"
 #include "concurrency/semaphore.hpp"
 #include "serializer/types.hpp"
@@ -56,6 +57,10 @@ public:
         return dirty_bufs.size();
     }
 
+    /* Changes how long modified data may sit in memory before a writeback is
+    started. Takes effect the next time the flush timer is started. */
+    void set_flush_timer_ms(unsigned int flush_timer_ms);
+
     class local_buf_t : public intrusive_list_node_t<local_buf_t> {
     public:
         local_buf_t();
@@ -112,6 +117,40 @@ private:
     // The flush timer callback.
     void on_timer();
 
+    /* Group commit: hard-durability transactions that commit while no flush is
+    running don't start one right away. Instead, `group_commit_timer` delays the
+    flush by `group_commit_window_ms()` so that transactions committing in the
+    meantime get written out by the same flush (and thus the same index write and
+    fsync). The window is derived from how long recent flushes took. */
+    struct group_commit_callback_t : public timer_callback_t {
+        writeback_t *parent;
+        void on_timer() { parent->on_group_commit_timer(); }
+    } group_commit_callback;
+    timer_token_t *group_commit_timer;
+    // Exponentially weighted moving average of the time spent writing a flush.
+    double avg_flush_write_ms;
+    int64_t group_commit_window_ms() const;
+    void start_group_commit();
+    void on_group_commit_timer();
+
+    /* Rate control: rather than waiting for the flush timer or the flush threshold,
+    a flush is started as soon as `trickle_threshold()` blocks are dirty, which
+    is how many blocks the disk writes in about WRITEBACK_TRICKLE_FLUSH_MS. This
+    turns rare big flushes into a steady trickle of small ones. */
+    // Exponentially weighted moving average of the blocks written per millisecond.
+    double avg_flush_blocks_per_ms;
+    unsigned int trickle_threshold() const;
+
+    /* Write transactions are delayed by `throttling_delay_ms()` before they try
+    to acquire `dirty_block_semaphore`, so writers slow down gradually as the
+    dirty blocks approach `max_dirty_blocks`. `throttle_mutex` keeps write and
+    `rwi_read_sync` transactions in order while one of them is being delayed. */
+    int64_t throttling_delay_ms() const;
+    mutex_t throttle_mutex;
+
+    // When the oldest change that no flush has picked up yet was made, or 0.
+    ticks_t oldest_dirty_time;
+
     bool writeback_in_progress;
     unsigned int active_flushes;
 
@@ -141,6 +141,7 @@ public:
                 perfmon_collection_t *parent);
 
     block_size_t get_block_size();
+    void set_flush_timer_ms(int flush_timer_ms);
     void create_cache_account(
             int priority,
             scoped_ptr_t<typename inner_cache_t::cache_account_type> *out);
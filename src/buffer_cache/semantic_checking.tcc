@@ -186,6 +186,11 @@ block_size_t scc_cache_t<inner_cache_t>::get_block_size() {
     return inner_cache.get_block_size();
 }
 
+template<class inner_cache_t>
+void scc_cache_t<inner_cache_t>::set_flush_timer_ms(int flush_timer_ms) {
+    inner_cache.set_flush_timer_ms(flush_timer_ms);
+}
+
 template<class inner_cache_t>
 void scc_cache_t<inner_cache_t>::create_cache_account(int priority, scoped_ptr_t<typename inner_cache_t::cache_account_type> *out) {
     inner_cache.create_cache_account(priority, out);
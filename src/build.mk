@@ -8,7 +8,7 @@ CXXPATHDS ?=
 LDFLAGS ?=
 CXXFLAGS ?=
 RT_LDFLAGS := $(LDFLAGS) $(RE2_LIBS) $(TERMCAP_LIBS)
-RT_LDFLAGS += $(V8_LIBS) $(PROTOBUF_LIBS) $(TCMALLOC_MINIMAL_LIBS) $(PTHREAD_LIBS)
+RT_LDFLAGS += $(V8_LIBS) $(PROTOBUF_LIBS) $(Z_LIBS) $(TCMALLOC_MINIMAL_LIBS) $(PTHREAD_LIBS)
 RT_CXXFLAGS := $(CXXFLAGS) $(RE2_CXXFLAGS)
 
 ifeq ($(USE_CCACHE),1)
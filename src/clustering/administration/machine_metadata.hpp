@@ -41,6 +41,7 @@ public:
 };
 
 RDB_MAKE_SEMILATTICE_JOINABLE_1(machines_semilattice_metadata_t, machines);
+RDB_MAKE_SEMILATTICE_DELTA_1(machines_semilattice_metadata_t, machines);
 RDB_MAKE_EQUALITY_COMPARABLE_1(machines_semilattice_metadata_t, machines);
 
 //json adapter concept for machines_semilattice_metadata_t
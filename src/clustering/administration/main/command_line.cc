@@ -308,16 +308,22 @@ public:
     serve_info_t(const std::vector<host_and_port_t> &_joins,
                  service_address_ports_t _ports,
                  std::string _web_assets,
-                 boost::optional<std::string> _config_file):
+                 boost::optional<std::string> _config_file,
+                 bool _use_write_ahead_log,
+                 bool _use_key_filters):
         joins(&_joins),
         ports(_ports),
         web_assets(_web_assets),
-        config_file(_config_file) { }
+        config_file(_config_file),
+        use_write_ahead_log(_use_write_ahead_log),
+        use_key_filters(_use_key_filters) { }
 
     const std::vector<host_and_port_t> *joins;
     service_address_ports_t ports;
     std::string web_assets;
     boost::optional<std::string> config_file;
+    bool use_write_ahead_log;
+    bool use_key_filters;
 };
 
 // Used for options that don't take parameters, such as --help or --exit-failure, tells whether the
@@ -579,9 +585,26 @@ peer_address_t get_canonical_addresses(const std::map<std::string, options::valu
     return peer_address_t(result);
 }
 
+cluster_compression_t get_cluster_compression(const std::map<std::string, options::values_t> &opts,
+                                              const std::string &name) {
+    const std::string value = get_single_option(opts, name);
+    cluster_compression_t result;
+    if (!parse_cluster_compression(value, &result)) {
+        throw std::runtime_error(strprintf("Option '%s' (with value '%s') must be one of "
+                                           "'none', 'fast', or 'strong'",
+                                           name.c_str(), value.c_str()));
+    }
+    return result;
+}
+
 service_address_ports_t get_service_address_ports(const std::map<std::string, options::values_t> &opts) {
     const int port_offset = get_single_int(opts, "--port-offset");
     const int cluster_port = offseted_port(get_single_int(opts, "--cluster-port"), port_offset);
+    const int cluster_connections = get_single_int(opts, "--cluster-connections");
+    if (cluster_connections < 1 || cluster_connections > CLUSTER_MAX_CONNECTIONS_PER_PEER) {
+        throw std::runtime_error(strprintf("--cluster-connections must be between 1 and %d",
+                                           CLUSTER_MAX_CONNECTIONS_PER_PEER));
+    }
     return service_address_ports_t(get_local_addresses(all_options(opts, "--bind")),
                                    get_canonical_addresses(opts, cluster_port),
                                    cluster_port,
@@ -590,6 +613,9 @@ service_address_ports_t get_service_address_ports(const std::map<std::string, op
 #else
                                    port_defaults::client_port,
 #endif
+                                   cluster_connections,
+                                   get_cluster_compression(opts, "--cluster-compression-local"),
+                                   get_cluster_compression(opts, "--cluster-compression"),
                                    exists_option(opts, "--no-http-admin"),
                                    offseted_port(get_single_int(opts, "--http-port"), port_offset),
                                    offseted_port(get_single_int(opts, "--driver-port"), port_offset),
@@ -759,6 +785,8 @@ void run_rethinkdb_serve(const base_path_t &base_path,
                             look_up_peers_addresses(*serve_info.joins),
                             serve_info.ports,
                             serve_info.web_assets,
+                            serve_info.use_write_ahead_log,
+                            serve_info.use_key_filters,
                             &sigint_cond,
                             serve_info.config_file);
 
@@ -870,6 +898,12 @@ options::help_section_t get_file_options(std::vector<options::option_t> *options
     options_out->push_back(options::option_t(options::names_t("--no-direct-io"),
                                              options::OPTIONAL_NO_PARAMETER));
     help.add("--no-direct-io", "disable direct I/O");
+    options_out->push_back(options::option_t(options::names_t("--write-ahead-log"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--write-ahead-log", "log soft durability writes to an fsynced write-ahead log, so that they survive a crash");
+    options_out->push_back(options::option_t(options::names_t("--key-filter"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--key-filter", "keep a Bloom filter over the primary keys of every table in memory, to speed up reads of missing keys");
     return help;
 }
 
@@ -918,6 +952,21 @@ options::help_section_t get_network_options(const bool join_required, std::vecto
                                              strprintf("%d", port_defaults::peer_port)));
     help.add("--cluster-port port", "port for receiving connections from other nodes");
 
+    options_out->push_back(options::option_t(options::names_t("--cluster-connections"),
+                                             options::OPTIONAL,
+                                             strprintf("%d", CLUSTER_CONNECTIONS_PER_PEER)));
+    help.add("--cluster-connections n", "number of TCP connections to open to each other node");
+    options_out->push_back(options::option_t(options::names_t("--cluster-compression"),
+                                             options::OPTIONAL,
+                                             "none"));
+    help.add("--cluster-compression none|fast|strong",
+             "how to compress traffic to nodes in other datacenters");
+    options_out->push_back(options::option_t(options::names_t("--cluster-compression-local"),
+                                             options::OPTIONAL,
+                                             "none"));
+    help.add("--cluster-compression-local none|fast|strong",
+             "how to compress traffic to nodes in the same datacenter");
+
 #ifndef NDEBUG
     options_out->push_back(options::option_t(options::names_t("--client-port"),
                                              options::OPTIONAL,
@@ -1314,7 +1363,9 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
         extproc_spawner_t extproc_spawner;
 
         serve_info_t serve_info(joins, address_ports, web_path,
-                                get_optional_option(opts, "--config-file"));
+                                get_optional_option(opts, "--config-file"),
+                                exists_option(opts, "--write-ahead-log"),
+                                exists_option(opts, "--key-filter"));
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
 
@@ -1434,7 +1485,8 @@ int main_rethinkdb_proxy(int argc, char *argv[]) {
         extproc_spawner_t extproc_spawner;
 
         serve_info_t serve_info(joins, address_ports, web_path,
-                                get_optional_option(opts, "--config-file"));
+                                get_optional_option(opts, "--config-file"),
+                                false, false);
 
         bool result;
         run_in_thread_pool(std::bind(&run_rethinkdb_proxy, serve_info, &result),
@@ -1575,7 +1627,9 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
         extproc_spawner_t extproc_spawner;
 
         serve_info_t serve_info(joins, address_ports, web_path,
-                                get_optional_option(opts, "--config-file"));
+                                get_optional_option(opts, "--config-file"),
+                                exists_option(opts, "--write-ahead-log"),
+                                exists_option(opts, "--key-filter"));
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
 
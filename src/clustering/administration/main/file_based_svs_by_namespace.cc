@@ -1,6 +1,7 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include "clustering/administration/main/file_based_svs_by_namespace.hpp"
 
+#include "btree/btree_store.hpp"
 #include "clustering/immediate_consistency/branch/multistore.hpp"
 #include "clustering/reactor/reactor.hpp"
 #include "serializer/config.hpp"
@@ -16,11 +17,13 @@ struct store_args_t {
     store_args_t(io_backender_t *_io_backender, const base_path_t &_base_path,
             namespace_id_t _namespace_id, int64_t _cache_size,
             perfmon_collection_t *_serializers_perfmon_collection, typename
-            protocol_t::context_t *_ctx)
+            protocol_t::context_t *_ctx, const std::string &_log_path_prefix,
+            bool _use_write_ahead_log, bool _use_key_filter)
         : io_backender(_io_backender), base_path(_base_path),
           namespace_id(_namespace_id), cache_size(_cache_size),
           serializers_perfmon_collection(_serializers_perfmon_collection),
-          ctx(_ctx)
+          ctx(_ctx), log_path_prefix(_log_path_prefix),
+          use_write_ahead_log(_use_write_ahead_log), use_key_filter(_use_key_filter)
     { }
 
     io_backender_t *io_backender;
@@ -29,12 +32,47 @@ struct store_args_t {
     int64_t cache_size;
     perfmon_collection_t *serializers_perfmon_collection;
     typename protocol_t::context_t *ctx;
+    // Where the stores' write-ahead logs are, whether or not they keep one
+    // now; logs left over from an earlier run always get replayed.
+    std::string log_path_prefix;
+    bool use_write_ahead_log;
+    bool use_key_filter;
 };
 
 std::string hash_shard_perfmon_name(int hash_shard_number) {
     return strprintf("shard_%d", hash_shard_number);
 }
 
+std::string write_ahead_log_path(const std::string &prefix, int hash_shard_number) {
+    return strprintf("%s_%s.wal", prefix.c_str(),
+                     hash_shard_perfmon_name(hash_shard_number).c_str());
+}
+
+/* Only B-Tree based stores know how to keep a write-ahead log; overload
+resolution picks the first version for them. */
+template <class protocol_t>
+void maybe_enable_write_ahead_log(btree_store_t<protocol_t> *store, const std::string &path,
+                                  bool enable) {
+    if (enable) {
+        store->enable_write_ahead_log(path);
+    } else {
+        store->recover_write_ahead_log(path);
+    }
+}
+
+template <class protocol_t>
+void maybe_enable_write_ahead_log(UNUSED store_view_t<protocol_t> *store,
+                                  UNUSED const std::string &path,
+                                  UNUSED bool enable) { }
+
+template <class protocol_t>
+void maybe_enable_key_filter(btree_store_t<protocol_t> *store) {
+    store->enable_key_filter();
+}
+
+template <class protocol_t>
+void maybe_enable_key_filter(UNUSED store_view_t<protocol_t> *store) { }
+
 template <class protocol_t>
 void do_construct_existing_store(
     const std::vector<threadnum_t> &threads,
@@ -53,6 +91,12 @@ void do_construct_existing_store(
         store_args.cache_size, false, store_args.serializers_perfmon_collection,
         store_args.ctx, store_args.io_backender, store_args.base_path);
     (*stores_out_stores)[thread_offset].init(store);
+    maybe_enable_write_ahead_log(store, write_ahead_log_path(store_args.log_path_prefix,
+                                                             thread_offset),
+                                 store_args.use_write_ahead_log);
+    if (store_args.use_key_filter) {
+        maybe_enable_key_filter(store);
+    }
     store_views[thread_offset] = store;
 }
 
@@ -71,6 +115,15 @@ void do_create_new_store(
         store_args.cache_size, true, store_args.serializers_perfmon_collection,
         store_args.ctx, store_args.io_backender, store_args.base_path);
     (*stores_out_stores)[thread_offset].init(store);
+    // Whatever log files are lying around belong to some earlier store.
+    const std::string log_path = write_ahead_log_path(store_args.log_path_prefix, thread_offset);
+    write_ahead_log_t::remove(log_path);
+    if (store_args.use_write_ahead_log) {
+        maybe_enable_write_ahead_log(store, log_path, true);
+    }
+    if (store_args.use_key_filter) {
+        maybe_enable_key_filter(store);
+    }
     store_views[thread_offset] = store;
 }
 
@@ -80,6 +133,7 @@ file_based_svs_by_namespace_t<protocol_t>::get_svs(
             perfmon_collection_t *serializers_perfmon_collection,
             namespace_id_t namespace_id,
             int64_t cache_size,
+            int64_t block_size,
             stores_lifetimer_t<protocol_t> *stores_out,
             scoped_ptr_t<multistore_ptr_t<protocol_t> > *svs_out,
             typename protocol_t::context_t *ctx) {
@@ -118,7 +172,9 @@ file_based_svs_by_namespace_t<protocol_t>::get_svs(
         int res = access(serializer_filepath.permanent_path().c_str(), R_OK | W_OK);
         store_args_t<protocol_t> store_args(io_backender_, base_path_,
                                             namespace_id, cache_size / num_stores,
-                                            serializers_perfmon_collection, ctx);
+                                            serializers_perfmon_collection, ctx,
+                                            serializer_filepath.permanent_path(),
+                                            use_write_ahead_log_, use_key_filters_);
         filepath_file_opener_t file_opener(serializer_filepath, io_backender_);
         if (res == 0) {
             // TODO: Could we handle failure when loading the serializer?  Right
@@ -145,8 +201,11 @@ file_based_svs_by_namespace_t<protocol_t>::get_svs(
                                          stores_out_stores, store_views.data()));
             mptr.init(new multistore_ptr_t<protocol_t>(store_views.data(), num_stores));
         } else {
-            standard_serializer_t::create(&file_opener,
-                                          standard_serializer_t::static_config_t());
+            // The block size only matters when the file is created; existing
+            // files remember theirs.
+            standard_serializer_t::static_config_t static_config;
+            static_config.block_size_ = block_size;
+            standard_serializer_t::create(&file_opener, static_config);
             serializer.init(new merger_serializer_t(
                                 scoped_ptr_t<serializer_t>(
                                     new standard_serializer_t(
@@ -203,6 +262,11 @@ void file_based_svs_by_namespace_t<protocol_t>::destroy_svs(namespace_id_t names
     const int res = ::unlink(filepath.c_str());
     guarantee_err(res == 0 || errno == ENOENT,
                   "unlink failed for file %s", filepath.c_str());
+
+    // Remove any write-ahead logs, even if we don't use them right now.
+    for (int i = 0; i < CPU_SHARDING_FACTOR; ++i) {
+        write_ahead_log_t::remove(write_ahead_log_path(filepath, i));
+    }
 }
 
 template<class protocol_t>
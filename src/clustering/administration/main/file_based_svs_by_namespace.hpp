@@ -10,12 +10,17 @@ template <class protocol_t>
 class file_based_svs_by_namespace_t : public svs_by_namespace_t<protocol_t> {
 public:
     file_based_svs_by_namespace_t(io_backender_t *io_backender,
-                                  const base_path_t& base_path)
-        : io_backender_(io_backender), base_path_(base_path), thread_counter_(0) { }
+                                  const base_path_t& base_path,
+                                  bool use_write_ahead_log,
+                                  bool use_key_filters)
+        : io_backender_(io_backender), base_path_(base_path),
+          use_write_ahead_log_(use_write_ahead_log),
+          use_key_filters_(use_key_filters), thread_counter_(0) { }
 
     void get_svs(perfmon_collection_t *serializers_perfmon_collection,
                  namespace_id_t namespace_id,
                  int64_t cache_size,
+                 int64_t block_size,
                  stores_lifetimer_t<protocol_t> *stores_out,
                  scoped_ptr_t<multistore_ptr_t<protocol_t> > *svs_out,
                  typename protocol_t::context_t *);
@@ -27,6 +32,10 @@ public:
 private:
     io_backender_t *io_backender_;
     const base_path_t base_path_;
+    // Whether soft-durability writes are recorded in a write-ahead log.
+    const bool use_write_ahead_log_;
+    // Whether stores keep Bloom filters over their primary keys.
+    const bool use_key_filters_;
 
     threadnum_t next_thread(int num_db_threads);
     int thread_counter_; // should only be used by `next_thread`
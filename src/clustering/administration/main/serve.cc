@@ -56,6 +56,22 @@ std::string service_address_ports_t::get_addresses_string() const {
     return result;
 }
 
+/* The cluster layer calls this on every new connection, to decide how to
+compress it. A machine that doesn't have a datacenter yet (or that has two,
+because of a conflict) counts as being in none. */
+static uuid_u get_our_datacenter(
+        const boost::shared_ptr<semilattice_read_view_t<machines_semilattice_metadata_t> > &machines_view,
+        machine_id_t machine_id) {
+    machines_semilattice_metadata_t machines = machines_view->get();
+    machines_semilattice_metadata_t::machine_map_t::iterator it = machines.machines.find(machine_id);
+    if (it == machines.machines.end()
+        || it->second.is_deleted()
+        || it->second.get_ref().datacenter.in_conflict()) {
+        return nil_uuid();
+    }
+    return it->second.get_ref().datacenter.get();
+}
+
 bool service_address_ports_t::is_bind_all() const {
     // If the set is empty, it means we're listening on all addresses.
     return local_addresses.empty();
@@ -71,6 +87,8 @@ bool do_serve(
     const peer_address_set_t &joins,
     service_address_ports_t address_ports,
     std::string web_assets,
+    bool use_write_ahead_log,
+    bool use_key_filters,
     os_signal_cond_t *stop_cond,
     const boost::optional<std::string> &config_file) {
     try {
@@ -149,6 +167,15 @@ bool do_serve(
         message_multiplexer_t::run_t message_multiplexer_run(&message_multiplexer);
         scoped_ptr_t<connectivity_cluster_t::run_t> connectivity_cluster_run;
 
+        cluster_compression_config_t compression_config;
+        compression_config.same_datacenter = address_ports.cluster_compression_local;
+        compression_config.other_datacenters = address_ports.cluster_compression;
+        compression_config.get_datacenter = boost::bind(
+            &get_our_datacenter,
+            metadata_field(&cluster_semilattice_metadata_t::machines,
+                           semilattice_manager_cluster.get_root_view()),
+            machine_id);
+
         try {
             connectivity_cluster_run.init(new connectivity_cluster_t::run_t(
                 &connectivity_cluster,
@@ -157,7 +184,9 @@ bool do_serve(
                 address_ports.port,
                 &message_multiplexer_run,
                 address_ports.client_port,
-                &heartbeat_manager));
+                &heartbeat_manager,
+                address_ports.cluster_connections,
+                compression_config));
 
             // Update the directory with the ip addresses that we are passing to peers
             std::set<ip_and_port_t> ips = connectivity_cluster_run->get_ips();
@@ -244,6 +273,7 @@ bool do_serve(
                                           semilattice_manager_cluster.get_root_view(),
                                           auth_manager_cluster.get_root_view(),
                                           &directory_read_manager,
+                                          &mailbox_manager,
                                           machine_id);
 
         namespace_repo_t<rdb_protocol_t> rdb_namespace_repo(&mailbox_manager,
@@ -265,7 +295,8 @@ bool do_serve(
 
             if (i_am_a_server) {
                 dummy_svs_source.init(new file_based_svs_by_namespace_t<mock::dummy_protocol_t>(
-                    io_backender, base_path));
+                    io_backender, base_path, use_write_ahead_log,
+                    use_key_filters));
                 dummy_reactor_driver.init(new reactor_driver_t<mock::dummy_protocol_t>(
                     base_path,
                     io_backender,
@@ -298,7 +329,8 @@ bool do_serve(
 
             if (i_am_a_server) {
                 memcached_svs_source.init(new file_based_svs_by_namespace_t<memcached_protocol_t>(
-                    io_backender, base_path));
+                    io_backender, base_path, use_write_ahead_log,
+                    use_key_filters));
                 memcached_reactor_driver.init(new reactor_driver_t<memcached_protocol_t>(
                     base_path,
                     io_backender,
@@ -331,7 +363,8 @@ bool do_serve(
 
             if (i_am_a_server) {
                 rdb_svs_source.init(new file_based_svs_by_namespace_t<rdb_protocol_t>(
-                    io_backender, base_path));
+                    io_backender, base_path, use_write_ahead_log,
+                    use_key_filters));
                 rdb_reactor_driver.init(new reactor_driver_t<rdb_protocol_t>(
                         base_path,
                         io_backender,
@@ -482,6 +515,8 @@ bool serve(io_backender_t *io_backender,
            const peer_address_set_t &joins,
            service_address_ports_t address_ports,
            std::string web_assets,
+           bool use_write_ahead_log,
+           bool use_key_filters,
            os_signal_cond_t *stop_cond,
            const boost::optional<std::string>& config_file) {
     return do_serve(io_backender,
@@ -492,6 +527,8 @@ bool serve(io_backender_t *io_backender,
                     joins,
                     address_ports,
                     web_assets,
+                    use_write_ahead_log,
+                    use_key_filters,
                     stop_cond,
                     config_file);
 }
@@ -511,6 +548,8 @@ bool serve_proxy(const peer_address_set_t &joins,
                     joins,
                     address_ports,
                     web_assets,
+                    false,
+                    false,
                     stop_cond,
                     config_file);
 }
@@ -8,6 +8,7 @@
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/persist.hpp"
 #include "arch/address.hpp"
+#include "rpc/connectivity/compression.hpp"
 
 class os_signal_cond_t;
 
@@ -41,6 +42,9 @@ struct service_address_ports_t {
     service_address_ports_t() :
         port(0),
         client_port(0),
+        cluster_connections(1),
+        cluster_compression_local(CLUSTER_COMPRESSION_NONE),
+        cluster_compression(CLUSTER_COMPRESSION_NONE),
         http_port(0),
         reql_port(0),
         port_offset(0) { }
@@ -49,6 +53,9 @@ struct service_address_ports_t {
                             const peer_address_t &_canonical_addresses,
                             int _port,
                             int _client_port,
+                            int _cluster_connections,
+                            cluster_compression_t _cluster_compression_local,
+                            cluster_compression_t _cluster_compression,
                             bool _http_admin_is_disabled,
                             int _http_port,
                             int _reql_port,
@@ -57,6 +64,9 @@ struct service_address_ports_t {
         canonical_addresses(_canonical_addresses),
         port(_port),
         client_port(_client_port),
+        cluster_connections(_cluster_connections),
+        cluster_compression_local(_cluster_compression_local),
+        cluster_compression(_cluster_compression),
         http_admin_is_disabled(_http_admin_is_disabled),
         http_port(_http_port),
         reql_port(_reql_port),
@@ -76,6 +86,12 @@ struct service_address_ports_t {
     peer_address_t canonical_addresses;
     int port;
     int client_port;
+    // How many TCP connections to open to each peer.
+    int cluster_connections;
+    // How to compress connections to nodes in the same datacenter, and to all
+    // other nodes.
+    cluster_compression_t cluster_compression_local;
+    cluster_compression_t cluster_compression;
     bool http_admin_is_disabled;
     int http_port;
     int reql_port;
@@ -92,6 +108,8 @@ bool serve(io_backender_t *io_backender,
            const peer_address_set_t &joins,
            service_address_ports_t ports,
            std::string web_assets,
+           bool use_write_ahead_log,
+           bool use_key_filters,
            os_signal_cond_t *stop_cond,
            const boost::optional<std::string>& config_file);
 
@@ -217,6 +217,52 @@ void apply_json_to(cJSON *change, cluster_directory_metadata_t *target) {
     apply_as_directory(change, target);
 }
 
+void serialize_directory_delta(write_message_t *msg,
+                               const cluster_directory_metadata_t &old_value,
+                               const cluster_directory_metadata_t &new_value) {
+    serialize_directory_delta(msg, old_value.dummy_namespaces, new_value.dummy_namespaces);
+    serialize_directory_delta(msg, old_value.memcached_namespaces, new_value.memcached_namespaces);
+    serialize_directory_delta(msg, old_value.rdb_namespaces, new_value.rdb_namespaces);
+    serialize_directory_delta(msg, old_value.machine_id, new_value.machine_id);
+    serialize_directory_delta(msg, old_value.peer_id, new_value.peer_id);
+    serialize_directory_delta(msg, old_value.ips, new_value.ips);
+    serialize_directory_delta(msg, old_value.get_stats_mailbox_address, new_value.get_stats_mailbox_address);
+    serialize_directory_delta(msg, old_value.semilattice_change_mailbox, new_value.semilattice_change_mailbox);
+    serialize_directory_delta(msg, old_value.auth_change_mailbox, new_value.auth_change_mailbox);
+    serialize_directory_delta(msg, old_value.log_mailbox, new_value.log_mailbox);
+    serialize_directory_delta(msg, old_value.local_issues, new_value.local_issues);
+    serialize_directory_delta(msg, old_value.peer_type, new_value.peer_type);
+}
+
+archive_result_t apply_directory_delta(read_stream_t *s, cluster_directory_metadata_t *value) {
+    archive_result_t res;
+    res = apply_directory_delta(s, &value->dummy_namespaces);
+    if (res) { return res; }
+    res = apply_directory_delta(s, &value->memcached_namespaces);
+    if (res) { return res; }
+    res = apply_directory_delta(s, &value->rdb_namespaces);
+    if (res) { return res; }
+    res = apply_directory_delta(s, &value->machine_id);
+    if (res) { return res; }
+    res = apply_directory_delta(s, &value->peer_id);
+    if (res) { return res; }
+    res = apply_directory_delta(s, &value->ips);
+    if (res) { return res; }
+    res = apply_directory_delta(s, &value->get_stats_mailbox_address);
+    if (res) { return res; }
+    res = apply_directory_delta(s, &value->semilattice_change_mailbox);
+    if (res) { return res; }
+    res = apply_directory_delta(s, &value->auth_change_mailbox);
+    if (res) { return res; }
+    res = apply_directory_delta(s, &value->log_mailbox);
+    if (res) { return res; }
+    res = apply_directory_delta(s, &value->local_issues);
+    if (res) { return res; }
+    res = apply_directory_delta(s, &value->peer_type);
+    if (res) { return res; }
+    return ARCHIVE_SUCCESS;
+}
+
 
 
 
@@ -258,6 +304,8 @@ json_adapter_if_t::json_adapter_map_t with_ctx_get_json_subfields(namespace_semi
     res["primary_key"] = boost::shared_ptr<json_adapter_if_t>(new json_vclock_adapter_t<std::string>(&target->primary_key, ctx));
     res["database"] = boost::shared_ptr<json_adapter_if_t>(new json_vclock_adapter_t<database_id_t>(&target->database, ctx));
     res["cache_size"] = boost::shared_ptr<json_adapter_if_t>(new json_vclock_adapter_t<int64_t>(&target->cache_size, ctx));
+    res["block_size"] = boost::shared_ptr<json_adapter_if_t>(new json_vclock_adapter_t<int64_t>(&target->block_size, ctx));
+    res["backfill_bytes_per_sec"] = boost::shared_ptr<json_adapter_if_t>(new json_vclock_adapter_t<int64_t>(&target->backfill_bytes_per_sec, ctx));
     return res;
 }
 
@@ -296,6 +344,8 @@ inline json_adapter_if_t::json_adapter_map_t with_ctx_get_json_subfields(namespa
     default_namespace.primary_key = default_namespace.primary_key.make_new_version("id", ctx.us);
 
     default_namespace.cache_size = default_namespace.cache_size.make_new_version(GIGABYTE, ctx.us);
+    default_namespace.block_size = default_namespace.block_size.make_new_version(DEFAULT_BTREE_BLOCK_SIZE, ctx.us);
+    default_namespace.backfill_bytes_per_sec = default_namespace.backfill_bytes_per_sec.make_new_version(DEFAULT_BACKFILL_BYTES_PER_SEC, ctx.us);
 
     deletable_t<namespace_semilattice_metadata_t<protocol_t> > default_ns_in_deletable(default_namespace);
     return json_ctx_adapter_with_inserter_t<typename namespaces_semilattice_metadata_t<protocol_t>::namespace_map_t, vclock_ctx_t>(&target->namespaces, generate_uuid, ctx, default_ns_in_deletable).get_subfields();
@@ -48,6 +48,7 @@ public:
 };
 
 RDB_MAKE_SEMILATTICE_JOINABLE_6(cluster_semilattice_metadata_t, dummy_namespaces, memcached_namespaces, rdb_namespaces, machines, datacenters, databases);
+RDB_MAKE_SEMILATTICE_DELTA_6(cluster_semilattice_metadata_t, dummy_namespaces, memcached_namespaces, rdb_namespaces, machines, datacenters, databases);
 RDB_MAKE_EQUALITY_COMPARABLE_6(cluster_semilattice_metadata_t, dummy_namespaces, memcached_namespaces, rdb_namespaces, machines, datacenters, databases);
 
 //json adapter concept for cluster_semilattice_metadata_t
@@ -125,6 +126,14 @@ public:
     RDB_MAKE_ME_SERIALIZABLE_12(dummy_namespaces, memcached_namespaces, rdb_namespaces, machine_id, peer_id, ips, get_stats_mailbox_address, semilattice_change_mailbox, auth_change_mailbox, log_mailbox, local_issues, peer_type);
 };
 
+/* Directory updates carry only the business cards that changed. The other
+fields are small, so they're sent in full. If you add a field, add it to both of
+these too. */
+void serialize_directory_delta(write_message_t *msg,
+                               const cluster_directory_metadata_t &old_value,
+                               const cluster_directory_metadata_t &new_value);
+MUST_USE archive_result_t apply_directory_delta(read_stream_t *s, cluster_directory_metadata_t *value);
+
 // ctx-less json adapter for directory_echo_wrapper_t
 template <typename T>
 json_adapter_if_t::json_adapter_map_t get_json_subfields(directory_echo_wrapper_t<T> *target) {
@@ -25,6 +25,7 @@
 #include "containers/name_string.hpp"
 #include "containers/uuid.hpp"
 #include "http/json/json_adapter.hpp"
+#include "rpc/directory/delta.hpp"
 #include "rpc/semilattice/joins/deletable.hpp"
 #include "rpc/semilattice/joins/macros.hpp"
 #include "rpc/semilattice/joins/map.hpp"
@@ -35,7 +36,8 @@
 /* This is the metadata for a single namespace of a specific protocol. */
 
 /* If you change this data structure, you must also update
-`clustering/administration/issues/vector_clock_conflict.hpp`. */
+`clustering/administration/issues/vector_clock_conflict.hpp`, and bump
+`CLUSTER_METADATA_VERSION` in `clustering/administration/persist.cc`. */
 
 class ack_expectation_t {
 public:
@@ -64,7 +66,8 @@ void debug_print(printf_buffer_t *buf, const ack_expectation_t &x);
 template<class protocol_t>
 class namespace_semilattice_metadata_t {
 public:
-    namespace_semilattice_metadata_t() : cache_size(GIGABYTE) { }
+    namespace_semilattice_metadata_t() : cache_size(GIGABYTE), block_size(DEFAULT_BTREE_BLOCK_SIZE),
+                                         backfill_bytes_per_sec(DEFAULT_BACKFILL_BYTES_PER_SEC) { }
 
     vclock_t<persistable_blueprint_t<protocol_t> > blueprint;
     vclock_t<datacenter_id_t> primary_datacenter;
@@ -78,8 +81,14 @@ public:
     vclock_t<std::string> primary_key; //TODO this should actually never be changed...
     vclock_t<database_id_t> database;
     vclock_t<int64_t> cache_size;
-
-    RDB_MAKE_ME_SERIALIZABLE_12(blueprint, primary_datacenter, replica_affinities, ack_expectations, shards, name, port, primary_pinnings, secondary_pinnings, primary_key, database, cache_size);
+    // The block size of the table's serializer files.  It only takes effect
+    // when a machine creates its files for the table.
+    vclock_t<int64_t> block_size;
+    // The most bytes per second that a backfill of the table sends, or 0 for
+    // no limit.  Changes apply to backfills that are already running.
+    vclock_t<int64_t> backfill_bytes_per_sec;
+
+    RDB_MAKE_ME_SERIALIZABLE_14(blueprint, primary_datacenter, replica_affinities, ack_expectations, shards, name, port, primary_pinnings, secondary_pinnings, primary_key, database, cache_size, block_size, backfill_bytes_per_sec);
 };
 
 template <class protocol_t>
@@ -106,14 +115,25 @@ void debug_print(printf_buffer_t *buf, const namespace_semilattice_metadata_t<pr
     debug_print(buf, m.primary_key);
     buf->appendf(", database=");
     debug_print(buf, m.database);
+    buf->appendf(", block_size=");
+    debug_print(buf, m.block_size);
+    buf->appendf(", backfill_bytes_per_sec=");
+    debug_print(buf, m.backfill_bytes_per_sec);
     buf->appendf("}");
 }
 
+/* Btree block sizes must be powers of two, so that blocks stay aligned to the
+device block size and fill extents exactly. */
+inline bool is_valid_btree_block_size(int64_t block_size) {
+    return block_size >= MIN_BTREE_BLOCK_SIZE && block_size <= MAX_BTREE_BLOCK_SIZE
+        && (block_size & (block_size - 1)) == 0;
+}
+
 template<class protocol_t>
 namespace_semilattice_metadata_t<protocol_t> new_namespace(
     uuid_u machine, uuid_u database, uuid_u datacenter,
     const name_string_t &name, const std::string &key, int port,
-    int64_t cache_size) {
+    int64_t cache_size, int64_t block_size) {
 
     namespace_semilattice_metadata_t<protocol_t> ns;
     ns.database           = make_vclock(database, machine);
@@ -140,14 +160,16 @@ namespace_semilattice_metadata_t<protocol_t> new_namespace(
     ns.secondary_pinnings = make_vclock(secondary_pinnings, machine);
 
     ns.cache_size = make_vclock(cache_size, machine);
+    ns.block_size = make_vclock(block_size, machine);
+    ns.backfill_bytes_per_sec = make_vclock(static_cast<int64_t>(DEFAULT_BACKFILL_BYTES_PER_SEC), machine);
     return ns;
 }
 
 template<class protocol_t>
-RDB_MAKE_SEMILATTICE_JOINABLE_12(namespace_semilattice_metadata_t<protocol_t>, blueprint, primary_datacenter, replica_affinities, ack_expectations, shards, name, port, primary_pinnings, secondary_pinnings, primary_key, database, cache_size);
+RDB_MAKE_SEMILATTICE_JOINABLE_14(namespace_semilattice_metadata_t<protocol_t>, blueprint, primary_datacenter, replica_affinities, ack_expectations, shards, name, port, primary_pinnings, secondary_pinnings, primary_key, database, cache_size, block_size, backfill_bytes_per_sec);
 
 template<class protocol_t>
-RDB_MAKE_EQUALITY_COMPARABLE_12(namespace_semilattice_metadata_t<protocol_t>, blueprint, primary_datacenter, replica_affinities, ack_expectations, shards, name, port, primary_pinnings, secondary_pinnings, primary_key, database, cache_size);
+RDB_MAKE_EQUALITY_COMPARABLE_14(namespace_semilattice_metadata_t<protocol_t>, blueprint, primary_datacenter, replica_affinities, ack_expectations, shards, name, port, primary_pinnings, secondary_pinnings, primary_key, database, cache_size, block_size, backfill_bytes_per_sec);
 
 // ctx-less json adapter concept for ack_expectation_t
 json_adapter_if_t::json_adapter_map_t get_json_subfields(ack_expectation_t *target);
@@ -180,6 +202,9 @@ public:
 template<class protocol_t>
 RDB_MAKE_SEMILATTICE_JOINABLE_1(namespaces_semilattice_metadata_t<protocol_t>, namespaces);
 
+template<class protocol_t>
+RDB_MAKE_SEMILATTICE_DELTA_1(namespaces_semilattice_metadata_t<protocol_t>, namespaces);
+
 template<class protocol_t>
 RDB_MAKE_EQUALITY_COMPARABLE_1(namespaces_semilattice_metadata_t<protocol_t>, namespaces);
 
@@ -211,6 +236,19 @@ public:
     RDB_MAKE_ME_SERIALIZABLE_1(reactor_bcards);
 };
 
+template <class protocol_t>
+void serialize_directory_delta(write_message_t *msg,
+                               const namespaces_directory_metadata_t<protocol_t> &old_value,
+                               const namespaces_directory_metadata_t<protocol_t> &new_value) {
+    serialize_directory_delta(msg, old_value.reactor_bcards, new_value.reactor_bcards);
+}
+
+template <class protocol_t>
+MUST_USE archive_result_t apply_directory_delta(read_stream_t *s,
+                                                namespaces_directory_metadata_t<protocol_t> *value) {
+    return apply_directory_delta(s, &value->reactor_bcards);
+}
+
 // ctx-less json adapter concept for namespaces_directory_metadata_t
 template <class protocol_t>
 json_adapter_if_t::json_adapter_map_t get_json_subfields(namespaces_directory_metadata_t<protocol_t> *target);
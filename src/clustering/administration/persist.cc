@@ -33,13 +33,149 @@ struct cluster_metadata_superblock_t {
     char dummy_branch_history_blob[BRANCH_HISTORY_BLOB_MAXREFLEN];
     char memcached_branch_history_blob[BRANCH_HISTORY_BLOB_MAXREFLEN];
     char rdb_branch_history_blob[BRANCH_HISTORY_BLOB_MAXREFLEN];
+
+    /* Changes to the metadata since `metadata_blob` was last written, one
+    serialized `semilattice_delta()` after another. Files from before this
+    existed have zeroes here, which is an empty blob. */
+    static const int METADATA_DELTAS_BLOB_MAXREFLEN = 500;
+    char metadata_deltas_blob[METADATA_DELTAS_BLOB_MAXREFLEN];
+
+    /* The format of the metadata in the blobs above.  Files from before this
+    existed have zeroes here. */
+    int32_t metadata_version;
 };
 
 /* Etymology: (R)ethink(D)B (m)eta(d)ata */
 const block_magic_t expected_magic = { { 'R', 'D', 'm', 'd' } };
 
+/* Bump this whenever the serialization of `cluster_semilattice_metadata_t`
+changes, and teach `migrate_metadata()` to convert the old format.  Version 0
+is from before tables had a block size, and version 1 from before they had a
+backfill budget. */
+const int32_t CLUSTER_METADATA_VERSION = 2;
+
+/* The metadata as older files hold it.  It's only ever read, to migrate those
+files. */
+template <class protocol_t>
+class namespace_semilattice_metadata_v0_t {
+public:
+    vclock_t<persistable_blueprint_t<protocol_t> > blueprint;
+    vclock_t<datacenter_id_t> primary_datacenter;
+    vclock_t<std::map<datacenter_id_t, int32_t> > replica_affinities;
+    vclock_t<std::map<datacenter_id_t, ack_expectation_t> > ack_expectations;
+    vclock_t<nonoverlapping_regions_t<protocol_t> > shards;
+    vclock_t<name_string_t> name;
+    vclock_t<int> port;
+    vclock_t<region_map_t<protocol_t, machine_id_t> > primary_pinnings;
+    vclock_t<region_map_t<protocol_t, std::set<machine_id_t> > > secondary_pinnings;
+    vclock_t<std::string> primary_key;
+    vclock_t<database_id_t> database;
+    vclock_t<int64_t> cache_size;
+
+    RDB_MAKE_ME_SERIALIZABLE_12(blueprint, primary_datacenter, replica_affinities, ack_expectations, shards, name, port, primary_pinnings, secondary_pinnings, primary_key, database, cache_size);
+};
+
+template <class protocol_t>
+class namespace_semilattice_metadata_v1_t {
+public:
+    vclock_t<persistable_blueprint_t<protocol_t> > blueprint;
+    vclock_t<datacenter_id_t> primary_datacenter;
+    vclock_t<std::map<datacenter_id_t, int32_t> > replica_affinities;
+    vclock_t<std::map<datacenter_id_t, ack_expectation_t> > ack_expectations;
+    vclock_t<nonoverlapping_regions_t<protocol_t> > shards;
+    vclock_t<name_string_t> name;
+    vclock_t<int> port;
+    vclock_t<region_map_t<protocol_t, machine_id_t> > primary_pinnings;
+    vclock_t<region_map_t<protocol_t, std::set<machine_id_t> > > secondary_pinnings;
+    vclock_t<std::string> primary_key;
+    vclock_t<database_id_t> database;
+    vclock_t<int64_t> cache_size;
+    vclock_t<int64_t> block_size;
+
+    RDB_MAKE_ME_SERIALIZABLE_13(blueprint, primary_datacenter, replica_affinities, ack_expectations, shards, name, port, primary_pinnings, secondary_pinnings, primary_key, database, cache_size, block_size);
+};
+
+template <class namespace_t>
+class old_namespaces_semilattice_metadata_t {
+public:
+    std::map<namespace_id_t, deletable_t<namespace_t> > namespaces;
+
+    RDB_MAKE_ME_SERIALIZABLE_1(namespaces);
+};
+
+// `cow_ptr_t` is serialized as what it points to.
+template <template <class> class namespace_t>
+class old_cluster_semilattice_metadata_t {
+public:
+    old_namespaces_semilattice_metadata_t<namespace_t<mock::dummy_protocol_t> > dummy_namespaces;
+    old_namespaces_semilattice_metadata_t<namespace_t<memcached_protocol_t> > memcached_namespaces;
+    old_namespaces_semilattice_metadata_t<namespace_t<rdb_protocol_t> > rdb_namespaces;
+
+    machines_semilattice_metadata_t machines;
+    datacenters_semilattice_metadata_t datacenters;
+    databases_semilattice_metadata_t databases;
+
+    RDB_MAKE_ME_SERIALIZABLE_6(dummy_namespaces, memcached_namespaces, rdb_namespaces, machines, datacenters, databases);
+};
+
+/* Settings that a table's old metadata doesn't have get their defaults, with
+the same version on every machine, so that their vclocks join cleanly. */
+template <class protocol_t>
+static void migrate_block_size(const namespace_semilattice_metadata_v0_t<protocol_t> &,
+                               namespace_semilattice_metadata_t<protocol_t> *ns_out) {
+    ns_out->block_size = vclock_t<int64_t>(DEFAULT_BTREE_BLOCK_SIZE);
+}
+
+template <class protocol_t>
+static void migrate_block_size(const namespace_semilattice_metadata_v1_t<protocol_t> &old_ns,
+                               namespace_semilattice_metadata_t<protocol_t> *ns_out) {
+    ns_out->block_size = old_ns.block_size;
+}
+
+template <template <class> class namespace_t, class protocol_t>
+static void migrate_namespaces(const old_namespaces_semilattice_metadata_t<namespace_t<protocol_t> > &old_namespaces,
+                               cow_ptr_t<namespaces_semilattice_metadata_t<protocol_t> > *namespaces_out) {
+    typename cow_ptr_t<namespaces_semilattice_metadata_t<protocol_t> >::change_t change(namespaces_out);
+    for (typename std::map<namespace_id_t, deletable_t<namespace_t<protocol_t> > >::const_iterator it
+             = old_namespaces.namespaces.begin(); it != old_namespaces.namespaces.end(); ++it) {
+        deletable_t<namespace_semilattice_metadata_t<protocol_t> > ns;
+        if (it->second.is_deleted()) {
+            ns.mark_deleted();
+        } else {
+            const namespace_t<protocol_t> &old_ns = it->second.get_ref();
+            namespace_semilattice_metadata_t<protocol_t> *new_ns = ns.get_mutable();
+            new_ns->blueprint = old_ns.blueprint;
+            new_ns->primary_datacenter = old_ns.primary_datacenter;
+            new_ns->replica_affinities = old_ns.replica_affinities;
+            new_ns->ack_expectations = old_ns.ack_expectations;
+            new_ns->shards = old_ns.shards;
+            new_ns->name = old_ns.name;
+            new_ns->port = old_ns.port;
+            new_ns->primary_pinnings = old_ns.primary_pinnings;
+            new_ns->secondary_pinnings = old_ns.secondary_pinnings;
+            new_ns->primary_key = old_ns.primary_key;
+            new_ns->database = old_ns.database;
+            new_ns->cache_size = old_ns.cache_size;
+            migrate_block_size(old_ns, new_ns);
+            new_ns->backfill_bytes_per_sec = vclock_t<int64_t>(DEFAULT_BACKFILL_BYTES_PER_SEC);
+        }
+        change.get()->namespaces[it->first] = ns;
+    }
+}
+
+template <template <class> class namespace_t>
+static void migrate_metadata_from(const old_cluster_semilattice_metadata_t<namespace_t> &old_metadata,
+                                  cluster_semilattice_metadata_t *metadata_out) {
+    migrate_namespaces(old_metadata.dummy_namespaces, &metadata_out->dummy_namespaces);
+    migrate_namespaces(old_metadata.memcached_namespaces, &metadata_out->memcached_namespaces);
+    migrate_namespaces(old_metadata.rdb_namespaces, &metadata_out->rdb_namespaces);
+    metadata_out->machines = old_metadata.machines;
+    metadata_out->datacenters = old_metadata.datacenters;
+    metadata_out->databases = old_metadata.databases;
+}
+
 template <class T>
-static void write_blob(transaction_t *txn, char *ref, int maxreflen, const T &value) {
+static std::string serialize_to_string(const T &value) {
     write_message_t msg;
     msg << value;
     intrusive_list_t<write_buffer_t> *buffers = msg.unsafe_expose_buffers();
@@ -53,11 +189,24 @@ static void write_blob(transaction_t *txn, char *ref, int maxreflen, const T &va
         str.append(p->data, p->size);
     }
     guarantee(str.size() == slen);
+    return str;
+}
+
+template <class T>
+static void write_blob(transaction_t *txn, char *ref, int maxreflen, const T &value) {
+    std::string str = serialize_to_string(value);
     blob_t blob(txn->get_cache()->get_block_size(), ref, maxreflen);
     blob.clear(txn);
     blob.append_region(txn, str.size());
     blob.write_from_string(str, txn, 0);
-    guarantee(blob.valuesize() == static_cast<int64_t>(slen));
+    guarantee(blob.valuesize() == static_cast<int64_t>(str.size()));
+}
+
+static void append_to_blob(transaction_t *txn, char *ref, int maxreflen, const std::string &str) {
+    blob_t blob(txn->get_cache()->get_block_size(), ref, maxreflen);
+    int64_t old_size = blob.valuesize();
+    blob.append_region(txn, str.size());
+    blob.write_from_string(str, txn, old_size);
 }
 
 template<class T>
@@ -72,6 +221,23 @@ static void read_blob(transaction_t *txn, const char *ref, int maxreflen, T *val
     guarantee_deserialization(res, "T (template code)");
 }
 
+/* Joins every value that was appended to the blob into `*value`. */
+template<class T>
+static void join_blob_deltas(transaction_t *txn, const char *ref, int maxreflen, T *value) {
+    blob_t blob(txn->get_cache()->get_block_size(),
+                const_cast<char *>(ref), maxreflen);
+    blob_acq_t acq_group;
+    buffer_group_t group;
+    blob.expose_all(txn, rwi_read, &group, &acq_group);
+    buffer_group_read_stream_t ss(const_view(&group));
+    while (!ss.entire_stream_consumed()) {
+        T delta;
+        archive_result_t res = deserialize(&ss, &delta);
+        guarantee_deserialization(res, "T (template code)");
+        semilattice_join(value, delta);
+    }
+}
+
 template <class metadata_t>
 persistent_file_t<metadata_t>::persistent_file_t(io_backender_t *io_backender,
                                                  const serializer_filepath_t &filename,
@@ -199,6 +365,7 @@ cluster_persistent_file_t::cluster_persistent_file_t(io_backender_t *io_backende
                                                      const serializer_filepath_t &filename,
                                                      perfmon_collection_t *perfmon_parent) :
     persistent_file_t<cluster_semilattice_metadata_t>(io_backender, filename, perfmon_parent, false) {
+    migrate_metadata();
     construct_branch_history_managers(false);
 }
 
@@ -218,6 +385,7 @@ cluster_persistent_file_t::cluster_persistent_file_t(io_backender_t *io_backende
     bzero(sb, get_cache_block_size().value());
     sb->magic = expected_magic;
     sb->machine_id = machine_id;
+    sb->metadata_version = CLUSTER_METADATA_VERSION;
     write_blob(txn.get(),
                sb->metadata_blob,
                cluster_metadata_superblock_t::METADATA_BLOB_MAXREFLEN,
@@ -235,6 +403,8 @@ cluster_persistent_file_t::cluster_persistent_file_t(io_backender_t *io_backende
                cluster_metadata_superblock_t::BRANCH_HISTORY_BLOB_MAXREFLEN,
                branch_history_t<rdb_protocol_t>());
 
+    last_metadata = initial_metadata;
+
     construct_branch_history_managers(true);
 }
 
@@ -250,16 +420,74 @@ cluster_semilattice_metadata_t cluster_persistent_file_t::read_metadata() {
     const cluster_metadata_superblock_t *sb = static_cast<const cluster_metadata_superblock_t *>(superblock.get_data_read());
     cluster_semilattice_metadata_t metadata;
     read_blob(txn.get(), sb->metadata_blob, cluster_metadata_superblock_t::METADATA_BLOB_MAXREFLEN, &metadata);
+    join_blob_deltas(txn.get(), sb->metadata_deltas_blob, cluster_metadata_superblock_t::METADATA_DELTAS_BLOB_MAXREFLEN, &metadata);
+    last_metadata = metadata;
     return metadata;
 }
 
+/* The metadata only ever grows, so instead of rewriting all of it every time
+something changes, we append the difference from what we wrote last time. Once
+the differences add up to more than the metadata itself, we write it out in full
+again so that reading it back stays cheap. */
 void cluster_persistent_file_t::update_metadata(const cluster_semilattice_metadata_t &metadata) {
     object_buffer_t<transaction_t> txn;
     get_write_transaction(&txn, "update_metadata");
     buf_lock_t superblock(txn.get(), SUPERBLOCK_ID, rwi_write);
 
+    cluster_metadata_superblock_t *sb = static_cast<cluster_metadata_superblock_t *>(superblock.get_data_write());
+    if (last_metadata) {
+        std::string delta = serialize_to_string(semilattice_delta(*last_metadata, metadata));
+        int64_t metadata_size = blob::value_size(sb->metadata_blob,
+            cluster_metadata_superblock_t::METADATA_BLOB_MAXREFLEN);
+        int64_t deltas_size = blob::value_size(sb->metadata_deltas_blob,
+            cluster_metadata_superblock_t::METADATA_DELTAS_BLOB_MAXREFLEN);
+        if (deltas_size + static_cast<int64_t>(delta.size()) <= metadata_size) {
+            append_to_blob(txn.get(), sb->metadata_deltas_blob,
+                cluster_metadata_superblock_t::METADATA_DELTAS_BLOB_MAXREFLEN, delta);
+            last_metadata = metadata;
+            return;
+        }
+    }
+
+    write_blob(txn.get(), sb->metadata_blob, cluster_metadata_superblock_t::METADATA_BLOB_MAXREFLEN, metadata);
+    blob_t deltas(get_cache_block_size(), sb->metadata_deltas_blob,
+                  cluster_metadata_superblock_t::METADATA_DELTAS_BLOB_MAXREFLEN);
+    deltas.clear(txn.get());
+    last_metadata = metadata;
+}
+
+/* Rewrites the metadata of files from older versions in the current format.
+Older versions never wrote deltas, so there's only the full metadata to
+convert. */
+void cluster_persistent_file_t::migrate_metadata() {
+    object_buffer_t<transaction_t> txn;
+    get_write_transaction(&txn, "migrate_metadata");
+    buf_lock_t superblock(txn.get(), SUPERBLOCK_ID, rwi_write);
+
+    const cluster_metadata_superblock_t *const_sb = static_cast<const cluster_metadata_superblock_t *>(superblock.get_data_read());
+    if (const_sb->metadata_version == CLUSTER_METADATA_VERSION) {
+        return;
+    }
+    guarantee(const_sb->metadata_version >= 0 && const_sb->metadata_version < CLUSTER_METADATA_VERSION,
+              "The metadata file is from a newer version of RethinkDB (metadata version %d).",
+              const_sb->metadata_version);
+    guarantee(blob::value_size(const_sb->metadata_deltas_blob,
+                               cluster_metadata_superblock_t::METADATA_DELTAS_BLOB_MAXREFLEN) == 0);
+
+    cluster_semilattice_metadata_t metadata;
+    if (const_sb->metadata_version == 0) {
+        old_cluster_semilattice_metadata_t<namespace_semilattice_metadata_v0_t> old_metadata;
+        read_blob(txn.get(), const_sb->metadata_blob, cluster_metadata_superblock_t::METADATA_BLOB_MAXREFLEN, &old_metadata);
+        migrate_metadata_from(old_metadata, &metadata);
+    } else {
+        old_cluster_semilattice_metadata_t<namespace_semilattice_metadata_v1_t> old_metadata;
+        read_blob(txn.get(), const_sb->metadata_blob, cluster_metadata_superblock_t::METADATA_BLOB_MAXREFLEN, &old_metadata);
+        migrate_metadata_from(old_metadata, &metadata);
+    }
+
     cluster_metadata_superblock_t *sb = static_cast<cluster_metadata_superblock_t *>(superblock.get_data_write());
     write_blob(txn.get(), sb->metadata_blob, cluster_metadata_superblock_t::METADATA_BLOB_MAXREFLEN, metadata);
+    sb->metadata_version = CLUSTER_METADATA_VERSION;
 }
 
 machine_id_t cluster_persistent_file_t::read_machine_id() {
@@ -4,6 +4,9 @@
 
 #include <string>
 
+#include "errors.hpp"
+#include <boost/optional.hpp>
+
 #include "buffer_cache/mirrored/config.hpp"
 #include "buffer_cache/types.hpp"
 #include "clustering/administration/metadata.hpp"
@@ -86,8 +89,13 @@ public:
     branch_history_manager_t<rdb_protocol_t> *get_rdb_branch_history_manager();
 
 private:
+    void migrate_metadata();
     void construct_branch_history_managers(bool create);
 
+    /* What's on disk as of the last `read_metadata()` or `update_metadata()`.
+    `update_metadata()` only writes the difference from it. */
+    boost::optional<cluster_semilattice_metadata_t> last_metadata;
+
     template <class protocol_t> class persistent_branch_history_manager_t;
 
     friend class persistent_branch_history_manager_t<mock::dummy_protocol_t>;
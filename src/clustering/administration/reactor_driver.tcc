@@ -115,16 +115,20 @@ public:
                             reactor_driver_t<protocol_t> *parent,
                             namespace_id_t namespace_id,
                             int64_t _cache_size,
+                            int64_t _block_size,
+                            int64_t _backfill_bytes_per_sec,
                             const blueprint_t<protocol_t> &bp,
                             svs_by_namespace_t<protocol_t> *svs_by_namespace,
                             typename protocol_t::context_t *_ctx) :
         base_path(_base_path),
         watchable(bp),
+        backfill_bytes_per_sec(_backfill_bytes_per_sec),
         ctx(_ctx),
         parent_(parent),
         namespace_id_(namespace_id),
         svs_by_namespace_(svs_by_namespace),
-        cache_size(_cache_size)
+        cache_size(_cache_size),
+        block_size(_block_size)
     {
         coro_t::spawn_sometime(boost::bind(&watchable_and_reactor_t<protocol_t>::initialize_reactor, this, io_backender));
     }
@@ -307,7 +311,7 @@ private:
         perfmon_collection_t *serializers_collection = &perfmon_collections->serializers_collection;
 
         // TODO: We probably shouldn't have to pass in this perfmon collection.
-        svs_by_namespace_->get_svs(serializers_collection, namespace_id_, cache_size, &stores_lifetimer_, &svs_, ctx);
+        svs_by_namespace_->get_svs(serializers_collection, namespace_id_, cache_size, block_size, &stores_lifetimer_, &svs_, ctx);
 
         reactor_.init(new reactor_t<protocol_t>(
             base_path,
@@ -317,6 +321,7 @@ private:
             parent_->directory_view->subview(boost::bind(&watchable_and_reactor_t<protocol_t>::extract_reactor_directory, this, _1)),
             parent_->branch_history_manager,
             watchable.get_watchable(),
+            backfill_bytes_per_sec.get_watchable(),
             svs_.get(), namespace_collection, ctx));
 
         {
@@ -340,6 +345,7 @@ private:
     const base_path_t base_path;
 public:
     watchable_variable_t<blueprint_t<protocol_t> > watchable;
+    watchable_variable_t<int64_t> backfill_bytes_per_sec;
 
     typename protocol_t::context_t *const ctx;
 
@@ -356,6 +362,7 @@ private:
 
     scoped_ptr_t<typename watchable_t<directory_echo_wrapper_t<cow_ptr_t<reactor_business_card_t<protocol_t> > > >::subscription_t> reactor_directory_subscription_;
     int64_t cache_size;
+    int64_t block_size;
 
     DISABLE_COPYING(watchable_and_reactor_t);
 };
@@ -445,6 +452,19 @@ void reactor_driver_t<protocol_t>::on_change() {
 
             blueprint_t<protocol_t> bp = translate_blueprint(pbp, machine_id_translation_table->get());
 
+            /* Unlike the cache and block sizes, this applies to a table's
+            reactor while it runs. */
+            int64_t backfill_bytes_per_sec;
+            if (it->second.get_ref().backfill_bytes_per_sec.in_conflict()) {
+                backfill_bytes_per_sec = DEFAULT_BACKFILL_BYTES_PER_SEC;
+            } else {
+                backfill_bytes_per_sec = it->second.get_ref().backfill_bytes_per_sec.get();
+            }
+
+            if (backfill_bytes_per_sec < 0) {
+                backfill_bytes_per_sec = DEFAULT_BACKFILL_BYTES_PER_SEC;
+            }
+
             if (std_contains(bp.peers_roles, mbox_manager->get_connectivity_service()->get_me())) {
                 /* Either construct a new reactor (if this is a namespace we
                  * haven't seen before). Or send the new blueprint to the
@@ -471,10 +491,29 @@ void reactor_driver_t<protocol_t>::on_change() {
                                 it->second.get_ref().name.in_conflict() ? "Name in conflict" : it->second.get_ref().name.get().c_str());
                     }
 
+                    int64_t block_size;
+                    if (it->second.get_ref().block_size.in_conflict()) {
+                        block_size = DEFAULT_BTREE_BLOCK_SIZE;
+                    } else {
+                        block_size = it->second.get_ref().block_size.get();
+                    }
+
+                    if (!is_valid_btree_block_size(block_size)) {
+                        logWRN("Namespace %s(%s) has an invalid block size of %" PRIi64 " bytes. Using %" PRIi64 " bytes instead.\n",
+                                uuid_to_str(it->first).c_str(),
+                                it->second.get_ref().name.in_conflict() ? "Name in conflict" : it->second.get_ref().name.get().c_str(),
+                                block_size, static_cast<int64_t>(DEFAULT_BTREE_BLOCK_SIZE));
+                        block_size = DEFAULT_BTREE_BLOCK_SIZE;
+                    }
+
                     namespace_id_t tmp = it->first;
-                    reactor_data.insert(tmp, new watchable_and_reactor_t<protocol_t>(base_path, io_backender, this, it->first, cache_size, bp, svs_by_namespace, ctx));
+                    reactor_data.insert(tmp, new watchable_and_reactor_t<protocol_t>(base_path, io_backender, this, it->first, cache_size, block_size, backfill_bytes_per_sec, bp, svs_by_namespace, ctx));
                 } else {
-                    reactor_data.find(it->first)->second->watchable.set_value(bp);
+                    watchable_and_reactor_t<protocol_t> *reactor = reactor_data.find(it->first)->second;
+                    reactor->watchable.set_value(bp);
+                    if (reactor->backfill_bytes_per_sec.get_watchable()->get() != backfill_bytes_per_sec) {
+                        reactor->backfill_bytes_per_sec.set_value(backfill_bytes_per_sec);
+                    }
                 }
             } else {
                 /* The blueprint does not mentions us so we destroy the
@@ -6,13 +6,20 @@
 #include "concurrency/watchable.hpp"
 #include "perfmon/collect.hpp"
 #include "perfmon/archive.hpp"
+#include "perfmon/core.hpp"
 #include "stl_utils.hpp"
 
+// How long a collected result is handed out again to identical requests.
+static const int64_t STATS_CACHE_TTL_MS = 500;
+
 stat_manager_t::stat_manager_t(mailbox_manager_t* mm) :
     mailbox_manager(mm),
-    get_stats_mailbox(mailbox_manager, boost::bind(&stat_manager_t::on_stats_request, this, _1, _2))
+    get_stats_mailbox(mailbox_manager, boost::bind(&stat_manager_t::on_stats_request, this, _1, _2)),
+    cached_at(0)
     { }
 
+stat_manager_t::~stat_manager_t() { }
+
 get_stats_mailbox_address_t stat_manager_t::get_address() {
     return get_stats_mailbox.get_address();
 }
@@ -22,9 +29,15 @@ void stat_manager_t::on_stats_request(const return_address_t& reply_address, con
 }
 
 void stat_manager_t::perform_stats_request(const return_address_t& reply_address, const std::set<std::string>& requested_stats, auto_drainer_t::lock_t) {
-    perfmon_filter_t request(requested_stats);
-    scoped_ptr_t<perfmon_result_t> perfmon_result(perfmon_get_stats());
-    request.filter(&perfmon_result);
-    guarantee(perfmon_result.has());
-    send(mailbox_manager, reply_address, *perfmon_result);
+    mutex_t::acq_t acq(&collection_mutex);
+    if (!cached_result.has()
+        || cached_request != requested_stats
+        || get_ticks() - cached_at > secs_to_ticks(1) * STATS_CACHE_TTL_MS / 1000) {
+        perfmon_filter_t request(requested_stats);
+        cached_result = perfmon_get_stats(request);
+        cached_request = requested_stats;
+        cached_at = get_ticks();
+    }
+    guarantee(cached_result.has());
+    send(mailbox_manager, reply_address, *cached_result);
 }
@@ -6,6 +6,8 @@
 #include <map>
 #include <set>
 
+#include "concurrency/mutex.hpp"
+#include "containers/scoped.hpp"
 #include "perfmon/types.hpp"
 #include "rpc/mailbox/typed.hpp"
 
@@ -17,6 +19,7 @@ public:
     typedef get_stats_mailbox_t::address_t get_stats_mailbox_address_t;
 
     explicit stat_manager_t(mailbox_manager_t* mailbox_manager);
+    ~stat_manager_t();
 
     get_stats_mailbox_address_t get_address();
 
@@ -27,6 +30,17 @@ private:
     mailbox_manager_t *mailbox_manager;
     get_stats_mailbox_t get_stats_mailbox;
 
+    /* Every open admin dashboard polls every machine for stats, so identical
+    requests tend to arrive in bursts. Collecting stats means visiting every
+    perfmon on every thread, so we hand out the last result again if the same
+    stats were asked for very recently. `collection_mutex` makes concurrent
+    requests wait for the collection already in progress instead of starting
+    their own. */
+    mutex_t collection_mutex;
+    std::set<stat_id_t> cached_request;
+    ticks_t cached_at;
+    scoped_ptr_t<perfmon_result_t> cached_result;
+
     auto_drainer_t drainer;
 
     DISABLE_COPYING(stat_manager_t);
@@ -13,30 +13,62 @@
 
 template <class protocol_t>
 struct backfill_queue_entry_t {
+    enum kind_t {
+        /* A backfill chunk */
+        CHUNK,
+        /* The start of a slice of the backfill; says what version that slice
+        will be at once we have all of it */
+        END_POINT,
+        /* The end of a slice; every chunk of it came before this */
+        SLICE_DONE,
+        /* The end of the backfill */
+        DONE
+    };
+
     // TODO: The fact that fifo_enforcer_queue_t requires a default
     // constructor (and assignment operator, presumably) is completely asinine.
     backfill_queue_entry_t() { }
-    backfill_queue_entry_t(bool _is_not_last_backfill_chunk,
-                           const typename protocol_t::backfill_chunk_t &_chunk,
-                           fifo_enforcer_write_token_t _write_token)
-        : is_not_last_backfill_chunk(_is_not_last_backfill_chunk),
-          chunk(_chunk),
-          write_token(_write_token) { }
-
-    bool is_not_last_backfill_chunk;
+    backfill_queue_entry_t(kind_t _kind, fifo_enforcer_write_token_t _write_token)
+        : kind(_kind), write_token(_write_token) { }
+
+    kind_t kind;
     typename protocol_t::backfill_chunk_t chunk;
+    region_map_t<protocol_t, version_range_t> end_point;
+    branch_history_t<protocol_t> end_point_associated_branch_history;
     fifo_enforcer_write_token_t write_token;
 };
 
 template <class protocol_t>
 void push_chunk_on_queue(fifo_enforcer_queue_t<backfill_queue_entry_t<protocol_t> > *queue,
                          typename protocol_t::backfill_chunk_t chunk, fifo_enforcer_write_token_t token) {
-    queue->push(token, backfill_queue_entry_t<protocol_t>(true, chunk, token));
+    backfill_queue_entry_t<protocol_t> entry(backfill_queue_entry_t<protocol_t>::CHUNK, token);
+    entry.chunk = chunk;
+    queue->push(token, entry);
+}
+
+template <class protocol_t>
+void push_end_point_on_queue(fifo_enforcer_queue_t<backfill_queue_entry_t<protocol_t> > *queue,
+                             const region_map_t<protocol_t, version_range_t> &end_point,
+                             const branch_history_t<protocol_t> &associated_branch_history,
+                             fifo_enforcer_write_token_t token) {
+    backfill_queue_entry_t<protocol_t> entry(backfill_queue_entry_t<protocol_t>::END_POINT, token);
+    entry.end_point = end_point;
+    entry.end_point_associated_branch_history = associated_branch_history;
+    queue->push(token, entry);
+}
+
+template <class protocol_t>
+void push_slice_done_on_queue(fifo_enforcer_queue_t<backfill_queue_entry_t<protocol_t> > *queue,
+                              const region_map_t<protocol_t, version_range_t> &end_point,
+                              fifo_enforcer_write_token_t token) {
+    backfill_queue_entry_t<protocol_t> entry(backfill_queue_entry_t<protocol_t>::SLICE_DONE, token);
+    entry.end_point = end_point;
+    queue->push(token, entry);
 }
 
 template <class protocol_t>
 void push_finish_on_queue(fifo_enforcer_queue_t<backfill_queue_entry_t<protocol_t> > *queue, fifo_enforcer_write_token_t token) {
-    queue->push(token, backfill_queue_entry_t<protocol_t>(false, typename protocol_t::backfill_chunk_t(), token));
+    queue->push(token, backfill_queue_entry_t<protocol_t>(backfill_queue_entry_t<protocol_t>::DONE, token));
 }
 
 
@@ -47,11 +79,17 @@ class chunk_callback_t : public coro_pool_callback_t<backfill_queue_entry_t<prot
                          public home_thread_mixin_debug_only_t {
 public:
     chunk_callback_t(store_view_t<protocol_t> *_svs,
+                     branch_history_manager_t<protocol_t> *_branch_history_manager,
+                     const region_map_t<protocol_t, version_range_t> &_start_point,
+                     order_source_t *_order_source,
                      fifo_enforcer_queue_t<backfill_queue_entry_t<protocol_t> > *_chunk_queue, mailbox_manager_t *_mbox_manager,
                      mailbox_addr_t<void(int)> _allocation_mailbox) :
-        svs(_svs), chunk_queue(_chunk_queue), mbox_manager(_mbox_manager),
+        svs(_svs), branch_history_manager(_branch_history_manager),
+        current_point(_start_point), order_source(_order_source),
+        chunk_queue(_chunk_queue), mbox_manager(_mbox_manager),
         allocation_mailbox(_allocation_mailbox), unacked_chunks(0),
-        done_message_arrived(false), num_outstanding_chunks(0)
+        done_message_arrived(false), num_outstanding_chunks(0),
+        outstanding_chunks_done(NULL)
     { }
 
     void apply_backfill_chunk(fifo_enforcer_write_token_t chunk_token, const typename protocol_t::backfill_chunk_t& chunk, signal_t *interruptor) {
@@ -63,10 +101,76 @@ public:
         svs->receive_backfill(chunk, &token_pair, interruptor);
     }
 
+    /* Called when a new slice of the backfill starts. Other slices may be
+    going on at the same time; they're all for different parts of the region. */
+    void start_slice(const backfill_queue_entry_t<protocol_t> &entry, signal_t *interruptor) {
+        /* Record the updated branch history information that we got. It's
+        essential that we call `record_branch_history()` before we update the
+        metainfo, because otherwise if we crashed at a bad time the data might
+        make it to disk as part of the metainfo but not as part of the branch
+        history, and that would lead to crashes. */
+        {
+            cross_thread_signal_t ct_interruptor(interruptor, branch_history_manager->home_thread());
+            on_thread_t th(branch_history_manager->home_thread());
+            branch_history_manager->import_branch_history(entry.end_point_associated_branch_history, &ct_interruptor);
+        }
+
+        /* Indicate in the metadata that the slice is being backfilled. We do
+        this by marking its region as indeterminate between the current state
+        and the slice's end state, since we don't know whether the backfill has
+        reached each part of it yet. */
+
+        typedef region_map_t<protocol_t, version_range_t> version_map_t;
+
+        const version_map_t start_point = current_point.mask(entry.end_point.get_domain());
+
+        std::vector<std::pair<typename protocol_t::region_t, version_range_t> > span_parts;
+
+        {
+#ifndef NDEBUG
+            on_thread_t th(branch_history_manager->home_thread());
+#endif
+            for (typename version_map_t::const_iterator it = start_point.begin(); it != start_point.end(); ++it) {
+                for (typename version_map_t::const_iterator jt = entry.end_point.begin(); jt != entry.end_point.end(); ++jt) {
+                    typename protocol_t::region_t ixn = region_intersection(it->first, jt->first);
+                    if (!region_is_empty(ixn)) {
+                        rassert(version_is_ancestor(branch_history_manager,
+                                                             it->second.earliest,
+                                                             jt->second.latest,
+                                                             ixn),
+                                         "We're on a different timeline than the backfiller, "
+                                         "but it somehow failed to notice.");
+                        span_parts.push_back(std::make_pair(
+                                                            ixn,
+                                                            version_range_t(it->second.earliest, jt->second.latest)));
+                    }
+                }
+            }
+        }
+
+        set_metainfo(version_map_t(span_parts.begin(), span_parts.end()), "backfillee(B)", interruptor);
+    }
+
+    /* Called when a slice of the backfill is over. All of its chunks came
+    before this in the queue, so once everything that has started has been
+    applied, the slice is at its end point and we can say so in the metainfo.
+    That's the checkpoint that lets an interrupted backfill pick up where it
+    left off. */
+    void finish_slice(const backfill_queue_entry_t<protocol_t> &entry, signal_t *interruptor) {
+        if (num_outstanding_chunks != 0) {
+            cond_t chunks_done;
+            assignment_sentry_t<cond_t *> notify_when_done(&outstanding_chunks_done, &chunks_done);
+            wait_interruptible(&chunks_done, interruptor);
+        }
+
+        set_metainfo(entry.end_point, "backfillee(C)", interruptor);
+        current_point.update(entry.end_point);
+    }
+
     void coro_pool_callback(backfill_queue_entry_t<protocol_t> chunk, signal_t *interruptor) {
         assert_thread();
         try {
-            if (chunk.is_not_last_backfill_chunk) {
+            if (chunk.kind == backfill_queue_entry_t<protocol_t>::CHUNK) {
                 /* This is an actual backfill chunk */
 
                 /* Before letting the next thing go, increment
@@ -99,6 +203,21 @@ public:
                 }
 
                 num_outstanding_chunks--;
+                if (num_outstanding_chunks == 0 && outstanding_chunks_done != NULL) {
+                    outstanding_chunks_done->pulse();
+                }
+
+            } else if (chunk.kind == backfill_queue_entry_t<protocol_t>::END_POINT) {
+                /* Nothing after this can start until the slice's metainfo is
+                in place, so we hold on to the queue until then. */
+                start_slice(chunk, interruptor);
+                chunk_queue->finish_write(chunk.write_token);
+
+            } else if (chunk.kind == backfill_queue_entry_t<protocol_t>::SLICE_DONE) {
+                /* Likewise, nothing after this can start until we've waited
+                for the slice's chunks to be applied. */
+                finish_slice(chunk, interruptor);
+                chunk_queue->finish_write(chunk.write_token);
 
             } else {
                 /* This is a fake backfill "chunk" that just indicates
@@ -117,31 +236,53 @@ public:
                before the queue drains. That can only happen if we are
                being interrupted or if we lost contact with the backfiller.
                In either case, abort; the store will be left in a
-               half-backfilled state. */
+               half-backfilled state, but every slice that we finished is
+               marked as done, so the next backfill won't have to send it
+               again. */
         }
     }
 
+    /* The versions that the finished slices brought the store to. Once
+    `done_cond` is pulsed, that's the end point of the whole backfill. */
+    const region_map_t<protocol_t, version_range_t> &get_end_point() const {
+        return current_point;
+    }
+
     cond_t done_cond;
 
 private:
+    void set_metainfo(const region_map_t<protocol_t, version_range_t> &metainfo,
+                      const char *tag, signal_t *interruptor) {
+        object_buffer_t<fifo_enforcer_sink_t::exit_write_t> write_token;
+        svs->new_write_token(&write_token);
+
+        svs->set_metainfo(
+            region_map_transform<protocol_t, version_range_t, binary_blob_t>(
+                metainfo,
+                &binary_blob_t::make<version_range_t>),
+            order_source->check_in(tag),
+            &write_token,
+            interruptor);
+    }
+
     store_view_t<protocol_t> *svs;
+    branch_history_manager_t<protocol_t> *branch_history_manager;
+    /* The versions that the store is at, as far as we know; it doesn't include
+    the slices that are in progress. */
+    region_map_t<protocol_t, version_range_t> current_point;
+    order_source_t *order_source;
     fifo_enforcer_queue_t<backfill_queue_entry_t<protocol_t> > *chunk_queue;
     mailbox_manager_t *mbox_manager;
     mailbox_addr_t<void(int)> allocation_mailbox;
     int unacked_chunks;
     bool done_message_arrived;
     int num_outstanding_chunks;
+    /* Pulsed when `num_outstanding_chunks` goes to zero, if it's set. */
+    cond_t *outstanding_chunks_done;
 
     DISABLE_COPYING(chunk_callback_t);
 };
 
-template <class protocol_t>
-void receive_end_point_message(promise_t<std::pair<region_map_t<protocol_t, version_range_t>, branch_history_t<protocol_t> > > *promise,
-        const region_map_t<protocol_t, version_range_t> &end_point,
-        const branch_history_t<protocol_t> &associated_branch_history) {
-    promise->pulse(std::make_pair(end_point, associated_branch_history));
-}
-
 template<class protocol_t>
 void backfillee(
         mailbox_manager_t *mailbox_manager,
@@ -156,7 +297,9 @@ void backfillee(
     rassert(region_is_superset(svs->get_region(), region));
     resource_access_t<backfiller_business_card_t<protocol_t> > backfiller(backfiller_metadata);
 
-    /* Read the metadata to determine where we're starting from */
+    /* Read the metadata to determine where we're starting from. If an earlier
+    backfill was interrupted, the slices it finished are already at their end
+    points, so the backfiller won't send them again. */
     object_buffer_t<fifo_enforcer_sink_t::exit_read_t> read_token;
     svs->new_read_token(&read_token);
 
@@ -175,13 +318,7 @@ void backfillee(
         branch_history_manager->export_branch_history(start_point, &start_point_associated_history);
     }
 
-    /* The backfiller will send a message to `end_point_mailbox` before it sends
-    any other messages; that message will tell us what the version will be when
-    the backfill is over. */
-    promise_t<std::pair<region_map_t<protocol_t, version_range_t>, branch_history_t<protocol_t> > > end_point_cond;
-    mailbox_t<void(region_map_t<protocol_t, version_range_t>, branch_history_t<protocol_t>)> end_point_mailbox(
-        mailbox_manager,
-        boost::bind(&receive_end_point_message<protocol_t>, &end_point_cond, _1, _2));
+    region_map_t<protocol_t, version_range_t> end_point;
 
     {
         typedef typename protocol_t::backfill_chunk_t backfill_chunk_t;
@@ -192,16 +329,30 @@ void backfillee(
 
         fifo_enforcer_queue_t<backfill_queue_entry_t<protocol_t> > chunk_queue;
 
+        /* Before each slice of the backfill, the backfiller sends a message to
+        `end_point_mailbox` that tells us what the version of that slice will
+        be when it's over. */
+        mailbox_t<void(region_map_t<protocol_t, version_range_t>, branch_history_t<protocol_t>, fifo_enforcer_write_token_t)> end_point_mailbox(
+            mailbox_manager,
+            boost::bind(&push_end_point_on_queue<protocol_t>, &chunk_queue, _1, _2, _3));
+
+        /* After the last chunk of each slice, the backfiller sends the slice's
+        end point again to `slice_done_mailbox`. */
+        mailbox_t<void(region_map_t<protocol_t, version_range_t>, fifo_enforcer_write_token_t)> slice_done_mailbox(
+            mailbox_manager,
+            boost::bind(&push_slice_done_on_queue<protocol_t>, &chunk_queue, _1, _2));
+
         /* The backfiller will notify `done_mailbox` when the backfill is all over
-        and the version described in `end_point_mailbox` has been achieved. */
+        and every slice is done. */
         mailbox_t<void(fifo_enforcer_write_token_t)> done_mailbox(
             mailbox_manager,
             boost::bind(&push_finish_on_queue<protocol_t>, &chunk_queue, _1));
 
         /* The backfiller will send individual chunks of the backfill to
-        `chunk_mailbox`. */
+        `chunk_mailbox`. They are bulk traffic, so they yield to queries. */
         mailbox_t<void(backfill_chunk_t, fifo_enforcer_write_token_t)> chunk_mailbox(
-            mailbox_manager, boost::bind(&push_chunk_on_queue<protocol_t>, &chunk_queue, _1, _2));
+            mailbox_manager, boost::bind(&push_chunk_on_queue<protocol_t>, &chunk_queue, _1, _2),
+            MESSAGE_CLASS_BACKFILL);
 
         /* The backfiller will register for allocations on the allocation
          * registration box. */
@@ -215,6 +366,7 @@ void backfillee(
             backfill_session_id,
             start_point, start_point_associated_history,
             end_point_mailbox.get_address(),
+            slice_done_mailbox.get_address(),
             chunk_mailbox.get_address(),
             done_mailbox.get_address(),
             alloc_registration_mbox.get_address());
@@ -250,74 +402,8 @@ void backfillee(
             guarantee(got_value);
         }
 
-        /* Wait until we get a message in `end_point_mailbox`. */
-        {
-            wait_any_t waiter(end_point_cond.get_ready_signal(), backfiller.get_failed_signal());
-            wait_interruptible(&waiter, interruptor);
-
-            /* Throw an exception if backfiller died */
-            backfiller.access();
-            guarantee(end_point_cond.get_ready_signal()->is_pulsed());
-        }
-
-        /* Record the updated branch history information that we got. It's
-        essential that we call `record_branch_history()` before we update the
-        metainfo, because otherwise if we crashed at a bad time the data might
-        make it to disk as part of the metainfo but not as part of the branch
-        history, and that would lead to crashes. */
-        {
-            cross_thread_signal_t ct_interruptor(interruptor, branch_history_manager->home_thread());
-            branch_history_t<protocol_t> branch_history = end_point_cond.wait().second;
-            on_thread_t th(branch_history_manager->home_thread());
-            branch_history_manager->import_branch_history(branch_history, &ct_interruptor);
-        }
-
-        /* Indicate in the metadata that a backfill is happening. We do this by
-        marking every region as indeterminate between the current state and the
-        backfill end state, since we don't know whether the backfill has reached
-        that region yet. */
-
-        typedef region_map_t<protocol_t, version_range_t> version_map_t;
-
-        version_map_t end_point = end_point_cond.wait().first;
-
-        std::vector<std::pair<typename protocol_t::region_t, version_range_t> > span_parts;
-
-        {
-#ifndef NDEBUG
-            on_thread_t th(branch_history_manager->home_thread());
-#endif
-            for (typename version_map_t::const_iterator it = start_point.begin(); it != start_point.end(); ++it) {
-                for (typename version_map_t::const_iterator jt = end_point.begin(); jt != end_point.end(); ++jt) {
-                    typename protocol_t::region_t ixn = region_intersection(it->first, jt->first);
-                    if (!region_is_empty(ixn)) {
-                        rassert(version_is_ancestor(branch_history_manager,
-                                                             it->second.earliest,
-                                                             jt->second.latest,
-                                                             ixn),
-                                         "We're on a different timeline than the backfiller, "
-                                         "but it somehow failed to notice.");
-                        span_parts.push_back(std::make_pair(
-                                                            ixn,
-                                                            version_range_t(it->second.earliest, jt->second.latest)));
-                    }
-                }
-            }
-        }
-
-        object_buffer_t<fifo_enforcer_sink_t::exit_write_t> write_token;
-
-        svs->new_write_token(&write_token);
-
-        svs->set_metainfo(
-            region_map_transform<protocol_t, version_range_t, binary_blob_t>(
-                region_map_t<protocol_t, version_range_t>(span_parts.begin(), span_parts.end()),
-                &binary_blob_t::make<version_range_t>),
-            order_source.check_in("backfillee(B)"),
-            &write_token,
-            interruptor);
-
-        chunk_callback_t<protocol_t> chunk_callback(svs, &chunk_queue, mailbox_manager, allocation_mailbox);
+        chunk_callback_t<protocol_t> chunk_callback(svs, branch_history_manager, start_point, &order_source,
+                                                    &chunk_queue, mailbox_manager, allocation_mailbox);
 
         coro_pool_t<backfill_queue_entry_t<protocol_t> > backfill_workers(10, &chunk_queue, &chunk_callback);
 
@@ -332,6 +418,9 @@ void backfillee(
             guarantee(chunk_callback.done_cond.is_pulsed());
         }
 
+        end_point = chunk_callback.get_end_point();
+        rassert(end_point.get_domain() == region);
+
         /* All went well, so don't send a cancel message to the backfiller */
         backfiller_notifier.fun = 0;
     }
@@ -341,9 +430,9 @@ void backfillee(
     svs->new_write_token(&write_token);
 
     svs->set_metainfo(
-        region_map_transform<protocol_t, version_range_t, binary_blob_t>(end_point_cond.wait().first,
+        region_map_transform<protocol_t, version_range_t, binary_blob_t>(end_point,
                                                                          &binary_blob_t::make<version_range_t>),
-        order_source.check_in("backfillee(C)"),
+        order_source.check_in("backfillee(D)"),
         &write_token,
         interruptor);
 }
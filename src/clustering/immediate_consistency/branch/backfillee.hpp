@@ -11,7 +11,9 @@ template <class> class clone_ptr_t;
 template <class> class watchable_t;
 
 /* `backfillee()` contacts the given backfiller and requests a backfill from it.
-It takes responsibility for updating the metainfo. */
+It takes responsibility for updating the metainfo. The backfill arrives in
+slices, and the metainfo records each slice as it is finished; so if the
+backfill is interrupted, calling `backfillee()` again picks up from there. */
 
 template<class protocol_t>
 void backfillee(
@@ -1,9 +1,14 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include "clustering/immediate_consistency/branch/backfiller.hpp"
 
+#include <algorithm>
+#include <functional>
+
 #include "btree/parallel_traversal.hpp"
 #include "clustering/immediate_consistency/branch/history.hpp"
 #include "concurrency/fifo_enforcer.hpp"
+#include "concurrency/pmap.hpp"
+#include "concurrency/rate_limiter.hpp"
 #include "concurrency/semaphore.hpp"
 #include "rpc/semilattice/view.hpp"
 #include "stl_utils.hpp"
@@ -14,14 +19,88 @@ inline state_timestamp_t get_earliest_timestamp_of_version_range(const version_r
     return vr.earliest.timestamp;
 }
 
+/* The rate that a backfill goes on at, given the one it's going at, the
+table's setting, and how long the backfill just had to wait for its turn on
+the thread. */
+static int64_t adapt_backfill_rate(int64_t rate, int64_t max_rate, int64_t lag_ms) {
+    if (max_rate == 0) {
+        return 0;
+    }
+    if (rate == 0 || rate > max_rate) {
+        rate = max_rate;
+    }
+    if (lag_ms > BACKFILL_BUSY_THREAD_LAG_MS) {
+        return std::max<int64_t>(std::min<int64_t>(BACKFILL_MIN_BYTES_PER_SEC, max_rate), rate / 2);
+    } else {
+        return std::min<int64_t>(max_rate, rate + max_rate / 8);
+    }
+}
+
+template <class protocol_t>
+struct backfiller_t<protocol_t>::session_t {
+    session_t(const end_point_addr_t &_end_point_cont,
+              const slice_done_addr_t &_slice_done_cont,
+              const chunk_addr_t &_chunk_cont,
+              const clone_ptr_t<watchable_t<int64_t> > &_max_bytes_per_sec) :
+        end_point_cont(_end_point_cont), slice_done_cont(_slice_done_cont),
+        chunk_cont(_chunk_cont), chunk_semaphore(MAX_CHUNKS_OUT),
+        slice_semaphore(BACKFILL_CONCURRENT_SLICES),
+        max_bytes_per_sec(_max_bytes_per_sec),
+        throttle(max_bytes_per_sec->get()), last_load_check(get_ticks()) { }
+
+    /* Waits for `size` more bytes to fit in the budget. Every so often, it
+    first sees how busy the thread is and sets the rate for the next while. */
+    void pace(int64_t size, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+        ticks_t now = get_ticks();
+        if (now - last_load_check >= ms_to_ticks(BACKFILL_LOAD_CHECK_INTERVAL_MS)) {
+            last_load_check = now;
+            /* Everything else that's ready to run on the thread goes first, so
+            the more queries the thread is busy with, the longer this takes. */
+            coro_t::yield();
+            int64_t lag_ms = ticks_to_ms(get_ticks() - now);
+            throttle.set_rate(adapt_backfill_rate(throttle.get_rate(), max_bytes_per_sec->get(), lag_ms));
+        }
+        throttle.co_consume(size, interruptor);
+    }
+
+    end_point_addr_t end_point_cont;
+    slice_done_addr_t slice_done_cont;
+    chunk_addr_t chunk_cont;
+
+    /* Orders the end points, chunks, and the final confirmation the same way
+    on the backfillee as they were sent. */
+    fifo_enforcer_source_t fifo_src;
+
+    /* Keeps us from sending more chunks than the backfillee has asked for. */
+    static_semaphore_t chunk_semaphore;
+
+    /* Limits how many slices are sent at the same time. */
+    static_semaphore_t slice_semaphore;
+
+    /* Keeps the backfill to its budget. The btree traversal waits for each
+    chunk to be sent before it reads much more, so this paces the disk reads
+    too. */
+    clone_ptr_t<watchable_t<int64_t> > max_bytes_per_sec;
+    rate_limiter_t throttle;
+    ticks_t last_load_check;
+
+    session_progress_t progress;
+};
+
 template <class protocol_t>
 backfiller_t<protocol_t>::backfiller_t(mailbox_manager_t *mm,
                                        branch_history_manager_t<protocol_t> *bhm,
-                                       store_view_t<protocol_t> *_svs)
+                                       store_view_t<protocol_t> *_svs,
+                                       const clone_ptr_t<watchable_t<int64_t> > &_max_bytes_per_sec)
     : mailbox_manager(mm), branch_history_manager(bhm),
-      svs(_svs),
+      svs(_svs), max_bytes_per_sec(_max_bytes_per_sec),
+      // `boost::bind()` doesn't take member functions with this many arguments.
       backfill_mailbox(mailbox_manager,
-                       boost::bind(&backfiller_t::on_backfill, this, _1, _2, _3, _4, _5, _6, _7, auto_drainer_t::lock_t(&drainer))),
+                       std::bind(&backfiller_t::on_backfill, this,
+                                 std::placeholders::_1, std::placeholders::_2, std::placeholders::_3,
+                                 std::placeholders::_4, std::placeholders::_5, std::placeholders::_6,
+                                 std::placeholders::_7, std::placeholders::_8,
+                                 auto_drainer_t::lock_t(&drainer))),
       cancel_backfill_mailbox(mailbox_manager,
                               boost::bind(&backfiller_t::on_cancel_backfill, this, _1, auto_drainer_t::lock_t(&drainer))),
       request_progress_mailbox(mailbox_manager,
@@ -37,7 +116,8 @@ backfiller_business_card_t<protocol_t> backfiller_t<protocol_t>::get_business_ca
 template <class protocol_t>
 bool backfiller_t<protocol_t>::confirm_and_send_metainfo(typename store_view_t<protocol_t>::metainfo_t metainfo,
                                                          region_map_t<protocol_t, version_range_t> start_point,
-                                                         mailbox_addr_t<void(region_map_t<protocol_t, version_range_t>, branch_history_t<protocol_t>)> end_point_cont) {
+                                                         session_t *session,
+                                                         region_map_t<protocol_t, version_range_t> *end_point_out) {
     guarantee(metainfo.get_domain() == start_point.get_domain());
     region_map_t<protocol_t, version_range_t> end_point =
         region_map_transform<protocol_t, binary_blob_t, version_range_t>(metainfo,
@@ -80,65 +160,102 @@ bool backfiller_t<protocol_t>::confirm_and_send_metainfo(typename store_view_t<p
     }
 
     /* Transmit `end_point` to the backfillee */
-    send(mailbox_manager, end_point_cont, end_point, branch_history);
+    send(mailbox_manager, session->end_point_cont, end_point, branch_history, session->fifo_src.enter_write());
 
+    *end_point_out = end_point;
     return true;
 }
 
-template <class protocol_t>
-void do_send_chunk(mailbox_manager_t *mbox_manager,
-                   mailbox_addr_t<void(typename protocol_t::backfill_chunk_t, fifo_enforcer_write_token_t)> chunk_addr,
-                   const typename protocol_t::backfill_chunk_t &chunk,
-                   fifo_enforcer_source_t *fifo_src,
-                   semaphore_t *chunk_semaphore,
-                   signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
-    chunk_semaphore->co_lock_interruptible(interruptor);
-    send(mbox_manager, chunk_addr, chunk, fifo_src->enter_write());
-}
-
 template <class protocol_t>
 class backfiller_send_backfill_callback_t : public send_backfill_callback_t<protocol_t> {
 public:
     backfiller_send_backfill_callback_t(const region_map_t<protocol_t, version_range_t> *start_point,
-                                        mailbox_addr_t<void(region_map_t<protocol_t, version_range_t>, branch_history_t<protocol_t>)> end_point_cont,
                                         mailbox_manager_t *mailbox_manager,
-                                        mailbox_addr_t<void(typename protocol_t::backfill_chunk_t, fifo_enforcer_write_token_t)> chunk_cont,
-                                        fifo_enforcer_source_t *fifo_src,
-                                        semaphore_t *chunk_semaphore,
-                                        backfiller_t<protocol_t> *backfiller)
+                                        typename backfiller_t<protocol_t>::session_t *session,
+                                        backfiller_t<protocol_t> *backfiller,
+                                        region_map_t<protocol_t, version_range_t> *end_point_out)
         : start_point_(start_point),
-          end_point_cont_(end_point_cont),
           mailbox_manager_(mailbox_manager),
-          chunk_cont_(chunk_cont),
-          fifo_src_(fifo_src),
-          chunk_semaphore_(chunk_semaphore),
-          backfiller_(backfiller) { }
+          session_(session),
+          backfiller_(backfiller),
+          end_point_out_(end_point_out) { }
 
     bool should_backfill_impl(const typename store_view_t<protocol_t>::metainfo_t &metainfo) {
-        return backfiller_->confirm_and_send_metainfo(metainfo, *start_point_, end_point_cont_);
+        return backfiller_->confirm_and_send_metainfo(metainfo, *start_point_, session_, end_point_out_);
     }
 
     void send_chunk(const typename protocol_t::backfill_chunk_t &chunk, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
-        do_send_chunk<protocol_t>(mailbox_manager_, chunk_cont_, chunk, fifo_src_, chunk_semaphore_, interruptor);
+        session_->chunk_semaphore.co_lock_interruptible(interruptor);
+        session_->pace(chunk.estimate_size(), interruptor);
+        send(mailbox_manager_, session_->chunk_cont, chunk, session_->fifo_src.enter_write());
     }
 private:
     const region_map_t<protocol_t, version_range_t> *start_point_;
-    mailbox_addr_t<void(region_map_t<protocol_t, version_range_t>, branch_history_t<protocol_t>)> end_point_cont_;
     mailbox_manager_t *mailbox_manager_;
-    mailbox_addr_t<void(typename protocol_t::backfill_chunk_t, fifo_enforcer_write_token_t)> chunk_cont_;
-    fifo_enforcer_source_t *fifo_src_;
-    semaphore_t *chunk_semaphore_;
+    typename backfiller_t<protocol_t>::session_t *session_;
     backfiller_t<protocol_t> *backfiller_;
+    region_map_t<protocol_t, version_range_t> *end_point_out_;
 
     DISABLE_COPYING(backfiller_send_backfill_callback_t);
 };
 
+template <class protocol_t>
+void backfiller_t<protocol_t>::send_backfill_pass(const region_map_t<protocol_t, version_range_t> &start_point,
+                                                  session_t *session,
+                                                  region_map_t<protocol_t, version_range_t> *end_point_out,
+                                                  signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t) {
+    session->progress.passes.push_back(new traversal_progress_combiner_t);
+
+    read_token_pair_t send_backfill_token_pair;
+    svs->new_read_token_pair(&send_backfill_token_pair);
+
+    backfiller_send_backfill_callback_t<protocol_t>
+        send_backfill_cb(&start_point, mailbox_manager, session, this, end_point_out);
+
+    svs->send_backfill(region_map_transform<protocol_t, version_range_t, state_timestamp_t>(
+                           start_point,
+                           &get_earliest_timestamp_of_version_range),
+                       &send_backfill_cb,
+                       &session->progress.passes.back(),
+                       &send_backfill_token_pair,
+                       interruptor);
+
+    /* Every chunk of the pass has been sent, so once the backfillee has
+    applied them, its part of the store is at `end_point_out`. */
+    send(mailbox_manager, session->slice_done_cont, *end_point_out, session->fifo_src.enter_write());
+}
+
+template <class protocol_t>
+void backfiller_t<protocol_t>::send_backfill_slice(int i,
+                                                   const std::vector<typename protocol_t::region_t> *slices,
+                                                   const region_map_t<protocol_t, version_range_t> *start_point,
+                                                   session_t *session,
+                                                   std::vector<region_map_t<protocol_t, version_range_t> > *slice_end_points,
+                                                   signal_t *interruptor)
+    THROWS_NOTHING {
+    /* `on_backfill()` checks `interruptor` once all the slices are done, so
+    we don't have to pass on `interrupted_exc_t`. */
+    try {
+        session->slice_semaphore.co_lock_interruptible(interruptor);
+    } catch (const interrupted_exc_t &) {
+        return;
+    }
+    try {
+        send_backfill_pass(start_point->mask((*slices)[i]), session,
+                           &(*slice_end_points)[i], interruptor);
+    } catch (const interrupted_exc_t &) {
+    }
+    session->slice_semaphore.unlock();
+}
+
 template <class protocol_t>
 void backfiller_t<protocol_t>::on_backfill(backfill_session_id_t session_id,
                                            const region_map_t<protocol_t, version_range_t> &start_point,
                                            const branch_history_t<protocol_t> &start_point_associated_branch_history,
-                                           mailbox_addr_t<void(region_map_t<protocol_t, version_range_t>, branch_history_t<protocol_t>)> end_point_cont,
-                                           mailbox_addr_t<void(typename protocol_t::backfill_chunk_t, fifo_enforcer_write_token_t)> chunk_cont,
+                                           end_point_addr_t end_point_cont,
+                                           slice_done_addr_t slice_done_cont,
+                                           chunk_addr_t chunk_cont,
                                            mailbox_addr_t<void(fifo_enforcer_write_token_t)> done_cont,
                                            mailbox_addr_t<void(mailbox_addr_t<void(int)>)> allocation_registration_box,
                                            auto_drainer_t::lock_t keepalive) {
@@ -151,17 +268,17 @@ void backfiller_t<protocol_t>::on_backfill(backfill_session_id_t session_id,
     cond_t local_interruptor;
     map_insertion_sentry_t<backfill_session_id_t, cond_t *> be_interruptible(&local_interruptors, session_id, &local_interruptor);
 
+    session_t session(end_point_cont, slice_done_cont, chunk_cont, max_bytes_per_sec);
+
     /* Set up a local progress monitor so people can query us for progress. */
-    traversal_progress_combiner_t local_progress;
-    map_insertion_sentry_t<backfill_session_id_t, traversal_progress_combiner_t *> display_progress(&local_backfill_progress, session_id, &local_progress);
+    map_insertion_sentry_t<backfill_session_id_t, session_progress_t *> display_progress(&local_backfill_progress, session_id, &session.progress);
 
     /* Set up a cond that gets pulsed if we're interrupted by either the
        backfillee stopping or the backfiller destructor being called, but don't
        wait on that cond yet. */
     wait_any_t interrupted(&local_interruptor, keepalive.get_drain_signal());
 
-    static_semaphore_t chunk_semaphore(MAX_CHUNKS_OUT);
-    mailbox_t<void(int)> receive_allocations_mbox(mailbox_manager, boost::bind(&semaphore_t::unlock, &chunk_semaphore, _1));
+    mailbox_t<void(int)> receive_allocations_mbox(mailbox_manager, boost::bind(&semaphore_t::unlock, &session.chunk_semaphore, _1));
     send(mailbox_manager, allocation_registration_box, receive_allocations_mbox.get_address());
 
     try {
@@ -170,28 +287,40 @@ void backfiller_t<protocol_t>::on_backfill(backfill_session_id_t session_id,
             branch_history_manager->import_branch_history(start_point_associated_branch_history, keepalive.get_drain_signal());
         }
 
-        // TODO: Describe this fifo source's purpose a bit.  It's for ordering backfill operations, right?
-        fifo_enforcer_source_t fifo_src;
-
-        read_token_pair_t send_backfill_token_pair;
-        svs->new_read_token_pair(&send_backfill_token_pair);
-
-        backfiller_send_backfill_callback_t<protocol_t>
-            send_backfill_cb(&start_point, end_point_cont, mailbox_manager, chunk_cont, &fifo_src, &chunk_semaphore, this);
+        /* Send the backfill one slice at a time. Each slice is a snapshot of
+        its part of the store, so once the backfillee has all of a slice, it
+        can record that slice as being at that snapshot's version. If the
+        backfill is interrupted, the next one only has to send what changed in
+        the finished slices since then. Several slices are sent at once so
+        that a big backfill isn't held up waiting on one part of the store at
+        a time. */
+        std::vector<typename protocol_t::region_t> slices =
+            protocol_t::backfill_slices(svs, start_point.get_domain(), &interrupted);
+        session.progress.num_passes = slices.size() > 1 ? slices.size() + 1 : 1;
+
+        std::vector<region_map_t<protocol_t, version_range_t> > slice_end_points(slices.size());
+        pmap(slices.size(), boost::bind(&backfiller_t<protocol_t>::send_backfill_slice, this,
+                                        _1, &slices, &start_point, &session, &slice_end_points, &interrupted));
+        if (interrupted.is_pulsed()) {
+            throw interrupted_exc_t();
+        }
 
-        /* Actually perform the backfill */
-        svs->send_backfill(
-                     region_map_transform<protocol_t, version_range_t, state_timestamp_t>(
-                                                      start_point,
-                                                      &get_earliest_timestamp_of_version_range
-                                                      ),
-                     &send_backfill_cb,
-                     local_backfill_progress[session_id],
-                     &send_backfill_token_pair,
-                     &interrupted);
+        /* The slices were taken at different times, so they are at different
+        versions. One more pass over the whole region brings it all to the same
+        version; it only has to send what changed while the slices were being
+        sent. */
+        if (slices.size() > 1) {
+            std::vector<std::pair<typename protocol_t::region_t, version_range_t> > slices_point;
+            for (size_t i = 0; i < slice_end_points.size(); ++i) {
+                slices_point.insert(slices_point.end(), slice_end_points[i].begin(), slice_end_points[i].end());
+            }
+            region_map_t<protocol_t, version_range_t> caught_up_point;
+            send_backfill_pass(region_map_t<protocol_t, version_range_t>(slices_point.begin(), slices_point.end()),
+                               &session, &caught_up_point, &interrupted);
+        }
 
         /* Send a confirmation */
-        send(mailbox_manager, done_cont, fifo_src.enter_write());
+        send(mailbox_manager, done_cont, session.fifo_src.enter_write());
 
     } catch (const interrupted_exc_t &) {
         /* Ignore. If we were interrupted by the backfillee, then it already
@@ -225,9 +354,26 @@ template <class protocol_t>
 void backfiller_t<protocol_t>::request_backfill_progress(backfill_session_id_t session_id,
                                                          mailbox_addr_t<void(std::pair<int, int>)> response_mbox,
                                                          auto_drainer_t::lock_t) {
-    if (std_contains(local_backfill_progress, session_id) && local_backfill_progress[session_id]) {
-        progress_completion_fraction_t fraction = local_backfill_progress[session_id]->guess_completion();
-        std::pair<int, int> pair_fraction = std::make_pair(fraction.estimate_of_released_nodes, fraction.estimate_of_total_nodes);
+    if (std_contains(local_backfill_progress, session_id) && !local_backfill_progress[session_id]->passes.empty()) {
+        const session_progress_t *progress = local_backfill_progress[session_id];
+        std::pair<int, int> pair_fraction;
+        if (progress->num_passes == 1) {
+            progress_completion_fraction_t fraction = progress->passes.back().guess_completion();
+            pair_fraction = std::make_pair(fraction.estimate_of_released_nodes, fraction.estimate_of_total_nodes);
+        } else {
+            /* Report how far along the whole backfill is, with each pass
+            counting for as much as each of the others. Several of them may be
+            going at once. */
+            const int scale = 1000000 / progress->num_passes;
+            int64_t released = 0;
+            for (size_t i = 0; i < progress->passes.size(); ++i) {
+                progress_completion_fraction_t fraction = progress->passes[i].guess_completion();
+                if (!fraction.invalid() && fraction.estimate_of_total_nodes != 0) {
+                    released += static_cast<int64_t>(scale) * fraction.estimate_of_released_nodes / fraction.estimate_of_total_nodes;
+                }
+            }
+            pair_fraction = std::make_pair(static_cast<int>(released), progress->num_passes * scale);
+        }
         send(mailbox_manager, response_mbox, pair_fraction);
     } else {
         send(mailbox_manager, response_mbox, std::make_pair(-1, -1));
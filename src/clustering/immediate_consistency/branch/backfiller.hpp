@@ -4,9 +4,14 @@
 
 #include <map>
 #include <utility>
+#include <vector>
+
+#include "errors.hpp"
+#include <boost/ptr_container/ptr_vector.hpp>
 
 #include "clustering/immediate_consistency/branch/history.hpp"
 #include "clustering/immediate_consistency/branch/metadata.hpp"
+#include "concurrency/watchable.hpp"
 
 template <class> class backfiller_send_backfill_callback_t;
 template <class> class semilattice_read_view_t;
@@ -14,14 +19,19 @@ class traversal_progress_combiner_t;
 
 /* If you construct a `backfiller_t` for a given store, then it will advertise
 its existence in the metadata and serve backfills over the network. Generally
-`backfiller_t` is constructed as a member of `replier_t`. */
+`backfiller_t` is constructed as a member of `replier_t`.
+
+Each backfill sends at most `max_bytes_per_sec` (0 means no limit), and less
+while the store's thread is busy. Changes to it apply to backfills that are
+already running. */
 
 template <class protocol_t>
 class backfiller_t : public home_thread_mixin_debug_only_t {
 public:
     backfiller_t(mailbox_manager_t *mm,
                  branch_history_manager_t<protocol_t> *bhm,
-                 store_view_t<protocol_t> *svs);
+                 store_view_t<protocol_t> *svs,
+                 const clone_ptr_t<watchable_t<int64_t> > &max_bytes_per_sec);
 
     backfiller_business_card_t<protocol_t> get_business_card();
 
@@ -30,15 +40,58 @@ public:
 private:
     friend class backfiller_send_backfill_callback_t<protocol_t>;
 
+    typedef mailbox_addr_t<void(region_map_t<protocol_t, version_range_t>,
+                                branch_history_t<protocol_t>,
+                                fifo_enforcer_write_token_t)> end_point_addr_t;
+    typedef mailbox_addr_t<void(region_map_t<protocol_t, version_range_t>,
+                                fifo_enforcer_write_token_t)> slice_done_addr_t;
+    typedef mailbox_addr_t<void(typename protocol_t::backfill_chunk_t,
+                                fifo_enforcer_write_token_t)> chunk_addr_t;
+
+    /* How far along a backfill session is. The backfill is sent in
+    `num_passes` passes (see `on_backfill()`); `passes` has the progress of
+    the ones that have started. */
+    struct session_progress_t {
+        session_progress_t() : num_passes(0) { }
+        int num_passes;
+        boost::ptr_vector<traversal_progress_combiner_t> passes;
+    };
+
+    /* Everything that the passes of one backfill session share. It's defined
+    in `backfiller.cc`. */
+    struct session_t;
+
     bool confirm_and_send_metainfo(typename store_view_t<protocol_t>::metainfo_t metainfo, region_map_t<protocol_t, version_range_t> start_point,
-                                   mailbox_addr_t<void(region_map_t<protocol_t, version_range_t>, branch_history_t<protocol_t>)> end_point_cont);
+                                   session_t *session,
+                                   region_map_t<protocol_t, version_range_t> *end_point_out);
+
+    /* Sends one pass of a backfill: everything in `start_point.get_domain()`
+    that changed since `start_point`, as of a single snapshot of the store.
+    Stores the version the pass brings the backfillee to in `end_point_out`. */
+    void send_backfill_pass(const region_map_t<protocol_t, version_range_t> &start_point,
+                            session_t *session,
+                            region_map_t<protocol_t, version_range_t> *end_point_out,
+                            signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
+
+    /* Sends the `i`th of `slices` as a pass of its own, once there's room for
+    it among the slices that are being sent at the same time. Returns quietly
+    if `interruptor` is pulsed. */
+    void send_backfill_slice(int i,
+                             const std::vector<typename protocol_t::region_t> *slices,
+                             const region_map_t<protocol_t, version_range_t> *start_point,
+                             session_t *session,
+                             std::vector<region_map_t<protocol_t, version_range_t> > *slice_end_points,
+                             signal_t *interruptor)
+        THROWS_NOTHING;
 
     void on_backfill(
             backfill_session_id_t session_id,
             const region_map_t<protocol_t, version_range_t> &start_point,
             const branch_history_t<protocol_t> &start_point_associated_branch_history,
-            mailbox_addr_t<void(region_map_t<protocol_t, version_range_t>, branch_history_t<protocol_t>)> end_point_cont,
-            mailbox_addr_t<void(typename protocol_t::backfill_chunk_t, fifo_enforcer_write_token_t)> chunk_cont,
+            end_point_addr_t end_point_cont,
+            slice_done_addr_t slice_done_cont,
+            chunk_addr_t chunk_cont,
             mailbox_addr_t<void(fifo_enforcer_write_token_t)> done_cont,
             mailbox_addr_t<void(mailbox_addr_t<void(int)>)> allocation_registration_box,
             auto_drainer_t::lock_t keepalive);
@@ -54,8 +107,10 @@ private:
 
     store_view_t<protocol_t> *const svs;
 
+    clone_ptr_t<watchable_t<int64_t> > max_bytes_per_sec;
+
     std::map<backfill_session_id_t, cond_t *> local_interruptors;
-    std::map<backfill_session_id_t, traversal_progress_combiner_t *> local_backfill_progress;
+    std::map<backfill_session_id_t, session_progress_t *> local_backfill_progress;
     auto_drainer_t drainer;
 
     typename backfiller_business_card_t<protocol_t>::backfill_mailbox_t backfill_mailbox;
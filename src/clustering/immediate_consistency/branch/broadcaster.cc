@@ -7,6 +7,7 @@
 #include "concurrency/coro_fifo.hpp"
 #include "concurrency/coro_pool.hpp"
 #include "concurrency/cross_thread_signal.hpp"
+#include "config/args.hpp"
 #include "containers/death_runner.hpp"
 #include "containers/uuid.hpp"
 #include "clustering/immediate_consistency/branch/listener.hpp"
@@ -45,7 +46,8 @@ broadcaster_t<protocol_t>::broadcaster_t(mailbox_manager_t *mm,
       branch_id(generate_uuid()),
       branch_history_manager(bhm),
       enforce_max_outstanding_writes(MAX_OUTSTANDING_WRITES),
-      registrar(mailbox_manager, this)
+      registrar(mailbox_manager, this),
+      heartbeat_timer(REPLICATION_HEARTBEAT_INTERVAL_MS, this)
 
 {
     order_checkpoint.set_tagappend("broadcaster_t");
@@ -136,10 +138,13 @@ template <class protocol_t>
 class broadcaster_t<protocol_t>::incomplete_write_t : public home_thread_mixin_debug_only_t {
 public:
     incomplete_write_t(broadcaster_t *p, const typename protocol_t::write_t &w, transition_timestamp_t ts, write_callback_t *cb) :
-        write(w), timestamp(ts), callback(cb), sem_acq(&p->enforce_max_outstanding_writes), parent(p), incomplete_count(0) { }
+        write(w), timestamp(ts), start_time(current_microtime()), callback(cb), sem_acq(&p->enforce_max_outstanding_writes), parent(p), incomplete_count(0) { }
 
     const typename protocol_t::write_t write;
     const transition_timestamp_t timestamp;
+    /* Listeners compare this with their own clocks to tell how far behind
+    they are. */
+    const microtime_t start_time;
     write_callback_t *callback;
 
     semaphore_assertion_t::acq_t sem_acq;
@@ -200,6 +205,21 @@ private:
     boost::shared_ptr<incomplete_write_t> write;
 };
 
+/* `write_batch_t` is a run of consecutive plain writes that go to one mirror
+   in a single message. */
+
+template <class protocol_t>
+class broadcaster_t<protocol_t>::write_batch_t {
+public:
+    write_batch_t() { }
+
+    std::vector<incomplete_write_ref_t> write_refs;
+    std::vector<listener_write_t<protocol_t> > writes;
+
+private:
+    DISABLE_COPYING(write_batch_t);
+};
+
 /* The `registrar_t` constructs a `dispatchee_t` for every mirror that
    connects to us. */
 
@@ -207,13 +227,14 @@ template <class protocol_t>
 class broadcaster_t<protocol_t>::dispatchee_t : public intrusive_list_node_t<dispatchee_t> {
 public:
     dispatchee_t(broadcaster_t *c, listener_business_card_t<protocol_t> d) THROWS_NOTHING :
-        write_mailbox(d.write_mailbox), is_readable(false),
+        write_mailbox(d.write_mailbox), heartbeat_mailbox(d.heartbeat_mailbox), is_readable(false),
         queue_count(),
         queue_count_membership(&c->broadcaster_collection, &queue_count, uuid_to_str(d.write_mailbox.get_peer().get_uuid()) + "_broadcast_queue_count"),
         background_write_queue(&queue_count),
         // TODO magic constant
         background_write_workers(100, &background_write_queue, &background_write_caller),
         controller(c),
+        flush_scheduled(false),
         upgrade_mailbox(controller->mailbox_manager,
             boost::bind(&dispatchee_t::upgrade, this, _1, _2, auto_drainer_t::lock_t(&drainer))),
         downgrade_mailbox(controller->mailbox_manager,
@@ -239,9 +260,8 @@ public:
 
         for (typename std::list<boost::shared_ptr<incomplete_write_t> >::iterator it = controller->incomplete_writes.begin();
                 it != controller->incomplete_writes.end(); it++) {
-
-            coro_t::spawn_sometime(boost::bind(&broadcaster_t::background_write, controller,
-                                               this, auto_drainer_t::lock_t(&drainer), incomplete_write_ref_t(*it), order_source.check_in("dispatchee_t"), fifo_source.enter_write()));
+            add_write(incomplete_write_ref_t(*it), order_source.check_in("dispatchee_t"),
+                      fifo_source.enter_write(), false, WRITE_DURABILITY_SOFT);
         }
     }
 
@@ -257,7 +277,71 @@ public:
         return write_mailbox.get_peer();
     }
 
+    /* Adds a write to the batch that goes to this mirror next. The batch is
+    sent once the writes that are ready right now have joined it, or as soon
+    as it's full, and doesn't wait for earlier batches to be acknowledged.
+    Write-reads have a client waiting on their response, so they aren't
+    batched; each one goes out right away, after the batch before it. The
+    caller must hold `controller->mutex`. */
+    void add_write(incomplete_write_ref_t write_ref, order_token_t order_token,
+                   fifo_enforcer_write_token_t token, bool is_writeread,
+                   write_durability_t durability) THROWS_NOTHING {
+        auto_drainer_t::lock_t keepalive(&drainer);
+        listener_write_t<protocol_t> write(
+            write_ref.get()->write, write_ref.get()->timestamp, order_token, token, durability,
+            write_ref.get()->start_time);
+
+        if (is_writeread) {
+            if (pending_batch) {
+                send_pending_batch(keepalive);
+            }
+            background_write_queue.push(boost::bind(&broadcaster_t::background_writeread, controller,
+                this, keepalive, write_ref, write));
+            return;
+        }
+
+        if (!pending_batch) {
+            pending_batch = boost::make_shared<write_batch_t>();
+        }
+        pending_batch->writes.push_back(write);
+        pending_batch->write_refs.push_back(write_ref);
+
+        if (pending_batch->writes.size() >= BROADCASTER_MAX_WRITES_PER_BATCH) {
+            send_pending_batch(keepalive);
+        } else if (!flush_scheduled) {
+            flush_scheduled = true;
+            coro_t::spawn_sometime(boost::bind(&dispatchee_t::flush_pending_batch, this,
+                                               keepalive));
+        }
+    }
+
+    void send_heartbeat(state_timestamp_t timestamp, microtime_t time,
+                        auto_drainer_t::lock_t keepalive) THROWS_NOTHING {
+        keepalive.assert_is_holding(&drainer);
+        send(controller->mailbox_manager, heartbeat_mailbox, timestamp, time);
+    }
+
 private:
+    void flush_pending_batch(auto_drainer_t::lock_t keepalive) THROWS_NOTHING {
+        keepalive.assert_is_holding(&drainer);
+        flush_scheduled = false;
+        if (keepalive.get_drain_signal()->is_pulsed()) {
+            /* The mirror went away after we were spawned; nobody is going to
+            receive the batch. */
+            pending_batch.reset();
+            return;
+        }
+        if (pending_batch) {
+            send_pending_batch(keepalive);
+        }
+    }
+
+    void send_pending_batch(const auto_drainer_t::lock_t &keepalive) THROWS_NOTHING {
+        background_write_queue.push(boost::bind(&broadcaster_t::background_write_batch, controller,
+            this, keepalive, pending_batch));
+        pending_batch.reset();
+    }
+
     /* The constructor spawns `send_intro()` in the background. */
     void send_intro(listener_business_card_t<protocol_t> to_send_intro_to,
                     state_timestamp_t intro_timestamp,
@@ -300,6 +384,7 @@ private:
 
 public:
     typename listener_business_card_t<protocol_t>::write_mailbox_t::address_t write_mailbox;
+    typename listener_business_card_t<protocol_t>::heartbeat_mailbox_t::address_t heartbeat_mailbox;
     bool is_readable;
     typename listener_business_card_t<protocol_t>::writeread_mailbox_t::address_t writeread_mailbox;
     typename listener_business_card_t<protocol_t>::read_mailbox_t::address_t read_mailbox;
@@ -324,6 +409,12 @@ public:
 private:
     coro_pool_t<boost::function<void()> > background_write_workers;
     broadcaster_t *controller;
+
+    /* The writes that `add_write()` has collected for the next batch, if
+    any, and whether a coroutine to send them has been spawned. */
+    boost::shared_ptr<write_batch_t> pending_batch;
+    bool flush_scheduled;
+
     auto_drainer_t drainer;
 
     typename listener_business_card_t<protocol_t>::upgrade_mailbox_t upgrade_mailbox;
@@ -340,8 +431,7 @@ template<class protocol_t>
 void listener_write(
         mailbox_manager_t *mailbox_manager,
         const typename listener_business_card_t<protocol_t>::write_mailbox_t::address_t &write_mailbox,
-        const typename protocol_t::write_t &w, transition_timestamp_t ts,
-        order_token_t order_token, fifo_enforcer_write_token_t token,
+        const std::vector<listener_write_t<protocol_t> > &writes,
         signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t)
 {
@@ -351,7 +441,7 @@ void listener_write(
         boost::bind(&cond_t::pulse, &ack_cond));
 
     send(mailbox_manager, write_mailbox,
-         w, ts, order_token, token, ack_mailbox.get_address());
+         writes, ack_mailbox.get_address());
 
     wait_interruptible(&ack_cond, interruptor);
 }
@@ -459,15 +549,25 @@ void broadcaster_t<protocol_t>::spawn_write(const typename protocol_t::write_t &
                 unreachable();
             }
 
-            it->first->background_write_queue.push(boost::bind(&broadcaster_t::background_writeread, this,
-                it->first, it->second, write_ref, order_token, fifo_enforcer_token, durability));
+            it->first->add_write(write_ref, order_token, fifo_enforcer_token, true, durability);
         } else {
-            it->first->background_write_queue.push(boost::bind(&broadcaster_t::background_write, this,
-                it->first, it->second, write_ref, order_token, fifo_enforcer_token));
+            it->first->add_write(write_ref, order_token, fifo_enforcer_token, false, WRITE_DURABILITY_SOFT);
         }
     }
 }
 
+template<class protocol_t>
+void broadcaster_t<protocol_t>::on_ring() {
+    DEBUG_VAR mutex_assertion_t::acq_t mutex_acq(&mutex);
+    ASSERT_FINITE_CORO_WAITING;
+    const microtime_t now = current_microtime();
+    for (typename std::map<dispatchee_t *, auto_drainer_t::lock_t>::iterator it = dispatchees.begin();
+         it != dispatchees.end(); ++it) {
+        coro_t::spawn_sometime(boost::bind(&dispatchee_t::send_heartbeat, it->first,
+                                           current_timestamp, now, it->second));
+    }
+}
+
 template<class protocol_t>
 void broadcaster_t<protocol_t>::pick_a_readable_dispatchee(dispatchee_t **dispatchee_out, mutex_assertion_t::acq_t *proof, auto_drainer_t::lock_t *lock_out) THROWS_ONLY(cannot_perform_query_exc_t) {
     ASSERT_FINITE_CORO_WAITING;
@@ -508,18 +608,17 @@ void broadcaster_t<protocol_t>::get_all_readable_dispatchees(
 }
 
 template<class protocol_t>
-void broadcaster_t<protocol_t>::background_write(dispatchee_t *mirror, auto_drainer_t::lock_t mirror_lock, incomplete_write_ref_t write_ref, order_token_t order_token, fifo_enforcer_write_token_t token) THROWS_NOTHING {
+void broadcaster_t<protocol_t>::background_write_batch(dispatchee_t *mirror, auto_drainer_t::lock_t mirror_lock, boost::shared_ptr<write_batch_t> batch) THROWS_NOTHING {
     try {
         listener_write<protocol_t>(mailbox_manager, mirror->write_mailbox,
-                                   write_ref.get()->write, write_ref.get()->timestamp, order_token, token,
-                                   mirror_lock.get_drain_signal());
+                                   batch->writes, mirror_lock.get_drain_signal());
     } catch (const interrupted_exc_t &) {
         return;
     }
 }
 
 template<class protocol_t>
-void broadcaster_t<protocol_t>::background_writeread(dispatchee_t *mirror, auto_drainer_t::lock_t mirror_lock, incomplete_write_ref_t write_ref, order_token_t order_token, fifo_enforcer_write_token_t token, const write_durability_t durability) THROWS_NOTHING {
+void broadcaster_t<protocol_t>::background_writeread(dispatchee_t *mirror, auto_drainer_t::lock_t mirror_lock, incomplete_write_ref_t write_ref, const listener_write_t<protocol_t> &write) THROWS_NOTHING {
     try {
         cond_t response_cond;
         typename protocol_t::write_response_t response;
@@ -527,7 +626,7 @@ void broadcaster_t<protocol_t>::background_writeread(dispatchee_t *mirror, auto_
             mailbox_manager,
             boost::bind(&store_listener_response<typename protocol_t::write_response_t>, &response, _1, &response_cond));
 
-        send(mailbox_manager, mirror->writeread_mailbox, write_ref.get()->write, write_ref.get()->timestamp, order_token, token, response_mailbox.get_address(), durability);
+        send(mailbox_manager, mirror->writeread_mailbox, write, response_mailbox.get_address());
 
         wait_interruptible(&response_cond, mirror_lock.get_drain_signal());
 
@@ -8,6 +8,7 @@
 #include "utils.hpp"
 #include <boost/shared_ptr.hpp>
 
+#include "arch/timing.hpp"
 #include "clustering/generic/registrar.hpp"
 #include "clustering/immediate_consistency/branch/history.hpp"
 #include "clustering/immediate_consistency/branch/metadata.hpp"
@@ -33,7 +34,8 @@ on that branch. The order in which write and read operations pass through the
 themselves. */
 
 template<class protocol_t>
-class broadcaster_t : public home_thread_mixin_debug_only_t {
+class broadcaster_t : public home_thread_mixin_debug_only_t,
+                      private repeating_timer_callback_t {
 private:
     class incomplete_write_t;
 
@@ -114,16 +116,24 @@ private:
         std::vector<auto_drainer_t::lock_t> *locks_out)
         THROWS_ONLY(cannot_perform_query_exc_t);
 
-    void background_write(
+    class write_batch_t;
+
+    /* Sends a batch of writes to a mirror and waits for it to acknowledge
+    them. */
+    void background_write_batch(
         dispatchee_t *mirror, auto_drainer_t::lock_t mirror_lock,
-        incomplete_write_ref_t write_ref, order_token_t order_token,
-        fifo_enforcer_write_token_t token) THROWS_NOTHING;
+        boost::shared_ptr<write_batch_t> batch) THROWS_NOTHING;
+    /* Sends a write-read to a mirror and passes its response to the write's
+    callback. */
     void background_writeread(
         dispatchee_t *mirror, auto_drainer_t::lock_t mirror_lock,
-        incomplete_write_ref_t write_ref, order_token_t order_token,
-        fifo_enforcer_write_token_t token, write_durability_t durability) THROWS_NOTHING;
+        incomplete_write_ref_t write_ref,
+        const listener_write_t<protocol_t> &write) THROWS_NOTHING;
     void end_write(boost::shared_ptr<incomplete_write_t> write) THROWS_NOTHING;
 
+    /* Sends every mirror a heartbeat. */
+    void on_ring();
+
     void single_read(
         const typename protocol_t::read_t &r,
         typename protocol_t::read_response_t *response,
@@ -183,6 +193,8 @@ private:
     registrar_t<listener_business_card_t<protocol_t>, broadcaster_t *, dispatchee_t>
         registrar;
 
+    repeating_timer_t heartbeat_timer;
+
     DISABLE_COPYING(broadcaster_t);
 };
 
@@ -8,6 +8,7 @@
 #include "clustering/immediate_consistency/branch/history.hpp"
 #include "concurrency/coro_pool.hpp"
 #include "concurrency/cross_thread_signal.hpp"
+#include "config/args.hpp"
 
 
 /* `WRITE_QUEUE_CORO_POOL_SIZE` is the number of coroutines that will be used
@@ -69,6 +70,8 @@ listener_t<protocol_t>::listener_t(const base_path_t &base_path,
     uuid_(generate_uuid()),
     perfmon_collection_(),
     perfmon_collection_membership_(backfill_stats_parent, &perfmon_collection_, "backfill-serialization-" + uuid_to_str(uuid_)),
+    replication_lag_(secs_to_ticks(1), false),
+    replication_lag_membership_(&perfmon_collection_, &replication_lag_, "replication_lag"),
     /* TODO: Put the file in the data directory, not here */
     write_queue_(io_backender,
                  serializer_filepath_t(base_path, "backfill-serialization-" + uuid_to_str(uuid_)),
@@ -77,9 +80,12 @@ listener_t<protocol_t>::listener_t(const base_path_t &base_path,
         WRITE_QUEUE_SEMAPHORE_TRICKLE_FRACTION),
     enforce_max_outstanding_writes_from_broadcaster_(MAX_OUTSTANDING_WRITES_FROM_BROADCASTER),
     write_mailbox_(mailbox_manager_,
-        boost::bind(&listener_t::on_write, this, _1, _2, _3, _4, _5)),
+        boost::bind(&listener_t::on_write, this, _1, _2),
+        MESSAGE_CLASS_REPLICATION),
+    heartbeat_mailbox_(mailbox_manager_,
+        boost::bind(&listener_t::on_heartbeat, this, _1, _2)),
     writeread_mailbox_(mailbox_manager_,
-        boost::bind(&listener_t::on_writeread, this, _1, _2, _3, _4, _5, _6)),
+        boost::bind(&listener_t::on_writeread, this, _1, _2)),
     read_mailbox_(mailbox_manager_,
         boost::bind(&listener_t::on_read, this, _1, _2, _3, _4, _5))
 {
@@ -211,6 +217,7 @@ listener_t<protocol_t>::listener_t(const base_path_t &base_path,
     guarantee(backfill_end_timestamp >= streaming_begin_point);
 
     current_timestamp_ = backfill_end_timestamp;
+    replication_lag_tracker_.on_reached(current_timestamp_);
     write_queue_coro_pool_callback_.init(new boost_function_callback_t<write_queue_entry_t>(
             boost::bind(&listener_t<protocol_t>::perform_enqueued_write, this, _1, backfill_end_timestamp, _2)));
     write_queue_coro_pool_.init(new coro_pool_t<write_queue_entry_t>(
@@ -241,15 +248,20 @@ listener_t<protocol_t>::listener_t(const base_path_t &base_path,
     uuid_(generate_uuid()),
     perfmon_collection_(),
     perfmon_collection_membership_(backfill_stats_parent, &perfmon_collection_, "backfill-serialization-" + uuid_to_str(uuid_)),
+    replication_lag_(secs_to_ticks(1), false),
+    replication_lag_membership_(&perfmon_collection_, &replication_lag_, "replication_lag"),
     /* TODO: Put the file in the data directory, not here */
     write_queue_(io_backender, serializer_filepath_t(base_path, "backfill-serialization-" + uuid_to_str(uuid_)), &perfmon_collection_),
     write_queue_semaphore_(WRITE_QUEUE_SEMAPHORE_LONG_TERM_CAPACITY,
         WRITE_QUEUE_SEMAPHORE_TRICKLE_FRACTION),
     enforce_max_outstanding_writes_from_broadcaster_(MAX_OUTSTANDING_WRITES_FROM_BROADCASTER),
     write_mailbox_(mailbox_manager_,
-        boost::bind(&listener_t::on_write, this, _1, _2, _3, _4, _5)),
+        boost::bind(&listener_t::on_write, this, _1, _2),
+        MESSAGE_CLASS_REPLICATION),
+    heartbeat_mailbox_(mailbox_manager_,
+        boost::bind(&listener_t::on_heartbeat, this, _1, _2)),
     writeread_mailbox_(mailbox_manager_,
-        boost::bind(&listener_t::on_writeread, this, _1, _2, _3, _4, _5, _6)),
+        boost::bind(&listener_t::on_writeread, this, _1, _2)),
     read_mailbox_(mailbox_manager_,
         boost::bind(&listener_t::on_read, this, _1, _2, _3, _4, _5))
 {
@@ -299,6 +311,7 @@ listener_t<protocol_t>::listener_t(const base_path_t &base_path,
 
     /* Start streaming, just like we do after we finish a backfill */
     current_timestamp_ = listener_intro.broadcaster_begin_timestamp;
+    replication_lag_tracker_.on_reached(current_timestamp_);
     write_queue_coro_pool_callback_.init(new boost_function_callback_t<write_queue_entry_t>(
             boost::bind(&listener_t<protocol_t>::perform_enqueued_write, this, _1, current_timestamp_, _2)));
     write_queue_coro_pool_.init(
@@ -371,7 +384,9 @@ void listener_t<protocol_t>::try_start_receiving_writes(
         registrant_.init(new registrant_t<listener_business_card_t<protocol_t> >(
             mailbox_manager_,
             broadcaster->subview(&listener_t<protocol_t>::get_registrar_from_broadcaster_bcard),
-            listener_business_card_t<protocol_t>(intro_mailbox.get_address(), write_mailbox_.get_address())));
+            listener_business_card_t<protocol_t>(intro_mailbox.get_address(),
+                                                 write_mailbox_.get_address(),
+                                                 heartbeat_mailbox_.get_address())));
     } catch (const resource_lost_exc_t &) {
         throw broadcaster_lost_exc_t();
     }
@@ -388,41 +403,51 @@ void listener_t<protocol_t>::try_start_receiving_writes(
 }
 
 template <class protocol_t>
-void listener_t<protocol_t>::on_write(const typename protocol_t::write_t &write,
-        transition_timestamp_t transition_timestamp,
-        order_token_t order_token,
-        fifo_enforcer_write_token_t fifo_token,
+void listener_t<protocol_t>::on_write(const std::vector<listener_write_t<protocol_t> > &writes,
         mailbox_addr_t<void()> ack_addr) THROWS_NOTHING {
-    rassert(region_is_superset(our_branch_region_, write.get_region()));
-    rassert(!region_is_empty(write.get_region()));
-    order_token.assert_write_mode();
+    microtime_t now = current_microtime();
+    for (auto it = writes.begin(); it != writes.end(); ++it) {
+        rassert(region_is_superset(our_branch_region_, it->write.get_region()));
+        rassert(!region_is_empty(it->write.get_region()));
+        it->order_token.assert_write_mode();
+        replication_lag_tracker_.on_stamp(it->transition_timestamp.timestamp_after(),
+                                          it->primary_time, now);
+    }
 
     coro_t::spawn_sometime(boost::bind(
-        &listener_t<protocol_t>::enqueue_write, this,
-        write, transition_timestamp, order_token, fifo_token, ack_addr,
+        &listener_t<protocol_t>::enqueue_writes, this,
+        writes, ack_addr,
         auto_drainer_t::lock_t(&drainer_)));
 }
 
 template <class protocol_t>
-void listener_t<protocol_t>::enqueue_write(const typename protocol_t::write_t &write,
-        transition_timestamp_t transition_timestamp,
-        order_token_t order_token,
-        fifo_enforcer_write_token_t fifo_token,
+void listener_t<protocol_t>::on_heartbeat(state_timestamp_t timestamp,
+        microtime_t primary_time) THROWS_NOTHING {
+    replication_lag_tracker_.on_stamp(timestamp, primary_time, current_microtime());
+}
+
+template <class protocol_t>
+void listener_t<protocol_t>::enqueue_writes(const std::vector<listener_write_t<protocol_t> > &writes,
         mailbox_addr_t<void()> ack_addr,
         auto_drainer_t::lock_t keepalive) THROWS_NOTHING {
     try {
         /* Make sure that the broadcaster isn't sending us too many concurrent
         writes */
-        semaphore_assertion_t::acq_t sem_acq(&enforce_max_outstanding_writes_from_broadcaster_);
+        boost::ptr_vector<semaphore_assertion_t::acq_t> sem_acqs;
+        for (size_t i = 0; i < writes.size(); ++i) {
+            sem_acqs.push_back(new semaphore_assertion_t::acq_t(&enforce_max_outstanding_writes_from_broadcaster_));
+        }
 
-        fifo_enforcer_sink_t::exit_write_t fifo_exit(&write_queue_entrance_sink_, fifo_token);
-        wait_interruptible(&fifo_exit, keepalive.get_drain_signal());
-        write_queue_semaphore_.co_lock_interruptible(keepalive.get_drain_signal());
-        write_queue_.push(write_queue_entry_t(write, transition_timestamp, order_token, fifo_token));
+        for (auto it = writes.begin(); it != writes.end(); ++it) {
+            fifo_enforcer_sink_t::exit_write_t fifo_exit(&write_queue_entrance_sink_, it->fifo_token);
+            wait_interruptible(&fifo_exit, keepalive.get_drain_signal());
+            write_queue_semaphore_.co_lock_interruptible(keepalive.get_drain_signal());
+            write_queue_.push(write_queue_entry_t(it->write, it->transition_timestamp, it->order_token, it->fifo_token));
+        }
 
         /* Release the semaphore before sending the response, because the
-        broadcaster can send us a new write as soon as we send the ack */
-        sem_acq.reset();
+        broadcaster can send us new writes as soon as we send the ack */
+        sem_acqs.clear();
         send(mailbox_manager_, ack_addr);
 
     } catch (const interrupted_exc_t &) {
@@ -474,30 +499,24 @@ void listener_t<protocol_t>::perform_enqueued_write(const write_queue_entry_t &q
 }
 
 template <class protocol_t>
-void listener_t<protocol_t>::on_writeread(const typename protocol_t::write_t &write,
-        transition_timestamp_t transition_timestamp,
-        order_token_t order_token,
-        fifo_enforcer_write_token_t fifo_token,
-        mailbox_addr_t<void(typename protocol_t::write_response_t)> ack_addr,
-        write_durability_t durability) THROWS_NOTHING {
-    rassert(region_is_superset(our_branch_region_, write.get_region()));
-    rassert(!region_is_empty(write.get_region()));
-    rassert(region_is_superset(svs_->get_region(), write.get_region()));
-    order_token.assert_write_mode();
+void listener_t<protocol_t>::on_writeread(const listener_write_t<protocol_t> &write,
+        mailbox_addr_t<void(typename protocol_t::write_response_t)> ack_addr) THROWS_NOTHING {
+    rassert(region_is_superset(our_branch_region_, write.write.get_region()));
+    rassert(!region_is_empty(write.write.get_region()));
+    rassert(region_is_superset(svs_->get_region(), write.write.get_region()));
+    write.order_token.assert_write_mode();
+    replication_lag_tracker_.on_stamp(write.transition_timestamp.timestamp_after(),
+                                      write.primary_time, current_microtime());
 
     coro_t::spawn_sometime(boost::bind(
         &listener_t<protocol_t>::perform_writeread, this,
-        write, transition_timestamp, order_token, fifo_token, ack_addr, durability,
+        write, ack_addr,
         auto_drainer_t::lock_t(&drainer_)));
 }
 
 template <class protocol_t>
-void listener_t<protocol_t>::perform_writeread(const typename protocol_t::write_t &write,
-        transition_timestamp_t transition_timestamp,
-        order_token_t order_token,
-        fifo_enforcer_write_token_t fifo_token,
+void listener_t<protocol_t>::perform_writeread(const listener_write_t<protocol_t> &write,
         mailbox_addr_t<void(typename protocol_t::write_response_t)> ack_addr,
-        const write_durability_t durability,
         auto_drainer_t::lock_t keepalive) THROWS_NOTHING {
     try {
         /* Make sure the broadcaster isn't sending us too many writes */
@@ -508,24 +527,24 @@ void listener_t<protocol_t>::perform_writeread(const typename protocol_t::write_
             {
                 /* Briefly pass through `write_queue_entrance_sink_` in case we
                 are receiving a mix of writes and write-reads */
-                fifo_enforcer_sink_t::exit_write_t fifo_exit_1(&write_queue_entrance_sink_, fifo_token);
+                fifo_enforcer_sink_t::exit_write_t fifo_exit_1(&write_queue_entrance_sink_, write.fifo_token);
             }
 
-            fifo_enforcer_sink_t::exit_write_t fifo_exit_2(&store_entrance_sink_, fifo_token);
+            fifo_enforcer_sink_t::exit_write_t fifo_exit_2(&store_entrance_sink_, write.fifo_token);
             wait_interruptible(&fifo_exit_2, keepalive.get_drain_signal());
 
-            advance_current_timestamp_and_pulse_waiters(transition_timestamp);
+            advance_current_timestamp_and_pulse_waiters(write.transition_timestamp);
 
             svs_->new_write_token_pair(&write_token_pair);
         }
 
         // Make sure we can serve the entire operation without masking it.
         // (We shouldn't have been signed up for writereads if we couldn't.)
-        rassert(region_is_superset(svs_->get_region(), write.get_region()));
+        rassert(region_is_superset(svs_->get_region(), write.write.get_region()));
 
 
 #ifndef NDEBUG
-        version_leq_metainfo_checker_callback_t<protocol_t> metainfo_checker_callback(transition_timestamp.timestamp_before());
+        version_leq_metainfo_checker_callback_t<protocol_t> metainfo_checker_callback(write.transition_timestamp.timestamp_before());
         metainfo_checker_t<protocol_t> metainfo_checker(&metainfo_checker_callback, svs_->get_region());
 #endif
 
@@ -534,12 +553,12 @@ void listener_t<protocol_t>::perform_writeread(const typename protocol_t::write_
 
         svs_->write(DEBUG_ONLY(metainfo_checker, )
                     region_map_t<protocol_t, binary_blob_t>(svs_->get_region(),
-                                                            binary_blob_t(version_range_t(version_t(branch_id_, transition_timestamp.timestamp_after())))),
-                    write,
+                                                            binary_blob_t(version_range_t(version_t(branch_id_, write.transition_timestamp.timestamp_after())))),
+                    write.write,
                     &response,
-                    durability,
-                    transition_timestamp,
-                    order_token,
+                    write.durability,
+                    write.transition_timestamp,
+                    write.order_token,
                     &write_token_pair,
                     keepalive.get_drain_signal());
 
@@ -629,11 +648,22 @@ void listener_t<protocol_t>::wait_for_version(state_timestamp_t timestamp, signa
     }
 }
 
+template <class protocol_t>
+int64_t listener_t<protocol_t>::get_replication_lag_ms() const {
+    return replication_lag_tracker_.get_lag_ms(current_microtime());
+}
+
 template <class protocol_t>
 void listener_t<protocol_t>::advance_current_timestamp_and_pulse_waiters(transition_timestamp_t timestamp) {
     guarantee(timestamp.timestamp_before() == current_timestamp_);
     current_timestamp_ = timestamp.timestamp_after();
 
+    replication_lag_tracker_.on_reached(current_timestamp_);
+    int64_t lag_ms = get_replication_lag_ms();
+    if (lag_ms != -1) {
+        replication_lag_.record(lag_ms / static_cast<double>(THOUSAND));
+    }
+
     for (std::multimap<state_timestamp_t, cond_t *>::const_iterator it = synchronize_waiters_.begin();
          it != synchronize_waiters_.upper_bound(current_timestamp_);
          ++it) {
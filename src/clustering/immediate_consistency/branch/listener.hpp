@@ -3,11 +3,17 @@
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_BRANCH_LISTENER_HPP_
 
 #include <map>
+#include <vector>
+
+#include "errors.hpp"
+#include <boost/ptr_container/ptr_vector.hpp>
 
 #include "clustering/immediate_consistency/branch/metadata.hpp"
 #include "concurrency/promise.hpp"
 #include "concurrency/queue/disk_backed_queue_wrapper.hpp"
 #include "concurrency/semaphore.hpp"
+#include "clustering/immediate_consistency/branch/replication_lag.hpp"
+#include "perfmon/perfmon.hpp"
 #include "serializer/types.hpp"
 #include "timestamps.hpp"
 #include "utils.hpp"
@@ -119,6 +125,12 @@ public:
 
     void wait_for_version(state_timestamp_t timestamp, signal_t *interruptor);
 
+    /* Returns how far behind the primary the data in the store is, in
+    milliseconds: the time since the store last had every write that the
+    primary had started by some point in time that it told us about. Returns -1
+    if that hasn't happened yet. */
+    int64_t get_replication_lag_ms() const;
+
     const listener_intro_t<protocol_t> &registration_done_cond_value() const {
         return registration_done_cond_.wait();
     }
@@ -155,17 +167,14 @@ private:
             signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t, broadcaster_lost_exc_t);
 
-    void on_write(const typename protocol_t::write_t &write,
-            transition_timestamp_t transition_timestamp,
-            order_token_t order_token,
-            fifo_enforcer_write_token_t fifo_token,
+    void on_write(const std::vector<listener_write_t<protocol_t> > &writes,
             mailbox_addr_t<void()> ack_addr)
         THROWS_NOTHING;
 
-    void enqueue_write(const typename protocol_t::write_t &write,
-            transition_timestamp_t transition_timestamp,
-            order_token_t order_token,
-            fifo_enforcer_write_token_t fifo_token,
+    void on_heartbeat(state_timestamp_t timestamp, microtime_t primary_time)
+        THROWS_NOTHING;
+
+    void enqueue_writes(const std::vector<listener_write_t<protocol_t> > &writes,
             mailbox_addr_t<void()> ack_addr,
             auto_drainer_t::lock_t keepalive)
         THROWS_NOTHING;
@@ -176,20 +185,12 @@ private:
     /* See the note at the place where `writeread_mailbox` is declared for an
     explanation of why `on_writeread()` and `on_read()` are here. */
 
-    void on_writeread(const typename protocol_t::write_t &write,
-            transition_timestamp_t transition_timestamp,
-            order_token_t order_token,
-            fifo_enforcer_write_token_t fifo_token,
-            mailbox_addr_t<void(typename protocol_t::write_response_t)> ack_addr,
-            write_durability_t durability)
+    void on_writeread(const listener_write_t<protocol_t> &write,
+            mailbox_addr_t<void(typename protocol_t::write_response_t)> ack_addr)
         THROWS_NOTHING;
 
-    void perform_writeread(const typename protocol_t::write_t &write,
-            transition_timestamp_t transition_timestamp,
-            order_token_t order_token,
-            fifo_enforcer_write_token_t fifo_token,
+    void perform_writeread(const listener_write_t<protocol_t> &write,
             mailbox_addr_t<void(typename protocol_t::write_response_t)> ack_addr,
-            write_durability_t durability,
             auto_drainer_t::lock_t keepalive)
         THROWS_NOTHING;
 
@@ -232,7 +233,13 @@ private:
     perfmon_collection_t perfmon_collection_;
     perfmon_membership_t perfmon_collection_membership_;
 
+    /* How far behind the primary we were each time we applied a write. */
+    perfmon_sampler_t replication_lag_;
+    perfmon_membership_t replication_lag_membership_;
+
     state_timestamp_t current_timestamp_;
+
+    replication_lag_tracker_t replication_lag_tracker_;
     fifo_enforcer_sink_t store_entrance_sink_;
 
     // Used by the replier_t which needs to be able to tell
@@ -258,6 +265,7 @@ private:
     auto_drainer_t drainer_;
 
     typename listener_business_card_t<protocol_t>::write_mailbox_t write_mailbox_;
+    typename listener_business_card_t<protocol_t>::heartbeat_mailbox_t heartbeat_mailbox_;
 
     /* `writeread_mailbox` and `read_mailbox` live on the `listener_t` even
     though they don't get used until the `replier_t` is constructed. The reason
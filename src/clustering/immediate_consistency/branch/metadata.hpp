@@ -4,12 +4,14 @@
 
 #include <map>
 #include <utility>
+#include <vector>
 
 #include "clustering/generic/registration_metadata.hpp"
 #include "clustering/immediate_consistency/branch/history.hpp"
 #include "concurrency/fifo_checker.hpp"
 #include "concurrency/fifo_enforcer.hpp"
 #include "concurrency/promise.hpp"
+#include "containers/archive/stl_types.hpp"
 #include "containers/uuid.hpp"
 #include "protocol_api.hpp"
 #include "rpc/mailbox/typed.hpp"
@@ -18,6 +20,40 @@
 
 template <class> class listener_intro_t;
 
+/* `listener_write_t` is one write that the `broadcaster_t` sends to a
+`listener_t`. The broadcaster sends runs of consecutive writes to a listener
+together in one message, and the listener acknowledges the whole run at once;
+each write still carries its own FIFO token, so they are performed in the same
+order as before. Write-reads have a client waiting on them, so they are sent
+one at a time. */
+
+template<class protocol_t>
+class listener_write_t {
+public:
+    listener_write_t() : durability(WRITE_DURABILITY_SOFT), primary_time(0) { }
+    listener_write_t(const typename protocol_t::write_t &w,
+                     transition_timestamp_t ts,
+                     order_token_t ot,
+                     fifo_enforcer_write_token_t ft,
+                     write_durability_t d,
+                     microtime_t pt) :
+        write(w), transition_timestamp(ts), order_token(ot), fifo_token(ft), durability(d),
+        primary_time(pt) { }
+
+    typename protocol_t::write_t write;
+    transition_timestamp_t transition_timestamp;
+    order_token_t order_token;
+    fifo_enforcer_write_token_t fifo_token;
+    /* Only write-reads look at this; plain writes never wait for the disk. */
+    write_durability_t durability;
+    /* When the broadcaster started the write, by the primary's clock. The
+    listener uses it to tell how far behind the primary it is. */
+    microtime_t primary_time;
+
+    RDB_MAKE_ME_SERIALIZABLE_6(write, transition_timestamp, order_token, fifo_token, durability,
+                               primary_time);
+};
+
 /* Every `listener_t` constructs a `listener_business_card_t` and sends it to
 the `broadcaster_t`. */
 
@@ -28,18 +64,12 @@ public:
     /* These are the types of mailboxes that the master uses to communicate with
     the mirrors. */
 
-    typedef mailbox_t<void(typename protocol_t::write_t,
-                           transition_timestamp_t,
-                           order_token_t,
-                           fifo_enforcer_write_token_t,
+    typedef mailbox_t<void(std::vector<listener_write_t<protocol_t> >,
                            mailbox_addr_t<void()> ack_addr)> write_mailbox_t;
 
-    typedef mailbox_t<void(typename protocol_t::write_t,
-                           transition_timestamp_t,
-                           order_token_t,
-                           fifo_enforcer_write_token_t,
-                           mailbox_addr_t<void(typename protocol_t::write_response_t)>,
-                           write_durability_t)> writeread_mailbox_t;
+    typedef mailbox_t<void(listener_write_t<protocol_t>,
+                           mailbox_addr_t<void(typename protocol_t::write_response_t)>
+                           )> writeread_mailbox_t;
 
     typedef mailbox_t<void(typename protocol_t::read_t,
                            state_timestamp_t,
@@ -59,15 +89,22 @@ public:
 
     typedef mailbox_t<void(listener_intro_t<protocol_t>)> intro_mailbox_t;
 
+    /* Every `REPLICATION_HEARTBEAT_INTERVAL_MS`, the master tells the mirrors
+    the timestamp it has reached and the time by its clock, so that they can
+    tell how far behind they are even when there are no writes. */
+    typedef mailbox_t<void(state_timestamp_t, microtime_t)> heartbeat_mailbox_t;
+
     listener_business_card_t() { }
     listener_business_card_t(const typename intro_mailbox_t::address_t &im,
-                             const typename write_mailbox_t::address_t &wm)
-        : intro_mailbox(im), write_mailbox(wm) { }
+                             const typename write_mailbox_t::address_t &wm,
+                             const typename heartbeat_mailbox_t::address_t &hm)
+        : intro_mailbox(im), write_mailbox(wm), heartbeat_mailbox(hm) { }
 
     typename intro_mailbox_t::address_t intro_mailbox;
     typename write_mailbox_t::address_t write_mailbox;
+    typename heartbeat_mailbox_t::address_t heartbeat_mailbox;
 
-    RDB_MAKE_ME_SERIALIZABLE_2(intro_mailbox, write_mailbox);
+    RDB_MAKE_ME_SERIALIZABLE_3(intro_mailbox, write_mailbox, heartbeat_mailbox);
 };
 
 
@@ -93,7 +130,13 @@ public:
 
 
 /* `backfiller_business_card_t` represents a thing that is willing to serve
-backfills over the network. It appears in the directory. */
+backfills over the network. It appears in the directory.
+
+A backfill is sent in slices, several at a time. Each one starts with a message
+to the end-point mailbox saying what version the slice will be at when it's
+done, and ends with a message to the slice-done mailbox once all of its chunks
+have been sent. Those messages are ordered with the chunks by the same FIFO
+enforcer. */
 
 template<class protocol_t>
 struct backfiller_business_card_t {
@@ -104,8 +147,10 @@ struct backfiller_business_card_t {
         branch_history_t<protocol_t>,
         mailbox_addr_t< void(
             region_map_t<protocol_t, version_range_t>,
-            branch_history_t<protocol_t>
+            branch_history_t<protocol_t>,
+            fifo_enforcer_write_token_t
             ) >,
+        mailbox_addr_t<void(region_map_t<protocol_t, version_range_t>, fifo_enforcer_write_token_t)>,
         mailbox_addr_t<void(typename protocol_t::backfill_chunk_t, fifo_enforcer_write_token_t)>,
         mailbox_t<void(fifo_enforcer_write_token_t)>::address_t,
         mailbox_t<void(mailbox_addr_t<void(int)>)>::address_t
@@ -0,0 +1,52 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "clustering/immediate_consistency/branch/replication_lag.hpp"
+
+#include <algorithm>
+
+#include "config/args.hpp"
+
+replication_lag_tracker_t::replication_lag_tracker_t() :
+    has_reached(false), reached(state_timestamp_t::zero()),
+    last_sync_primary_time(0), has_clock_offset(false), clock_offset(0) { }
+
+void replication_lag_tracker_t::on_stamp(state_timestamp_t timestamp,
+                                         microtime_t primary_time,
+                                         microtime_t now) {
+    int64_t offset = static_cast<int64_t>(now) - static_cast<int64_t>(primary_time);
+    if (!has_clock_offset || offset < clock_offset) {
+        has_clock_offset = true;
+        clock_offset = offset;
+    }
+
+    microtime_t *stamp = &pending_stamps[timestamp];
+    *stamp = std::max(*stamp, primary_time);
+    reach_stamps();
+}
+
+void replication_lag_tracker_t::on_reached(state_timestamp_t timestamp) {
+    guarantee(!has_reached || timestamp >= reached);
+    has_reached = true;
+    reached = timestamp;
+    reach_stamps();
+}
+
+int64_t replication_lag_tracker_t::get_lag_ms(microtime_t now) const {
+    if (last_sync_primary_time == 0) {
+        return -1;
+    }
+    int64_t sync_time = static_cast<int64_t>(last_sync_primary_time) + clock_offset;
+    return std::max<int64_t>(0, static_cast<int64_t>(now) - sync_time) / THOUSAND;
+}
+
+void replication_lag_tracker_t::reach_stamps() {
+    if (!has_reached) {
+        return;
+    }
+    std::map<state_timestamp_t, microtime_t>::iterator end = pending_stamps.upper_bound(reached);
+    for (std::map<state_timestamp_t, microtime_t>::iterator it = pending_stamps.begin();
+         it != end;
+         ++it) {
+        last_sync_primary_time = std::max(last_sync_primary_time, it->second);
+    }
+    pending_stamps.erase(pending_stamps.begin(), end);
+}
@@ -0,0 +1,58 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_BRANCH_REPLICATION_LAG_HPP_
+#define CLUSTERING_IMMEDIATE_CONSISTENCY_BRANCH_REPLICATION_LAG_HPP_
+
+#include <map>
+
+#include "timestamps.hpp"
+#include "utils.hpp"
+
+/* `replication_lag_tracker_t` works out how far behind its primary a replica
+is. The primary stamps every write, and a heartbeat that it sends every
+`REPLICATION_HEARTBEAT_INTERVAL_MS`, with its clock and the timestamp it had
+reached by then. Once the replica reaches that timestamp, it knows that it was
+in sync with the primary at that time, and its lag is the time since the latest
+such moment. A replica that stops hearing from the primary, or that falls
+behind on applying writes, doesn't find any newer moments, so its lag keeps
+growing.
+
+The two machines' clocks needn't agree. The tracker keeps the smallest
+difference between the time a stamp reaches us and the stamp itself, which is
+the clock skew plus the fastest delivery it has seen, and uses that to turn
+stamps into local times. */
+class replication_lag_tracker_t {
+public:
+    replication_lag_tracker_t();
+
+    /* The primary had issued every write up to `timestamp` at `primary_time`,
+    by its clock. The stamp reached us at `now`. */
+    void on_stamp(state_timestamp_t timestamp, microtime_t primary_time, microtime_t now);
+
+    /* The replica has applied (or queued at the store) every write up to
+    `timestamp`. */
+    void on_reached(state_timestamp_t timestamp);
+
+    /* Returns how many milliseconds behind the primary the replica is at
+    `now`, or -1 if it hasn't been in sync with the primary yet. */
+    int64_t get_lag_ms(microtime_t now) const;
+
+private:
+    void reach_stamps();
+
+    /* Stamps for timestamps that we haven't reached yet. */
+    std::map<state_timestamp_t, microtime_t> pending_stamps;
+
+    bool has_reached;
+    state_timestamp_t reached;
+
+    /* The latest primary time at which we are known to have been in sync, or
+    zero if we never were. */
+    microtime_t last_sync_primary_time;
+
+    bool has_clock_offset;
+    int64_t clock_offset;
+
+    DISABLE_COPYING(replication_lag_tracker_t);
+};
+
+#endif  // CLUSTERING_IMMEDIATE_CONSISTENCY_BRANCH_REPLICATION_LAG_HPP_
@@ -7,7 +7,8 @@
 template <class protocol_t>
 replier_t<protocol_t>::replier_t(listener_t<protocol_t> *li,
                                  mailbox_manager_t *mailbox_manager,
-                                 branch_history_manager_t<protocol_t> *branch_history_manager) :
+                                 branch_history_manager_t<protocol_t> *branch_history_manager,
+                                 const clone_ptr_t<watchable_t<int64_t> > &backfill_bytes_per_sec) :
     mailbox_manager_(mailbox_manager),
     listener_(li),
 
@@ -21,7 +22,8 @@ replier_t<protocol_t>::replier_t(listener_t<protocol_t> *li,
     /* Start serving backfills */
     backfiller_(mailbox_manager_,
                 branch_history_manager,
-                listener_->svs()) {
+                listener_->svs(),
+                backfill_bytes_per_sec) {
 
 #ifndef NDEBUG
     {
@@ -22,7 +22,8 @@ template <class protocol_t>
 class replier_t {
 
 public:
-    replier_t(listener_t<protocol_t> *l, mailbox_manager_t *mm, branch_history_manager_t<protocol_t> *bhm);
+    replier_t(listener_t<protocol_t> *l, mailbox_manager_t *mm, branch_history_manager_t<protocol_t> *bhm,
+              const clone_ptr_t<watchable_t<int64_t> > &backfill_bytes_per_sec);
 
     /* The destructor immediately stops responding to queries. If there was an
     outstanding write or read that the broadcaster was expecting us to respond
@@ -3,14 +3,18 @@
 
 #include "protocol_api.hpp"
 #include "btree/btree_store.hpp"
+#include "clustering/immediate_consistency/branch/listener.hpp"
 
 template <class protocol_t>
 direct_reader_t<protocol_t>::direct_reader_t(
         mailbox_manager_t *mm,
-        store_view_t<protocol_t> *svs_) :
+        store_view_t<protocol_t> *svs_,
+        listener_t<protocol_t> *listener_) :
     mailbox_manager(mm),
     svs(svs_),
-    read_mailbox(mm, boost::bind(&direct_reader_t<protocol_t>::on_read, this, _1, _2))
+    listener(listener_),
+    reads_in_progress(0),
+    read_mailbox(mm, boost::bind(&direct_reader_t<protocol_t>::on_read, this, _1, _2, _3))
     { }
 
 template <class protocol_t>
@@ -18,21 +22,40 @@ direct_reader_business_card_t<protocol_t> direct_reader_t<protocol_t>::get_busin
     return direct_reader_business_card_t<protocol_t>(read_mailbox.get_address());
 }
 
+template <class protocol_t>
+direct_reader_status_t direct_reader_t<protocol_t>::get_status() {
+    int64_t lag = -1;
+    if (listener != NULL && !listener->get_broadcaster_lost_signal()->is_pulsed()) {
+        lag = listener->get_replication_lag_ms();
+    }
+    return direct_reader_status_t(lag, reads_in_progress);
+}
+
 template <class protocol_t>
 void direct_reader_t<protocol_t>::on_read(
         const typename protocol_t::read_t &read,
-        const mailbox_addr_t<void(typename protocol_t::read_response_t)> &cont) {
+        int64_t max_staleness_ms,
+        const response_addr_t &cont) {
     coro_t::spawn_sometime(boost::bind(
         &direct_reader_t<protocol_t>::perform_read, this,
-        read, cont,
+        read, max_staleness_ms, cont,
         auto_drainer_t::lock_t(&drainer)));
 }
 
 template <class protocol_t>
 void direct_reader_t<protocol_t>::perform_read(
         const typename protocol_t::read_t &read,
-        const mailbox_addr_t<void(typename protocol_t::read_response_t)> &cont,
+        int64_t max_staleness_ms,
+        const response_addr_t &cont,
         auto_drainer_t::lock_t keepalive) {
+    direct_reader_status_t status = get_status();
+    if (max_staleness_ms != NO_STALENESS_BOUND &&
+            (status.replication_lag_ms == -1 || status.replication_lag_ms > max_staleness_ms)) {
+        send(mailbox_manager, cont, boost::optional<typename protocol_t::read_response_t>(), status);
+        return;
+    }
+
+    ++reads_in_progress;
     try {
         read_token_pair_t token_pair;
         svs->new_read_token_pair(&token_pair);
@@ -50,10 +73,11 @@ void direct_reader_t<protocol_t>::perform_read(
                   &token_pair,
                   keepalive.get_drain_signal());
 
-        send(mailbox_manager, cont, response);
+        --reads_in_progress;
+        send(mailbox_manager, cont, boost::make_optional(response), get_status());
 
     } catch (const interrupted_exc_t &) {
-        /* ignore */
+        --reads_in_progress;
     }
 }
 
@@ -5,34 +5,50 @@
 #include "clustering/immediate_consistency/query/direct_reader_metadata.hpp"
 #include "concurrency/fifo_checker.hpp"
 
+template <class> class listener_t;
 template <class> class store_view_t;
 
 /* For each primary and secondary of each shard, there is a `direct_reader_t`.
 The `direct_reader_t` allows the `cluster_namespace_interface_t` to bypass the
 `broadcaster_t` and read directly from the B-tree itself. This reduces network
 traffic and is possible even when the primary is down, but the data it returns
-might be out of date. */
+might be out of date.
+
+If the replica is following a primary, `listener` is the `listener_t` that
+keeps `svs` up to date, and reads that bound how stale their data may be are
+refused while it is further behind than that. Otherwise `listener` is `NULL`
+and only reads without a bound are served. */
 
 template <class protocol_t>
 class direct_reader_t {
 public:
     direct_reader_t(
             mailbox_manager_t *mm,
-            store_view_t<protocol_t> *svs);
+            store_view_t<protocol_t> *svs,
+            listener_t<protocol_t> *listener);
 
     direct_reader_business_card_t<protocol_t> get_business_card();
 
 private:
+    typedef mailbox_addr_t<void(boost::optional<typename protocol_t::read_response_t>, direct_reader_status_t)> response_addr_t;
+
     void on_read(
             const typename protocol_t::read_t &,
-            const mailbox_addr_t<void(typename protocol_t::read_response_t)> &);
+            int64_t max_staleness_ms,
+            const response_addr_t &);
     void perform_read(
             const typename protocol_t::read_t &,
-            const mailbox_addr_t<void(typename protocol_t::read_response_t)> &,
+            int64_t max_staleness_ms,
+            const response_addr_t &,
             auto_drainer_t::lock_t);
 
+    direct_reader_status_t get_status();
+
     mailbox_manager_t *mailbox_manager;
     store_view_t<protocol_t> *svs;
+    listener_t<protocol_t> *listener;
+
+    int64_t reads_in_progress;
 
     order_source_t order_source;  // TODO: order_token_t::ignore
     auto_drainer_t drainer;
@@ -2,17 +2,44 @@
 #ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_QUERY_DIRECT_READER_METADATA_HPP_
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_QUERY_DIRECT_READER_METADATA_HPP_
 
+#include "containers/archive/boost_types.hpp"
 #include "rpc/mailbox/typed.hpp"
 
+/* Pass this as the staleness bound of a direct read to accept data no matter
+how far behind the primary it is. */
+const int64_t NO_STALENESS_BOUND = -1;
+
+/* A `direct_reader_t` sends its status back with every reply, so that
+`cluster_namespace_interface_t` can prefer replicas that are caught up and not
+too busy. */
+class direct_reader_status_t {
+public:
+    direct_reader_status_t() : replication_lag_ms(-1), reads_in_progress(0) { }
+    direct_reader_status_t(int64_t lag, int64_t reads) :
+        replication_lag_ms(lag), reads_in_progress(reads) { }
+
+    /* How far behind the primary the replica's data is, or -1 if it can't
+    tell because it isn't following a primary or hasn't caught up with one
+    yet. */
+    int64_t replication_lag_ms;
+
+    int64_t reads_in_progress;
+
+    RDB_MAKE_ME_SERIALIZABLE_2(replication_lag_ms, reads_in_progress);
+};
+
 /* Each replica exposes a `direct_reader_business_card_t` for each shard that it
-is a primary or secondary for. */
+is a primary or secondary for. A read carries the most it may lag behind the
+primary, in milliseconds; a replica that is further behind than that replies
+with no response instead of performing it. */
 
 template <class protocol_t>
 class direct_reader_business_card_t {
 public:
     typedef mailbox_t< void(
             typename protocol_t::read_t,
-            mailbox_addr_t< void(typename protocol_t::read_response_t)>
+            int64_t,
+            mailbox_addr_t< void(boost::optional<typename protocol_t::read_response_t>, direct_reader_status_t)>
             )> read_mailbox_t;
 
     direct_reader_business_card_t() { }
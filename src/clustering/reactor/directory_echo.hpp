@@ -6,6 +6,7 @@
 
 #include "concurrency/watchable.hpp"
 #include "containers/scoped.hpp"
+#include "rpc/directory/delta.hpp"
 #include "rpc/mailbox/typed.hpp"
 #include "utils.hpp"
 
@@ -26,6 +27,13 @@ private:
     directory_echo_version_t version;
     mailbox_addr_t<void(peer_id_t, directory_echo_version_t)> ack_mailbox;
     RDB_MAKE_ME_SERIALIZABLE_3(internal, version, ack_mailbox);
+
+    /* Every change goes through `directory_echo_writer_t`, which bumps the
+    version, so we don't have to look at `ack_mailbox`. The version alone isn't
+    enough, because a new writer starts counting over. */
+    friend bool directory_value_unchanged(const directory_echo_wrapper_t &a, const directory_echo_wrapper_t &b) {
+        return a.version == b.version && directory_value_unchanged(a.internal, b.internal);
+    }
 };
 
 template<class internal_t>
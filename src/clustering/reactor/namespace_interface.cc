@@ -3,6 +3,7 @@
 #include "clustering/immediate_consistency/query/master_access.hpp"
 #include "concurrency/fifo_enforcer.hpp"
 #include "concurrency/watchable.hpp"
+#include "config/args.hpp"
 
 template <class protocol_t>
 cluster_namespace_interface_t<protocol_t>::cluster_namespace_interface_t(
@@ -50,7 +51,14 @@ void cluster_namespace_interface_t<protocol_t>::read_outdated(const typename pro
     /* This seems kind of silly. We do it this way because
        `dispatch_outdated_read` needs to be able to see `outdated_read_info_t`,
        which is defined in the `private` section. */
-    dispatch_outdated_read(r, response, interruptor);
+    dispatch_outdated_read(r, response, NO_STALENESS_BOUND, interruptor);
+}
+
+template <class protocol_t>
+void cluster_namespace_interface_t<protocol_t>::read_outdated_bounded(const typename protocol_t::read_t &r, typename protocol_t::read_response_t *response, int64_t max_staleness_ms, signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t) {
+    guarantee(max_staleness_ms >= 0);
+    dispatch_outdated_read(r, response, max_staleness_ms, interruptor);
 }
 
 template <class protocol_t>
@@ -201,11 +209,55 @@ void cluster_namespace_interface_t<protocol_t>::perform_immediate_op(
     }
 }
 
+template <class protocol_t>
+bool cluster_namespace_interface_t<protocol_t>::has_recent_status(
+        const relationship_t *relationship, ticks_t now) {
+    return relationship->last_status_time != 0 &&
+        now - relationship->last_status_time <= ms_to_ticks(DIRECT_READER_STATUS_EXPIRY_MS);
+}
+
+template <class protocol_t>
+bool cluster_namespace_interface_t<protocol_t>::could_be_within_staleness_bound(
+        const relationship_t *relationship, int64_t max_staleness_ms, ticks_t now) {
+    if (max_staleness_ms == NO_STALENESS_BOUND) {
+        return true;
+    }
+    if (!has_recent_status(relationship, now)) {
+        /* We don't know, so ask it; it will refuse if it's too far behind. */
+        return true;
+    }
+    return relationship->last_status.replication_lag_ms != -1 &&
+        relationship->last_status.replication_lag_ms <= max_staleness_ms;
+}
+
+template <class protocol_t>
+int64_t cluster_namespace_interface_t<protocol_t>::estimate_load(
+        const relationship_t *relationship, ticks_t now) {
+    int64_t load = relationship->reads_in_flight;
+    if (has_recent_status(relationship, now)) {
+        load += relationship->last_status.reads_in_progress;
+    }
+    return load;
+}
+
+template <class protocol_t>
+bool cluster_namespace_interface_t<protocol_t>::is_better_direct_reader(
+        const std::pair<int64_t, relationship_t *> &a,
+        const std::pair<int64_t, relationship_t *> &b) {
+    if (a.first != b.first) {
+        return a.first < b.first;
+    }
+    /* Between equally busy direct readers, a local one saves a round trip
+    over the network. */
+    return a.second->is_local && !b.second->is_local;
+}
+
 template <class protocol_t>
 void
 cluster_namespace_interface_t<protocol_t>::dispatch_outdated_read(
     const typename protocol_t::read_t &op,
     typename protocol_t::read_response_t *response,
+    int64_t max_staleness_ms,
     signal_t *interruptor)
     THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t) {
 
@@ -213,39 +265,52 @@ cluster_namespace_interface_t<protocol_t>::dispatch_outdated_read(
 
     boost::ptr_vector<outdated_read_info_t> direct_readers_to_contact;
 
+    ticks_t now = get_ticks();
     scoped_ptr_t<outdated_read_info_t> new_op_info(new outdated_read_info_t());
     for (auto it = relationships.begin(); it != relationships.end(); ++it) {
         if (op.shard(it->first, &new_op_info->sharded_op)) {
-            std::vector<relationship_t *> potential_relationships;
-            relationship_t *chosen_relationship = NULL;
+            bool found_direct_reader = false;
+            /* Pairs of estimated load and relationship */
+            std::vector<std::pair<int64_t, relationship_t *> > potential_relationships;
 
             const std::set<relationship_t *> *relationship_map = &it->second;
             for (auto jt = relationship_map->begin();
                  jt != relationship_map->end();
                  ++jt) {
                 if ((*jt)->direct_reader_access) {
-                    if ((*jt)->is_local) {
-                        chosen_relationship = *jt;
-                        break;
-                    } else {
-                        potential_relationships.push_back(*jt);
+                    found_direct_reader = true;
+                    if (could_be_within_staleness_bound(*jt, max_staleness_ms, now)) {
+                        potential_relationships.push_back(
+                            std::make_pair(estimate_load(*jt, now), *jt));
                     }
                 }
             }
-            if (!chosen_relationship && !potential_relationships.empty()) {
-                chosen_relationship
-                    = potential_relationships[
-                        distributor_rng.randint(potential_relationships.size())];
-            }
-            if (!chosen_relationship) {
+            if (!found_direct_reader) {
                 /* Don't bother looking for masters; if there are no direct
                    readers, there won't be any masters either. */
                 throw cannot_perform_query_exc_t("No direct reader available");
             }
-            new_op_info->direct_reader_access
-                = chosen_relationship->direct_reader_access;
-            new_op_info->keepalive = auto_drainer_t::lock_t(
-                &chosen_relationship->drainer);
+            if (potential_relationships.empty()) {
+                throw cannot_perform_query_exc_t("No replica is within the staleness bound");
+            }
+
+            /* Shuffle first so that ties between equally busy remote direct
+            readers are broken at random. */
+            for (size_t i = potential_relationships.size(); i > 1; --i) {
+                std::swap(potential_relationships[i - 1],
+                          potential_relationships[distributor_rng.randint(i)]);
+            }
+            std::stable_sort(potential_relationships.begin(),
+                             potential_relationships.end(),
+                             &cluster_namespace_interface_t::is_better_direct_reader);
+
+            for (auto jt = potential_relationships.begin();
+                 jt != potential_relationships.end();
+                 ++jt) {
+                new_op_info->candidates.push_back(jt->second);
+                new_op_info->keepalives.push_back(
+                    auto_drainer_t::lock_t(&jt->second->drainer));
+            }
             direct_readers_to_contact.push_back(new_op_info.release());
             new_op_info.init(new outdated_read_info_t());
         }
@@ -254,7 +319,7 @@ cluster_namespace_interface_t<protocol_t>::dispatch_outdated_read(
     std::vector<typename protocol_t::read_response_t> results(direct_readers_to_contact.size());
     std::vector<std::string> failures(direct_readers_to_contact.size());
     pmap(direct_readers_to_contact.size(), boost::bind(&cluster_namespace_interface_t::perform_outdated_read, this,
-                                                       &direct_readers_to_contact, &results, &failures, _1, interruptor));
+                                                       &direct_readers_to_contact, max_staleness_ms, &results, &failures, _1, interruptor));
 
     if (interruptor->is_pulsed()) throw interrupted_exc_t();
 
@@ -268,14 +333,20 @@ cluster_namespace_interface_t<protocol_t>::dispatch_outdated_read(
 }
 
 template <class protocol_t>
-void outdated_read_store_result(typename protocol_t::read_response_t *result_out, const typename protocol_t::read_response_t &result_in, cond_t *done) {
+void outdated_read_store_result(boost::optional<typename protocol_t::read_response_t> *result_out,
+                                direct_reader_status_t *status_out,
+                                const boost::optional<typename protocol_t::read_response_t> &result_in,
+                                const direct_reader_status_t &status_in,
+                                cond_t *done) {
     *result_out = result_in;
+    *status_out = status_in;
     done->pulse();
 }
 
 template <class protocol_t>
 void cluster_namespace_interface_t<protocol_t>::perform_outdated_read(
     boost::ptr_vector<outdated_read_info_t> *direct_readers_to_contact,
+    int64_t max_staleness_ms,
     std::vector<typename protocol_t::read_response_t> *results,
     std::vector<std::string> *failures,
     int i,
@@ -284,23 +355,48 @@ void cluster_namespace_interface_t<protocol_t>::perform_outdated_read(
 {
     outdated_read_info_t *direct_reader_to_contact = &(*direct_readers_to_contact)[i];
 
-    try {
-        cond_t done;
-        mailbox_t<void(typename protocol_t::read_response_t)> cont(mailbox_manager,
-                                                                   boost::bind(&outdated_read_store_result<protocol_t>, &results->at(i), _1, &done));
-
-        send(mailbox_manager, direct_reader_to_contact->direct_reader_access->access().read_mailbox, direct_reader_to_contact->sharded_op, cont.get_address());
-        wait_any_t waiter(direct_reader_to_contact->direct_reader_access->get_failed_signal(), &done);
-        wait_interruptible(&waiter, interruptor);
-        direct_reader_to_contact->direct_reader_access->access();   /* throws if `get_failed_signal()->is_pulsed()` */
-    } catch (const resource_lost_exc_t &) {
-        failures->at(i).assign("lost contact with direct reader");
-    } catch (const interrupted_exc_t &) {
-        guarantee(interruptor->is_pulsed());
-        /* Ignore `interrupted_exc_t` and return immediately.
-           `read_outdated()` will notice that the interruptor has been pulsed
-           and won't try to access our result. */
+    std::string failure = "No replica is within the staleness bound";
+    for (auto it = direct_reader_to_contact->candidates.begin();
+         it != direct_reader_to_contact->candidates.end();
+         ++it) {
+        relationship_t *relationship = *it;
+        boost::optional<typename protocol_t::read_response_t> result;
+
+        ++relationship->reads_in_flight;
+        try {
+            cond_t done;
+            direct_reader_status_t status;
+            mailbox_t<void(boost::optional<typename protocol_t::read_response_t>, direct_reader_status_t)> cont(mailbox_manager,
+                boost::bind(&outdated_read_store_result<protocol_t>, &result, &status, _1, _2, &done));
+
+            send(mailbox_manager, relationship->direct_reader_access->access().read_mailbox, direct_reader_to_contact->sharded_op, max_staleness_ms, cont.get_address());
+            wait_any_t waiter(relationship->direct_reader_access->get_failed_signal(), &done);
+            wait_interruptible(&waiter, interruptor);
+            relationship->direct_reader_access->access();   /* throws if `get_failed_signal()->is_pulsed()` */
+
+            relationship->last_status = status;
+            relationship->last_status_time = get_ticks();
+        } catch (const resource_lost_exc_t &) {
+            --relationship->reads_in_flight;
+            failure = "lost contact with direct reader";
+            continue;
+        } catch (const interrupted_exc_t &) {
+            --relationship->reads_in_flight;
+            guarantee(interruptor->is_pulsed());
+            /* Ignore `interrupted_exc_t` and return immediately.
+               `read_outdated()` will notice that the interruptor has been pulsed
+               and won't try to access our result. */
+            return;
+        }
+        --relationship->reads_in_flight;
+
+        if (result) {
+            results->at(i) = *result;
+            return;
+        }
+        /* The direct reader is further behind than `max_staleness_ms`. */
     }
+    failures->at(i) = failure;
 }
 
 template <class protocol_t>
@@ -433,6 +529,8 @@ void cluster_namespace_interface_t<protocol_t>::relationship_coroutine(peer_id_t
         relationship_record.region = region;
         relationship_record.master_access = master_access.has() ? master_access.get() : NULL;
         relationship_record.direct_reader_access = direct_reader_access.has() ? direct_reader_access.get() : NULL;
+        relationship_record.last_status_time = 0;
+        relationship_record.reads_in_flight = 0;
 
         region_map_set_membership_t<protocol_t, relationship_t *> relationship_map_insertion(&relationships,
                                                                                              region,
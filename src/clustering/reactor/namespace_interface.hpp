@@ -77,6 +77,8 @@ public:
 
     void read_outdated(const typename protocol_t::read_t &r, typename protocol_t::read_response_t *response, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t);
 
+    void read_outdated_bounded(const typename protocol_t::read_t &r, typename protocol_t::read_response_t *response, int64_t max_staleness_ms, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t);
+
     void write(const typename protocol_t::write_t &w, typename protocol_t::write_response_t *response, order_token_t order_token, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t);
 
     std::set<typename protocol_t::region_t> get_sharding_scheme() THROWS_ONLY(cannot_perform_query_exc_t);
@@ -88,6 +90,14 @@ private:
         typename protocol_t::region_t region;
         master_access_t<protocol_t> *master_access;
         resource_access_t<direct_reader_business_card_t<protocol_t> > *direct_reader_access;
+
+        /* What the direct reader told us about itself the last time it
+        answered one of our reads, and when that was. */
+        direct_reader_status_t last_status;
+        ticks_t last_status_time;
+        /* How many of our outdated reads it's working on right now. */
+        int64_t reads_in_flight;
+
         auto_drainer_t drainer;
     };
 
@@ -107,8 +117,10 @@ private:
     class outdated_read_info_t {
     public:
         typename protocol_t::read_t sharded_op;
-        resource_access_t<direct_reader_business_card_t<protocol_t> > *direct_reader_access;
-        auto_drainer_t::lock_t keepalive;
+        /* The direct readers to try, most preferred first. We move on to the
+        next one if a direct reader is too far behind or goes away. */
+        std::vector<relationship_t *> candidates;
+        std::vector<auto_drainer_t::lock_t> keepalives;
     };
 
     template <class op_type, class fifo_enforcer_token_type, class op_response_type>
@@ -137,14 +149,23 @@ private:
             signal_t *interruptor)
         THROWS_NOTHING;
 
+    /* Outdated reads go to the least busy direct reader that is within
+    `max_staleness_ms` of the primary, as far as we know. */
+    static bool has_recent_status(const relationship_t *relationship, ticks_t now);
+    static bool could_be_within_staleness_bound(const relationship_t *relationship, int64_t max_staleness_ms, ticks_t now);
+    static int64_t estimate_load(const relationship_t *relationship, ticks_t now);
+    static bool is_better_direct_reader(const std::pair<int64_t, relationship_t *> &a, const std::pair<int64_t, relationship_t *> &b);
+
     void dispatch_outdated_read(
             const typename protocol_t::read_t &op,
             typename protocol_t::read_response_t *response,
+            int64_t max_staleness_ms,
             signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t);
 
     void perform_outdated_read(
             boost::ptr_vector<outdated_read_info_t> *direct_readers_to_contact,
+            int64_t max_staleness_ms,
             std::vector<typename protocol_t::read_response_t> *results,
             std::vector<std::string> *failures,
             int i,
@@ -28,6 +28,7 @@ reactor_t<protocol_t>::reactor_t(
         clone_ptr_t<watchable_t<std::map<peer_id_t, boost::optional<directory_echo_wrapper_t<cow_ptr_t<reactor_business_card_t<protocol_t> > > > > > > rd,
         branch_history_manager_t<protocol_t> *bhm,
         clone_ptr_t<watchable_t<blueprint_t<protocol_t> > > b,
+        clone_ptr_t<watchable_t<int64_t> > _backfill_bytes_per_sec,
         multistore_ptr_t<protocol_t> *_underlying_svs,
         perfmon_collection_t *_parent_perfmon_collection,
         typename protocol_t::context_t *_ctx) THROWS_NOTHING :
@@ -42,6 +43,7 @@ reactor_t<protocol_t>::reactor_t(
     directory_echo_mirror(mailbox_manager, rd->subview(&collapse_optionals_in_map<peer_id_t, directory_echo_wrapper_t<cow_ptr_t<reactor_business_card_t<protocol_t> > > >)),
     branch_history_manager(bhm),
     blueprint_watchable(b),
+    backfill_bytes_per_sec(_backfill_bytes_per_sec),
     underlying_svs(_underlying_svs),
     blueprint_subscription(boost::bind(&reactor_t<protocol_t>::on_blueprint_changed, this)),
     ctx(_ctx)
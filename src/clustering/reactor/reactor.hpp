@@ -32,6 +32,7 @@ public:
             clone_ptr_t<watchable_t<std::map<peer_id_t, boost::optional<directory_echo_wrapper_t<cow_ptr_t<reactor_business_card_t<protocol_t> > > > > > > reactor_directory,
             branch_history_manager_t<protocol_t> *branch_history_manager,
             clone_ptr_t<watchable_t<blueprint_t<protocol_t> > > blueprint_watchable,
+            clone_ptr_t<watchable_t<int64_t> > backfill_bytes_per_sec,
             multistore_ptr_t<protocol_t> *_underlying_svs,
             perfmon_collection_t *_parent_perfmon_collection,
             typename protocol_t::context_t *) THROWS_NOTHING;
@@ -172,6 +173,9 @@ private:
 
     clone_ptr_t<watchable_t<blueprint_t<protocol_t> > > blueprint_watchable;
 
+    /* The table's backfill budget, for the backfills we serve. */
+    clone_ptr_t<watchable_t<int64_t> > backfill_bytes_per_sec;
+
     multistore_ptr_t<protocol_t> *underlying_svs;
 
     std::map<typename protocol_t::region_t, current_role_t *> current_roles;
@@ -4,6 +4,7 @@
 #include "clustering/immediate_consistency/branch/backfiller.hpp"
 #include "clustering/immediate_consistency/branch/replier.hpp"
 #include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/cross_thread_watchable.hpp"
 
 
 /* Returns true if every peer listed as a primary for this shard in the
@@ -64,6 +65,7 @@ void reactor_t<protocol_t>::be_nothing(typename protocol_t::region_t region,
 
         {
             cross_thread_signal_t ct_interruptor(interruptor, svs->home_thread());
+            cross_thread_watchable_variable_t<int64_t> ct_backfill_bytes_per_sec(backfill_bytes_per_sec, svs->home_thread());
 
             on_thread_t th(svs->home_thread());
 
@@ -71,7 +73,7 @@ void reactor_t<protocol_t>::be_nothing(typename protocol_t::region_t region,
 
             /* We offer backfills while waiting for it to be safe to shutdown
              * in case another peer needs a copy of the data */
-            backfiller_t<protocol_t> backfiller(mailbox_manager, branch_history_manager, svs);
+            backfiller_t<protocol_t> backfiller(mailbox_manager, branch_history_manager, svs, ct_backfill_bytes_per_sec.get_watchable());
 
             /* Tell the other peers that we are looking to shutdown and
              * offering backfilling until we do. */
@@ -439,12 +439,13 @@ void reactor_t<protocol_t>::be_primary(typename protocol_t::region_t region, sto
         broadcaster_business_card->run_until_satisfied(&check_that_we_see_our_broadcaster<protocol_t>, interruptor);
 
         cross_thread_watchable_variable_t<boost::optional<boost::optional<broadcaster_business_card_t<protocol_t> > > > ct_broadcaster_business_card(broadcaster_business_card, svs->home_thread());
+        cross_thread_watchable_variable_t<int64_t> ct_backfill_bytes_per_sec(backfill_bytes_per_sec, svs->home_thread());
 
         on_thread_t th3(svs->home_thread());
         listener_t<protocol_t> listener(base_path, io_backender, mailbox_manager, ct_broadcaster_business_card.get_watchable(), branch_history_manager, &broadcaster, &region_perfmon_collection, &ct_interruptor, &order_source);
-        replier_t<protocol_t> replier(&listener, mailbox_manager, branch_history_manager);
+        replier_t<protocol_t> replier(&listener, mailbox_manager, branch_history_manager, ct_backfill_bytes_per_sec.get_watchable());
         master_t<protocol_t> master(mailbox_manager, ack_checker, region, &broadcaster);
-        direct_reader_t<protocol_t> direct_reader(mailbox_manager, svs);
+        direct_reader_t<protocol_t> direct_reader(mailbox_manager, svs, &listener);
 
         on_thread_t th4(this->home_thread());
 
@@ -159,6 +159,7 @@ void reactor_t<protocol_t>::be_secondary(typename protocol_t::region_t region, s
 
             {
                 cross_thread_signal_t ct_interruptor(interruptor, svs->home_thread());
+                cross_thread_watchable_variable_t<int64_t> ct_backfill_bytes_per_sec(backfill_bytes_per_sec, svs->home_thread());
                 on_thread_t th(svs->home_thread());
 
                 /* First we construct a backfiller which offers backfills to
@@ -168,7 +169,7 @@ void reactor_t<protocol_t>::be_secondary(typename protocol_t::region_t region, s
                  * Also this is potentially a performance boost because it
                  * allows other secondaries to preemptively backfill before the
                  * primary is up. */
-                backfiller_t<protocol_t> backfiller(mailbox_manager, branch_history_manager, svs);
+                backfiller_t<protocol_t> backfiller(mailbox_manager, branch_history_manager, svs, ct_backfill_bytes_per_sec.get_watchable());
 
                 /* Tell everyone in the cluster what state we're in. */
                 object_buffer_t<fifo_enforcer_sink_t::exit_read_t> read_token;
@@ -177,7 +178,7 @@ void reactor_t<protocol_t>::be_secondary(typename protocol_t::region_t region, s
                 region_map_t<protocol_t, binary_blob_t> metainfo_blob;
                 svs->do_get_metainfo(order_source.check_in("reactor_t::be_secondary").with_read_mode(), &read_token, &ct_interruptor, &metainfo_blob);
 
-                direct_reader_t<protocol_t> direct_reader(mailbox_manager, svs);
+                direct_reader_t<protocol_t> direct_reader(mailbox_manager, svs, NULL);
 
                 on_thread_t th2(this->home_thread());
 
@@ -235,6 +236,7 @@ void reactor_t<protocol_t>::be_secondary(typename protocol_t::region_t region, s
                 cross_thread_signal_t ct_interruptor(interruptor, svs->home_thread());
                 cross_thread_watchable_variable_t<boost::optional<boost::optional<broadcaster_business_card_t<protocol_t> > > > ct_broadcaster(broadcaster, svs->home_thread());
                 cross_thread_watchable_variable_t<boost::optional<boost::optional<replier_business_card_t<protocol_t> > > > ct_location_to_backfill_from(location_to_backfill_from, svs->home_thread());
+                cross_thread_watchable_variable_t<int64_t> ct_backfill_bytes_per_sec(backfill_bytes_per_sec, svs->home_thread());
                 on_thread_t th(svs->home_thread());
 
                 // TODO: Don't use local stack variable for name.
@@ -248,9 +250,9 @@ void reactor_t<protocol_t>::be_secondary(typename protocol_t::region_t region, s
                 /* This gives others access to our services, in particular once
                  * this constructor returns people can send us queries and use
                  * us for backfills. */
-                replier_t<protocol_t> replier(&listener, mailbox_manager, branch_history_manager);
+                replier_t<protocol_t> replier(&listener, mailbox_manager, branch_history_manager, ct_backfill_bytes_per_sec.get_watchable());
 
-                direct_reader_t<protocol_t> direct_reader(mailbox_manager, svs);
+                direct_reader_t<protocol_t> direct_reader(mailbox_manager, svs, &listener);
 
                 cross_thread_signal_t ct_broadcaster_lost_signal(listener.get_broadcaster_lost_signal(), this->home_thread());
                 on_thread_t th2(this->home_thread());
@@ -0,0 +1,60 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "concurrency/rate_limiter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "arch/timing.hpp"
+
+rate_limiter_t::rate_limiter_t(int64_t _rate) :
+    rate(_rate), available(_rate), last_refill(get_ticks()) {
+    rassert(rate >= 0);
+}
+
+void rate_limiter_t::set_rate(int64_t new_rate) {
+    assert_thread();
+    rassert(new_rate >= 0);
+    if (rate == 0) {
+        /* Nothing was being counted, so start out with a full second's worth. */
+        available = new_rate;
+        last_refill = get_ticks();
+    } else {
+        refill(get_ticks());
+        available = std::min<double>(available, new_rate);
+    }
+    rate = new_rate;
+}
+
+void rate_limiter_t::co_consume(int64_t amount, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+    assert_thread();
+    int64_t wait_ms = consume(amount, get_ticks());
+    if (wait_ms > 0) {
+        nap(wait_ms, interruptor);
+    }
+}
+
+int64_t rate_limiter_t::consume(int64_t amount, ticks_t now) {
+    assert_thread();
+    if (rate == 0) {
+        return 0;
+    }
+
+    refill(now);
+
+    /* Take the units right away, even if that puts us in debt; then anyone who
+    comes after us waits for our debt to be paid off as well as their own. */
+    available -= amount;
+    if (available >= 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(ceil(-available * 1000 / rate));
+}
+
+void rate_limiter_t::refill(ticks_t now) {
+    /* `now` is behind `last_refill` if the caller looked at the clock before
+    someone else refilled. */
+    if (now > last_refill) {
+        available = std::min<double>(rate, available + rate * ticks_to_secs(now - last_refill));
+        last_refill = now;
+    }
+}
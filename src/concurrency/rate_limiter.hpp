@@ -0,0 +1,46 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef CONCURRENCY_RATE_LIMITER_HPP_
+#define CONCURRENCY_RATE_LIMITER_HPP_
+
+#include "utils.hpp"
+
+class signal_t;
+
+/* `rate_limiter_t` paces something, like the bytes a backfill sends, to at
+most `rate` units per second. Whatever wasn't used in the last second can be
+used at once, so short bursts go through without waiting. A `rate` of zero
+means there is no limit. */
+class rate_limiter_t : public home_thread_mixin_debug_only_t {
+public:
+    explicit rate_limiter_t(int64_t rate);
+
+    int64_t get_rate() const { return rate; }
+
+    /* Changes the rate from now on. What was used so far is accounted for at
+    the old rate. */
+    void set_rate(int64_t new_rate);
+
+    /* Uses up `amount` units, first waiting for as long as it takes for them
+    to fit in the rate. Coroutines that call it at the same time wait in
+    turn. */
+    void co_consume(int64_t amount, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t);
+
+    /* Uses up `amount` units as of `now`, without waiting, and returns how
+    many milliseconds the caller has to wait before they fit in the rate.
+    `co_consume()` is built on this. */
+    int64_t consume(int64_t amount, ticks_t now);
+
+private:
+    /* Adds what the rate allows since `last_refill` to `available`. */
+    void refill(ticks_t now);
+
+    int64_t rate;
+    /* How many units can be used right now. Negative if coroutines are waiting
+    to use more than that. */
+    double available;
+    ticks_t last_refill;
+
+    DISABLE_COPYING(rate_limiter_t);
+};
+
+#endif  // CONCURRENCY_RATE_LIMITER_HPP_
@@ -120,6 +120,7 @@ public:
     void set_capacity(int new_capacity);
 
     int get_capacity() const { return capacity; }
+    int get_current() const { return current; }
 
 private:
     bool try_lock(int count);
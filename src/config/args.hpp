@@ -81,6 +81,11 @@
 // Size of each btree node (in bytes) on disk
 #define DEFAULT_BTREE_BLOCK_SIZE                  (4 * KILOBYTE)
 
+// The range of btree block sizes a table may be created with.  Nodes address
+// their contents with 16-bit offsets, so blocks can't be larger than 64 KB.
+#define MIN_BTREE_BLOCK_SIZE                      (4 * KILOBYTE)
+#define MAX_BTREE_BLOCK_SIZE                      (64 * KILOBYTE)
+
 // Size of each extent (in bytes)
 #define DEFAULT_EXTENT_SIZE                       (512 * KILOBYTE)
 
@@ -128,6 +133,57 @@
 // We start flushing dirty pages as soon as we hit this fraction of the unsaved data limit
 #define FLUSH_AT_FRACTION_OF_UNSAVED_DATA_LIMIT   0.2
 
+// When a hard-durability write commits while no flush is running, the writeback waits
+// this fraction of the recent average flush duration before starting the flush, so that
+// other writes committing in the meantime share its index write and fsync. Windows
+// shorter than TIMER_TICKS_IN_MS are skipped, which means that on fast disks every
+// commit is flushed right away.
+#define GROUP_COMMIT_WINDOW_FRACTION              0.5
+
+// The group commit window never exceeds this many milliseconds.
+#define MAX_GROUP_COMMIT_WINDOW_MS                20
+
+// Instead of letting dirty blocks pile up until the flush timer or the unsaved data
+// limit forces a big flush, the writeback starts a flush whenever the dirty blocks
+// would take about this many milliseconds to write at the disk bandwidth measured by
+// recent flushes.  How often this happens follows from how fast blocks get dirtied.
+#define WRITEBACK_TRICKLE_FLUSH_MS                100
+
+// A trickle flush writes at least this many blocks, so that small flushes with their
+// fixed costs don't take over.
+#define WRITEBACK_TRICKLE_MIN_BLOCKS              64
+
+// Once this fraction of the dirty block limit is used up, write transactions get
+// delayed by up to MAX_WRITEBACK_THROTTLE_DELAY_MS (growing quadratically towards the
+// limit), instead of running at full speed until they hit the limit and stall.
+#define WRITEBACK_THROTTLE_START_FRACTION         0.5
+#define MAX_WRITEBACK_THROTTLE_DELAY_MS           20
+
+// Stores that log their soft-durability writes to a write-ahead log don't depend on
+// the flush timer to bound data loss, so they let changes sit in memory this long.
+#define WRITE_AHEAD_LOG_FLUSH_TIMER_MS            30000
+
+// Once the active write-ahead log file grows past this many bytes, the store forces a
+// flush of its cache and starts over with the other log file.
+#define WRITE_AHEAD_LOG_CHECKPOINT_SIZE           (64 * MEGABYTE)
+
+// Range erases unlink subtrees that lie entirely within the range from the btree, and
+// then free their blocks with up to this many blocks in flight at once.
+#define ERASE_RANGE_FREE_CONCURRENCY              16
+
+// Bloom filters over the primary keys of a store use this many bits per key they are
+// sized for, and are sized for this many times the keys in the store when they are
+// built. Ten bits per key give about one percent false positives.
+#define KEY_FILTER_BITS_PER_KEY                   10
+#define KEY_FILTER_HEADROOM_FACTOR                2
+#define KEY_FILTER_MIN_CAPACITY                   65536
+
+// A key filter is rebuilt once more than this fraction of the lookups of missing keys
+// get past it (e.g. because many keys were deleted), provided it has seen at least
+// KEY_FILTER_MIN_NEGATIVE_LOOKUPS such lookups since it was built.
+#define KEY_FILTER_MAX_FALSE_POSITIVE_RATE        0.05
+#define KEY_FILTER_MIN_NEGATIVE_LOOKUPS           10000
+
 // How many times the page replacement algorithm tries to find an eligible page before giving up.
 // Note that (MAX_UNSAVED_DATA_LIMIT_FRACTION ** PAGE_REPL_NUM_TRIES) is the probability that the
 // page replacement algorithm will succeed on a given try, and if that probability is less than 1/2
@@ -155,6 +211,91 @@
 // The number of concurrent queries when loading memcached operations from a file.
 #define MAX_CONCURRENT_QUEURIES_ON_IMPORT         1000
 
+// A shard sends at most this many changes to a changefeed at once, and sends no
+// more until the feed acknowledges them.
+#define CHANGEFEED_MAX_BATCH                      100
+
+// A shard queues at most this many changes for a changefeed that hasn't caught
+// up.  Feeds that fall further behind are stopped with an error rather than
+// holding up writes.
+#define CHANGEFEED_MAX_QUEUED                     10000
+
+// A changefeed stops acknowledging changes once it has this many that the query
+// hasn't consumed yet.
+#define CHANGEFEED_MAX_BUFFERED                   1000
+
+// How many TCP connections a node opens to each peer by default.  Mailbox
+// messages are spread over them; everything else uses the first one.
+#define CLUSTER_CONNECTIONS_PER_PEER              4
+#define CLUSTER_MAX_CONNECTIONS_PER_PEER          64
+
+// How long a new peer connection waits for its extra connections to come up
+// before it gives up on the peer.
+#define CLUSTER_EXTRA_CONNECTIONS_TIMEOUT_MS      10000
+
+// Compressed cluster connections send messages smaller than this as they are,
+// since compressing them would save next to nothing.
+#define CLUSTER_COMPRESSION_MIN_SIZE              256
+
+// Values at least this big that are deserialized from cluster messages refer to
+// the message's buffer instead of being copied out of it. Smaller ones are
+// cheaper to copy, and copying them keeps them from holding big messages in
+// memory.
+#define CLUSTER_MESSAGE_MIN_SHARED_READ_SIZE      1024
+
+// How cluster connections are shared between the classes of messages waiting
+// to go out over them (see `message_class_t`): each class gets bandwidth in
+// proportion to its weight. Heartbeats always go first.
+#define CLUSTER_QUERY_MESSAGE_WEIGHT              16
+#define CLUSTER_REPLICATION_MESSAGE_WEIGHT        8
+#define CLUSTER_METADATA_MESSAGE_WEIGHT           4
+#define CLUSTER_BACKFILL_MESSAGE_WEIGHT           1
+
+// A change to a node's directory value is sent to its peers right away, unless
+// it comes this soon after the last update; then it waits for this long after
+// that update, and goes out together with whatever else changed meanwhile.
+#define DIRECTORY_UPDATE_COALESCE_MS              20
+
+// Backfills are sent a slice of the key space at a time.  The receiving node
+// records each slice as it finishes, so an interrupted backfill picks up where
+// it left off.  A backfill is cut into at most this many slices of at least
+// this many keys each.
+#define BACKFILL_MAX_SLICES                       64
+#define BACKFILL_MIN_KEYS_PER_SLICE               100000
+
+// How many slices of a backfill are sent at the same time.
+#define BACKFILL_CONCURRENT_SLICES                4
+
+// The most bytes per second that one backfill of a new table sends.  Each
+// table has its own setting, which can be changed while it runs.  Reading the
+// data from disk is held to the same pace.  0 means no limit.
+#define DEFAULT_BACKFILL_BYTES_PER_SEC            (64 * MEGABYTE)
+
+// A backfill slows down while the thread that it reads the store on is busy,
+// halving its rate down to this floor, and speeds back up by an eighth of the
+// table's setting at a time once the thread is idle again.
+#define BACKFILL_MIN_BYTES_PER_SEC                MEGABYTE
+
+// How often a backfill checks how busy its thread is, and how long the other
+// coroutines on the thread can keep it waiting for its turn before the thread
+// counts as busy.
+#define BACKFILL_LOAD_CHECK_INTERVAL_MS           100
+#define BACKFILL_BUSY_THREAD_LAG_MS               5
+
+// The most writes that a broadcaster sends to one mirror in a single message.
+// Writes that arrive together are batched up to this many.
+#define BROADCASTER_MAX_WRITES_PER_BATCH          64
+
+// How long a query router goes by the replication lag and load that a
+// replica last reported when choosing where to send an outdated read.
+// After that it asks the replica again.
+#define DIRECT_READER_STATUS_EXPIRY_MS            1000
+
+// How often a broadcaster tells its listeners, with its own clock, how far it
+// has got.  A replica counts as behind from the last heartbeat it caught up
+// with, so even an idle replica lags by up to this much.
+#define REPLICATION_HEARTBEAT_INTERVAL_MS         200
+
 // How many timestamps we store in a leaf node.  We store the
 // NUM_LEAF_NODE_EARLIER_TIMES+1 most-recent timestamps.
 #define NUM_LEAF_NODE_EARLIER_TIMES               4
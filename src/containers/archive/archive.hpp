@@ -8,6 +8,8 @@
 #include "utils.hpp"
 
 class uuid_u;
+struct data_buffer_t;
+template <class> class counted_t;
 
 struct fake_archive_exc_t {
     const char *what() const throw() {
@@ -20,6 +22,12 @@ public:
     read_stream_t() { }
     // Returns number of bytes read or 0 upon EOF, -1 upon error.
     virtual MUST_USE int64_t read(void *p, int64_t n) = 0;
+    // Streams that read out of a `data_buffer_t` can hand out the next n bytes
+    // as a slice of it instead of copying them.  Returns false, having read
+    // nothing, if the stream can't or there aren't n bytes left.
+    virtual MUST_USE bool read_shared(UNUSED int64_t n, UNUSED counted_t<data_buffer_t> *out) {
+        return false;
+    }
 protected:
     virtual ~read_stream_t() { }
 private:
@@ -0,0 +1,46 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "containers/archive/data_buffer_stream.hpp"
+
+data_buffer_read_stream_t::data_buffer_read_stream_t(const counted_t<data_buffer_t> &_source,
+                                                     int64_t _offset) :
+    source(_source), offset(_offset) {
+    guarantee(source.has());
+    guarantee(offset >= 0);
+    guarantee(offset <= source->size());
+}
+
+data_buffer_read_stream_t::~data_buffer_read_stream_t() { }
+
+int64_t data_buffer_read_stream_t::read(void *p, int64_t n) {
+    int64_t num_left = source->size() - offset;
+    int64_t num_to_read = n < num_left ? n : num_left;
+
+    memcpy(p, source->buf() + offset, num_to_read);
+
+    offset += num_to_read;
+
+    return num_to_read;
+}
+
+bool data_buffer_read_stream_t::read_shared(int64_t n, counted_t<data_buffer_t> *out) {
+    rassert(n >= 0);
+    if (n > source->size() - offset) {
+        return false;
+    }
+
+    *out = data_buffer_t::create_slice(source, offset, n);
+    offset += n;
+    return true;
+}
+
+void data_buffer_read_stream_t::swap(counted_t<data_buffer_t> *other_source, int64_t *other_offset) {
+    int64_t temp_offset = *other_offset;
+    *other_offset = offset;
+    offset = temp_offset;
+
+    source.swap(*other_source);
+
+    // The stream may be left empty, in which case it must not be read.
+    guarantee(offset >= 0);
+    guarantee(!source.has() || offset <= source->size());
+}
@@ -0,0 +1,28 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_ARCHIVE_DATA_BUFFER_STREAM_HPP_
+#define CONTAINERS_ARCHIVE_DATA_BUFFER_STREAM_HPP_
+
+#include "containers/archive/archive.hpp"
+#include "containers/data_buffer.hpp"
+
+/* Reads out of a `data_buffer_t`. Unlike `string_read_stream_t`, it supports
+`read_shared()`, so big values can be deserialized as slices of the buffer
+rather than copies. */
+class data_buffer_read_stream_t : public read_stream_t {
+public:
+    data_buffer_read_stream_t(const counted_t<data_buffer_t> &_source, int64_t _offset);
+    virtual ~data_buffer_read_stream_t();
+
+    virtual MUST_USE int64_t read(void *p, int64_t n);
+    virtual MUST_USE bool read_shared(int64_t n, counted_t<data_buffer_t> *out);
+
+    void swap(counted_t<data_buffer_t> *other_source, int64_t *other_offset);  // NOLINT(build/include_what_you_use)
+
+private:
+    counted_t<data_buffer_t> source;
+    int64_t offset;
+
+    DISABLE_COPYING(data_buffer_read_stream_t);
+};
+
+#endif  // CONTAINERS_ARCHIVE_DATA_BUFFER_STREAM_HPP_
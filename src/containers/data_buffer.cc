@@ -19,13 +19,41 @@ void debug_print(printf_buffer_t *buf, const counted_t<data_buffer_t>& ptr) {
     }
 }
 
+void data_buffer_t::destroy(data_buffer_t *p) {
+    rassert(p->ref_count_ == 0);
+    if (p->parent_ != NULL) {
+        counted_release(p->parent_);
+    }
+    free(p);
+}
+
 counted_t<data_buffer_t> data_buffer_t::create(int64_t size) {
-    static_assert(sizeof(data_buffer_t) == sizeof(ref_count_) + sizeof(size_),
+    static_assert(sizeof(data_buffer_t) == sizeof(ref_count_) + sizeof(size_)
+                  + sizeof(data_) + sizeof(parent_),
                   "data_buffer_t is not a packed struct type");
 
     rassert(size >= 0 && static_cast<uint64_t>(size) <= SIZE_MAX - sizeof(data_buffer_t));
     data_buffer_t *b = static_cast<data_buffer_t *>(malloc(sizeof(data_buffer_t) + size));
     b->ref_count_ = 0;
     b->size_ = size;
+    b->data_ = b->bytes_;
+    b->parent_ = NULL;
+    return counted_t<data_buffer_t>(b);
+}
+
+counted_t<data_buffer_t> data_buffer_t::create_slice(const counted_t<data_buffer_t> &parent,
+                                                     int64_t offset, int64_t size) {
+    guarantee(parent.has());
+    rassert(offset >= 0 && size >= 0 && offset + size <= parent->size());
+
+    /* Slices of slices point straight at the buffer that holds the bytes, so
+    that the chain never gets longer than one. */
+    data_buffer_t *owner = parent->parent_ != NULL ? parent->parent_ : parent.get();
+    data_buffer_t *b = static_cast<data_buffer_t *>(malloc(sizeof(data_buffer_t)));
+    b->ref_count_ = 0;
+    b->size_ = size;
+    b->data_ = parent->data_ + offset;
+    b->parent_ = owner;
+    counted_add_ref(owner);
     return counted_t<data_buffer_t>(b);
 }
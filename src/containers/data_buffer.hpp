@@ -7,10 +7,17 @@
 
 class printf_buffer_t;
 
+/* `data_buffer_t` is a reference-counted array of bytes. It either holds its
+own bytes or is a slice of another `data_buffer_t`, which it keeps alive; that
+way a value can be read out of a big buffer, such as a message received over
+the network, without copying it. */
 struct data_buffer_t {
 private:
     intptr_t ref_count_;
     size_t size_;
+    /* Points at `bytes_`, or into `parent_` if we're a slice of it. */
+    char *data_;
+    data_buffer_t *parent_;
     char bytes_[];
 
     friend void counted_add_ref(data_buffer_t *buffer);
@@ -19,15 +26,17 @@ private:
     DISABLE_COPYING(data_buffer_t);
 
 public:
-    static void destroy(data_buffer_t *p) {
-        rassert(p->ref_count_ == 0);
-        free(p);
-    }
+    static void destroy(data_buffer_t *p);
 
     static counted_t<data_buffer_t> create(int64_t size);
 
-    char *buf() { return bytes_; }
-    const char *buf() const { return bytes_; }
+    /* Returns the `size` bytes of `parent` that start at `offset`, without
+    copying them. */
+    static counted_t<data_buffer_t> create_slice(const counted_t<data_buffer_t> &parent,
+                                                 int64_t offset, int64_t size);
+
+    char *buf() { return data_; }
+    const char *buf() const { return data_; }
     int64_t size() const { return size_; }
 };
 
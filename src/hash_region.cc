@@ -240,3 +240,33 @@ bool region_contains_key(const hash_region_t<key_range_t> &region, const store_k
     const uint64_t hash_value = hash_region_hasher(key.contents(), key.size());
     return region_contains_key_with_precomputed_hash(region, key, hash_value);
 }
+
+std::vector<hash_region_t<key_range_t> > region_split_by_key_counts(const hash_region_t<key_range_t> &region,
+                                                                    const std::map<store_key_t, int64_t> &key_counts,
+                                                                    int max_pieces,
+                                                                    int64_t min_keys_per_piece) {
+    int64_t total = 0;
+    for (std::map<store_key_t, int64_t>::const_iterator it = key_counts.begin(); it != key_counts.end(); ++it) {
+        total += it->second;
+    }
+    const int64_t num_pieces = std::min<int64_t>(max_pieces, total / std::max<int64_t>(min_keys_per_piece, 1));
+
+    std::vector<hash_region_t<key_range_t> > pieces;
+    hash_region_t<key_range_t> piece = region;
+    int64_t seen = 0;
+    for (std::map<store_key_t, int64_t>::const_iterator it = key_counts.begin();
+         it != key_counts.end() && static_cast<int64_t>(pieces.size()) + 1 < num_pieces;
+         ++it) {
+        // Each key in `key_counts` starts a bucket, so we can cut just before it.
+        const int64_t cut_point = total * (pieces.size() + 1) / num_pieces;
+        if (seen >= cut_point && piece.inner.left < it->first && region.inner.contains_key(it->first)) {
+            piece.inner.right = key_range_t::right_bound_t(it->first);
+            pieces.push_back(piece);
+            piece.inner.left = it->first;
+            piece.inner.right = region.inner.right;
+        }
+        seen += it->second;
+    }
+    pieces.push_back(piece);
+    return pieces;
+}
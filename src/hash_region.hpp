@@ -11,6 +11,7 @@
 #include <inttypes.h>
 
 #include <algorithm>
+#include <map>
 #include <vector>
 
 #include "rpc/serialize_macros.hpp"
@@ -135,6 +136,15 @@ bool region_contains_key_with_precomputed_hash(const hash_region_t<key_range_t>
 
 bool region_contains_key(const hash_region_t<key_range_t> &region, const store_key_t &key);
 
+/* Cuts `region` by key into pieces that hold roughly the same number of keys,
+going by `key_counts` (the result of a distribution read of `region`). There
+are at most `max_pieces` pieces, and none has fewer than about
+`min_keys_per_piece` keys. The pieces are in key order. */
+std::vector<hash_region_t<key_range_t> > region_split_by_key_counts(const hash_region_t<key_range_t> &region,
+                                                                    const std::map<store_key_t, int64_t> &key_counts,
+                                                                    int max_pieces,
+                                                                    int64_t min_keys_per_piece);
+
 template <class inner_region_t>
 bool region_overlaps(const hash_region_t<inner_region_t> &r1, const hash_region_t<inner_region_t> &r2) {
     return r1.beg < r2.end && r2.beg < r1.end
@@ -2,11 +2,11 @@
 #include "memcached/memcached_btree/distribution.hpp"
 #include "btree/get_distribution.hpp"
 
-distribution_result_t memcached_distribution_get(btree_slice_t *slice, int max_depth, const store_key_t &left_key,
+distribution_result_t memcached_distribution_get(btree_slice_t *slice, int max_depth, size_t min_sample_size, const store_key_t &left_key,
         exptime_t, transaction_t *txn, superblock_t *superblock) {
     int64_t key_count_out;
     std::vector<store_key_t> key_splits;
-    get_btree_key_distribution(slice, txn, superblock, max_depth, &key_count_out, &key_splits);
+    get_btree_key_distribution(slice, txn, superblock, max_depth, min_sample_size, &key_count_out, &key_splits);
 
     distribution_result_t res;
 
@@ -14,14 +14,19 @@ distribution_result_t memcached_distribution_get(btree_slice_t *slice, int max_d
     if (key_splits.empty()) {
         keys_per_bucket = key_count_out;
     } else  {
-        keys_per_bucket = std::max<int64_t>(key_count_out / key_splits.size(), 1);
+        // The split points divide the keys into one more bucket than there
+        // are split points.
+        keys_per_bucket = std::max<int64_t>(key_count_out / (key_splits.size() + 1), 1);
     }
     res.key_counts[left_key] = keys_per_bucket;
 
     for (std::vector<store_key_t>::iterator it  = key_splits.begin();
                                             it != key_splits.end();
                                             ++it) {
-        res.key_counts[*it] = keys_per_bucket;
+        // Sampled keys are truncated, which can take them below `left_key`.
+        if (left_key < *it) {
+            res.key_counts[*it] = keys_per_bucket;
+        }
     }
 
     return res;
@@ -6,6 +6,23 @@
 #include "memcached/memcached_btree/node.hpp"
 #include "memcached/memcached_btree/value.hpp"
 
+namespace {
+
+struct memcached_value_deleter_t : public value_deleter_t {
+    void delete_value(transaction_t *_txn, void *value) {
+        blob_t blob(_txn->get_cache()->get_block_size(),
+                    static_cast<memcached_value_t *>(value)->value_ref(),
+                    blob::btree_maxreflen);
+        blob.clear(_txn);
+    }
+
+    value_deleter_t *clone() const {
+        return new memcached_value_deleter_t;
+    }
+};
+
+}   /* anonymous namespace */
+
 void memcached_erase_range(btree_slice_t *slice, key_tester_t *tester,
                        bool left_key_supplied, const store_key_t& left_key_exclusive,
                        bool right_key_supplied, const store_key_t& right_key_inclusive,
@@ -14,14 +31,7 @@ void memcached_erase_range(btree_slice_t *slice, key_tester_t *tester,
     value_sizer_t<memcached_value_t> mc_sizer(slice->cache()->get_block_size());
     value_sizer_t<void> *sizer = &mc_sizer;
 
-    struct : public value_deleter_t {
-        void delete_value(transaction_t *_txn, void *value) {
-            blob_t blob(_txn->get_cache()->get_block_size(),
-                        static_cast<memcached_value_t *>(value)->value_ref(),
-                        blob::btree_maxreflen);
-            blob.clear(_txn);
-        }
-    } deleter;
+    memcached_value_deleter_t deleter;
 
     btree_erase_range_generic(sizer, slice, tester, &deleter,
         left_key_supplied ? left_key_exclusive.btree_key() : NULL,
@@ -46,3 +56,8 @@ void memcached_erase_range(btree_slice_t *slice, key_tester_t *tester,
     memcached_erase_range(slice, tester, left_key_supplied, left_exclusive, right_key_supplied, right_inclusive, txn, superblock, interruptor);
 }
 
+void memcached_free_detached_subtrees(btree_slice_t *slice) {
+    memcached_value_deleter_t deleter;
+    start_freeing_detached_subtrees(slice, &deleter);
+}
+
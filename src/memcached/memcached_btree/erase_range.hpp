@@ -13,4 +13,8 @@ void memcached_erase_range(btree_slice_t *slice, key_tester_t *tester,
                                  const key_range_t &keys,
                                  transaction_t *txn, superblock_t *superblock, signal_t *interruptor);
 
+// Starts freeing the subtrees that range erases left on `slice`'s list of
+// detached subtrees; see `start_freeing_detached_subtrees()`.
+void memcached_free_detached_subtrees(btree_slice_t *slice);
+
 #endif /* MEMCACHED_MEMCACHED_BTREE_ERASE_RANGE_HPP_ */
@@ -4,15 +4,24 @@
 #include "btree/internal_node.hpp"
 #include "btree/leaf_node.hpp"
 #include "btree/operations.hpp"
+#include "btree/slice.hpp"
 #include "memcached/memcached_btree/btree_data_provider.hpp"
 #include "memcached/memcached_btree/node.hpp"
 #include "memcached/memcached_btree/value.hpp"
 
 get_result_t memcached_get(const store_key_t &store_key, btree_slice_t *slice, exptime_t effective_time, transaction_t *txn, superblock_t *superblock) {
 
+    if (slice->key_filter.has() && !slice->key_filter->may_contain(store_key.btree_key())) {
+        return get_result_t();
+    }
+
     keyvalue_location_t<memcached_value_t> kv_location;
     find_keyvalue_location_for_read(txn, superblock, store_key.btree_key(), &kv_location, slice->root_eviction_priority, &slice->stats, NULL);
 
+    if (slice->key_filter.has()) {
+        slice->key_filter->on_lookup(kv_location.value.has());
+    }
+
     if (!kv_location.value.has()) {
         return get_result_t();
     }
@@ -39,6 +39,10 @@ void run_memcached_modify_oper(memcached_modify_oper_t *oper, btree_slice_t *sli
 
     // Actually update the leaf, if needed.
     if (update_needed) {
+        if (slice->key_filter.has() && the_value.has()
+            && !kv_location.there_originally_was_value) {
+            slice->key_filter->on_insert(store_key.btree_key());
+        }
         kv_location.value = std::move(the_value);
         null_key_modification_callback_t<memcached_value_t> null_cb;
         apply_keyvalue_change(txn, &kv_location, store_key.btree_key(), timestamp, expired, &null_cb, &slice->root_eviction_priority);
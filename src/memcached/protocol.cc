@@ -6,12 +6,14 @@
 #include <boost/bind.hpp>
 
 #include "btree/operations.hpp"
+#include "btree/get_distribution.hpp"
 #include "btree/parallel_traversal.hpp"
 #include "btree/slice.hpp"
 #include "btree/superblock.hpp"
 #include "concurrency/access.hpp"
 #include "concurrency/pmap.hpp"
 #include "concurrency/wait_any.hpp"
+#include "config/args.hpp"
 #include "containers/archive/boost_types.hpp"
 #include "containers/iterators.hpp"
 #include "containers/scoped.hpp"
@@ -66,6 +68,9 @@ archive_result_t deserialize(read_stream_t *s, counted_t<data_buffer_t> *buf) {
         res = deserialize(s, &size);
         if (res) { return res; }
         if (size < 0) { return ARCHIVE_RANGE_ERROR; }
+        if (size >= CLUSTER_MESSAGE_MIN_SHARED_READ_SIZE && s->read_shared(size, buf)) {
+            return ARCHIVE_SUCCESS;
+        }
         *buf = data_buffer_t::create(size);
         int64_t num_read = force_read(s, (*buf)->buf(), size);
 
@@ -385,6 +390,20 @@ public:
     }
 };
 
+struct backfill_chunk_estimate_size_visitor_t : public boost::static_visitor<size_t> {
+public:
+    size_t operator()(const backfill_chunk_t::delete_key_t &del) {
+        return del.key.size();
+    }
+    size_t operator()(const backfill_chunk_t::delete_range_t &) {
+        return 0;
+    }
+    size_t operator()(const backfill_chunk_t::key_value_pair_t &kv) {
+        const counted_t<data_buffer_t> &value = kv.backfill_atom.value;
+        return kv.backfill_atom.key.size() + (value.has() ? value->size() : 0);
+    }
+};
+
 }   /* anonymous namespace */
 
 repli_timestamp_t backfill_chunk_t::get_btree_repli_timestamp() const THROWS_NOTHING {
@@ -392,6 +411,14 @@ repli_timestamp_t backfill_chunk_t::get_btree_repli_timestamp() const THROWS_NOT
     return boost::apply_visitor(v, val);
 }
 
+size_t backfill_chunk_t::estimate_size() const THROWS_NOTHING {
+    /* The variant tag, the flags, timestamps and CAS, and the key bounds of a
+    range. */
+    static const size_t approx_per_chunk_overhead = 40;
+    backfill_chunk_estimate_size_visitor_t v;
+    return approx_per_chunk_overhead + boost::apply_visitor(v, val);
+}
+
 region_t memcached_protocol_t::cpu_sharding_subspace(int subregion_number, int num_cpu_shards) {
     guarantee(subregion_number >= 0);
     guarantee(subregion_number < num_cpu_shards);
@@ -405,6 +432,30 @@ region_t memcached_protocol_t::cpu_sharding_subspace(int subregion_number, int n
     return region_t(beg, end, key_range_t::universe());
 }
 
+std::vector<region_t> memcached_protocol_t::backfill_slices(store_view_t<memcached_protocol_t> *store,
+                                                            const region_t &region,
+                                                            signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t) {
+    distribution_get_query_t query(2, BACKFILL_MAX_SLICES * 4);
+    query.region = region;
+    read_t read(query, time(NULL));
+    read_response_t response;
+
+    read_token_pair_t token_pair;
+    store->new_read_token_pair(&token_pair);
+#ifndef NDEBUG
+    trivial_metainfo_checker_callback_t<memcached_protocol_t> metainfo_checker_callback;
+    metainfo_checker_t<memcached_protocol_t> metainfo_checker(&metainfo_checker_callback, store->get_region());
+#endif
+    store->read(DEBUG_ONLY(metainfo_checker, )
+                read, &response, order_token_t::ignore, &token_pair, interruptor);
+
+    return region_split_by_key_counts(region,
+                                      boost::get<distribution_result_t>(response.result).key_counts,
+                                      BACKFILL_MAX_SLICES,
+                                      BACKFILL_MIN_KEYS_PER_SLICE);
+}
+
 store_t::store_t(serializer_t *serializer,
                  const std::string &perfmon_name,
                  int64_t cache_size,
@@ -417,7 +468,10 @@ store_t::store_t(serializer_t *serializer,
             serializer, perfmon_name, cache_size,
             create, parent_perfmon_collection, ctx, io,
             base_path)
-{ }
+{
+    // Finish freeing whatever range erases left behind before a restart.
+    memcached_free_detached_subtrees(btree.get());
+}
 
 store_t::~store_t() {
     assert_thread();
@@ -437,7 +491,9 @@ struct read_visitor_t : public boost::static_visitor<read_response_t> {
     }
 
     read_response_t operator()(const distribution_get_query_t& dget) {
-        distribution_result_t dstr = memcached_distribution_get(btree, dget.max_depth, dget.region.inner.left, effective_time, txn, superblock);
+        distribution_result_t dstr = memcached_distribution_get(btree, dget.max_depth,
+                key_sample_size_for_distribution(dget.result_limit, dget.region),
+                dget.region.inner.left, effective_time, txn, superblock);
         for (std::map<store_key_t, int64_t>::iterator it = dstr.key_counts.begin(); it != dstr.key_counts.end(); ) {
             if (!dget.region.inner.contains_key(store_key_t(it->first))) {
                 dstr.key_counts.erase(it++);
@@ -633,16 +689,17 @@ void store_t::protocol_send_backfill(const region_map_t<memcached_protocol_t, st
 namespace {
 
 struct receive_backfill_visitor_t : public boost::static_visitor<> {
-    receive_backfill_visitor_t(btree_slice_t *_btree, transaction_t *_txn,
-                               superblock_t *_superblock, signal_t *_interruptor)
-        : btree(_btree), txn(_txn),
+    receive_backfill_visitor_t(const region_t &_store_region, btree_slice_t *_btree,
+                               transaction_t *_txn, superblock_t *_superblock,
+                               signal_t *_interruptor)
+        : store_region(_store_region), btree(_btree), txn(_txn),
           superblock(_superblock), interruptor(_interruptor) { }
 
     void operator()(const backfill_chunk_t::delete_key_t& delete_key) const {
         memcached_delete(delete_key.key, true, btree, 0, delete_key.recency, txn, superblock);
     }
     void operator()(const backfill_chunk_t::delete_range_t& delete_range) const {
-        hash_range_key_tester_t tester(delete_range.range);
+        hash_range_key_tester_t tester(delete_range.range, store_region);
         memcached_erase_range(btree, &tester, delete_range.range.inner, txn, superblock, interruptor);
     }
     void operator()(const backfill_chunk_t::key_value_pair_t& kv) const {
@@ -655,18 +712,26 @@ struct receive_backfill_visitor_t : public boost::static_visitor<> {
     }
 private:
     struct hash_range_key_tester_t : public key_tester_t {
-        explicit hash_range_key_tester_t(const region_t &delete_range) : delete_range_(delete_range) { }
+        hash_range_key_tester_t(const region_t &delete_range, const region_t &store_region)
+            : delete_range_(delete_range), store_region_(store_region) { }
         bool key_should_be_erased(const btree_key_t *key) {
             uint64_t h = hash_region_hasher(key->contents, key->size);
             return delete_range_.beg <= h && h < delete_range_.end
                 && delete_range_.inner.contains_key(key->contents, key->size);
         }
+        // Every key in the store hashes into its hash shard.
+        bool erases_every_key() {
+            return delete_range_.beg <= store_region_.beg
+                && store_region_.end <= delete_range_.end;
+        }
 
         const region_t &delete_range_;
+        const region_t &store_region_;
 
     private:
         DISABLE_COPYING(hash_range_key_tester_t);
     };
+    const region_t store_region;
     btree_slice_t *btree;
     transaction_t *txn;
     superblock_t *superblock;
@@ -682,7 +747,7 @@ void store_t::protocol_receive_backfill(btree_slice_t *btree,
                                         signal_t *interruptor,
                                         const backfill_chunk_t &chunk) {
     token_pair->sindex_write_token.reset();
-    boost::apply_visitor(receive_backfill_visitor_t(btree, txn, superblock, interruptor), chunk.val);
+    boost::apply_visitor(receive_backfill_visitor_t(get_region(), btree, txn, superblock, interruptor), chunk.val);
 }
 
 namespace {
@@ -690,15 +755,22 @@ namespace {
 // TODO: Maybe hash_range_key_tester_t is redundant with this, since
 // the key range test is redundant.
 struct hash_key_tester_t : public key_tester_t {
-    hash_key_tester_t(uint64_t beg, uint64_t end) : beg_(beg), end_(end) { }
+    hash_key_tester_t(uint64_t beg, uint64_t end, const region_t &store_region)
+        : beg_(beg), end_(end), store_beg_(store_region.beg), store_end_(store_region.end) { }
     bool key_should_be_erased(const btree_key_t *key) {
         uint64_t h = hash_region_hasher(key->contents, key->size);
         return beg_ <= h && h < end_;
     }
+    // Every key in the store hashes into its hash shard.
+    bool erases_every_key() {
+        return beg_ <= store_beg_ && store_end_ <= end_;
+    }
 
 private:
     uint64_t beg_;
     uint64_t end_;
+    uint64_t store_beg_;
+    uint64_t store_end_;
 
     DISABLE_COPYING(hash_key_tester_t);
 };
@@ -713,7 +785,7 @@ void store_t::protocol_reset_data(const region_t& subregion,
                                   signal_t *interruptor) {
     token_pair->sindex_write_token.reset();
 
-    hash_key_tester_t key_tester(subregion.beg, subregion.end);
+    hash_key_tester_t key_tester(subregion.beg, subregion.end, get_region());
     memcached_erase_range(btree, &key_tester, subregion.inner, txn, superblock, interruptor);
 }
 
@@ -155,6 +155,10 @@ public:
         API. */
         repli_timestamp_t get_btree_repli_timestamp() const THROWS_NOTHING;
 
+        /* Roughly how many bytes the chunk takes up when it's sent, without
+        serializing it. The backfiller paces itself by this. */
+        size_t estimate_size() const THROWS_NOTHING;
+
         boost::variant<delete_range_t, delete_key_t, key_value_pair_t> val;
 
         static backfill_chunk_t delete_range(const region_t &range) {
@@ -172,6 +176,13 @@ public:
 
     static region_t cpu_sharding_subspace(int subregion_number, int num_cpu_shards);
 
+    /* Cuts `region` of `store` into the slices that a backfill of it is sent
+    in (see `backfiller_t`). */
+    static std::vector<region_t> backfill_slices(store_view_t<memcached_protocol_t> *store,
+                                                 const region_t &region,
+                                                 signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
+
     class store_t : public btree_store_t<memcached_protocol_t> {
     public:
         store_t(serializer_t *serializer,
@@ -208,6 +208,23 @@ dummy_protocol_t::region_t dummy_protocol_t::cpu_sharding_subspace(int subregion
     }
 }
 
+std::vector<dummy_protocol_t::region_t> dummy_protocol_t::backfill_slices(UNUSED store_view_t<dummy_protocol_t> *store,
+                                                                         const region_t &region,
+                                                                         UNUSED signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t) {
+    /* Real stores only slice big backfills, but we always cut the region in
+    two so that the tests exercise slicing. */
+    std::vector<region_t> slices(2);
+    size_t i = 0;
+    for (std::set<std::string>::const_iterator it = region.keys.begin(); it != region.keys.end(); ++it, ++i) {
+        slices[i < region.keys.size() / 2 ? 0 : 1].keys.insert(*it);
+    }
+    if (slices[0].keys.empty()) {
+        slices.erase(slices.begin());
+    }
+    return slices;
+}
+
 
 dummy_protocol_t::store_t::store_t() : store_view_t<dummy_protocol_t>(dummy_protocol_t::region_t('a', 'z')), serializer(NULL) {
     initialize_empty();
@@ -89,6 +89,10 @@ public:
         std::string key, value;
         state_timestamp_t timestamp;
 
+        size_t estimate_size() const THROWS_NOTHING {
+            return key.size() + value.size() + sizeof(timestamp);
+        }
+
         RDB_MAKE_ME_SERIALIZABLE_3(key, value, timestamp);
     };
 
@@ -101,6 +105,13 @@ public:
 
     static region_t cpu_sharding_subspace(int subregion_number, int num_cpu_shards);
 
+    /* Cuts `region` of `store` into the slices that a backfill of it is sent
+    in (see `backfiller_t`). */
+    static std::vector<region_t> backfill_slices(store_view_t<dummy_protocol_t> *store,
+                                                 const region_t &region,
+                                                 signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
+
 
     class store_t : public store_view_t<dummy_protocol_t> {
     public:
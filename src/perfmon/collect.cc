@@ -20,3 +20,11 @@ scoped_ptr_t<perfmon_result_t> perfmon_get_stats() {
     return get_global_perfmon_collection().end_stats(data);
 }
 
+
+scoped_ptr_t<perfmon_result_t> perfmon_get_stats(const perfmon_filter_t &filter) {
+    void *data = get_global_perfmon_collection().begin_filtered_stats(&filter, 0, filter.all_active());
+    pmap(get_num_threads(), boost::bind(&co_perfmon_visit, _1, data));
+    scoped_ptr_t<perfmon_result_t> result = get_global_perfmon_collection().end_stats(data);
+    filter.filter(&result);
+    return result;
+}
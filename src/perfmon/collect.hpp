@@ -11,4 +11,11 @@
  */
 scoped_ptr_t<perfmon_result_t> perfmon_get_stats();
 
+/* Like `perfmon_get_stats()`, but only returns the stats that pass `filter`.
+ * Perfmons that the filter rules out by name are never visited, which makes
+ * narrow requests much cheaper than collecting everything and filtering
+ * afterwards.
+ */
+scoped_ptr_t<perfmon_result_t> perfmon_get_stats(const perfmon_filter_t &filter);
+
 #endif  // PERFMON_COLLECT_HPP_
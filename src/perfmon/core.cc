@@ -24,12 +24,15 @@ private:
 public:
     DEBUG_ONLY(size_t size;)
     void **contexts;
+    // Constituents that were filtered out are not visited at all.
+    std::vector<bool> included;
 
     stats_collection_context_t(rwi_lock_t *constituents_lock,
                                const intrusive_list_t<perfmon_membership_t> &constituents) :
         lock_sentry(constituents_lock),
         DEBUG_ONLY(size(constituents.size()), )
-        contexts(new void *[constituents.size()])
+        contexts(new void *[constituents.size()]),
+        included(constituents.size(), true)
     { }
 
     ~stats_collection_context_t() {
@@ -55,12 +58,46 @@ void *perfmon_collection_t::begin_stats() {
     return ctx;
 }
 
+void *perfmon_collection_t::begin_filtered_stats(const perfmon_filter_t *filter,
+                                                 size_t depth,
+                                                 const std::vector<bool> &active) {
+    if (filter->keeps_everything(depth, active)) {
+        return begin_stats();
+    }
+
+    stats_collection_context_t *ctx;
+    {
+        on_thread_t thread_switcher(home_thread());
+        ctx = new stats_collection_context_t(&constituents_access, constituents);
+    }
+
+    size_t i = 0;
+    for (perfmon_membership_t *p = constituents.head(); p != NULL; p = constituents.next(p), ++i) {
+        rassert(i < ctx->size);
+        if (p->splice()) {
+            // Spliced results end up in our own map, at our own depth.
+            ctx->contexts[i] = p->get()->begin_filtered_stats(filter, depth, active);
+            continue;
+        }
+        std::vector<bool> subactive;
+        if (filter->may_keep(depth, active, p->name, &subactive)) {
+            ctx->contexts[i] = p->get()->begin_filtered_stats(filter, depth + 1, subactive);
+        } else {
+            ctx->contexts[i] = NULL;
+            ctx->included[i] = false;
+        }
+    }
+    return ctx;
+}
+
 void perfmon_collection_t::visit_stats(void *_context) {
     stats_collection_context_t *ctx = reinterpret_cast<stats_collection_context_t*>(_context);
     size_t i = 0;
     for (perfmon_membership_t *p = constituents.head(); p != NULL; p = constituents.next(p), ++i) {
         rassert(i < ctx->size);
-        p->get()->visit_stats(ctx->contexts[i]);
+        if (ctx->included[i]) {
+            p->get()->visit_stats(ctx->contexts[i]);
+        }
     }
 }
 
@@ -72,6 +109,9 @@ scoped_ptr_t<perfmon_result_t> perfmon_collection_t::end_stats(void *_context) {
     size_t i = 0;
     for (perfmon_membership_t *p = constituents.head(); p != NULL; p = constituents.next(p), ++i) {
         rassert(i < ctx->size);
+        if (!ctx->included[i]) {
+            continue;
+        }
         scoped_ptr_t<perfmon_result_t> stat = p->get()->end_stats(ctx->contexts[i]);
         if (p->splice()) {
             stat->splice_into(map.get());
@@ -339,6 +379,38 @@ void perfmon_filter_t::filter(const scoped_ptr_t<perfmon_result_t> *p) const {
     guarantee(p->has(), "subfilter is not supposed to delete the top-most node.");
 }
 
+std::vector<bool> perfmon_filter_t::all_active() const {
+    return std::vector<bool>(regexps.size(), true);
+}
+
+/* These mirror the decisions `subfilter` makes for a map at [depth], but only
+   look at the names so that they can be made before the stats are collected. */
+bool perfmon_filter_t::keeps_everything(const size_t depth,
+                                        const std::vector<bool> &active) const {
+    for (size_t i = 0; i < regexps.size(); ++i) {
+        if (active[i] && depth >= regexps[i].size()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool perfmon_filter_t::may_keep(const size_t depth, const std::vector<bool> &active,
+                                const std::string &name,
+                                std::vector<bool> *subactive_out) const {
+    rassert(!keeps_everything(depth, active));
+    *subactive_out = active;
+    bool some_subpath = false;
+    for (size_t i = 0; i < regexps.size(); ++i) {
+        if (!active[i]) {
+            continue;
+        }
+        (*subactive_out)[i] = regexps[i][depth]->matches(name);
+        some_subpath |= (*subactive_out)[i];
+    }
+    return some_subpath;
+}
+
 /* Filter a [perfmon_result_t].  [depth] is how deep we are in the paths that
    the [perfmon_filter_t] was constructed from, and [active] is the set of paths
    that are still active (i.e. that haven't failed a match yet).  This should
@@ -14,6 +14,7 @@
 #include "utils.hpp"
 
 class perfmon_collection_t;
+class perfmon_filter_t;
 class perfmon_result_t;
 class scoped_regex_t;
 
@@ -44,6 +45,17 @@ public:
     virtual void *begin_stats() = 0;
     virtual void visit_stats(void *ctx) = 0;
     virtual scoped_ptr_t<perfmon_result_t> end_stats(void *ctx) = 0;
+
+    /* Like begin_stats(), but the perfmon may leave out the parts of its result
+     * that `filter` is going to discard anyway, so that they don't have to be
+     * visited on every thread. `depth` and `active` say where in the filter's
+     * paths the result of this perfmon ends up (see perfmon_filter_t). The
+     * result still has to be passed through the filter afterwards. */
+    virtual void *begin_filtered_stats(UNUSED const perfmon_filter_t *filter,
+                                       UNUSED size_t depth,
+                                       UNUSED const std::vector<bool> &active) {
+        return begin_stats();
+    }
 };
 
 class perfmon_membership_t;
@@ -56,6 +68,8 @@ public:
 
     /* Perfmon interface */
     void *begin_stats();
+    void *begin_filtered_stats(const perfmon_filter_t *filter, size_t depth,
+                               const std::vector<bool> &active);
     void visit_stats(void *_contexts);
     scoped_ptr_t<perfmon_result_t> end_stats(void *_contexts);
 
@@ -107,6 +121,17 @@ public:
     ~perfmon_filter_t();
     // This takes a const scoped_ptr_t because subfilter needs one to sanely work.
     void filter(const scoped_ptr_t<perfmon_result_t> *target) const;
+
+    /* These let perfmons skip collecting stats that `filter()` would throw away.
+     * `active` has one entry per path and says whether that path still matches
+     * at `depth`. */
+    std::vector<bool> all_active() const;
+    // True if everything in a map at `depth` is going to be kept.
+    bool keeps_everything(size_t depth, const std::vector<bool> &active) const;
+    // True if the entry called `name` in a map at `depth` may be kept;
+    // `subactive_out` receives the active paths for the level below it.
+    bool may_keep(size_t depth, const std::vector<bool> &active,
+                  const std::string &name, std::vector<bool> *subactive_out) const;
 private:
     void subfilter(scoped_ptr_t<perfmon_result_t> *target,
                    size_t depth, std::vector<bool> active) const;
@@ -18,6 +18,10 @@ static const char * stat_per_sec = "per_sec";
 static const char * stat_count = "count";
 static const char * stat_mean = "mean";
 static const char * stat_std_dev = "std_dev";
+static const char * stat_p50 = "p50";
+static const char * stat_p90 = "p90";
+static const char * stat_p99 = "p99";
+static const char * stat_p999 = "p99.9";
 static const char * no_value = "-";
 
 
@@ -231,6 +235,168 @@ void perfmon_stddev_t::record(double value) {
     thread_data[get_thread_id().threadnum].add(value);
 }
 
+/* latency_histogram_t */
+
+const int latency_histogram_t::sub_bucket_bits;
+const uint64_t latency_histogram_t::sub_buckets;
+const int latency_histogram_t::max_value_bits;
+const size_t latency_histogram_t::num_buckets;
+
+latency_histogram_t::latency_histogram_t() : total(0), max_micros(0) { }
+
+size_t latency_histogram_t::bucket_for_value(uint64_t micros) {
+    if (micros < sub_buckets) {
+        return micros;
+    }
+    const uint64_t max_micros_value = (static_cast<uint64_t>(1) << max_value_bits) - 1;
+    micros = std::min(micros, max_micros_value);
+    // `msb` is the position of the highest set bit; everything below the top
+    // `sub_bucket_bits + 1` bits is folded into the same bucket.
+    int msb = 63 - __builtin_clzll(micros);
+    int shift = msb - sub_bucket_bits;
+    return (shift + 1) * sub_buckets + ((micros >> shift) - sub_buckets);
+}
+
+uint64_t latency_histogram_t::bucket_upper_bound(size_t bucket) {
+    if (bucket < sub_buckets) {
+        return bucket;
+    }
+    int shift = bucket / sub_buckets - 1;
+    uint64_t lower = (sub_buckets + bucket % sub_buckets) << shift;
+    return lower + (static_cast<uint64_t>(1) << shift) - 1;
+}
+
+void latency_histogram_t::record(double secs) {
+    if (buckets.empty()) {
+        buckets.resize(num_buckets, 0);
+    }
+    uint64_t micros = secs > 0 ? static_cast<uint64_t>(secs * 1000000.0) : 0;
+    ++buckets[bucket_for_value(micros)];
+    ++total;
+    max_micros = std::max(max_micros, micros);
+}
+
+void latency_histogram_t::aggregate(const latency_histogram_t &other) {
+    if (other.total == 0) {
+        return;
+    }
+    if (buckets.empty()) {
+        buckets.resize(num_buckets, 0);
+    }
+    for (size_t i = 0; i < num_buckets; ++i) {
+        buckets[i] += other.buckets[i];
+    }
+    total += other.total;
+    max_micros = std::max(max_micros, other.max_micros);
+}
+
+void latency_histogram_t::reset() {
+    std::fill(buckets.begin(), buckets.end(), 0);
+    total = 0;
+    max_micros = 0;
+}
+
+uint64_t latency_histogram_t::count() const {
+    return total;
+}
+
+double latency_histogram_t::max() const {
+    return max_micros / 1000000.0;
+}
+
+double latency_histogram_t::percentile(double fraction) const {
+    rassert(total > 0);
+    rassert(fraction >= 0 && fraction <= 1);
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(ceil(fraction * total)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < num_buckets; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            // The bucket bound can overshoot the largest value we've actually
+            // seen, which would look odd next to `max`.
+            return std::min(bucket_upper_bound(i), max_micros) / 1000000.0;
+        }
+    }
+    return max();
+}
+
+/* perfmon_histogram_t */
+
+perfmon_histogram_t::perfmon_histogram_t(ticks_t _length)
+    : perfmon_perthread_t<latency_histogram_t>(), thread_data(new thread_info_t[MAX_THREADS]), length(_length)
+{
+    for (int i = 0; i < MAX_THREADS; i++) {
+        thread_data[i].current_interval = get_ticks() / length;
+    }
+}
+
+perfmon_histogram_t::~perfmon_histogram_t() {
+    delete[] thread_data;
+}
+
+void perfmon_histogram_t::update(ticks_t now) {
+    int interval = now / length;
+    rassert(get_thread_id().threadnum >= 0);
+    thread_info_t *thread = &thread_data[get_thread_id().threadnum];
+
+    if (thread->current_interval == interval) {
+        /* We're up to date; nothing to do */
+    } else if (thread->current_interval + 1 == interval) {
+        /* We're one step behind. Swap instead of copying so that the bucket
+        storage gets reused. */
+        thread->last_stats.reset();
+        std::swap(thread->last_stats, thread->current_stats);
+        thread->current_interval++;
+    } else {
+        /* We're more than one step behind */
+        thread->last_stats.reset();
+        thread->current_stats.reset();
+        thread->current_interval = interval;
+    }
+}
+
+void perfmon_histogram_t::record(double secs) {
+    update(get_ticks());
+    rassert(get_thread_id().threadnum >= 0);
+    thread_data[get_thread_id().threadnum].current_stats.record(secs);
+}
+
+void perfmon_histogram_t::get_thread_stat(latency_histogram_t *stat) {
+    update(get_ticks());
+    /* As with `perfmon_sampler_t`, report the last complete interval. */
+    rassert(get_thread_id().threadnum >= 0);
+    *stat = thread_data[get_thread_id().threadnum].last_stats;
+}
+
+latency_histogram_t perfmon_histogram_t::combine_stats(const latency_histogram_t *stats) {
+    latency_histogram_t aggregated;
+    for (int i = 0; i < get_num_threads(); i++) {
+        aggregated.aggregate(stats[i]);
+    }
+    return aggregated;
+}
+
+scoped_ptr_t<perfmon_result_t> perfmon_histogram_t::output_stat(const latency_histogram_t &aggregated) {
+    scoped_ptr_t<perfmon_result_t> stat = perfmon_result_t::alloc_map_result();
+
+    stat->insert(stat_count, new perfmon_result_t(strprintf("%" PRIu64, aggregated.count())));
+    if (aggregated.count() > 0) {
+        stat->insert(stat_p50, new perfmon_result_t(strprintf("%.8f", aggregated.percentile(0.5))));
+        stat->insert(stat_p90, new perfmon_result_t(strprintf("%.8f", aggregated.percentile(0.9))));
+        stat->insert(stat_p99, new perfmon_result_t(strprintf("%.8f", aggregated.percentile(0.99))));
+        stat->insert(stat_p999, new perfmon_result_t(strprintf("%.8f", aggregated.percentile(0.999))));
+        stat->insert(stat_max, new perfmon_result_t(strprintf("%.8f", aggregated.max())));
+    } else {
+        stat->insert(stat_p50, new perfmon_result_t(no_value));
+        stat->insert(stat_p90, new perfmon_result_t(no_value));
+        stat->insert(stat_p99, new perfmon_result_t(no_value));
+        stat->insert(stat_p999, new perfmon_result_t(no_value));
+        stat->insert(stat_max, new perfmon_result_t(no_value));
+    }
+
+    return stat;
+}
+
 /* perfmon_rate_monitor_t */
 
 perfmon_rate_monitor_t::perfmon_rate_monitor_t(ticks_t _length)
@@ -318,6 +484,12 @@ void *perfmon_duration_sampler_t::begin_stats() {
     return stat.begin_stats();
 }
 
+void *perfmon_duration_sampler_t::begin_filtered_stats(const perfmon_filter_t *filter,
+                                                       size_t depth,
+                                                       const std::vector<bool> &active) {
+    return stat.begin_filtered_stats(filter, depth, active);
+}
+
 void perfmon_duration_sampler_t::visit_stats(void *data) {
     stat.visit_stats(data);
 }
@@ -13,6 +13,7 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "perfmon/types.hpp"
 #include "perfmon/core.hpp"
@@ -177,6 +178,68 @@ private:
     stddev_t thread_data[MAX_THREADS]; // TODO(rntz) should this be cache-line padded?
 };
 
+/* `latency_histogram_t` is an HDR-style log-linear histogram of durations. Values
+ * are recorded in whole microseconds; every power of two is split into
+ * `sub_buckets` linear buckets, so any percentile read back from the histogram is
+ * within 1/sub_buckets of the true value. Storage is only allocated on the first
+ * call to `record()`, so histograms on threads that never record anything cost
+ * nothing. */
+class latency_histogram_t {
+public:
+    latency_histogram_t();
+
+    // Records a duration given in seconds.
+    void record(double secs);
+    void aggregate(const latency_histogram_t &other);
+    // Zeroes the counts but keeps the storage around for reuse.
+    void reset();
+
+    uint64_t count() const;
+    double max() const;
+    // Returns the smallest recorded bucket bound (in seconds) such that at
+    // least `fraction` of the recorded values are not above it.
+    double percentile(double fraction) const;
+
+    static const int sub_bucket_bits = 4;
+    static const uint64_t sub_buckets = 1 << sub_bucket_bits;
+    // Values of 2^max_value_bits microseconds (about 12 days) and more are clamped.
+    static const int max_value_bits = 40;
+    static const size_t num_buckets = (max_value_bits - sub_bucket_bits + 1) * sub_buckets;
+
+    static size_t bucket_for_value(uint64_t micros);
+    static uint64_t bucket_upper_bound(size_t bucket);
+
+private:
+    std::vector<uint64_t> buckets;
+    uint64_t total;
+    uint64_t max_micros;
+};
+
+/* `perfmon_histogram_t` reports percentiles (p50, p90, p99, p99.9) and the
+ * maximum of the values recorded over the last full interval of `length` ticks.
+ * Each thread records into its own histogram without any synchronization; the
+ * per-thread histograms are only merged when stats are requested. */
+class perfmon_histogram_t : public perfmon_perthread_t<latency_histogram_t> {
+    struct thread_info_t {
+        latency_histogram_t current_stats, last_stats;
+        int current_interval;
+    };
+
+    thread_info_t *thread_data;
+
+    void get_thread_stat(latency_histogram_t *);
+    latency_histogram_t combine_stats(const latency_histogram_t *);
+    scoped_ptr_t<perfmon_result_t> output_stat(const latency_histogram_t &);
+
+    void update(ticks_t now);
+
+    ticks_t length;
+public:
+    explicit perfmon_histogram_t(ticks_t _length);
+    virtual ~perfmon_histogram_t();
+    void record(double secs);
+};
+
 /* `perfmon_rate_monitor_t` keeps track of the number of times some event
  * happens per second. It is different from `perfmon_sampler_t` in that it does
  * not associate a number with each event, but you can record many events at
@@ -232,6 +295,8 @@ public:
     void end(ticks_t *v);
 
     void *begin_stats();
+    void *begin_filtered_stats(const perfmon_filter_t *filter, size_t depth,
+                               const std::vector<bool> &active);
     void visit_stats(void *data);
     scoped_ptr_t<perfmon_result_t> end_stats(void *data);
 
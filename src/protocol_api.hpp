@@ -51,6 +51,13 @@ public:
     virtual void read_outdated(const typename protocol_t::read_t &, typename protocol_t::read_response_t *response, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t) = 0;
     virtual void write(const typename protocol_t::write_t &, typename protocol_t::write_response_t *response, order_token_t tok, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t) = 0;
 
+    /* Like `read_outdated()`, but the data may be at most `max_staleness_ms`
+    milliseconds behind the primary. Interfaces whose outdated reads are never
+    behind don't have to override it. */
+    virtual void read_outdated_bounded(const typename protocol_t::read_t &r, typename protocol_t::read_response_t *response, UNUSED int64_t max_staleness_ms, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t) {
+        read_outdated(r, response, interruptor);
+    }
+
     /* These calls are for the sole purpose of optimizing queries; don't rely
     on them for correctness. They should not block. */
     virtual std::set<typename protocol_t::region_t> get_sharding_scheme() THROWS_ONLY(cannot_perform_query_exc_t) {
@@ -193,6 +200,13 @@ void debug_print(printf_buffer_t *buf, const region_map_t<P, V> &map) {
 
 template<class P, class V>
 bool operator==(const region_map_t<P, V> &left, const region_map_t<P, V> &right) {
+    /* Copies of the same map have the same pairs in the same order, and then
+    there's no need to work out their domains and mask one by the other. */
+    if (left.end() - left.begin() == right.end() - right.begin()
+            && std::equal(left.begin(), left.end(), right.begin())) {
+        return true;
+    }
+
     if (left.get_domain() != right.get_domain()) {
         return false;
     }
@@ -1,6 +1,8 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "rdb_protocol/btree.hpp"
 
+#include <algorithm>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -71,10 +73,19 @@ bool btree_value_fits(block_size_t bs, int data_length, const rdb_value_t *value
 
 void rdb_get(const store_key_t &store_key, btree_slice_t *slice, transaction_t *txn,
         superblock_t *superblock, point_read_response_t *response, profile::trace_t *trace) {
+    if (slice->key_filter.has() && !slice->key_filter->may_contain(store_key.btree_key())) {
+        response->data.reset(new ql::datum_t(ql::datum_t::R_NULL));
+        return;
+    }
+
     keyvalue_location_t<rdb_value_t> kv_location;
     find_keyvalue_location_for_read(txn, superblock, store_key.btree_key(), &kv_location,
             slice->root_eviction_priority, &slice->stats, trace);
 
+    if (slice->key_filter.has()) {
+        slice->key_filter->on_lookup(kv_location.value.has());
+    }
+
     if (!kv_location.value.has()) {
         response->data.reset(new ql::datum_t(ql::datum_t::R_NULL));
     } else {
@@ -136,6 +147,10 @@ void kv_location_set(keyvalue_location_t<rdb_value_t> *kv_location,
             + kv_location->value->inline_size(block_size));
     }
 
+    if (slice->key_filter.has() && !kv_location->there_originally_was_value) {
+        slice->key_filter->on_insert(key.btree_key());
+    }
+
     // Actually update the leaf, if needed.
     kv_location->value = std::move(new_value);
     null_key_modification_callback_t<rdb_value_t> null_cb;
@@ -153,6 +168,10 @@ void kv_location_set(keyvalue_location_t<rdb_value_t> *kv_location,
     scoped_malloc_t<rdb_value_t> new_value(
             value_ref.data(), value_ref.data() + value_ref.size());
 
+    if (slice->key_filter.has() && !kv_location->there_originally_was_value) {
+        slice->key_filter->on_insert(key.btree_key());
+    }
+
     // Update the leaf, if needed.
     kv_location->value = std::move(new_value);
     null_key_modification_callback_t<rdb_value_t> null_cb;
@@ -309,25 +328,16 @@ private:
 
 void do_a_replace_from_batched_replace(
     auto_drainer_t::lock_t,
-    fifo_enforcer_sink_t *batched_replaces_fifo_sink,
-    const fifo_enforcer_write_token_t &batched_replaces_fifo_token,
     const btree_loc_info_t &info,
     const one_replace_t one_replace,
     promise_t<superblock_t *> *superblock_promise,
-    rdb_modification_report_cb_t *sindex_cb,
+    rdb_modification_report_t *mod_report_out,
     batched_replace_response_t *stats_out,
     profile::trace_t *trace)
 {
-    fifo_enforcer_sink_t::exit_write_t exiter(
-        batched_replaces_fifo_sink, batched_replaces_fifo_token);
-
-    rdb_modification_report_t mod_report(*info.key);
     counted_t<const ql::datum_t> res = rdb_replace_and_return_superblock(
-        info, &one_replace, superblock_promise, &mod_report.info, trace);
+        info, &one_replace, superblock_promise, &mod_report_out->info, trace);
     *stats_out = (*stats_out)->merge(res, ql::stats_merge);
-
-    exiter.wait();
-    sindex_cb->on_mod_report(mod_report);
 }
 
 batched_replace_response_t rdb_batched_replace(
@@ -338,11 +348,13 @@ batched_replace_response_t rdb_batched_replace(
     rdb_modification_report_cb_t *sindex_cb,
     profile::trace_t *trace) {
 
-    fifo_enforcer_source_t batched_replaces_fifo_source;
-    fifo_enforcer_sink_t batched_replaces_fifo_sink;
-
     counted_t<const ql::datum_t> stats(new ql::datum_t(ql::datum_t::R_OBJECT));
 
+    // The sindexes are updated for the whole batch at once, once all of the
+    // replaces are done.
+    std::vector<rdb_modification_report_t> mod_reports;
+    mod_reports.reserve(keys.size());
+
     // We have to drain write operations before destructing everything above us,
     // because the coroutines being drained use them.
     {
@@ -353,24 +365,25 @@ batched_replace_response_t rdb_batched_replace(
         for (size_t i = 0; i < keys.size(); ++i) {
             // Pass out the point_replace_response_t.
             promise_t<superblock_t *> superblock_promise;
+            mod_reports.push_back(rdb_modification_report_t(keys[i]));
             coro_t::spawn(
                 boost::bind(
                     &do_a_replace_from_batched_replace,
                     auto_drainer_t::lock_t(&drainer),
-                    &batched_replaces_fifo_sink,
-                    batched_replaces_fifo_source.enter_write(),
 
                     btree_loc_info_t(&info, current_superblock.release(), &keys[i]),
                     one_replace_t(replacer, i),
 
                     &superblock_promise,
-                    sindex_cb,
+                    &mod_reports.back(),
                     &stats,
                     trace));
 
             current_superblock.init(superblock_promise.wait());
         }
     } // Make sure the drainer is destructed before the return statement.
+
+    sindex_cb->on_mod_reports(mod_reports);
     return stats;
 }
 
@@ -475,12 +488,17 @@ void rdb_value_deleter_t::delete_value(transaction_t *_txn, void *_value) {
     blob.clear(_txn);
 }
 
+value_deleter_t *rdb_value_deleter_t::clone() const {
+    return new rdb_value_deleter_t;
+}
+
 void rdb_value_non_deleter_t::delete_value(transaction_t *, void *) { }
 
 class sindex_key_range_tester_t : public key_tester_t {
 public:
-    explicit sindex_key_range_tester_t(const key_range_t &key_range)
-        : key_range_(key_range) { }
+    sindex_key_range_tester_t(const key_range_t &key_range,
+                              const key_range_t &store_key_range)
+        : key_range_(key_range), store_key_range_(store_key_range) { }
 
     bool key_should_be_erased(const btree_key_t *key) {
         std::string pk = ql::datum_t::extract_primary(
@@ -488,14 +506,21 @@ public:
 
         return key_range_.contains_key(store_key_t(pk));
     }
+
+    // Every primary key in the sindex is in the store's key range.
+    bool erases_every_key() {
+        return key_range_.is_superset(store_key_range_);
+    }
 private:
     key_range_t key_range_;
+    key_range_t store_key_range_;
 };
 
 typedef btree_store_t<rdb_protocol_t>::sindex_access_t sindex_access_t;
 typedef btree_store_t<rdb_protocol_t>::sindex_access_vector_t sindex_access_vector_t;
 
 void sindex_erase_range(const key_range_t &key_range,
+        const key_range_t &store_key_range,
         transaction_t *txn, const sindex_access_t *sindex_access, auto_drainer_t::lock_t,
         signal_t *interruptor, bool release_superblock) THROWS_NOTHING {
 
@@ -504,7 +529,7 @@ void sindex_erase_range(const key_range_t &key_range,
 
     rdb_value_non_deleter_t deleter;
 
-    sindex_key_range_tester_t tester(key_range);
+    sindex_key_range_tester_t tester(key_range, store_key_range);
 
     try {
         btree_erase_range_generic(sizer, sindex_access->btree, &tester,
@@ -518,6 +543,7 @@ void sindex_erase_range(const key_range_t &key_range,
 void spawn_sindex_erase_ranges(
         const sindex_access_vector_t *sindex_access,
         const key_range_t &key_range,
+        const key_range_t &store_key_range,
         transaction_t *txn,
         auto_drainer_t *drainer,
         auto_drainer_t::lock_t,
@@ -525,7 +551,7 @@ void spawn_sindex_erase_ranges(
         signal_t *interruptor) {
     for (auto it = sindex_access->begin(); it != sindex_access->end(); ++it) {
         coro_t::spawn_sometime(boost::bind(
-                    &sindex_erase_range, key_range, txn, &*it,
+                    &sindex_erase_range, key_range, store_key_range, txn, &*it,
                     auto_drainer_t::lock_t(drainer), interruptor,
                     release_superblock));
     }
@@ -562,7 +588,8 @@ void rdb_erase_range(btree_slice_t *slice, key_tester_t *tester,
 
     {
         auto_drainer_t sindex_erase_drainer;
-        spawn_sindex_erase_ranges(&sindex_superblocks, key_range, txn,
+        spawn_sindex_erase_ranges(&sindex_superblocks, key_range,
+                store->get_region().inner, txn,
                 &sindex_erase_drainer, auto_drainer_t::lock_t(&sindex_erase_drainer),
                 true, /* release the superblock */ interruptor);
 
@@ -723,8 +750,21 @@ public:
             }
         }
         try {
-            lazy_json_t first_value(static_cast<const rdb_value_t *>(keyvalue.value()),
-                                    transaction);
+            // Unless the key was truncated, the index value can be read straight
+            // out of it instead of evaluating the index function again. Counting
+            // then doesn't even need the document.
+            counted_t<const ql::datum_t> sindex_value;
+            if (sindex_function && !ql::datum_t::key_is_truncated(store_key)) {
+                sindex_value = ql::datum_t::extract_secondary_datum(
+                    key_to_unescaped_str(store_key));
+            }
+            const bool index_only = sindex_value.has() && transform.empty()
+                && terminal && boost::get<ql::count_wire_func_t>(&*terminal) != NULL;
+
+            lazy_json_t first_value = index_only
+                ? lazy_json_t(sindex_value)
+                : lazy_json_t(static_cast<const rdb_value_t *>(keyvalue.value()),
+                              transaction);
             first_value.get();
 
             keyvalue.reset();
@@ -739,20 +779,21 @@ public:
             std::vector<lazy_json_t> data;
             data.push_back(first_value);
 
-            counted_t<const ql::datum_t> sindex_value;
             if (sindex_function) {
-                sindex_value =
-                    sindex_function->call(ql_env, first_value.get())->as_datum();
                 guarantee(sindex_range);
                 guarantee(sindex_multi);
-
-                if (sindex_multi == sindex_multi_bool_t::MULTI &&
-                    sindex_value->get_type() == ql::datum_t::R_ARRAY) {
-                        boost::optional<uint64_t> tag =
-                            ql::datum_t::extract_tag(key_to_unescaped_str(store_key));
-                        guarantee(tag);
-                        guarantee(sindex_value->size() > *tag);
-                        sindex_value = sindex_value->get(*tag);
+                if (!sindex_value.has()) {
+                    sindex_value =
+                        sindex_function->call(ql_env, first_value.get())->as_datum();
+
+                    if (sindex_multi == sindex_multi_bool_t::MULTI &&
+                        sindex_value->get_type() == ql::datum_t::R_ARRAY) {
+                            boost::optional<uint64_t> tag =
+                                ql::datum_t::extract_tag(key_to_unescaped_str(store_key));
+                            guarantee(tag);
+                            guarantee(sindex_value->size() > *tag);
+                            sindex_value = sindex_value->get(*tag);
+                    }
                 }
                 if (!sindex_range->contains(sindex_value)) {
                     return true;
@@ -906,24 +947,29 @@ void rdb_rget_secondary_slice(
     boost::apply_visitor(result_finalizer_visitor_t(), response->result);
 }
 
-void rdb_distribution_get(btree_slice_t *slice, int max_depth, const store_key_t &left_key,
+void rdb_distribution_get(btree_slice_t *slice, int max_depth, size_t min_sample_size, const store_key_t &left_key,
                           transaction_t *txn, superblock_t *superblock, distribution_read_response_t *response) {
     int64_t key_count_out;
     std::vector<store_key_t> key_splits;
-    get_btree_key_distribution(slice, txn, superblock, max_depth, &key_count_out, &key_splits);
+    get_btree_key_distribution(slice, txn, superblock, max_depth, min_sample_size, &key_count_out, &key_splits);
 
     int64_t keys_per_bucket;
     if (key_splits.size() == 0) {
         keys_per_bucket = key_count_out;
     } else  {
-        keys_per_bucket = std::max<int64_t>(key_count_out / key_splits.size(), 1);
+        // The split points divide the keys into one more bucket than there
+        // are split points.
+        keys_per_bucket = std::max<int64_t>(key_count_out / (key_splits.size() + 1), 1);
     }
     response->key_counts[left_key] = keys_per_bucket;
 
     for (std::vector<store_key_t>::iterator it  = key_splits.begin();
                                             it != key_splits.end();
                                             ++it) {
-        response->key_counts[*it] = keys_per_bucket;
+        // Sampled keys are truncated, which can take them below `left_key`.
+        if (left_key < *it) {
+            response->key_counts[*it] = keys_per_bucket;
+        }
     }
 }
 
@@ -976,10 +1022,11 @@ RDB_IMPL_ME_SERIALIZABLE_1(rdb_erase_range_report_t, range_to_erase);
 
 rdb_modification_report_cb_t::rdb_modification_report_cb_t(
         btree_store_t<rdb_protocol_t> *store,
+        ql::changefeed::server_t *changefeed_server,
         write_token_pair_t *token_pair,
         transaction_t *txn, block_id_t sindex_block_id,
         auto_drainer_t::lock_t lock)
-    : store_(store), token_pair_(token_pair),
+    : store_(store), changefeed_server_(changefeed_server), token_pair_(token_pair),
       txn_(txn), sindex_block_id_(sindex_block_id),
       lock_(lock)
 { }
@@ -990,8 +1037,7 @@ rdb_modification_report_cb_t::~rdb_modification_report_cb_t() {
     }
 }
 
-void rdb_modification_report_cb_t::on_mod_report(
-        const rdb_modification_report_t &mod_report) {
+void rdb_modification_report_cb_t::acquire_sindexes() {
     if (!sindex_block_.has()) {
         // Don't allow interruption here, or we may end up with inconsistent data
         cond_t dummy_interruptor;
@@ -1002,6 +1048,11 @@ void rdb_modification_report_cb_t::on_mod_report(
         store_->aquire_post_constructed_sindex_superblocks_for_write(
                 sindex_block_.get(), txn_, &sindexes_);
     }
+}
+
+void rdb_modification_report_cb_t::on_mod_report(
+        const rdb_modification_report_t &mod_report) {
+    acquire_sindexes();
 
     mutex_t::acq_t acq;
     store_->lock_sindex_queue(sindex_block_.get(), &acq);
@@ -1011,6 +1062,32 @@ void rdb_modification_report_cb_t::on_mod_report(
     store_->sindex_queue_push(wm, &acq);
 
     rdb_update_sindexes(sindexes_, &mod_report, txn_);
+
+    if (changefeed_server_ != NULL) {
+        changefeed_server_->on_mod_report(mod_report);
+    }
+}
+
+void rdb_modification_report_cb_t::on_mod_reports(
+        const std::vector<rdb_modification_report_t> &mod_reports) {
+    acquire_sindexes();
+
+    mutex_t::acq_t acq;
+    store_->lock_sindex_queue(sindex_block_.get(), &acq);
+
+    for (auto it = mod_reports.begin(); it != mod_reports.end(); ++it) {
+        write_message_t wm;
+        wm << rdb_sindex_change_t(*it);
+        store_->sindex_queue_push(wm, &acq);
+    }
+
+    rdb_update_sindexes(sindexes_, mod_reports, txn_);
+
+    if (changefeed_server_ != NULL) {
+        for (auto it = mod_reports.begin(); it != mod_reports.end(); ++it) {
+            changefeed_server_->on_mod_report(*it);
+        }
+    }
 }
 
 typedef btree_store_t<rdb_protocol_t>::sindex_access_vector_t sindex_access_vector_t;
@@ -1032,18 +1109,28 @@ void compute_keys(const store_key_t &primary_key, counted_t<const ql::datum_t> d
     }
 }
 
-/* Used below by rdb_update_sindexes. */
+/* A change to a sindex tree, computed from a modification report. */
+struct sindex_update_t {
+    store_key_t sindex_key;
+    // The value to store under the key, or NULL to delete the key.
+    const std::vector<char> *value_ref;
+};
+
+bool sindex_update_less(const sindex_update_t &a, const sindex_update_t &b) {
+    return a.sindex_key < b.sindex_key;
+}
+
+/* Used below by rdb_update_sindexes. Applies the modifications to the sindex
+ * in sindex key order, so that consecutive descents mostly go through blocks
+ * that the previous descent just brought into the cache. Sindex keys embed the
+ * primary key, so only modifications of the same row can touch the same key;
+ * the stable sort keeps those in the order they happened. */
 void rdb_update_single_sindex(
         const btree_store_t<rdb_protocol_t>::sindex_access_t *sindex,
-        const rdb_modification_report_t *modification,
+        const rdb_modification_report_t *modifications,
+        size_t num_modifications,
         transaction_t *txn,
         auto_drainer_t::lock_t) {
-    // Note if you get this error it's likely that you've passed in a default
-    // constructed mod_report. Don't do that.  Mod reports should always be passed
-    // to a function as an output parameter before they're passed to this
-    // function.
-    guarantee(modification->primary_key.size() != 0);
-
     ql::map_wire_func_t mapping;
     sindex_multi_bool_t multi = sindex_multi_bool_t::MULTI;
     vector_read_stream_t read_stream(&sindex->sindex.opaque_definition);
@@ -1060,79 +1147,82 @@ void rdb_update_single_sindex(
     cond_t non_interruptor;
     ql::env_t env(&non_interruptor);
 
-    superblock_t *super_block = sindex->super_block.get();
-
-    if (modification->info.deleted.first) {
-        guarantee(!modification->info.deleted.second.empty());
-        try {
-            counted_t<const ql::datum_t> deleted = modification->info.deleted.first;
-
-            std::vector<store_key_t> keys;
-
-            compute_keys(modification->primary_key, deleted, &mapping, multi, &env, &keys);
-
-            for (auto it = keys.begin(); it != keys.end(); ++it) {
-                promise_t<superblock_t *> return_superblock_local;
-                {
-                    keyvalue_location_t<rdb_value_t> kv_location;
-
-                    find_keyvalue_location_for_write(txn, super_block,
-                                                     it->btree_key(),
-                                                     &kv_location,
-                                                     &sindex->btree->root_eviction_priority,
-                                                     &sindex->btree->stats,
-                                                     env.trace.get_or_null(),
-                                                     &return_superblock_local);
+    std::vector<sindex_update_t> updates;
+    for (size_t i = 0; i < num_modifications; ++i) {
+        const rdb_modification_report_t *modification = &modifications[i];
+        // Note if you get this error it's likely that you've passed in a default
+        // constructed mod_report. Don't do that.  Mod reports should always be passed
+        // to a function as an output parameter before they're passed to this
+        // function.
+        guarantee(modification->primary_key.size() != 0);
+
+        if (modification->info.deleted.first) {
+            guarantee(!modification->info.deleted.second.empty());
+            try {
+                std::vector<store_key_t> keys;
+                compute_keys(modification->primary_key, modification->info.deleted.first,
+                             &mapping, multi, &env, &keys);
+                for (auto it = keys.begin(); it != keys.end(); ++it) {
+                    sindex_update_t update;
+                    update.sindex_key = *it;
+                    update.value_ref = NULL;
+                    updates.push_back(update);
+                }
+            } catch (const ql::base_exc_t &) {
+                // Do nothing (it wasn't actually in the index).
+            }
+        }
 
-                    if (kv_location.value.has()) {
-                        kv_location_delete(&kv_location, *it,
-                            sindex->btree, repli_timestamp_t::distant_past, txn, NULL);
-                    }
-                    // The keyvalue location gets destroyed here.
+        if (modification->info.added.first) {
+            try {
+                std::vector<store_key_t> keys;
+                compute_keys(modification->primary_key, modification->info.added.first,
+                             &mapping, multi, &env, &keys);
+                for (auto it = keys.begin(); it != keys.end(); ++it) {
+                    sindex_update_t update;
+                    update.sindex_key = *it;
+                    update.value_ref = &modification->info.added.second;
+                    updates.push_back(update);
                 }
-                super_block = return_superblock_local.wait();
+            } catch (const ql::base_exc_t &) {
+                // Do nothing (we just drop the row from the index).
             }
-        } catch (const ql::base_exc_t &) {
-            // Do nothing (it wasn't actually in the index).
         }
     }
 
-    if (modification->info.added.first) {
-        try {
-            counted_t<const ql::datum_t> added = modification->info.added.first;
-
-            std::vector<store_key_t> keys;
+    std::stable_sort(updates.begin(), updates.end(), &sindex_update_less);
 
-            compute_keys(modification->primary_key, added, &mapping, multi, &env, &keys);
-
-            for (auto it = keys.begin(); it != keys.end(); ++it) {
-                promise_t<superblock_t *> return_superblock_local;
-                {
-                    keyvalue_location_t<rdb_value_t> kv_location;
-
-                    find_keyvalue_location_for_write(txn, super_block,
-                                                     it->btree_key(),
-                                                     &kv_location,
-                                                     &sindex->btree->root_eviction_priority,
-                                                     &sindex->btree->stats,
-                                                     env.trace.get_or_null(),
-                                                     &return_superblock_local);
-
-                    kv_location_set(&kv_location, *it,
-                                    modification->info.added.second, sindex->btree,
-                                    repli_timestamp_t::distant_past, txn);
-                    // The keyvalue location gets destroyed here.
-                }
-                super_block = return_superblock_local.wait();
+    superblock_t *super_block = sindex->super_block.get();
+    for (auto it = updates.begin(); it != updates.end(); ++it) {
+        promise_t<superblock_t *> return_superblock_local;
+        {
+            keyvalue_location_t<rdb_value_t> kv_location;
+
+            find_keyvalue_location_for_write(txn, super_block,
+                                             it->sindex_key.btree_key(),
+                                             &kv_location,
+                                             &sindex->btree->root_eviction_priority,
+                                             &sindex->btree->stats,
+                                             env.trace.get_or_null(),
+                                             &return_superblock_local);
+
+            if (it->value_ref != NULL) {
+                kv_location_set(&kv_location, it->sindex_key,
+                                *it->value_ref, sindex->btree,
+                                repli_timestamp_t::distant_past, txn);
+            } else if (kv_location.value.has()) {
+                kv_location_delete(&kv_location, it->sindex_key,
+                    sindex->btree, repli_timestamp_t::distant_past, txn, NULL);
             }
-        } catch (const ql::base_exc_t &) {
-            // Do nothing (we just drop the row from the index).
+            // The keyvalue location gets destroyed here.
         }
+        super_block = return_superblock_local.wait();
     }
 }
 
 void rdb_update_sindexes(const sindex_access_vector_t &sindexes,
-        const rdb_modification_report_t *modification,
+        const rdb_modification_report_t *modifications,
+        size_t num_modifications,
         transaction_t *txn) {
     {
         auto_drainer_t drainer;
@@ -1142,48 +1232,188 @@ void rdb_update_sindexes(const sindex_access_vector_t &sindexes,
                                                     ++it) {
             coro_t::spawn_sometime(boost::bind(
                         &rdb_update_single_sindex, &*it,
-                        modification, txn, auto_drainer_t::lock_t(&drainer)));
+                        modifications, num_modifications, txn,
+                        auto_drainer_t::lock_t(&drainer)));
         }
     }
 
     /* All of the sindex have been updated now it's time to actually clear the
-     * deleted blob if it exists. */
-    std::vector<char> ref_cpy(modification->info.deleted.second);
-    if (modification->info.deleted.first) {
-        ref_cpy.insert(ref_cpy.end(), blob::btree_maxreflen - ref_cpy.size(), 0);
-        guarantee(ref_cpy.size() == static_cast<size_t>(blob::btree_maxreflen));
-
-        rdb_value_deleter_t deleter;
-        deleter.delete_value(txn, ref_cpy.data());
+     * deleted blobs if they exist. */
+    for (size_t i = 0; i < num_modifications; ++i) {
+        const rdb_modification_report_t *modification = &modifications[i];
+        if (modification->info.deleted.first) {
+            std::vector<char> ref_cpy(modification->info.deleted.second);
+            ref_cpy.insert(ref_cpy.end(), blob::btree_maxreflen - ref_cpy.size(), 0);
+            guarantee(ref_cpy.size() == static_cast<size_t>(blob::btree_maxreflen));
+
+            rdb_value_deleter_t deleter;
+            deleter.delete_value(txn, ref_cpy.data());
+        }
+    }
+}
+
+void rdb_update_sindexes(const sindex_access_vector_t &sindexes,
+        const rdb_modification_report_t *modification,
+        transaction_t *txn) {
+    rdb_update_sindexes(sindexes, modification, 1, txn);
+}
+
+void rdb_update_sindexes(const sindex_access_vector_t &sindexes,
+        const std::vector<rdb_modification_report_t> &modifications,
+        transaction_t *txn) {
+    if (!modifications.empty()) {
+        rdb_update_sindexes(sindexes, modifications.data(), modifications.size(), txn);
     }
 }
 
 void rdb_erase_range_sindexes(const sindex_access_vector_t &sindexes,
         const rdb_erase_range_report_t *erase_range,
+        const key_range_t &store_key_range,
         transaction_t *txn, signal_t *interruptor) {
     auto_drainer_t drainer;
 
     spawn_sindex_erase_ranges(&sindexes, erase_range->range_to_erase,
-            txn, &drainer, auto_drainer_t::lock_t(&drainer),
+            store_key_range, txn, &drainer, auto_drainer_t::lock_t(&drainer),
             false, /* don't release the superblock */ interruptor);
 }
 
+/* A row of the primary btree, copied out of a leaf node so that the sindex
+ * functions can be evaluated without holding any sindex locks. */
+struct post_construct_row_t {
+    store_key_t primary_key;
+    counted_t<const ql::datum_t> doc;
+    std::vector<char> value_ref;
+};
+
+/* An entry of a sindex that is being post-constructed. `row` indexes the
+ * leaf's vector of `post_construct_row_t`. */
+struct post_construct_entry_t {
+    store_key_t sindex_key;
+    size_t row;
+};
+
+bool post_construct_entry_less(const post_construct_entry_t &a,
+                               const post_construct_entry_t &b) {
+    return a.sindex_key < b.sindex_key;
+}
+
+/* Evaluates one sindex function over a leaf's worth of rows. This doesn't
+ * touch the store, so it can run on any thread. The resulting entries are
+ * sorted by sindex key, so that the inserts walk the sindex tree in order. */
+void compute_post_construct_entries(
+        const secondary_index_t::opaque_definition_t &definition,
+        const std::vector<post_construct_row_t> &rows,
+        std::vector<post_construct_entry_t> *entries_out) {
+    ql::map_wire_func_t mapping;
+    sindex_multi_bool_t multi = sindex_multi_bool_t::MULTI;
+    vector_read_stream_t read_stream(&definition);
+    archive_result_t success = deserialize(&read_stream, &mapping);
+    guarantee_deserialization(success, "sindex deserialize");
+    success = deserialize(&read_stream, &multi);
+    guarantee_deserialization(success, "sindex deserialize");
+
+    // See `rdb_update_single_sindex` about the NULL environment.
+    cond_t non_interruptor;
+    ql::env_t env(&non_interruptor);
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+        std::vector<store_key_t> keys;
+        try {
+            compute_keys(rows[i].primary_key, rows[i].doc, &mapping, multi, &env, &keys);
+        } catch (const ql::base_exc_t &) {
+            // Do nothing (we just drop the row from the index).
+            continue;
+        }
+        for (auto it = keys.begin(); it != keys.end(); ++it) {
+            post_construct_entry_t entry;
+            entry.sindex_key = *it;
+            entry.row = i;
+            entries_out->push_back(entry);
+        }
+    }
+
+    std::sort(entries_out->begin(), entries_out->end(), &post_construct_entry_less);
+}
+
+void insert_post_construct_entries(
+        const btree_store_t<rdb_protocol_t>::sindex_access_t *sindex,
+        const std::vector<post_construct_row_t> *rows,
+        const std::vector<post_construct_entry_t> *entries,
+        transaction_t *txn,
+        auto_drainer_t::lock_t) {
+    superblock_t *super_block = sindex->super_block.get();
+    for (auto it = entries->begin(); it != entries->end(); ++it) {
+        promise_t<superblock_t *> return_superblock_local;
+        {
+            keyvalue_location_t<rdb_value_t> kv_location;
+
+            find_keyvalue_location_for_write(txn, super_block,
+                                             it->sindex_key.btree_key(),
+                                             &kv_location,
+                                             &sindex->btree->root_eviction_priority,
+                                             &sindex->btree->stats,
+                                             NULL,
+                                             &return_superblock_local);
+
+            kv_location_set(&kv_location, it->sindex_key,
+                            (*rows)[it->row].value_ref, sindex->btree,
+                            repli_timestamp_t::distant_past, txn);
+            // The keyvalue location gets destroyed here.
+        }
+        super_block = return_superblock_local.wait();
+        coro_t::yield();
+    }
+}
+
 class post_construct_traversal_helper_t : public btree_traversal_helper_t {
 public:
     post_construct_traversal_helper_t(
             btree_store_t<rdb_protocol_t> *store,
             const std::set<uuid_u> &sindexes_to_post_construct,
+            const std::map<uuid_u, secondary_index_t::opaque_definition_t> &definitions,
             cond_t *interrupt_myself,
             signal_t *interruptor
             )
         : store_(store),
           sindexes_to_post_construct_(sindexes_to_post_construct),
-          interrupt_myself_(interrupt_myself), interruptor_(interruptor)
+          definitions_(definitions),
+          interrupt_myself_(interrupt_myself), interruptor_(interruptor),
+          next_evaluation_thread_(0)
     { }
 
     void process_a_leaf(transaction_t *txn, buf_lock_t *leaf_node_buf,
                         const btree_key_t *, const btree_key_t *,
                         signal_t *, int *) THROWS_ONLY(interrupted_exc_t) {
+        /* Copy the rows out of the leaf node and compute the sindex entries
+         * before touching the sindexes. The traversal works on several leaves
+         * at once, and this way only the inserts themselves are serialized by
+         * the sindex locks, while the sindex functions of different leaves
+         * are evaluated concurrently on different threads. */
+        std::vector<post_construct_row_t> rows;
+        const leaf_node_t *leaf_node = static_cast<const leaf_node_t *>(leaf_node_buf->get_data_read());
+        const block_size_t block_size = txn->get_cache()->get_block_size();
+        for (auto it = leaf::begin(*leaf_node); it != leaf::end(*leaf_node); ++it) {
+            /* Grab relevant values from the leaf node. */
+            const btree_key_t *key = (*it).first;
+            const void *value = (*it).second;
+            guarantee(key);
+
+            const rdb_value_t *rdb_value = static_cast<const rdb_value_t *>(value);
+            rows.push_back(post_construct_row_t());
+            rows.back().primary_key = store_key_t(key);
+            rows.back().doc = get_data(rdb_value, txn);
+            rows.back().value_ref.assign(rdb_value->value_ref(),
+                rdb_value->value_ref() + rdb_value->inline_size(block_size));
+        }
+
+        std::map<uuid_u, std::vector<post_construct_entry_t> > entries;
+        {
+            on_thread_t th(threadnum_t(next_evaluation_thread_++ % get_num_db_threads()));
+            for (auto it = definitions_.begin(); it != definitions_.end(); ++it) {
+                compute_post_construct_entries(it->second, rows, &entries[it->first]);
+            }
+        }
+
         write_token_pair_t token_pair;
         store_->new_write_token_pair(&token_pair);
 
@@ -1249,24 +1479,16 @@ public:
             return;
         }
 
-        const leaf_node_t *leaf_node = static_cast<const leaf_node_t *>(leaf_node_buf->get_data_read());
-
-        for (auto it = leaf::begin(*leaf_node); it != leaf::end(*leaf_node); ++it) {
-            /* Grab relevant values from the leaf node. */
-            const btree_key_t *key = (*it).first;
-            const void *value = (*it).second;
-            guarantee(key);
-
-            store_key_t pk(key);
-            rdb_modification_report_t mod_report(pk);
-            const rdb_value_t *rdb_value = static_cast<const rdb_value_t *>(value);
-            block_size_t block_size = txn->get_cache()->get_block_size();
-            mod_report.info.added = std::make_pair(get_data(rdb_value, txn),
-                    std::vector<char>(rdb_value->value_ref(),
-                        rdb_value->value_ref() + rdb_value->inline_size(block_size)));
-
-            rdb_update_sindexes(sindexes, &mod_report, wtxn.get());
-            coro_t::yield();
+        auto_drainer_t drainer;
+        for (auto it = sindexes.begin(); it != sindexes.end(); ++it) {
+            // Every index we acquired already existed when post-construction
+            // started, so we know its definition.
+            auto entries_it = entries.find(it->sindex.id);
+            guarantee(entries_it != entries.end());
+            coro_t::spawn_sometime(boost::bind(
+                        &insert_post_construct_entries, &*it, &rows,
+                        &entries_it->second, wtxn.get(),
+                        auto_drainer_t::lock_t(&drainer)));
         }
     }
 
@@ -1284,8 +1506,10 @@ public:
 
     btree_store_t<rdb_protocol_t> *store_;
     const std::set<uuid_u> &sindexes_to_post_construct_;
+    const std::map<uuid_u, secondary_index_t::opaque_definition_t> &definitions_;
     cond_t *interrupt_myself_;
     signal_t *interruptor_;
+    int next_evaluation_thread_;
 };
 
 void post_construct_secondary_indexes(
@@ -1297,25 +1521,22 @@ void post_construct_secondary_indexes(
 
     wait_any_t wait_any(&local_interruptor, interruptor);
 
-    post_construct_traversal_helper_t helper(store,
-            sindexes_to_post_construct, &local_interruptor, interruptor);
     /* Notice the ordering of progress_tracker and insertion_sentries matters.
      * insertion_sentries puts pointers in the progress tracker map. Once
      * insertion_sentries is destructed nothing has a reference to
      * progress_tracker so we know it's safe to destruct it. */
     parallel_traversal_progress_t progress_tracker;
-    helper.progress = &progress_tracker;
 
     std::vector<map_insertion_sentry_t<uuid_u, const parallel_traversal_progress_t *> >
         insertion_sentries(sindexes_to_post_construct.size());
     auto sentry = insertion_sentries.begin();
     for (auto it = sindexes_to_post_construct.begin();
-         it != sindexes_to_post_construct.end(); ++it) {
+         it != sindexes_to_post_construct.end(); ++it, ++sentry) {
         store->add_progress_tracker(&*sentry, *it, &progress_tracker);
     }
 
-    object_buffer_t<fifo_enforcer_sink_t::exit_read_t> read_token;
-    store->new_read_token(&read_token);
+    read_token_pair_t token_pair;
+    store->new_read_token_pair(&token_pair);
 
     // Mind the destructor ordering.
     // The superblock must be released before txn (`btree_parallel_traversal`
@@ -1327,12 +1548,27 @@ void post_construct_secondary_indexes(
 
     store->acquire_superblock_for_read(
         rwi_read,
-        &read_token,
+        &token_pair.main_read_token,
         &txn,
         &superblock,
         interruptor,
         true /* USE_SNAPSHOT */);
 
+    /* The helper evaluates the sindex functions before it acquires the
+     * sindexes, so it needs their definitions up front. */
+    std::map<std::string, secondary_index_t> sindexes;
+    store->get_sindexes(&token_pair, txn.get(), superblock.get(), &sindexes, interruptor);
+    std::map<uuid_u, secondary_index_t::opaque_definition_t> definitions;
+    for (auto it = sindexes.begin(); it != sindexes.end(); ++it) {
+        if (std_contains(sindexes_to_post_construct, it->second.id)) {
+            definitions[it->second.id] = it->second.opaque_definition;
+        }
+    }
+
+    post_construct_traversal_helper_t helper(store,
+            sindexes_to_post_construct, definitions, &local_interruptor, interruptor);
+    helper.progress = &progress_tracker;
+
     txn->get_cache()->create_cache_account(SINDEX_POST_CONSTRUCTION_CACHE_PRIORITY, &cache_account);
     txn->set_account(cache_account.get());
 
@@ -224,7 +224,7 @@ void rdb_rget_secondary_slice(
     sindex_multi_bool_t sindex_multi,
     rget_read_response_t *response);
 
-void rdb_distribution_get(btree_slice_t *slice, int max_depth, const store_key_t &left_key,
+void rdb_distribution_get(btree_slice_t *slice, int max_depth, size_t min_sample_size, const store_key_t &left_key,
                           transaction_t *txn, superblock_t *superblock, distribution_read_response_t *response);
 
 /* Secondary Indexes */
@@ -267,17 +267,26 @@ typedef boost::variant<rdb_modification_report_t,
  * modify the secondary while they perform an operation. */
 class rdb_modification_report_cb_t {
 public:
+    /* `changefeed_server` may be NULL. */
     rdb_modification_report_cb_t(
-            btree_store_t<rdb_protocol_t> *store, write_token_pair_t *token_pair,
+            btree_store_t<rdb_protocol_t> *store,
+            ql::changefeed::server_t *changefeed_server,
+            write_token_pair_t *token_pair,
             transaction_t *txn, block_id_t sindex_block, auto_drainer_t::lock_t lock);
 
     void on_mod_report(const rdb_modification_report_t &mod_report);
 
+    /* Updates the sindexes for a whole batch of modifications at once, and
+    then passes the modifications on to the changefeeds. */
+    void on_mod_reports(const std::vector<rdb_modification_report_t> &mod_reports);
+
     ~rdb_modification_report_cb_t();
 private:
+    void acquire_sindexes();
 
     /* Fields initialized by the constructor. */
     btree_store_t<rdb_protocol_t> *store_;
+    ql::changefeed::server_t *changefeed_server_;
     write_token_pair_t *token_pair_;
     transaction_t *txn_;
     block_id_t sindex_block_id_;
@@ -293,9 +302,23 @@ void rdb_update_sindexes(
         const rdb_modification_report_t *modification,
         transaction_t *txn);
 
+/* Updates the sindexes for a batch of modifications, which must be given in
+the order they were applied. */
+void rdb_update_sindexes(
+        const btree_store_t<rdb_protocol_t>::sindex_access_vector_t &sindexes,
+        const rdb_modification_report_t *modifications,
+        size_t num_modifications,
+        transaction_t *txn);
+
+void rdb_update_sindexes(
+        const btree_store_t<rdb_protocol_t>::sindex_access_vector_t &sindexes,
+        const std::vector<rdb_modification_report_t> &modifications,
+        transaction_t *txn);
+
 void rdb_erase_range_sindexes(
         const btree_store_t<rdb_protocol_t>::sindex_access_vector_t &sindexes,
         const rdb_erase_range_report_t *erase_range,
+        const key_range_t &store_key_range,
         transaction_t *txn,
         signal_t *interruptor);
 
@@ -308,9 +331,11 @@ void post_construct_secondary_indexes(
 class rdb_value_deleter_t : public value_deleter_t {
 friend void rdb_update_sindexes(
         const btree_store_t<rdb_protocol_t>::sindex_access_vector_t &sindexes,
-        const rdb_modification_report_t *modification, transaction_t *txn);
+        const rdb_modification_report_t *modifications, size_t num_modifications,
+        transaction_t *txn);
 
     void delete_value(transaction_t *_txn, void *_value);
+    value_deleter_t *clone() const;
 };
 
 
@@ -0,0 +1,272 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "rdb_protocol/changefeed.hpp"
+
+#include "errors.hpp"
+#include <boost/bind.hpp>
+
+#include "arch/runtime/coroutines.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/wait_any.hpp"
+#include "config/args.hpp"
+#include "rdb_protocol/btree.hpp"
+
+namespace ql {
+namespace changefeed {
+
+counted_t<const datum_t> change_t::to_datum() const {
+    std::map<std::string, counted_t<const datum_t> > obj;
+    obj["old_val"] = old_val;
+    obj["new_val"] = new_val;
+    return make_counted<const datum_t>(std::move(obj));
+}
+
+/* Sending to a mailbox can block, and a message to a mailbox on the same node is
+delivered before `send()` returns.  So that writes never wait for the network,
+and so that the servers and feeds don't get called back in the middle of
+updating their state, they send their messages from separate coroutines. */
+template <class addr_t, class arg_t>
+void send_in_coro(mailbox_manager_t *manager, addr_t addr, arg_t arg,
+                  UNUSED auto_drainer_t::lock_t keepalive) {
+    send(manager, addr, arg);
+}
+
+counted_t<const datum_t> or_null(const counted_t<const datum_t> &d) {
+    return d.has() ? d : make_counted<const datum_t>(datum_t::R_NULL);
+}
+
+server_t::feed_info_t::feed_info_t(mailbox_manager_t *manager, const feed_addr_t &_addr)
+    : addr(_addr), next_seq(0), awaiting_ack(false),
+      disconnected(manager->get_connectivity_service(), addr.get_peer()) { }
+
+server_t::server_t(mailbox_manager_t *_manager)
+    : manager(_manager),
+      server_id(generate_uuid()),
+      ack_mailbox(manager, boost::bind(&server_t::on_ack, this, _1)),
+      stop_mailbox(manager, boost::bind(&server_t::on_stop, this, _1)) { }
+
+server_t::~server_t() {
+    assert_thread();
+    while (!feeds.empty()) {
+        stop_feed(feeds.begin(), "The table's primary replica went away "
+                  "(the table may have been resharded or its primary moved).");
+    }
+}
+
+void server_t::add_feed(uuid_u feed_id, const feed_addr_t &feed_addr) {
+    assert_thread();
+    feeds.insert(feed_id, new feed_info_t(manager, feed_addr));
+}
+
+server_addr_t server_t::get_addr() const {
+    server_addr_t addr;
+    addr.server_id = server_id;
+    addr.ack_addr = ack_mailbox.get_address();
+    addr.stop_addr = stop_mailbox.get_address();
+    return addr;
+}
+
+void server_t::on_mod_report(const rdb_modification_report_t &mod_report) {
+    assert_thread();
+    if (feeds.empty()) {
+        return;
+    }
+    const counted_t<const datum_t> &old_val = mod_report.info.deleted.first;
+    const counted_t<const datum_t> &new_val = mod_report.info.added.first;
+    if (old_val.has() == new_val.has() && (!old_val.has() || *old_val == *new_val)) {
+        // Nothing changed.
+        return;
+    }
+
+    change_t change(or_null(old_val), or_null(new_val));
+    for (auto it = feeds.begin(); it != feeds.end();) {
+        feed_info_t *feed = it->second;
+        if (feed->disconnected.is_pulsed()) {
+            feeds.erase(it++);
+        } else if (feed->queue.size() >= CHANGEFEED_MAX_QUEUED) {
+            stop_feed(it++, "Changefeed fell too far behind the table's writes.");
+        } else {
+            feed->queue.push_back(change);
+            if (!feed->awaiting_ack) {
+                send_batch(feed);
+            }
+            ++it;
+        }
+    }
+}
+
+void server_t::send_batch(feed_info_t *feed) {
+    rassert(!feed->awaiting_ack);
+    rassert(!feed->queue.empty());
+    msg_t msg;
+    msg.server = get_addr();
+    msg.seq = feed->next_seq++;
+    while (!feed->queue.empty() && msg.changes.size() < CHANGEFEED_MAX_BATCH) {
+        msg.changes.push_back(feed->queue.front());
+        feed->queue.pop_front();
+    }
+    feed->awaiting_ack = true;
+    coro_t::spawn_sometime(boost::bind(&send_in_coro<feed_addr_t, msg_t>,
+                                       manager, feed->addr, msg,
+                                       auto_drainer_t::lock_t(&drainer)));
+}
+
+void server_t::stop_feed(feed_map_t::iterator it, const std::string &reason) {
+    msg_t msg;
+    msg.server = get_addr();
+    msg.seq = it->second->next_seq++;
+    msg.stop = true;
+    msg.stop_reason = reason;
+    coro_t::spawn_sometime(boost::bind(&send_in_coro<feed_addr_t, msg_t>,
+                                       manager, it->second->addr, msg,
+                                       auto_drainer_t::lock_t(&drainer)));
+    feeds.erase(it);
+}
+
+void server_t::on_ack(uuid_u feed_id) {
+    assert_thread();
+    auto it = feeds.find(feed_id);
+    if (it == feeds.end()) {
+        return;
+    }
+    feed_info_t *feed = it->second;
+    feed->awaiting_ack = false;
+    if (!feed->queue.empty()) {
+        send_batch(feed);
+    }
+}
+
+void server_t::on_stop(uuid_u feed_id) {
+    assert_thread();
+    auto it = feeds.find(feed_id);
+    if (it != feeds.end()) {
+        feeds.erase(it);
+    }
+}
+
+feed_t::server_info_t::server_info_t(mailbox_manager_t *manager,
+                                     const server_addr_t &_addr)
+    : addr(_addr), next_seq(0), ack_pending(false), stopped(false),
+      disconnected(manager->get_connectivity_service(), addr.ack_addr.get_peer()) { }
+
+feed_t::feed_t(mailbox_manager_t *_manager)
+    : manager(_manager),
+      feed_id(generate_uuid()),
+      stopped(false),
+      wakeup(NULL),
+      mailbox(manager, boost::bind(&feed_t::on_msg, this, _1)) { }
+
+feed_t::~feed_t() {
+    assert_thread();
+    for (auto it = servers.begin(); it != servers.end(); ++it) {
+        if (!it->second->stopped) {
+            coro_t::spawn_sometime(boost::bind(
+                &send_in_coro<server_addr_t::stop_mailbox_t::address_t, uuid_u>,
+                manager, it->second->addr.stop_addr, feed_id,
+                auto_drainer_t::lock_t(&drainer)));
+        }
+    }
+}
+
+void feed_t::add_servers(const std::vector<server_addr_t> &new_servers) {
+    assert_thread();
+    for (auto it = new_servers.begin(); it != new_servers.end(); ++it) {
+        get_server(*it);
+    }
+}
+
+feed_t::server_info_t *feed_t::get_server(const server_addr_t &addr) {
+    auto it = servers.find(addr.server_id);
+    if (it == servers.end()) {
+        uuid_u server_id = addr.server_id;
+        it = servers.insert(server_id, new server_info_t(manager, addr)).first;
+    }
+    return it->second;
+}
+
+bool feed_t::wait_for_changes(signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+    assert_thread();
+    while (buffer.empty() && !stopped) {
+        cond_t got_changes;
+        wait_any_t waiter(&got_changes);
+        for (auto it = servers.begin(); it != servers.end(); ++it) {
+            if (it->second->disconnected.is_pulsed()) {
+                stop("Lost contact with the table's primary replica.");
+                return false;
+            }
+            waiter.add(&it->second->disconnected);
+        }
+        assignment_sentry_t<cond_t *> set_wakeup(&wakeup, &got_changes);
+        wait_interruptible(&waiter, interruptor);
+    }
+    return !buffer.empty();
+}
+
+change_t feed_t::pop_change() {
+    assert_thread();
+    guarantee(!buffer.empty());
+    change_t change = buffer.front();
+    buffer.pop_front();
+    maybe_send_acks();
+    return change;
+}
+
+void feed_t::on_msg(const msg_t &msg) {
+    assert_thread();
+    server_info_t *server = get_server(msg.server);
+    if (msg.seq != server->next_seq) {
+        server->held.insert(std::make_pair(msg.seq, msg));
+        return;
+    }
+    handle_msg(server, msg);
+    for (auto it = server->held.find(server->next_seq);
+         it != server->held.end();
+         it = server->held.find(server->next_seq)) {
+        msg_t next = it->second;
+        server->held.erase(it);
+        handle_msg(server, next);
+    }
+    if (wakeup != NULL) {
+        wakeup->pulse_if_not_already_pulsed();
+    }
+}
+
+void feed_t::handle_msg(server_info_t *server, const msg_t &msg) {
+    ++server->next_seq;
+    if (msg.stop) {
+        server->stopped = true;
+        stop(msg.stop_reason);
+        return;
+    }
+    if (stopped) {
+        return;
+    }
+    buffer.insert(buffer.end(), msg.changes.begin(), msg.changes.end());
+    server->ack_pending = true;
+    maybe_send_acks();
+}
+
+void feed_t::stop(const std::string &reason) {
+    if (!stopped) {
+        stopped = true;
+        stop_reason_ = reason;
+    }
+}
+
+void feed_t::maybe_send_acks() {
+    if (stopped || buffer.size() >= CHANGEFEED_MAX_BUFFERED) {
+        return;
+    }
+    for (auto it = servers.begin(); it != servers.end(); ++it) {
+        server_info_t *server = it->second;
+        if (server->ack_pending) {
+            server->ack_pending = false;
+            coro_t::spawn_sometime(boost::bind(
+                &send_in_coro<server_addr_t::ack_mailbox_t::address_t, uuid_u>,
+                manager, server->addr.ack_addr, feed_id,
+                auto_drainer_t::lock_t(&drainer)));
+        }
+    }
+}
+
+}  // namespace changefeed
+}  // namespace ql
@@ -0,0 +1,194 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_CHANGEFEED_HPP_
+#define RDB_PROTOCOL_CHANGEFEED_HPP_
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "errors.hpp"
+#include <boost/ptr_container/ptr_map.hpp>
+
+#include "concurrency/auto_drainer.hpp"
+#include "concurrency/signal.hpp"
+#include "containers/uuid.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rpc/connectivity/connectivity.hpp"
+#include "rpc/mailbox/typed.hpp"
+#include "rpc/serialize_macros.hpp"
+
+class cond_t;
+struct rdb_modification_report_t;
+
+/* Changefeeds stream the modifications made to a table to a query, so that the
+query doesn't have to scan the table again to find out what changed.
+
+A `server_t` lives next to each shard's store.  When a query subscribes to a
+table's changes, a `feed_t` is created on the query's thread and the
+subscription is sent to the primary of every shard as a read.  From then on,
+each shard sends the modifications it applies to the feed's mailbox, in batches.
+A shard sends the next batch only once the feed has acknowledged the last one,
+and the feed only acknowledges batches while the query keeps consuming them, so
+a slow query doesn't make the shards or the network buffer without bound.
+Writes are never held up for a feed: a shard that has queued too many changes
+for a feed stops it with an error instead. */
+
+namespace ql {
+namespace changefeed {
+
+/* One modified row.  A row that was inserted has a `null` old value, and a row
+that was deleted has a `null` new value. */
+struct change_t {
+    change_t() { }
+    change_t(counted_t<const datum_t> _old_val, counted_t<const datum_t> _new_val)
+        : old_val(_old_val), new_val(_new_val) { }
+
+    // Returns the change as `{old_val: ..., new_val: ...}`.
+    counted_t<const datum_t> to_datum() const;
+
+    counted_t<const datum_t> old_val;
+    counted_t<const datum_t> new_val;
+
+    RDB_MAKE_ME_SERIALIZABLE_2(old_val, new_val);
+};
+
+/* How a feed reaches a server.  Both mailboxes take the feed's id. */
+struct server_addr_t {
+    typedef mailbox_t<void(uuid_u)> ack_mailbox_t;
+    typedef mailbox_t<void(uuid_u)> stop_mailbox_t;
+
+    uuid_u server_id;
+    ack_mailbox_t::address_t ack_addr;
+    stop_mailbox_t::address_t stop_addr;
+
+    RDB_MAKE_ME_SERIALIZABLE_3(server_id, ack_addr, stop_addr);
+};
+
+/* What a server sends to a feed.  Mailbox messages can overtake each other, so
+the feed puts the messages from each server back in order by `seq`.  The last
+message a server sends to a feed has `stop` set. */
+struct msg_t {
+    msg_t() : seq(0), stop(false) { }
+
+    server_addr_t server;
+    uint64_t seq;
+    std::vector<change_t> changes;
+    bool stop;
+    std::string stop_reason;
+
+    RDB_MAKE_ME_SERIALIZABLE_5(server, seq, changes, stop, stop_reason);
+};
+
+typedef mailbox_t<void(msg_t)> feed_mailbox_t;
+typedef feed_mailbox_t::address_t feed_addr_t;
+
+/* Sends the modifications made to one shard's store to the feeds subscribed to
+it.  All of its methods must be called on the store's thread, and none of them
+block. */
+class server_t : public home_thread_mixin_t {
+public:
+    explicit server_t(mailbox_manager_t *manager);
+    // Stops all of the feeds that are still subscribed.
+    ~server_t();
+
+    void add_feed(uuid_u feed_id, const feed_addr_t &feed_addr);
+    server_addr_t get_addr() const;
+
+    void on_mod_report(const rdb_modification_report_t &mod_report);
+
+private:
+    struct feed_info_t {
+        feed_info_t(mailbox_manager_t *manager, const feed_addr_t &_addr);
+
+        feed_addr_t addr;
+        uint64_t next_seq;
+        std::deque<change_t> queue;
+        // True while a batch is on its way and hasn't been acknowledged yet.
+        bool awaiting_ack;
+        disconnect_watcher_t disconnected;
+    };
+    typedef boost::ptr_map<uuid_u, feed_info_t> feed_map_t;
+
+    void send_batch(feed_info_t *feed);
+    void stop_feed(feed_map_t::iterator it, const std::string &reason);
+    void on_ack(uuid_u feed_id);
+    void on_stop(uuid_u feed_id);
+
+    mailbox_manager_t *manager;
+    const uuid_u server_id;
+    feed_map_t feeds;
+
+    // For the coroutines that send the messages.  The mailboxes are destroyed
+    // first, so that their callbacks don't take locks while this drains.
+    auto_drainer_t drainer;
+
+    server_addr_t::ack_mailbox_t ack_mailbox;
+    server_addr_t::stop_mailbox_t stop_mailbox;
+
+    DISABLE_COPYING(server_t);
+};
+
+/* The query's end of a changefeed.  It must be used on the thread it was
+created on.  Destroying it unsubscribes from all of the servers. */
+class feed_t : public home_thread_mixin_t {
+public:
+    explicit feed_t(mailbox_manager_t *manager);
+    ~feed_t();
+
+    uuid_u get_id() const { return feed_id; }
+    feed_addr_t get_addr() const { return mailbox.get_address(); }
+
+    // Call this with the servers that answered the subscription.
+    void add_servers(const std::vector<server_addr_t> &servers);
+
+    /* Blocks until there are changes to pop.  Returns false once the feed has
+    stopped and all of the changes it got before have been popped, in which
+    case `stop_reason()` says why. */
+    bool wait_for_changes(signal_t *interruptor) THROWS_ONLY(interrupted_exc_t);
+    bool has_changes() const { return !buffer.empty(); }
+    change_t pop_change();
+    const std::string &stop_reason() const { return stop_reason_; }
+
+private:
+    struct server_info_t {
+        server_info_t(mailbox_manager_t *manager, const server_addr_t &_addr);
+
+        server_addr_t addr;
+        uint64_t next_seq;
+        // Messages that overtook an earlier one.
+        std::map<uint64_t, msg_t> held;
+        // True if a batch has been received but not acknowledged yet.
+        bool ack_pending;
+        bool stopped;
+        disconnect_watcher_t disconnected;
+    };
+    typedef boost::ptr_map<uuid_u, server_info_t> server_map_t;
+
+    server_info_t *get_server(const server_addr_t &addr);
+    void on_msg(const msg_t &msg);
+    void handle_msg(server_info_t *server, const msg_t &msg);
+    void stop(const std::string &reason);
+    void maybe_send_acks();
+
+    mailbox_manager_t *manager;
+    const uuid_u feed_id;
+    server_map_t servers;
+    std::deque<change_t> buffer;
+    bool stopped;
+    std::string stop_reason_;
+    // Pulsed when there are new changes, while `wait_for_changes()` waits.
+    cond_t *wakeup;
+
+    // For the coroutines that send the acknowledgements.
+    auto_drainer_t drainer;
+
+    feed_mailbox_t mailbox;
+
+    DISABLE_COPYING(feed_t);
+};
+
+}  // namespace changefeed
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_CHANGEFEED_HPP_
@@ -514,6 +514,99 @@ boost::optional<uint64_t> datum_t::extract_tag(const std::string &secondary) {
     return components.tag_num;
 }
 
+// Parses a value written by one of the `*_to_str_key` functions, starting at
+// `*pos`.  Inside an array, a value ends at the null character that follows it;
+// at the top level it ends with the string.  Returns an empty pointer if the
+// key doesn't hold everything needed to rebuild the value.
+counted_t<const datum_t> parse_str_key(const std::string &str, bool in_array,
+                                       size_t *pos) {
+    if (*pos >= str.size()) {
+        return counted_t<const datum_t>();
+    }
+    const char type = str[*pos];
+    ++*pos;
+    const size_t end = in_array ? str.find('\0', *pos) : str.size();
+    if (end == std::string::npos) {
+        return counted_t<const datum_t>();
+    }
+
+    switch (type) {
+    case 'N': {
+        // See `num_to_str_key`; the hex digits hold the mangled bits.
+        static const size_t hex_digits = sizeof(double) * 2;
+        if (end - *pos < hex_digits) {
+            return counted_t<const datum_t>();
+        }
+        uint64_t u = 0;
+        for (size_t i = 0; i < hex_digits; ++i) {
+            const char c = str[*pos + i];
+            int digit;
+            if (c >= '0' && c <= '9') {
+                digit = c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                digit = c - 'a' + 10;
+            } else {
+                return counted_t<const datum_t>();
+            }
+            u = (u << 4) | digit;
+        }
+        if (u & (1ULL << 63)) {
+            u ^= (1ULL << 63);
+        } else {
+            u = ~u;
+        }
+        double d;
+        memcpy(&d, &u, sizeof(d));
+        *pos = end;
+        return make_counted<const datum_t>(d);
+    }
+    case 'S': {
+        std::string s = str.substr(*pos, end - *pos);
+        *pos = end;
+        return make_counted<const datum_t>(std::move(s));
+    }
+    case 'B': {
+        if (end - *pos != 1 || (str[*pos] != 't' && str[*pos] != 'f')) {
+            return counted_t<const datum_t>();
+        }
+        const bool b = str[*pos] == 't';
+        *pos = end;
+        return make_counted<const datum_t>(datum_t::R_BOOL, b);
+    }
+    case 'A': {
+        // An array ends at the end of the key, or at a null character where
+        // its next element would start (which is the separator that follows
+        // the array in the enclosing array).
+        std::vector<counted_t<const datum_t> > items;
+        while (*pos < str.size() && str[*pos] != '\0') {
+            counted_t<const datum_t> item = parse_str_key(str, true, pos);
+            if (!item.has() || *pos >= str.size()) {
+                return counted_t<const datum_t>();
+            }
+            // Skip the null character after the element.
+            ++*pos;
+            items.push_back(item);
+        }
+        return make_counted<const datum_t>(std::move(items));
+    }
+    default:
+        // Pseudotypes (e.g. times don't keep their timezone in the key).
+        return counted_t<const datum_t>();
+    }
+}
+
+counted_t<const datum_t> datum_t::extract_secondary_datum(
+        const std::string &secondary_and_primary) {
+    components_t components;
+    parse_secondary(secondary_and_primary, &components);
+    size_t pos = 0;
+    counted_t<const datum_t> res = parse_str_key(components.secondary, false, &pos);
+    if (pos != components.secondary.size()) {
+        return counted_t<const datum_t>();
+    }
+    return res;
+}
+
 // This function returns a store_key_t suitable for searching by a
 // secondary-index.  This is needed because secondary indexes may be truncated,
 // but the amount truncated depends on the length of the primary key.  Since we
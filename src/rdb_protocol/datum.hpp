@@ -100,6 +100,11 @@ public:
     static std::string extract_secondary(const std::string &secondary_and_primary);
     static boost::optional<uint64_t> extract_tag(
         const std::string &secondary_and_primary);
+    /* An inverse to print_secondary for keys that weren't truncated. Returns the
+       secondary value, or an empty pointer for pseudotypes, whose keys don't
+       hold all of their fields. */
+    static counted_t<const datum_t> extract_secondary_datum(
+        const std::string &secondary_and_primary);
     store_key_t truncated_secondary() const;
     void check_type(type_t desired, const char *msg = NULL) const;
     void type_error(const std::string &msg) const NORETURN;
@@ -49,6 +49,22 @@ void rdb_namespace_interface_t::read_outdated(
     splitter.give_splits(response->n_shards, response->event_log);
 }
 
+void rdb_namespace_interface_t::read_outdated_bounded(
+        const rdb_protocol_t::read_t &read,
+        rdb_protocol_t::read_response_t *response,
+        int64_t max_staleness_ms,
+        signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t) {
+    profile::starter_t starter("Perform outdated read.", env_->trace);
+    profile::splitter_t splitter(env_->trace);
+    /* propagate whether or not we're doing profiles */
+    r_sanity_check(read.profile == env_->profile());
+    /* Do the actual read. */
+    internal_->read_outdated_bounded(read, response, max_staleness_ms, interruptor);
+    /* Append the results of the profile to the current task */
+    splitter.give_splits(response->n_shards, response->event_log);
+}
+
 void rdb_namespace_interface_t::write(
         rdb_protocol_t::write_t *write,
         rdb_protocol_t::write_response_t *response,
@@ -94,9 +110,11 @@ const char *const empty_stream_msg =
 reader_t::reader_t(
     const rdb_namespace_access_t &_ns_access,
     bool _use_outdated,
+    boost::optional<int64_t> _max_staleness_ms,
     scoped_ptr_t<readgen_t> &&_readgen)
     : ns_access(_ns_access),
       use_outdated(_use_outdated),
+      max_staleness_ms(_max_staleness_ms),
       started(false), finished(false),
       readgen(std::move(_readgen)),
       active_range(readgen->original_keyrange()) { }
@@ -119,7 +137,10 @@ reader_t::run_terminal(env_t *env, terminal_variant_t &&tv) {
 rget_read_response_t reader_t::do_read(env_t *env, const read_t &read) {
     read_response_t res;
     try {
-        if (use_outdated) {
+        if (use_outdated && max_staleness_ms) {
+            ns_access.get_namespace_if().read_outdated_bounded(
+                read, &res, *max_staleness_ms, env->interruptor);
+        } else if (use_outdated) {
             ns_access.get_namespace_if().read_outdated(read, &res, env->interruptor);
         } else {
             ns_access.get_namespace_if().read(
@@ -627,11 +648,12 @@ counted_t<const datum_t> eager_datum_stream_t::as_array(env_t *env) {
 lazy_datum_stream_t::lazy_datum_stream_t(
     rdb_namespace_access_t *ns_access,
     bool use_outdated,
+    boost::optional<int64_t> max_staleness_ms,
     scoped_ptr_t<readgen_t> &&readgen,
     const protob_t<const Backtrace> &bt_src)
     : datum_stream_t(bt_src),
       current_batch_offset(0),
-      reader(*ns_access, use_outdated, std::move(readgen)) { }
+      reader(*ns_access, use_outdated, max_staleness_ms, std::move(readgen)) { }
 
 counted_t<datum_stream_t> lazy_datum_stream_t::map(counted_t<func_t> f) {
     reader.add_transformation(map_wire_func_t(f));
@@ -756,6 +778,38 @@ bool array_datum_stream_t::is_array() {
     return true;
 }
 
+// CHANGEFEED_DATUM_STREAM_T
+changefeed_datum_stream_t::changefeed_datum_stream_t(
+    scoped_ptr_t<changefeed::feed_t> &&_feed,
+    const protob_t<const Backtrace> &bt_source)
+    : eager_datum_stream_t(bt_source), feed(std::move(_feed)) { }
+
+bool changefeed_datum_stream_t::is_exhausted() const {
+    return false;
+}
+
+bool changefeed_datum_stream_t::is_array() {
+    return false;
+}
+
+std::vector<counted_t<const datum_t> >
+changefeed_datum_stream_t::next_batch_impl(env_t *env, const batchspec_t &batchspec) {
+    rcheck(feed->wait_for_changes(env->interruptor), base_exc_t::GENERIC,
+           strprintf("Changefeed stopped: %s", feed->stop_reason().c_str()));
+
+    std::vector<counted_t<const datum_t> > v;
+    batcher_t batcher = batchspec.to_batcher();
+    while (feed->has_changes()) {
+        counted_t<const datum_t> d = feed->pop_change().to_datum();
+        batcher.note_el(d);
+        v.push_back(std::move(d));
+        if (batcher.should_send_batch()) {
+            break;
+        }
+    }
+    return v;
+}
+
 // INDEXED_SORT_DATUM_STREAM_T
 indexed_sort_datum_stream_t::indexed_sort_datum_stream_t(
     counted_t<datum_stream_t> stream,
@@ -48,6 +48,11 @@ public:
                        rdb_protocol_t::read_response_t *response,
                        signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t);
+    void read_outdated_bounded(const rdb_protocol_t::read_t &,
+                               rdb_protocol_t::read_response_t *response,
+                               int64_t max_staleness_ms,
+                               signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t);
     void write(rdb_protocol_t::write_t *,
                rdb_protocol_t::write_response_t *response,
                order_token_t tok,
@@ -338,6 +343,7 @@ public:
     explicit reader_t(
         const rdb_namespace_access_t &ns_access,
         bool use_outdated,
+        boost::optional<int64_t> max_staleness_ms,
         scoped_ptr_t<readgen_t> &&readgen);
     void add_transformation(transform_variant_t &&tv);
     rget_read_response_t::result_t run_terminal(env_t *env, terminal_variant_t &&tv);
@@ -352,6 +358,8 @@ private:
 
     rdb_namespace_access_t ns_access;
     const bool use_outdated;
+    // How far behind the primary outdated reads may be, if there's a bound.
+    const boost::optional<int64_t> max_staleness_ms;
     transform_t transform;
 
     bool started, finished;
@@ -368,6 +376,7 @@ public:
     lazy_datum_stream_t(
         rdb_namespace_access_t *_ns_access,
         bool _use_outdated,
+        boost::optional<int64_t> _max_staleness_ms,
         scoped_ptr_t<readgen_t> &&_readgen,
         const protob_t<const Backtrace> &bt_src);
     virtual counted_t<datum_stream_t> filter(counted_t<func_t> f,
@@ -422,6 +431,23 @@ private:
     counted_t<const datum_t> arr;
 };
 
+// The changes made to a table, as `{old_val: ..., new_val: ...}` objects.  It
+// never ends on its own: it blocks until there are changes, and fails if the
+// changefeed stops.
+class changefeed_datum_stream_t : public eager_datum_stream_t {
+public:
+    changefeed_datum_stream_t(scoped_ptr_t<changefeed::feed_t> &&_feed,
+                              const protob_t<const Backtrace> &bt_src);
+    virtual bool is_exhausted() const;
+
+private:
+    virtual bool is_array();
+    virtual std::vector<counted_t<const datum_t> >
+    next_batch_impl(env_t *env, const batchspec_t &batchspec);
+
+    scoped_ptr_t<changefeed::feed_t> feed;
+};
+
 class slice_datum_stream_t : public wrapper_datum_stream_t {
 public:
     slice_datum_stream_t(uint64_t left, uint64_t right, counted_t<datum_stream_t> src);
@@ -115,12 +115,14 @@ cluster_access_t::cluster_access_t(
         boost::shared_ptr<semilattice_readwrite_view_t<cluster_semilattice_metadata_t> >
             _semilattice_metadata,
         directory_read_manager_t<cluster_directory_metadata_t> *_directory_read_manager,
+        mailbox_manager_t *_mailbox_manager,
         uuid_u _this_machine)
     : ns_repo(_ns_repo),
       namespaces_semilattice_metadata(_namespaces_semilattice_metadata),
       databases_semilattice_metadata(_databases_semilattice_metadata),
       semilattice_metadata(_semilattice_metadata),
       directory_read_manager(_directory_read_manager),
+      mailbox_manager(_mailbox_manager),
       this_machine(_this_machine) { }
 
 void cluster_access_t::join_and_wait_to_propagate(
@@ -173,6 +175,7 @@ env_t::env_t(
     boost::shared_ptr<semilattice_readwrite_view_t<cluster_semilattice_metadata_t> >
     _semilattice_metadata,
     directory_read_manager_t<cluster_directory_metadata_t> *_directory_read_manager,
+    mailbox_manager_t *_mailbox_manager,
     signal_t *_interruptor,
     uuid_u _this_machine,
     protob_t<Query> query)
@@ -183,6 +186,7 @@ env_t::env_t(
                    _databases_semilattice_metadata,
                    _semilattice_metadata,
                    _directory_read_manager,
+                   _mailbox_manager,
                    _this_machine),
     interruptor(_interruptor),
     eval_callback(NULL)
@@ -208,6 +212,7 @@ env_t::env_t(
     boost::shared_ptr<semilattice_readwrite_view_t<cluster_semilattice_metadata_t> >
         _semilattice_metadata,
     directory_read_manager_t<cluster_directory_metadata_t> *_directory_read_manager,
+    mailbox_manager_t *_mailbox_manager,
     signal_t *_interruptor,
     uuid_u _this_machine,
     profile_bool_t _profile)
@@ -218,6 +223,7 @@ env_t::env_t(
                    _databases_semilattice_metadata,
                    _semilattice_metadata,
                    _directory_read_manager,
+                   _mailbox_manager,
                    _this_machine),
     interruptor(_interruptor),
     eval_callback(NULL)
@@ -235,6 +241,7 @@ env_t::env_t(signal_t *_interruptor)
                    boost::shared_ptr<
                        semilattice_readwrite_view_t<cluster_semilattice_metadata_t> >(),
                    NULL,
+                   NULL,
                    uuid_u()),
     interruptor(_interruptor),
     eval_callback(NULL)
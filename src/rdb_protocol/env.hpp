@@ -55,6 +55,7 @@ public:
         boost::shared_ptr<semilattice_readwrite_view_t<cluster_semilattice_metadata_t> >
             _semilattice_metadata,
         directory_read_manager_t<cluster_directory_metadata_t> *_directory_read_manager,
+        mailbox_manager_t *_mailbox_manager,
         uuid_u _this_machine);
 
     base_namespace_repo_t<rdb_protocol_t> *ns_repo;
@@ -68,6 +69,8 @@ public:
     boost::shared_ptr<semilattice_readwrite_view_t<cluster_semilattice_metadata_t> >
         semilattice_metadata;
     directory_read_manager_t<cluster_directory_metadata_t> *directory_read_manager;
+    // Used for changefeeds.  May be NULL.
+    mailbox_manager_t *mailbox_manager;
 
     // Semilattice modification functions
     void join_and_wait_to_propagate(
@@ -96,6 +99,7 @@ public:
         boost::shared_ptr<semilattice_readwrite_view_t<cluster_semilattice_metadata_t> >
             _semilattice_metadata,
         directory_read_manager_t<cluster_directory_metadata_t> *_directory_read_manager,
+        mailbox_manager_t *_mailbox_manager,
         signal_t *_interruptor,
         uuid_u _this_machine,
         protob_t<Query> query);
@@ -112,6 +116,7 @@ public:
         boost::shared_ptr<semilattice_readwrite_view_t<cluster_semilattice_metadata_t> >
             _semilattice_metadata,
         directory_read_manager_t<cluster_directory_metadata_t> *_directory_read_manager,
+        mailbox_manager_t *_mailbox_manager,
         signal_t *_interruptor,
         uuid_u _this_machine,
         profile_bool_t _profile);
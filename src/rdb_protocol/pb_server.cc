@@ -3,12 +3,16 @@
 
 #include "concurrency/cross_thread_watchable.hpp"
 #include "concurrency/watchable.hpp"
+#include "perfmon/perfmon.hpp"
 #include "rdb_protocol/counted_term.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/profile.hpp"
 #include "rdb_protocol/stream_cache.hpp"
 #include "rpc/semilattice/view/field.hpp"
 
+static perfmon_histogram_t pm_query_latency(secs_to_ticks(1));
+static perfmon_membership_t pm_query_latency_membership(&get_global_perfmon_collection(), &pm_query_latency, "query_latency");
+
 Response on_unparsable_query2(ql::protob_t<Query> q, std::string msg) {
     Response res;
     res.set_token((q.has() && q->has_token()) ? q->token() : -1);
@@ -52,6 +56,7 @@ bool query2_server_t::handle(ql::protob_t<Query> q,
     signal_t *interruptor = query2_context->interruptor;
     guarantee(interruptor);
     response_out->set_token(q->token());
+    ticks_t start_time = get_ticks();
 
     counted_t<const ql::datum_t> noreply = static_optarg("noreply", q);
     bool response_needed = !(noreply.has() &&
@@ -73,6 +78,7 @@ bool query2_server_t::handle(ql::protob_t<Query> q,
                        strprintf("Unexpected exception: %s\n", e.what()));
     }
 
+    pm_query_latency.record(ticks_to_secs(get_ticks() - start_time));
     return response_needed;
 }
 
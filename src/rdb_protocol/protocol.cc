@@ -8,6 +8,7 @@
 
 #include "arch/io/disk.hpp"
 #include "btree/erase_range.hpp"
+#include "btree/get_distribution.hpp"
 #include "btree/parallel_traversal.hpp"
 #include "btree/slice.hpp"
 #include "btree/superblock.hpp"
@@ -57,6 +58,9 @@ typedef rdb_protocol_t::sindex_list_response_t sindex_list_response_t;
 typedef rdb_protocol_t::sindex_status_t sindex_status_t;
 typedef rdb_protocol_t::sindex_status_response_t sindex_status_response_t;
 
+typedef rdb_protocol_t::changefeed_subscribe_t changefeed_subscribe_t;
+typedef rdb_protocol_t::changefeed_subscribe_response_t changefeed_subscribe_response_t;
+
 typedef rdb_protocol_t::write_t write_t;
 typedef rdb_protocol_t::write_response_t write_response_t;
 
@@ -213,19 +217,23 @@ void bring_sindexes_up_to_date(
 class apply_sindex_change_visitor_t : public boost::static_visitor<> {
 public:
     apply_sindex_change_visitor_t(const sindex_access_vector_t *sindexes,
+            const key_range_t &store_key_range,
             transaction_t *txn,
             signal_t *interruptor)
-        : sindexes_(sindexes), txn_(txn), interruptor_(interruptor) { }
+        : sindexes_(sindexes), store_key_range_(store_key_range), txn_(txn),
+          interruptor_(interruptor) { }
     void operator()(const rdb_modification_report_t &mod_report) const {
         rdb_update_sindexes(*sindexes_, &mod_report, txn_);
     }
 
     void operator()(const rdb_erase_range_report_t &erase_range_report) const {
-        rdb_erase_range_sindexes(*sindexes_, &erase_range_report, txn_, interruptor_);
+        rdb_erase_range_sindexes(*sindexes_, &erase_range_report, store_key_range_,
+                                 txn_, interruptor_);
     }
 
 private:
     const sindex_access_vector_t *sindexes_;
+    key_range_t store_key_range_;
     transaction_t *txn_;
     signal_t *interruptor_;
 };
@@ -307,6 +315,7 @@ void post_construct_and_drain_queue(
                 deserializing_viewer_t<rdb_sindex_change_t> viewer(&sindex_change);
                 mod_queue->pop(&viewer);
                 boost::apply_visitor(apply_sindex_change_visitor_t(&sindexes,
+                                                                   store->get_region().inner,
                                                                    queue_txn.get(),
                                                                    lock.get_drain_signal()),
                                      sindex_change);
@@ -383,6 +392,12 @@ bool range_key_tester_t::key_should_be_erased(const btree_key_t *key) {
         && delete_range->inner.contains_key(key->contents, key->size);
 }
 
+// The range erase only visits keys in `delete_range->inner` to begin with, and
+// every key in the store hashes into its hash shard.
+bool range_key_tester_t::erases_every_key() {
+    return delete_range->beg <= store_beg && store_end <= delete_range->end;
+}
+
 typedef boost::variant<rdb_modification_report_t,
                        rdb_erase_range_report_t>
         sindex_change_t;
@@ -392,6 +407,9 @@ void add_status(const single_sindex_status_t &new_status,
     status_out->blocks_processed += new_status.blocks_processed;
     status_out->blocks_total += new_status.blocks_total;
     status_out->ready &= new_status.ready;
+    // Shards are post-constructed concurrently, so the slowest one decides.
+    status_out->seconds_remaining = std::max(status_out->seconds_remaining,
+                                             new_status.seconds_remaining);
 }
 
 }  // namespace rdb_protocol_details
@@ -401,6 +419,7 @@ rdb_protocol_t::context_t::context_t()
     cross_thread_namespace_watchables(get_num_threads()),
     cross_thread_database_watchables(get_num_threads()),
     directory_read_manager(NULL),
+    manager(NULL),
     signals(get_num_threads())
 { }
 
@@ -413,6 +432,7 @@ rdb_protocol_t::context_t::context_t(
         _auth_metadata,
     directory_read_manager_t<cluster_directory_metadata_t>
         *_directory_read_manager,
+    mailbox_manager_t *_manager,
     machine_id_t _machine_id)
     : extproc_pool(_extproc_pool), ns_repo(_ns_repo),
       cross_thread_namespace_watchables(get_num_threads()),
@@ -420,6 +440,7 @@ rdb_protocol_t::context_t::context_t(
       cluster_metadata(_cluster_metadata),
       auth_metadata(_auth_metadata),
       directory_read_manager(_directory_read_manager),
+      manager(_manager),
       signals(get_num_threads()),
       machine_id(_machine_id)
 {
@@ -493,6 +514,10 @@ struct rdb_r_get_region_visitor : public boost::static_visitor<region_t> {
     region_t operator()(const sindex_status_t &ss) const {
         return ss.region;
     }
+
+    region_t operator()(const changefeed_subscribe_t &cs) const {
+        return cs.region;
+    }
 };
 
 region_t read_t::get_region() const THROWS_NOTHING {
@@ -549,6 +574,10 @@ struct rdb_r_shard_visitor_t : public boost::static_visitor<bool> {
         return rangey_read(ss);
     }
 
+    bool operator()(const changefeed_subscribe_t &cs) const {
+        return rangey_read(cs);
+    }
+
     const hash_region_t<key_range_t> *region;
     profile_bool_t profile;
     read_t *read_out;
@@ -606,6 +635,7 @@ public:
                      ->get_watchable(),
                  ctx->cluster_metadata,
                  NULL,
+                 ctx->manager,
                  interruptor,
                  ctx->machine_id,
                  ql::protob_t<Query>())
@@ -737,6 +767,18 @@ public:
         }
     }
 
+    void operator()(UNUSED const changefeed_subscribe_t &cs) {
+        *response_out = read_response_t(changefeed_subscribe_response_t());
+        auto cs_response
+            = boost::get<changefeed_subscribe_response_t>(&response_out->response);
+        for (size_t i = 0; i < count; ++i) {
+            auto resp = boost::get<changefeed_subscribe_response_t>(&responses[i].response);
+            guarantee(resp);
+            cs_response->servers.insert(cs_response->servers.end(),
+                                        resp->servers.begin(), resp->servers.end());
+        }
+    }
+
 private:
     const read_response_t *responses;
     size_t count;
@@ -1236,6 +1278,14 @@ store_t::store_t(serializer_t *serializer,
             create, parent_perfmon_collection, _ctx, io, base_path),
     ctx(_ctx)
 {
+    if (ctx != NULL && ctx->manager != NULL) {
+        changefeed_server.init(new ql::changefeed::server_t(ctx->manager));
+    }
+
+    // Finish freeing whatever range erases left behind before a restart.
+    rdb_value_deleter_t deleter;
+    start_freeing_detached_subtrees(btree.get(), &deleter);
+
     // Make sure to continue bringing sindexes up-to-date if it was interrupted earlier
 
     // This uses a dummy interruptor because this is the only thing using the store at
@@ -1348,7 +1398,9 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
     void operator()(const distribution_read_t &dg) {
         response->response = distribution_read_response_t();
         distribution_read_response_t *res = boost::get<distribution_read_response_t>(&response->response);
-        rdb_distribution_get(btree, dg.max_depth, dg.region.inner.left, txn, superblock, res);
+        rdb_distribution_get(btree, dg.max_depth,
+                             key_sample_size_for_distribution(dg.result_limit, dg.region),
+                             dg.region.inner.left, txn, superblock, res);
         for (std::map<store_key_t, int64_t>::iterator it = res->key_counts.begin(); it != res->key_counts.end(); ) {
             if (!dg.region.inner.contains_key(store_key_t(it->first))) {
                 std::map<store_key_t, int64_t>::iterator tmp = it;
@@ -1402,14 +1454,25 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
                     } else {
                         s->blocks_processed = frac.estimate_of_released_nodes;
                         s->blocks_total = frac.estimate_of_total_nodes;
+                        s->seconds_remaining = store->get_seconds_remaining(it->second.id);
                     }
                 }
             }
         }
     }
 
+    void operator()(const changefeed_subscribe_t &cs) {
+        response->response = changefeed_subscribe_response_t();
+        auto res = &boost::get<changefeed_subscribe_response_t>(response->response);
+        if (changefeed_server != NULL) {
+            changefeed_server->add_feed(cs.feed_id, cs.feed_addr);
+            res->servers.push_back(changefeed_server->get_addr());
+        }
+    }
+
     rdb_read_visitor_t(btree_slice_t *_btree,
                        btree_store_t<rdb_protocol_t> *_store,
+                       ql::changefeed::server_t *_changefeed_server,
                        transaction_t *_txn,
                        superblock_t *_superblock,
                        read_token_pair_t *_token_pair,
@@ -1420,6 +1483,7 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
         response(_response),
         btree(_btree),
         store(_store),
+        changefeed_server(_changefeed_server),
         txn(_txn),
         superblock(_superblock),
         token_pair(_token_pair),
@@ -1432,6 +1496,7 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
                    ->get_watchable(),
                ctx->cluster_metadata,
                NULL,
+               ctx->manager,
                &interruptor,
                ctx->machine_id,
                profile)
@@ -1454,6 +1519,7 @@ private:
     read_response_t *response;
     btree_slice_t *btree;
     btree_store_t<rdb_protocol_t> *store;
+    ql::changefeed::server_t *changefeed_server;
     transaction_t *txn;
     superblock_t *superblock;
     read_token_pair_t *token_pair;
@@ -1469,7 +1535,7 @@ void store_t::protocol_read(const read_t &read,
                             read_token_pair_t *token_pair,
                             signal_t *interruptor) {
     rdb_read_visitor_t v(
-        btree, this, txn, superblock, token_pair,
+        btree, this, changefeed_server.get(), txn, superblock, token_pair,
         ctx, response, read.profile, interruptor);
     {
         profile::starter_t start_write("Perform read on shard.", v.get_env()->trace);
@@ -1534,7 +1600,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
             throw;
         }
         rdb_modification_report_cb_t sindex_cb(
-            store, token_pair, txn,
+            store, changefeed_server, token_pair, txn,
             (*superblock)->get_sindex_block_id(),
             auto_drainer_t::lock_t(&store->drainer));
         func_replacer_t replacer(&ql_env, br.f, br.return_vals);
@@ -1547,7 +1613,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
 
     void operator()(const batched_insert_t &bi) {
         rdb_modification_report_cb_t sindex_cb(
-            store, token_pair, txn,
+            store, changefeed_server, token_pair, txn,
             (*superblock)->get_sindex_block_id(),
             auto_drainer_t::lock_t(&store->drainer));
         datum_replacer_t replacer(&bi.inserts, bi.upsert, bi.pkey, bi.return_vals);
@@ -1648,6 +1714,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
 
     rdb_write_visitor_t(btree_slice_t *_btree,
                         btree_store_t<rdb_protocol_t> *_store,
+                        ql::changefeed::server_t *_changefeed_server,
                         transaction_t *_txn,
                         scoped_ptr_t<superblock_t> *_superblock,
                         write_token_pair_t *_token_pair,
@@ -1657,6 +1724,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
                         signal_t *_interruptor) :
         btree(_btree),
         store(_store),
+        changefeed_server(_changefeed_server),
         txn(_txn),
         response(_response),
         superblock(_superblock),
@@ -1669,6 +1737,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
                ctx->cross_thread_database_watchables[get_thread_id().threadnum].get()->get_watchable(),
                ctx->cluster_metadata,
                NULL,
+               ctx->manager,
                &interruptor,
                ctx->machine_id,
                ql::protob_t<Query>()),
@@ -1706,10 +1775,15 @@ private:
         sindex_access_vector_t sindexes;
         store->aquire_post_constructed_sindex_superblocks_for_write(sindex_block.get(), txn, &sindexes);
         rdb_update_sindexes(sindexes, mod_report, txn);
+
+        if (changefeed_server != NULL) {
+            changefeed_server->on_mod_report(*mod_report);
+        }
     }
 
     btree_slice_t *btree;
     btree_store_t<rdb_protocol_t> *store;
+    ql::changefeed::server_t *changefeed_server;
     transaction_t *txn;
     write_response_t *response;
     scoped_ptr_t<superblock_t> *superblock;
@@ -1728,7 +1802,7 @@ void store_t::protocol_write(const write_t &write,
                              scoped_ptr_t<superblock_t> *superblock,
                              write_token_pair_t *token_pair,
                              signal_t *interruptor) {
-    rdb_write_visitor_t v(btree, this, txn, superblock, token_pair,
+    rdb_write_visitor_t v(btree, this, changefeed_server.get(), txn, superblock, token_pair,
             timestamp.to_repli_timestamp(), ctx, response, interruptor);
     {
         profile::starter_t start_write("Perform write on shard.", v.get_env()->trace);
@@ -1764,6 +1838,36 @@ repli_timestamp_t backfill_chunk_t::get_btree_repli_timestamp() const THROWS_NOT
     return boost::apply_visitor(v, val);
 }
 
+struct rdb_backfill_chunk_estimate_size_visitor_t : public boost::static_visitor<size_t> {
+    size_t operator()(const backfill_chunk_t::delete_key_t &del) {
+        return del.key.size();
+    }
+
+    size_t operator()(const backfill_chunk_t::delete_range_t &) {
+        return 0;
+    }
+
+    size_t operator()(const backfill_chunk_t::key_value_pair_t &kv) {
+        return kv.backfill_atom.key.size() + estimate_rget_response_size(kv.backfill_atom.value);
+    }
+
+    size_t operator()(const backfill_chunk_t::sindexes_t &s) {
+        size_t size = 0;
+        for (std::map<std::string, secondary_index_t>::const_iterator it = s.sindexes.begin();
+             it != s.sindexes.end(); ++it) {
+            size += it->first.size() + it->second.opaque_definition.size();
+        }
+        return size;
+    }
+};
+
+size_t backfill_chunk_t::estimate_size() const THROWS_NOTHING {
+    /* The variant tag, the timestamps, and the key bounds of a range. */
+    static const size_t approx_per_chunk_overhead = 32;
+    rdb_backfill_chunk_estimate_size_visitor_t v;
+    return approx_per_chunk_overhead + boost::apply_visitor(v, val);
+}
+
 struct rdb_backfill_callback_impl_t : public rdb_backfill_callback_t {
 public:
     typedef backfill_chunk_t chunk_t;
@@ -1859,7 +1963,7 @@ struct rdb_receive_backfill_visitor_t : public boost::static_visitor<void> {
     }
 
     void operator()(const backfill_chunk_t::delete_range_t& delete_range) const {
-        range_key_tester_t tester(&delete_range.range);
+        range_key_tester_t tester(&delete_range.range, store->get_region());
         rdb_erase_range(btree, &tester, delete_range.range.inner, txn, superblock,
                 store, token_pair, interruptor);
     }
@@ -1965,9 +2069,33 @@ region_t rdb_protocol_t::cpu_sharding_subspace(int subregion_number,
     return region_t(beg, end, key_range_t::universe());
 }
 
+std::vector<region_t> rdb_protocol_t::backfill_slices(store_view_t<rdb_protocol_t> *store,
+                                                      const region_t &region,
+                                                      signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t) {
+    distribution_read_t distribution_read(2, BACKFILL_MAX_SLICES * 4);
+    distribution_read.region = region;
+    read_t read(distribution_read, profile_bool_t::DONT_PROFILE);
+    read_response_t response;
+
+    read_token_pair_t token_pair;
+    store->new_read_token_pair(&token_pair);
+#ifndef NDEBUG
+    trivial_metainfo_checker_callback_t<rdb_protocol_t> metainfo_checker_callback;
+    metainfo_checker_t<rdb_protocol_t> metainfo_checker(&metainfo_checker_callback, store->get_region());
+#endif
+    store->read(DEBUG_ONLY(metainfo_checker, )
+                read, &response, order_token_t::ignore, &token_pair, interruptor);
+
+    return region_split_by_key_counts(region,
+                                      boost::get<distribution_read_response_t>(response.response).key_counts,
+                                      BACKFILL_MAX_SLICES,
+                                      BACKFILL_MIN_KEYS_PER_SLICE);
+}
+
 RDB_IMPL_ME_SERIALIZABLE_3(rdb_protocol_details::rget_item_t, key, sindex_key, data);
-RDB_IMPL_ME_SERIALIZABLE_3(rdb_protocol_details::single_sindex_status_t,
-                           blocks_total, blocks_processed, ready);
+RDB_IMPL_ME_SERIALIZABLE_4(rdb_protocol_details::single_sindex_status_t,
+                           blocks_total, blocks_processed, ready, seconds_remaining);
 
 RDB_IMPL_ME_SERIALIZABLE_1(rdb_protocol_t::point_read_response_t, data);
 RDB_IMPL_ME_SERIALIZABLE_4(rdb_protocol_t::rget_read_response_t,
@@ -1978,6 +2106,7 @@ RDB_IMPL_ME_SERIALIZABLE_1(rdb_protocol_t::sindex_list_response_t, sindexes);
 RDB_IMPL_ME_SERIALIZABLE_3(rdb_protocol_t::read_response_t,
                            response, event_log, n_shards);
 RDB_IMPL_ME_SERIALIZABLE_1(rdb_protocol_t::sindex_status_response_t, statuses);
+RDB_IMPL_ME_SERIALIZABLE_1(rdb_protocol_t::changefeed_subscribe_response_t, servers);
 
 RDB_IMPL_ME_SERIALIZABLE_1(rdb_protocol_t::point_read_t, key);
 RDB_IMPL_ME_SERIALIZABLE_3(rdb_protocol_t::sindex_rangespec_t,
@@ -1996,6 +2125,8 @@ RDB_IMPL_ME_SERIALIZABLE_3(rdb_protocol_t::distribution_read_t,
                            max_depth, result_limit, region);
 RDB_IMPL_ME_SERIALIZABLE_0(rdb_protocol_t::sindex_list_t);
 RDB_IMPL_ME_SERIALIZABLE_2(rdb_protocol_t::sindex_status_t, sindexes, region);
+RDB_IMPL_ME_SERIALIZABLE_3(rdb_protocol_t::changefeed_subscribe_t,
+                           feed_id, feed_addr, region);
 RDB_IMPL_ME_SERIALIZABLE_2(rdb_protocol_t::read_t, read, profile);
 RDB_IMPL_ME_SERIALIZABLE_1(rdb_protocol_t::point_write_response_t, result);
 
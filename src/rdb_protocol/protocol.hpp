@@ -25,6 +25,7 @@
 #include "http/json/cJSON.hpp"
 #include "memcached/region.hpp"
 #include "protocol_api.hpp"
+#include "rdb_protocol/changefeed.hpp"
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/profile.hpp"
 #include "rdb_protocol/rdb_protocol_json.hpp"
@@ -188,13 +189,16 @@ struct rget_item_t {
 struct single_sindex_status_t {
     single_sindex_status_t()
         : blocks_processed(0),
-          blocks_total(0), ready(true)
+          blocks_total(0), ready(true), seconds_remaining(-1)
     { }
     single_sindex_status_t(size_t _blocks_processed, size_t _blocks_total, bool _ready)
         : blocks_processed(_blocks_processed),
-          blocks_total(_blocks_total), ready(_ready) { }
+          blocks_total(_blocks_total), ready(_ready), seconds_remaining(-1) { }
     size_t blocks_processed, blocks_total;
     bool ready;
+    // An estimate of how long post-construction will still take, or a
+    // negative number if there isn't one yet.
+    double seconds_remaining;
 
     RDB_DECLARE_ME_SERIALIZABLE;
 };
@@ -233,6 +237,7 @@ struct rdb_protocol_t {
                       auth_semilattice_metadata_t> > _auth_metadata,
                   directory_read_manager_t<
                       cluster_directory_metadata_t> *_directory_read_manager,
+                  mailbox_manager_t *_manager,
                   uuid_u _machine_id);
         ~context_t();
 
@@ -251,6 +256,8 @@ struct rdb_protocol_t {
         boost::shared_ptr<semilattice_readwrite_view_t<auth_semilattice_metadata_t> >
             auth_metadata;
         directory_read_manager_t<cluster_directory_metadata_t> *directory_read_manager;
+        // Used for changefeeds.  NULL if there is no cluster, as in some unit tests.
+        mailbox_manager_t *manager;
         // TODO figure out where we're going to want to interrupt this from and
         // put this there instead
         cond_t interruptor;
@@ -331,12 +338,20 @@ struct rdb_protocol_t {
         RDB_DECLARE_ME_SERIALIZABLE;
     };
 
+    struct changefeed_subscribe_response_t {
+        changefeed_subscribe_response_t() { }
+        std::vector<ql::changefeed::server_addr_t> servers;
+
+        RDB_DECLARE_ME_SERIALIZABLE;
+    };
+
     struct read_response_t {
         typedef boost::variant<point_read_response_t,
                                rget_read_response_t,
                                distribution_read_response_t,
                                sindex_list_response_t,
-                               sindex_status_response_t> variant_t;
+                               sindex_status_response_t,
+                               changefeed_subscribe_response_t> variant_t;
         variant_t response;
         profile::event_log_t event_log;
         size_t n_shards;
@@ -444,12 +459,27 @@ struct rdb_protocol_t {
         RDB_DECLARE_ME_SERIALIZABLE;
     };
 
+    // Subscribes a changefeed to the modifications made in `region`.
+    class changefeed_subscribe_t {
+    public:
+        changefeed_subscribe_t() { }
+        changefeed_subscribe_t(uuid_u _feed_id,
+                               const ql::changefeed::feed_addr_t &_feed_addr)
+            : feed_id(_feed_id), feed_addr(_feed_addr), region(region_t::universe())
+        { }
+        uuid_u feed_id;
+        ql::changefeed::feed_addr_t feed_addr;
+        region_t region;
+        RDB_DECLARE_ME_SERIALIZABLE;
+    };
+
     struct read_t {
         typedef boost::variant<point_read_t,
                                rget_read_t,
                                distribution_read_t,
                                sindex_list_t,
-                               sindex_status_t> variant_t;
+                               sindex_status_t,
+                               changefeed_subscribe_t> variant_t;
         variant_t read;
         profile_bool_t profile;
 
@@ -787,6 +817,10 @@ struct rdb_protocol_t {
         /* This is for `btree_store_t`; it's not part of the ICL protocol API. */
         repli_timestamp_t get_btree_repli_timestamp() const THROWS_NOTHING;
 
+        /* Roughly how many bytes the chunk takes up when it's sent, without
+        serializing it. The backfiller paces itself by this. */
+        size_t estimate_size() const THROWS_NOTHING;
+
         RDB_DECLARE_ME_SERIALIZABLE;
     };
 
@@ -848,9 +882,18 @@ struct rdb_protocol_t {
                                  write_token_pair_t *token_pair,
                                  signal_t *interruptor);
         context_t *ctx;
+        // NULL if `ctx` has no mailbox manager.
+        scoped_ptr_t<ql::changefeed::server_t> changefeed_server;
     };
 
     static region_t cpu_sharding_subspace(int subregion_number, int num_cpu_shards);
+
+    /* Cuts `region` of `store` into the slices that a backfill of it is sent
+    in (see `backfiller_t`). */
+    static std::vector<region_t> backfill_slices(store_view_t<rdb_protocol_t> *store,
+                                                 const region_t &region,
+                                                 signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
 };
 
 namespace rdb_protocol_details {
@@ -858,10 +901,17 @@ namespace rdb_protocol_details {
 originally necessary because in v1.1.x the hashing scheme might be different
 between the source and destination machines. */
 struct range_key_tester_t : public key_tester_t {
-    explicit range_key_tester_t(const rdb_protocol_t::region_t *_delete_range) : delete_range(_delete_range) { }
+    /* `store_region` is the region of the store being erased from; its btree
+    only holds keys that hash into that region. */
+    range_key_tester_t(const rdb_protocol_t::region_t *_delete_range,
+                       const rdb_protocol_t::region_t &store_region)
+        : delete_range(_delete_range), store_beg(store_region.beg),
+          store_end(store_region.end) { }
     bool key_should_be_erased(const btree_key_t *key);
+    bool erases_every_key();
 
     const rdb_protocol_t::region_t *delete_range;
+    uint64_t store_beg, store_end;
 };
 } // namespace rdb_protocol_details
 
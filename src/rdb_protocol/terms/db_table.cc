@@ -155,7 +155,7 @@ public:
     table_create_term_t(compile_env_t *env, const protob_t<const Term> &term) :
         meta_write_op_t(env, term, argspec_t(1, 2),
                         optargspec_t({"datacenter", "primary_key",
-                                    "cache_size", "durability"})) { }
+                                    "cache_size", "block_size", "durability"})) { }
 private:
     virtual std::string write_eval_impl(scope_env_t *env, UNUSED eval_flags_t flags) {
         uuid_u dc_id = nil_uuid();
@@ -183,6 +183,17 @@ private:
             cache_size = v->as_int<int64_t>();
         }
 
+        int64_t block_size = DEFAULT_BTREE_BLOCK_SIZE;
+        if (counted_t<val_t> v = optarg(env, "block_size")) {
+            block_size = v->as_int<int64_t>();
+            rcheck(is_valid_btree_block_size(block_size),
+                   base_exc_t::GENERIC,
+                   strprintf("Block size must be a power of two between %" PRIi64
+                             " and %" PRIi64 " bytes (got %" PRIi64 ").",
+                             static_cast<int64_t>(MIN_BTREE_BLOCK_SIZE),
+                             static_cast<int64_t>(MAX_BTREE_BLOCK_SIZE), block_size));
+        }
+
         uuid_u db_id;
         name_string_t tbl_name;
         if (num_args() == 1) {
@@ -213,7 +224,7 @@ private:
             namespace_semilattice_metadata_t<rdb_protocol_t> ns =
                 new_namespace<rdb_protocol_t>(env->env->cluster_access.this_machine, db_id, dc_id, tbl_name,
                                               primary_key, port_defaults::reql_port,
-                                              cache_size);
+                                              cache_size, block_size);
 
             // Set Durability
             std::map<datacenter_id_t, ack_expectation_t> *ack_map =
@@ -421,14 +432,43 @@ private:
     virtual const char *name() const { return "sync"; }
 };
 
+class changes_term_t : public op_term_t {
+public:
+    changes_term_t(compile_env_t *env, const protob_t<const Term> &term)
+        : op_term_t(env, term, argspec_t(1)) { }
+private:
+    virtual counted_t<val_t> eval_impl(scope_env_t *env, UNUSED eval_flags_t flags) {
+        counted_t<table_t> t = arg(env, 0)->as_table();
+        return new_val(env->env, t->changes(env->env, backtrace()));
+    }
+    virtual bool is_deterministic() const { return false; }
+    virtual const char *name() const { return "changes"; }
+};
+
 class table_term_t : public op_term_t {
 public:
     table_term_t(compile_env_t *env, const protob_t<const Term> &term)
-        : op_term_t(env, term, argspec_t(1, 2), optargspec_t({ "use_outdated" })) { }
+        : op_term_t(env, term, argspec_t(1, 2),
+                    optargspec_t({ "use_outdated", "max_staleness" })) { }
 private:
     virtual counted_t<val_t> eval_impl(scope_env_t *env, UNUSED eval_flags_t flags) {
         counted_t<val_t> t = optarg(env, "use_outdated");
         bool use_outdated = t ? t->as_bool() : false;
+        // A bound on how stale the data may be only makes sense for outdated
+        // reads, so giving one asks for them.
+        boost::optional<int64_t> max_staleness_ms;
+        if (counted_t<val_t> v = optarg(env, "max_staleness")) {
+            double max_staleness = v->as_num();
+            rcheck(max_staleness >= 0, base_exc_t::GENERIC,
+                   strprintf("`max_staleness` must be a non-negative number of "
+                             "seconds (got %f).", max_staleness));
+            if (max_staleness > static_cast<double>(INT64_MAX) / 1000) {
+                max_staleness_ms = INT64_MAX;
+            } else {
+                max_staleness_ms = static_cast<int64_t>(max_staleness * 1000);
+            }
+            use_outdated = true;
+        }
         counted_t<const db_t> db;
         std::string name;
         if (num_args() == 1) {
@@ -441,7 +481,8 @@ private:
             db = arg(env, 0)->as_db();
             name = arg(env, 1)->as_str();
         }
-        return new_val(make_counted<table_t>(env->env, db, name, use_outdated, backtrace()));
+        return new_val(make_counted<table_t>(
+            env->env, db, name, use_outdated, max_staleness_ms, backtrace()));
     }
     virtual bool is_deterministic() const { return false; }
     virtual const char *name() const { return "table"; }
@@ -540,6 +581,10 @@ counted_t<term_t> make_sync_term(compile_env_t *env, const protob_t<const Term>
     return make_counted<sync_term_t>(env, term);
 }
 
+counted_t<term_t> make_changes_term(compile_env_t *env, const protob_t<const Term> &term) {
+    return make_counted<changes_term_t>(env, term);
+}
+
 
 
 } // namespace ql
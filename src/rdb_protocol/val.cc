@@ -13,11 +13,13 @@ namespace ql {
 
 table_t::table_t(env_t *env,
                  counted_t<const db_t> _db, const std::string &_name,
-                 bool _use_outdated, const protob_t<const Backtrace> &backtrace)
+                 bool _use_outdated, boost::optional<int64_t> _max_staleness_ms,
+                 const protob_t<const Backtrace> &backtrace)
     : pb_rcheckable_t(backtrace),
       db(_db),
       name(_name),
       use_outdated(_use_outdated),
+      max_staleness_ms(_max_staleness_ms),
       bounds(datum_range_t::universe()),
       sorting(sorting_t::UNORDERED) {
     uuid_u db_id = db->id;
@@ -250,6 +252,10 @@ counted_t<const datum_t> table_t::sindex_status(env_t *env, std::set<std::string
                     make_counted<const datum_t>(
                         safe_to_double(it->second.blocks_total));
             }
+            if (!it->second.ready && it->second.seconds_remaining >= 0) {
+                status["seconds_remaining"] =
+                    make_counted<const datum_t>(it->second.seconds_remaining);
+            }
             status["ready"] = make_counted<const datum_t>(datum_t::R_BOOL, it->second.ready);
             std::string index_name = it->first;
             status["index"] = make_counted<const datum_t>(std::move(index_name));
@@ -286,6 +292,32 @@ MUST_USE bool table_t::sync_depending_on_durability(env_t *env,
     return true; // With our current implementation, a sync can never fail.
 }
 
+counted_t<datum_stream_t> table_t::changes(env_t *env,
+                                           const protob_t<const Backtrace> &bt) {
+    rcheck(bounds.is_universe() && sorting == sorting_t::UNORDERED,
+           base_exc_t::GENERIC,
+           "changes can only be applied directly to a table.");
+    rcheck(env->cluster_access.mailbox_manager != NULL, base_exc_t::GENERIC,
+           "Changefeeds are not available here.");
+    scoped_ptr_t<changefeed::feed_t> feed(
+        new changefeed::feed_t(env->cluster_access.mailbox_manager));
+    rdb_protocol_t::read_t read(
+        rdb_protocol_t::changefeed_subscribe_t(feed->get_id(), feed->get_addr()),
+        env->profile());
+    try {
+        rdb_protocol_t::read_response_t res;
+        access->get_namespace_if().read(
+            read, &res, order_token_t::ignore, env->interruptor);
+        auto cs_res =
+            boost::get<rdb_protocol_t::changefeed_subscribe_response_t>(&res.response);
+        r_sanity_check(cs_res);
+        feed->add_servers(cs_res->servers);
+    } catch (const cannot_perform_query_exc_t &ex) {
+        rfail(base_exc_t::GENERIC, "cannot subscribe to changes: %s", ex.what());
+    }
+    return make_counted<changefeed_datum_stream_t>(std::move(feed), bt);
+}
+
 const std::string &table_t::get_pkey() { return pkey; }
 
 counted_t<const datum_t> table_t::get_row(env_t *env, counted_t<const datum_t> pval) {
@@ -293,7 +325,10 @@ counted_t<const datum_t> table_t::get_row(env_t *env, counted_t<const datum_t> p
     rdb_protocol_t::read_t read(
             rdb_protocol_t::point_read_t(store_key_t(pks)), env->profile());
     rdb_protocol_t::read_response_t res;
-    if (use_outdated) {
+    if (use_outdated && max_staleness_ms) {
+        access->get_namespace_if().read_outdated_bounded(
+            read, &res, *max_staleness_ms, env->interruptor);
+    } else if (use_outdated) {
         access->get_namespace_if().read_outdated(read, &res, env->interruptor);
     } else {
         access->get_namespace_if().read(
@@ -319,12 +354,14 @@ counted_t<datum_stream_t> table_t::get_all(
         return make_counted<lazy_datum_stream_t>(
             access.get(),
             use_outdated,
+            max_staleness_ms,
             primary_readgen_t::make(env, datum_range_t(value)),
             bt);
     } else {
         return make_counted<lazy_datum_stream_t>(
             access.get(),
             use_outdated,
+            max_staleness_ms,
             sindex_readgen_t::make(env, get_all_sindex_id, datum_range_t(value)),
             bt);
     }
@@ -368,6 +405,7 @@ counted_t<datum_stream_t> table_t::as_datum_stream(env_t *env,
     return make_counted<lazy_datum_stream_t>(
         access.get(),
         use_outdated,
+        max_staleness_ms,
         (!sindex_id || *sindex_id == get_pkey())
             ? primary_readgen_t::make(env, bounds, sorting)
             : sindex_readgen_t::make(env, *sindex_id, bounds, sorting),
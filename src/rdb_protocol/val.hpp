@@ -31,7 +31,8 @@ class table_t : public single_threaded_countable_t<table_t>, public pb_rcheckabl
 public:
     table_t(env_t *env,
             counted_t<const db_t> db, const std::string &name,
-            bool use_outdated, const protob_t<const Backtrace> &src);
+            bool use_outdated, boost::optional<int64_t> max_staleness_ms,
+            const protob_t<const Backtrace> &src);
     counted_t<datum_stream_t> as_datum_stream(env_t *env,
                                               const protob_t<const Backtrace> &bt);
     const std::string &get_pkey();
@@ -73,6 +74,7 @@ public:
     counted_t<const datum_t> sindex_status(env_t *env,
         std::set<std::string> sindex);
     MUST_USE bool sync(env_t *env, const rcheckable_t *parent);
+    counted_t<datum_stream_t> changes(env_t *env, const protob_t<const Backtrace> &bt);
 
     counted_t<const db_t> db;
     const std::string name;
@@ -95,6 +97,7 @@ private:
         env_t *env, durability_requirement_t durability_requirement);
 
     bool use_outdated;
+    boost::optional<int64_t> max_staleness_ms;
     std::string pkey;
     scoped_ptr_t<rdb_namespace_access_t> access;
 
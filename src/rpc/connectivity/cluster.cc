@@ -10,6 +10,9 @@
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/pmap.hpp"
 #include "concurrency/semaphore.hpp"
+#include "concurrency/wait_any.hpp"
+#include "config/args.hpp"
+#include "containers/archive/data_buffer_stream.hpp"
 #include "containers/archive/string_stream.hpp"
 #include "containers/object_buffer.hpp"
 #include "containers/uuid.hpp"
@@ -70,11 +73,18 @@ connectivity_cluster_t::run_t::run_t(connectivity_cluster_t *p,
                                      int port,
                                      message_handler_t *mh,
                                      int client_port,
-                                     heartbeat_manager_t *_heartbeat_manager) THROWS_ONLY(address_in_use_exc_t) :
+                                     heartbeat_manager_t *_heartbeat_manager,
+                                     int _connections_per_peer,
+                                     const cluster_compression_config_t &_compression_config) THROWS_ONLY(address_in_use_exc_t) :
     parent(p),
     message_handler(mh),
     heartbeat_manager(_heartbeat_manager),
 
+    /* If all of our connections come from the same client port, TCP can't
+    tell several connections to the same peer apart. */
+    connections_per_peer(client_port == 0 ? _connections_per_peer : 1),
+    compression_config(_compression_config),
+
     /* Create the socket to use when listening for connections from peers */
     cluster_listener_socket(new tcp_bound_socket_t(local_addresses, port)),
     cluster_listener_port(cluster_listener_socket->get_port()),
@@ -104,13 +114,16 @@ connectivity_cluster_t::run_t::run_t(connectivity_cluster_t *p,
     `connection_map` on each thread and notifying any listeners that we're now
     connected to ourself. The destructor will remove us from the
     `connection_map` and again notify any listeners. */
-    connection_to_ourself(this, parent->me, NULL, routing_table[parent->me]),
+    connection_to_ourself(this, parent->me, std::vector<tcp_conn_stream_t *>(),
+                          routing_table[parent->me], CLUSTER_COMPRESSION_NONE),
 
     listener(new tcp_listener_t(cluster_listener_socket.get(),
                                 boost::bind(&connectivity_cluster_t::run_t::on_new_connection,
                                             this, _1, auto_drainer_t::lock_t(&drainer))))
 {
     parent->assert_thread();
+    guarantee(connections_per_peer >= 1
+              && connections_per_peer <= CLUSTER_MAX_CONNECTIONS_PER_PEER);
 }
 
 connectivity_cluster_t::run_t::~run_t() { }
@@ -135,17 +148,40 @@ void connectivity_cluster_t::run_t::join(const peer_address_t &address) THROWS_N
         auto_drainer_t::lock_t(&drainer)));
 }
 
+connectivity_cluster_t::run_t::connection_entry_t::lane_t::lane_t(perfmon_collection_t *parent_collection,
+                                                                  size_t index,
+                                                                  tcp_conn_stream_t *c,
+                                                                  cluster_compression_t compression) :
+    conn(c),
+    compressor(compression),
+    pm_collection(),
+    pm_bytes_sent(secs_to_ticks(1), true),
+    pm_wire_bytes_sent(secs_to_ticks(1), true),
+    pm_collection_membership(parent_collection, &pm_collection, strprintf("connection_%zu", index)),
+    pm_bytes_sent_membership(&pm_collection, &pm_bytes_sent, "bytes_sent"),
+    pm_wire_bytes_sent_membership(&pm_collection, &pm_wire_bytes_sent, "wire_bytes_sent") { }
+
 connectivity_cluster_t::run_t::connection_entry_t::connection_entry_t(run_t *p,
                                                                       peer_id_t id,
-                                                                      tcp_conn_stream_t *c,
-                                                                      const peer_address_t &a) THROWS_NOTHING :
-    conn(c), address(a), session_id(generate_uuid()),
+                                                                      const std::vector<tcp_conn_stream_t *> &conns,
+                                                                      const peer_address_t &a,
+                                                                      cluster_compression_t compression) THROWS_NOTHING :
+    conn(conns.empty() ? NULL : conns[0]), address(a), session_id(generate_uuid()),
     pm_collection(),
     pm_bytes_sent(secs_to_ticks(1), true),
+    pm_wire_bytes_sent(secs_to_ticks(1), true),
     pm_collection_membership(&p->parent->connectivity_collection, &pm_collection, uuid_to_str(id.get_uuid())),
     pm_bytes_sent_membership(&pm_collection, &pm_bytes_sent, "bytes_sent"),
-    parent(p), peer(id),
-    entries(new one_per_thread_t<entry_installation_t>(this)) {
+    pm_wire_bytes_sent_membership(&pm_collection, &pm_wire_bytes_sent, "wire_bytes_sent"),
+    parent(p), peer(id) {
+    for (size_t i = 0; i < conns.size(); ++i) {
+        lanes.push_back(new lane_t(&pm_collection, i, conns[i], compression));
+    }
+
+    /* Only now can other coroutines find us and send messages over the
+    lanes. */
+    entries.init(new one_per_thread_t<entry_installation_t>(this));
+
     if (peer != parent->parent->me && parent->heartbeat_manager != NULL) {
         parent->heartbeat_manager->begin_peer_heartbeat(peer);
     }
@@ -160,8 +196,34 @@ connectivity_cluster_t::run_t::connection_entry_t::~connection_entry_t() THROWS_
     entries.reset();
 
     /* `~entry_installation_t` destroys the `auto_drainer_t`'s in entries,
-    so nothing can be holding the `send_mutex`. */
-    guarantee(!send_mutex.is_locked());
+    so nothing can be holding a `send_scheduler`. */
+    for (size_t i = 0; i < lanes.size(); ++i) {
+        guarantee(!lanes[i].send_scheduler.is_busy());
+    }
+}
+
+connectivity_cluster_t::run_t::connection_entry_t::lane_t *
+connectivity_cluster_t::run_t::connection_entry_t::get_lane(uint64_t ordering_key) {
+    guarantee(!lanes.empty());
+    return &lanes[ordering_key % lanes.size()];
+}
+
+connectivity_cluster_t::run_t::lane_bundle_t::lane_bundle_t(int n, threadnum_t first_thread,
+                                                            cluster_compression_t _compression) :
+    conns(n, NULL), compression(_compression), num_ready(0) {
+    for (int i = 0; i < n; ++i) {
+        threads.push_back(threadnum_t((first_thread.threadnum + i) % get_num_threads()));
+    }
+    if (n == 1) {
+        all_ready.pulse();
+    }
+}
+
+void connectivity_cluster_t::run_t::lane_bundle_t::on_lane_ready() {
+    ++num_ready;
+    if (num_ready == num_lanes() - 1) {
+        all_ready.pulse();
+    }
 }
 
 static void ping_connection_watcher(peer_id_t peer, peers_list_callback_t *connect_disconnect_cb) THROWS_NOTHING {
@@ -211,7 +273,33 @@ void connectivity_cluster_t::run_t::on_new_connection(const scoped_ptr_t<tcp_con
     nconn->make_overcomplicated(&conn);
     keepalive_tcp_conn_stream_t conn_stream(conn);
 
-    handle(&conn_stream, boost::none, boost::none, lock, NULL);
+    handle(&conn_stream, boost::none, boost::none, NULL, 0, lock, NULL);
+}
+
+void connectivity_cluster_t::run_t::connect_lane(ip_and_port_t addr,
+                                                 peer_id_t peer,
+                                                 int lane,
+                                                 lane_bundle_t *bundle,
+                                                 auto_drainer_t::lock_t bundle_lock,
+                                                 auto_drainer_t::lock_t drainer_lock) THROWS_NOTHING {
+    try {
+        wait_any_t interruptor(bundle_lock.get_drain_signal(),
+                               drainer_lock.get_drain_signal());
+        keepalive_tcp_conn_stream_t conn(addr.ip(), addr.port().value(),
+                                         &interruptor, cluster_client_port);
+        handle(&conn, peer, boost::none, NULL, lane, drainer_lock, NULL);
+    } catch (const tcp_conn_t::connect_failed_exc_t &) {
+        /* Ignore */
+    } catch (const interrupted_exc_t &) {
+        /* Ignore */
+    }
+
+    /* If the connection made it into the bundle, `handle()` only returns once
+    the bundle is going away. Otherwise there's no point in waiting for the
+    other connections. */
+    if (bundle->conns[lane] == NULL) {
+        bundle->failed.pulse_if_not_already_pulsed();
+    }
 }
 
 void connectivity_cluster_t::run_t::connect_to_peer(const peer_address_t *address,
@@ -246,7 +334,8 @@ void connectivity_cluster_t::run_t::connect_to_peer(const peer_address_t *addres
             keepalive_tcp_conn_stream_t conn(selected_addr->ip(), selected_addr->port().value(),
                                              drainer_lock.get_drain_signal(), cluster_client_port);
             if (!*successful_join) {
-                handle(&conn, expected_id, boost::optional<peer_address_t>(*address), drainer_lock, successful_join);
+                handle(&conn, expected_id, boost::optional<peer_address_t>(*address),
+                       &*selected_addr, 0, drainer_lock, successful_join);
             }
         } catch (const tcp_conn_t::connect_failed_exc_t &) {
             /* Ignore */
@@ -366,9 +455,7 @@ private:
 
 // Error-handling helper for connectivity_cluster_t::run_t::handle(). Returns true if handle()
 // should return.
-template<typename T>
-static bool deserialize_and_check(tcp_conn_stream_t *c, T *p, const char *peer) {
-    archive_result_t res = deserialize(c, p);
+static bool check_archive_result(archive_result_t res, const char *peer) {
     switch (res) {
       case ARCHIVE_SUCCESS: return false; // no problem.
 
@@ -385,6 +472,26 @@ static bool deserialize_and_check(tcp_conn_stream_t *c, T *p, const char *peer)
     }
 }
 
+template<typename T>
+static bool deserialize_and_check(tcp_conn_stream_t *c, T *p, const char *peer) {
+    return check_archive_result(deserialize(c, p), peer);
+}
+
+/* Both ends of a connection compute the same result, so they agree on how
+to compress it without another round trip. */
+static cluster_compression_t negotiate_compression(
+        const cluster_compression_config_t &ours,
+        const uuid_u &our_datacenter,
+        cluster_compression_t their_same_datacenter,
+        cluster_compression_t their_other_datacenters,
+        const uuid_u &their_datacenter) {
+    if (!our_datacenter.is_nil() && our_datacenter == their_datacenter) {
+        return std::min(ours.same_datacenter, their_same_datacenter);
+    } else {
+        return std::min(ours.other_datacenters, their_other_datacenters);
+    }
+}
+
 // Reads a chunk of data off of the connection, buffer must have at least 'size' bytes
 //  available to write into
 static bool read_header_chunk(tcp_conn_stream_t *conn, char *buffer, int64_t size, const char *peer) {
@@ -508,6 +615,8 @@ void connectivity_cluster_t::run_t::handle(
         keepalive_tcp_conn_stream_t *conn,
         boost::optional<peer_id_t> expected_id,
         boost::optional<peer_address_t> expected_address,
+        const ip_and_port_t *connected_to,
+        int lane,
         auto_drainer_t::lock_t drainer_lock,
         bool *successful_join) THROWS_NOTHING
 {
@@ -525,6 +634,9 @@ void connectivity_cluster_t::run_t::handle(
     cluster_conn_closing_subscription_t conn_closer_1(conn);
     conn_closer_1.reset(drainer_lock.get_drain_signal());
 
+    uuid_u our_datacenter = compression_config.get_datacenter.empty()
+        ? nil_uuid() : compression_config.get_datacenter();
+
     // Each side sends a header followed by its own ID and address, then receives and checks the
     // other side's.
     {
@@ -538,6 +650,11 @@ void connectivity_cluster_t::run_t::handle(
         msg.append(cluster_build_mode.data(), cluster_build_mode.length());
         msg << parent->me;
         msg << routing_table[parent->me].hosts();
+        msg << static_cast<int32_t>(connections_per_peer);
+        msg << static_cast<int32_t>(lane);
+        msg << our_datacenter;
+        msg << static_cast<int8_t>(compression_config.same_datacenter);
+        msg << static_cast<int8_t>(compression_config.other_datacenters);
         if (send_write_message(conn, &msg))
             return; // network error.
     }
@@ -609,11 +726,22 @@ void connectivity_cluster_t::run_t::handle(
         }
     }
 
-    // Receive id, host/ports.
+    // Receive id, host/ports, how many connections the peer wants, and how it
+    // wants them compressed.
     peer_id_t other_id;
     std::set<host_and_port_t> other_peer_addr_hosts;
+    int32_t other_connections_per_peer;
+    int32_t other_lane;
+    uuid_u other_datacenter;
+    int8_t other_same_datacenter_compression;
+    int8_t other_other_datacenters_compression;
     if (deserialize_and_check(conn, &other_id, peername) ||
-        deserialize_and_check(conn, &other_peer_addr_hosts, peername))
+        deserialize_and_check(conn, &other_peer_addr_hosts, peername) ||
+        deserialize_and_check(conn, &other_connections_per_peer, peername) ||
+        deserialize_and_check(conn, &other_lane, peername) ||
+        deserialize_and_check(conn, &other_datacenter, peername) ||
+        deserialize_and_check(conn, &other_same_datacenter_compression, peername) ||
+        deserialize_and_check(conn, &other_other_datacenters_compression, peername))
         return;
 
     // Look up the ip addresses for the other host
@@ -646,6 +774,27 @@ void connectivity_cluster_t::run_t::handle(
         logERR("received inconsistent routing information (wrong address) from %s (%s), closing connection", peername, buf.c_str());
         return;
     }
+    if (other_connections_per_peer < 1
+        || other_connections_per_peer > CLUSTER_MAX_CONNECTIONS_PER_PEER
+        || other_lane < 0
+        || (lane != 0 && other_lane != 0)
+        || other_same_datacenter_compression < CLUSTER_COMPRESSION_NONE
+        || other_same_datacenter_compression > CLUSTER_COMPRESSION_STRONG
+        || other_other_datacenters_compression < CLUSTER_COMPRESSION_NONE
+        || other_other_datacenters_compression > CLUSTER_COMPRESSION_STRONG) {
+        logERR("received invalid connection parameters from %s, closing connection", peername);
+        return;
+    }
+
+    /* The extra connections to a peer skip the rest of the handshake; the
+    peer's first connection took care of it. `handle_lane()` moves the
+    connection to another thread and closes it when the bundle goes away. */
+    if (lane != 0 || other_lane != 0) {
+        conn_closer_1.reset();
+        handle_lane(conn, other_id, std::max(lane, static_cast<int>(other_lane)),
+                    peername, drainer_lock);
+        return;
+    }
 
     // Just saying that we're still on the rpc listener thread.
     parent->assert_thread();
@@ -660,6 +809,23 @@ void connectivity_cluster_t::run_t::handle(
     object_buffer_t<map_insertion_sentry_t<peer_id_t, peer_address_t> >
         routing_table_entry_sentry;
 
+    /* We use as many connections as both of us allow. The extra connections
+    find the first one through `lane_bundles`. It's important that the bundle
+    is registered before we send our routing table, because the peer may start
+    opening the extra connections as soon as it has it. */
+    threadnum_t chosen_thread = threadnum_t(rng.randint(get_num_threads()));
+    lane_bundle_t lanes(std::min(connections_per_peer,
+                                 static_cast<int>(other_connections_per_peer)),
+                        chosen_thread,
+                        negotiate_compression(
+                            compression_config, our_datacenter,
+                            static_cast<cluster_compression_t>(other_same_datacenter_compression),
+                            static_cast<cluster_compression_t>(other_other_datacenters_compression),
+                            other_datacenter));
+    lanes.conns[0] = conn;
+    object_buffer_t<map_insertion_sentry_t<peer_id_t, lane_bundle_t *> >
+        lane_bundle_sentry;
+
     /* We pick one side of the connection to be the "leader" and the other side
     to be the "follower". These roles are only relevant in the initial startup
     process. The leader registers the connection locally. If there's a conflict,
@@ -682,6 +848,7 @@ void connectivity_cluster_t::run_t::handle(
                                                     &routing_table_to_send)) {
             return;
         }
+        lane_bundle_sentry.create(&lane_bundles, other_id, &lanes);
 
         /* We're good to go! Transmit the routing table to the follower, so it
         knows we're in. */
@@ -710,6 +877,7 @@ void connectivity_cluster_t::run_t::handle(
                                                     &routing_table_to_send)) {
             return;
         }
+        lane_bundle_sentry.create(&lane_bundles, other_id, &lanes);
 
         /* Send our routing table to the leader */
         {
@@ -750,33 +918,66 @@ void connectivity_cluster_t::run_t::handle(
         }
     }
 
+    /* Wait for the extra connections. The side that connected opens them, at
+    the address that worked for this one. If they don't all make it, we give up
+    on this connection, and the peer will notice when we close it. */
+    if (lanes.num_lanes() > 1) {
+        if (connected_to != NULL) {
+            for (int i = 1; i < lanes.num_lanes(); ++i) {
+                coro_t::spawn_sometime(boost::bind(
+                    &connectivity_cluster_t::run_t::connect_lane, this,
+                    *connected_to, other_id, i, &lanes,
+                    auto_drainer_t::lock_t(&lanes.drainer), drainer_lock));
+            }
+        }
+        signal_timer_t timeout;
+        timeout.start(CLUSTER_EXTRA_CONNECTIONS_TIMEOUT_MS);
+        wait_any_t waiter(&lanes.all_ready, &lanes.failed, &timeout,
+                          drainer_lock.get_drain_signal());
+        waiter.wait_lazily_unordered();
+        if (!lanes.all_ready.is_pulsed() || lanes.failed.is_pulsed()) {
+            if (!drainer_lock.get_drain_signal()->is_pulsed()) {
+                logWRN("Could not open %d connections to %s, closing connection",
+                       lanes.num_lanes(), peername);
+            }
+            return;
+        }
+    }
+
     /* Now that we're about to switch threads, it's not safe to try to close
     the connection from this thread anymore. This is safe because we won't do
     anything that permanently blocks before setting up `conn_closer_2`. */
     conn_closer_1.reset();
 
-    // We could pick a better way to pick a better thread, our choice
-    // now is hopefully a performance non-problem.
-    threadnum_t chosen_thread = threadnum_t(rng.randint(get_num_threads()));
-
+    const threadnum_t rpc_thread = get_thread_id();
     cross_thread_signal_t connection_thread_drain_signal(drainer_lock.get_drain_signal(), chosen_thread);
+    cross_thread_signal_t lane_failed_signal(&lanes.failed, chosen_thread);
 
     rethread_tcp_conn_stream_t unregister_conn(conn, INVALID_THREAD);
     on_thread_t conn_threader(chosen_thread);
     rethread_tcp_conn_stream_t reregister_conn(conn, get_thread_id());
 
-    // Make sure that if we're ordered to shut down, any pending read
-    // or write gets interrupted.
+    // Make sure that if we're ordered to shut down, or one of the other
+    // connections to the peer dies, any pending read or write gets interrupted.
+    wait_any_t close_signal(&connection_thread_drain_signal, &lane_failed_signal);
     cluster_conn_closing_subscription_t conn_closer_2(conn);
-    conn_closer_2.reset(&connection_thread_drain_signal);
+    conn_closer_2.reset(&close_signal);
 
     {
         /* `connection_entry_t` is the public interface of this coroutine. Its
         constructor registers it in the `connectivity_cluster_t`'s connection
         map and notifies any connect listeners. */
-        connection_entry_t conn_structure(this, other_id, conn, other_peer_addr);
+        connection_entry_t conn_structure(this, other_id, lanes.conns, other_peer_addr,
+                                          lanes.compression);
         object_buffer_t<heartbeat_keepalive_t> keepalive;
 
+        /* Only now that we can reply to them do the extra connections start
+        reading messages. */
+        {
+            on_thread_t threader(rpc_thread);
+            lanes.started.pulse();
+        }
+
         if (heartbeat_manager != NULL) {
             keepalive.create(conn, heartbeat_manager, other_id);
         }
@@ -784,16 +985,17 @@ void connectivity_cluster_t::run_t::handle(
         /* Main message-handling loop: read messages off the connection until
         it's closed, which may be due to network events, or the other end
         shutting down, or us shutting down. */
+        message_decompressor_t decompressor(lanes.compression);
         try {
             while (true) {
-                /* For now, we use `std::string` for messages on the wire: it's
-                just a length and a byte vector. This is obviously slow and we
-                should change it when we care about performance. */
-                std::string message;
-                if (deserialize_and_check(conn, &message, peername))
+                /* Each message is read whole into a buffer of its own. The
+                handler may hold on to slices of it, such as big values that it
+                deserializes without copying, after we move on. */
+                counted_t<data_buffer_t> message;
+                if (check_archive_result(decompressor.read(conn, &message), peername))
                     break;
 
-                string_read_stream_t stream(std::move(message), 0);
+                data_buffer_read_stream_t stream(message, 0);
                 message_handler->on_message(other_id, &stream); // might raise fake_archive_exc_t
                 coro_t::yield();
             }
@@ -813,6 +1015,76 @@ void connectivity_cluster_t::run_t::handle(
     }
 }
 
+void connectivity_cluster_t::run_t::handle_lane(
+        keepalive_tcp_conn_stream_t *conn,
+        peer_id_t peer,
+        int lane,
+        const char *peername,
+        UNUSED auto_drainer_t::lock_t drainer_lock) THROWS_NOTHING {
+    parent->assert_thread();
+    const threadnum_t rpc_thread = get_thread_id();
+
+    std::map<peer_id_t, lane_bundle_t *>::iterator it = lane_bundles.find(peer);
+    if (it == lane_bundles.end()) {
+        // The first connection to the peer lost a conflict or went away.
+        return;
+    }
+    lane_bundle_t *bundle = it->second;
+    if (lane >= bundle->num_lanes() || bundle->conns[lane] != NULL) {
+        logERR("received an unexpected connection from %s, closing it", peername);
+        return;
+    }
+
+    /* The bundle stays around until we let go of this lock. */
+    auto_drainer_t::lock_t bundle_lock(&bundle->drainer);
+    bundle->conns[lane] = conn;
+    const threadnum_t lane_thread = bundle->threads[lane];
+
+    cross_thread_signal_t lane_drain_signal(bundle_lock.get_drain_signal(), lane_thread);
+    {
+        rethread_tcp_conn_stream_t unregister_conn(conn, INVALID_THREAD);
+        on_thread_t conn_threader(lane_thread);
+        rethread_tcp_conn_stream_t reregister_conn(conn, get_thread_id());
+
+        cluster_conn_closing_subscription_t conn_closer(conn);
+        conn_closer.reset(&lane_drain_signal);
+
+        {
+            on_thread_t threader(rpc_thread);
+            bundle->on_lane_ready();
+            wait_any_t waiter(&bundle->started, bundle_lock.get_drain_signal());
+            waiter.wait_lazily_unordered();
+        }
+
+        /* This is the same as the message-handling loop in `handle()`. */
+        message_decompressor_t decompressor(bundle->compression);
+        try {
+            while (true) {
+                counted_t<data_buffer_t> message;
+                if (check_archive_result(decompressor.read(conn, &message), peername))
+                    break;
+
+                data_buffer_read_stream_t stream(message, 0);
+                message_handler->on_message(peer, &stream); // might raise fake_archive_exc_t
+                coro_t::yield();
+            }
+        } catch (const fake_archive_exc_t &) {
+            /* Same as in `handle()` */
+        }
+
+        /* Tear down the rest of the connections to the peer. (This does
+        nothing if they are already going away.) */
+        {
+            on_thread_t threader(rpc_thread);
+            bundle->failed.pulse_if_not_already_pulsed();
+        }
+    }
+
+    /* The peer's `connection_entry_t` may still be sending messages over
+    `conn`, so we can't let our caller destroy it before the bundle is gone. */
+    bundle_lock.get_drain_signal()->wait_lazily_unordered();
+}
+
 connectivity_cluster_t::connectivity_cluster_t() THROWS_NOTHING :
     me(peer_id_t(generate_uuid())),
     current_run(NULL),
@@ -913,37 +1185,48 @@ void connectivity_cluster_t::send_message(peer_id_t dest, send_message_write_cal
     }
 
     size_t bytes_sent = buffer.str().size();
+    size_t wire_bytes_sent = bytes_sent;
 
     if (conn_structure->conn == NULL) {
         // We're sending a message to ourself
         guarantee(dest == me);
         // We could be on any thread here! Oh no!
-        string_read_stream_t read_stream(std::move(buffer.str()), 0);
+        counted_t<data_buffer_t> message = data_buffer_t::create(buffer.str().size());
+        memcpy(message->buf(), buffer.str().data(), buffer.str().size());
+        data_buffer_read_stream_t read_stream(message, 0);
         current_run->message_handler->on_message(me, &read_stream);
     } else {
         guarantee(dest != me);
-        on_thread_t threader(conn_structure->conn->home_thread());
+        run_t::connection_entry_t::lane_t *lane =
+            conn_structure->get_lane(callback->get_ordering_key());
+        on_thread_t threader(lane->conn->home_thread());
 
-        /* Acquire the send-mutex so we don't collide with other things trying
-        to send on the same connection. */
-        mutex_t::acq_t acq(&conn_structure->send_mutex);
+        /* Wait for our turn, so we don't collide with other things trying to
+        send on the same connection. */
+        send_scheduler_t::acq_t acq(&lane->send_scheduler,
+                                    callback->get_message_class(), bytes_sent);
 
         {
             write_message_t msg;
-            msg << buffer.str();
-            int res = send_write_message(conn_structure->conn, &msg);
+            lane->compressor.append(buffer.str(), &msg);
+            wire_bytes_sent = msg.size();
+            int res = send_write_message(lane->conn, &msg);
             if (res) {
                 /* Close the other half of the connection to make sure that
                    `connectivity_cluster_t::run_t::handle()` notices that something is
                    up */
-                if (conn_structure->conn->is_read_open()) {
-                    conn_structure->conn->shutdown_read();
+                if (lane->conn->is_read_open()) {
+                    lane->conn->shutdown_read();
                 }
             }
         }
+
+        lane->pm_bytes_sent.record(bytes_sent);
+        lane->pm_wire_bytes_sent.record(wire_bytes_sent);
     }
 
     conn_structure->pm_bytes_sent.record(bytes_sent);
+    conn_structure->pm_wire_bytes_sent.record(wire_bytes_sent);
 }
 
 void connectivity_cluster_t::kill_connection(peer_id_t peer) THROWS_NOTHING {
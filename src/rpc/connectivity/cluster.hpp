@@ -8,16 +8,22 @@
 #include <utility>
 #include <vector>
 
+#include "errors.hpp"
+#include <boost/ptr_container/ptr_vector.hpp>
+
 #include "arch/types.hpp"
 #include "concurrency/auto_drainer.hpp"
+#include "concurrency/cond_var.hpp"
 #include "concurrency/one_per_thread.hpp"
 #include "concurrency/semaphore.hpp"
 #include "containers/archive/tcp_conn_stream.hpp"
 #include "containers/map_sentries.hpp"
 #include "perfmon/perfmon.hpp"
+#include "rpc/connectivity/compression.hpp"
 #include "rpc/connectivity/connectivity.hpp"
 #include "rpc/connectivity/messages.hpp"
 #include "rpc/connectivity/heartbeat.hpp"
+#include "rpc/connectivity/send_scheduler.hpp"
 #include "containers/uuid.hpp"
 
 namespace boost {
@@ -74,7 +80,10 @@ public:
               int port,
               message_handler_t *message_handler,
               int client_port,
-              heartbeat_manager_t *_heartbeat_manager) THROWS_ONLY(address_in_use_exc_t);
+              heartbeat_manager_t *_heartbeat_manager,
+              int connections_per_peer = 1,
+              const cluster_compression_config_t &compression_config
+                  = cluster_compression_config_t()) THROWS_ONLY(address_in_use_exc_t);
 
         ~run_t();
 
@@ -92,12 +101,50 @@ public:
         class connection_entry_t : public home_thread_mixin_debug_only_t {
         public:
             /* The constructor registers us in every thread's `connection_map`;
-            the destructor deregisters us. Both also notify all subscribers. */
-            connection_entry_t(run_t *, peer_id_t, tcp_conn_stream_t *,
-                               const peer_address_t &peer) THROWS_NOTHING;
+            the destructor deregisters us. Both also notify all subscribers.
+            `conns` are all of the TCP connections to the peer, starting with
+            the one that `handle()` was called for; it's empty for our
+            "connection" to ourself. Messages sent over them are compressed with
+            `compression`. */
+            connection_entry_t(run_t *, peer_id_t,
+                               const std::vector<tcp_conn_stream_t *> &conns,
+                               const peer_address_t &peer,
+                               cluster_compression_t compression) THROWS_NOTHING;
             ~connection_entry_t() THROWS_NOTHING;
 
-            /* NULL for our "connection" to ourself */
+            /* One of the TCP connections to the peer. Each one lives on its own
+            thread. */
+            class lane_t {
+            public:
+                lane_t(perfmon_collection_t *parent_collection, size_t index,
+                       tcp_conn_stream_t *conn, cluster_compression_t compression);
+
+                tcp_conn_stream_t *conn;
+                /* Decides which of the messages waiting to be sent goes
+                next. */
+                send_scheduler_t send_scheduler;
+                /* Only used while holding `send_scheduler`, so that messages
+                are compressed in the order they are sent in. */
+                message_compressor_t compressor;
+
+                perfmon_collection_t pm_collection;
+                /* `pm_bytes_sent` counts the bytes of the messages;
+                `pm_wire_bytes_sent` counts what they took up on the wire once
+                compressed. */
+                perfmon_sampler_t pm_bytes_sent, pm_wire_bytes_sent;
+                perfmon_membership_t pm_collection_membership, pm_bytes_sent_membership,
+                    pm_wire_bytes_sent_membership;
+
+            private:
+                DISABLE_COPYING(lane_t);
+            };
+
+            /* Picks the connection for a message with the given ordering key.
+            Messages without a key use the first connection. */
+            lane_t *get_lane(uint64_t ordering_key);
+
+            /* NULL for our "connection" to ourself; otherwise the same as
+            `lanes[0].conn`. */
             tcp_conn_stream_t *conn;
 
             /* `connection_t` contains the addresses so that we can call
@@ -105,14 +152,15 @@ public:
             cross-thread to access the routing table. */
             peer_address_t address;
 
-            /* Unused for our connection to ourself */
-            mutex_t send_mutex;
-
             uuid_u session_id;
 
             perfmon_collection_t pm_collection;
-            perfmon_sampler_t pm_bytes_sent;
-            perfmon_membership_t pm_collection_membership, pm_bytes_sent_membership;
+            perfmon_sampler_t pm_bytes_sent, pm_wire_bytes_sent;
+            perfmon_membership_t pm_collection_membership, pm_bytes_sent_membership,
+                pm_wire_bytes_sent_membership;
+
+            /* Empty for our connection to ourself */
+            boost::ptr_vector<lane_t> lanes;
 
         private:
             /* We only hold this information so we can deregister ourself */
@@ -155,11 +203,57 @@ public:
             DISABLE_COPYING(variable_setter_t);
         };
 
+        /* While the first connection to a peer is being set up, the extra
+        connections to the same peer gather in a `lane_bundle_t`. Once all of
+        them have arrived, each one moves to its own thread and the peer is
+        registered. The extra connections' coroutines (see `handle_lane()`)
+        read messages off them until the bundle is destroyed; if one of them
+        dies, `failed` is pulsed and the whole peer connection is torn down.
+        Everything but `threads` and the connections themselves is only used
+        on the `run_t`'s thread. */
+        class lane_bundle_t {
+        public:
+            lane_bundle_t(int num_lanes, threadnum_t first_thread,
+                          cluster_compression_t compression);
+
+            int num_lanes() const { return conns.size(); }
+            void on_lane_ready();
+
+            /* `conns[0]` is the connection `handle()` was called for. */
+            std::vector<tcp_conn_stream_t *> conns;
+            std::vector<threadnum_t> threads;
+
+            /* Negotiated over the first connection; all of them use it. */
+            const cluster_compression_t compression;
+
+            int num_ready;
+            cond_t all_ready;
+            /* Pulsed once the peer is registered, so that we can reply to the
+            messages that come in over the extra connections. */
+            cond_t started;
+            cond_t failed;
+
+            /* Held by the extra connections' coroutines. Destroyed first. */
+            auto_drainer_t drainer;
+
+        private:
+            DISABLE_COPYING(lane_bundle_t);
+        };
+
         void on_new_connection(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn, auto_drainer_t::lock_t lock) THROWS_NOTHING;
 
         /* `connectivity_cluster_t::connect_to_peer` is spawned for each known
         ip address of a peer which we want to connect to, all but one should
         fail */
+        /* Opens the `lane`th connection to a peer that we're connecting to,
+        at the address that worked for the first connection. */
+        void connect_lane(ip_and_port_t addr,
+                          peer_id_t peer,
+                          int lane,
+                          lane_bundle_t *bundle,
+                          auto_drainer_t::lock_t bundle_lock,
+                          auto_drainer_t::lock_t drainer_lock) THROWS_NOTHING;
+
         void connect_to_peer(const peer_address_t *addr,
                              int index,
                              boost::optional<peer_id_t> expected_id,
@@ -187,19 +281,39 @@ public:
         It handles the handshake, exchanging node maps, sending out the
         connect-notification, receiving messages from the peer until it
         disconnects or we are shut down, and sending out the
-        disconnect-notification. */
+        disconnect-notification. `connected_to` is the address we connected
+        to, or NULL if the peer connected to us; `lane` is nonzero if this is
+        one of the extra connections to a peer. */
         void handle(keepalive_tcp_conn_stream_t *c,
             boost::optional<peer_id_t> expected_id,
             boost::optional<peer_address_t> expected_address,
+            const ip_and_port_t *connected_to,
+            int lane,
             auto_drainer_t::lock_t,
             bool *successful_join) THROWS_NOTHING;
 
+        /* Adds an extra connection to the bundle of the peer's first
+        connection, and reads messages off it for as long as that lasts. */
+        void handle_lane(keepalive_tcp_conn_stream_t *c,
+                         peer_id_t peer,
+                         int lane,
+                         const char *peername,
+                         auto_drainer_t::lock_t) THROWS_NOTHING;
+
         connectivity_cluster_t *parent;
 
         message_handler_t *message_handler;
 
         heartbeat_manager_t *heartbeat_manager;
 
+        /* How many TCP connections we open to each peer. We use as many as
+        both sides allow. */
+        const int connections_per_peer;
+
+        /* How we'd like our connections to be compressed. The two ends of a
+        connection agree on the lesser compression either of them asks for. */
+        const cluster_compression_config_t compression_config;
+
         /* `attempt_table` is a table of all the host:port pairs we're currently
         trying to connect to or have connected to. If we are told to connect to
         an address already in this table, we'll just ignore it. That's important
@@ -215,6 +329,11 @@ public:
         `parent->thread_info.get()->connection_map`. */
         std::map<peer_id_t, peer_address_t> routing_table;
 
+        /* The bundles of the peers whose connections are being set up or are
+        up. Entries are added right after the peer is added to
+        `routing_table`, so the extra connections always find them. */
+        std::map<peer_id_t, lane_bundle_t *> lane_bundles;
+
         /* Writes to `routing_table` are protected by this mutex so we never get
         redundant connections to the same peer. */
         mutex_t new_connection_mutex;
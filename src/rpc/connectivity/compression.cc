@@ -0,0 +1,361 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "rpc/connectivity/compression.hpp"
+
+#include <limits.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <limits>
+#include <vector>
+
+#include "config/args.hpp"
+#include "containers/archive/stl_types.hpp"
+#include "containers/archive/varint.hpp"
+
+bool parse_cluster_compression(const std::string &str, cluster_compression_t *out) {
+    if (str == "none") {
+        *out = CLUSTER_COMPRESSION_NONE;
+    } else if (str == "fast") {
+        *out = CLUSTER_COMPRESSION_FAST;
+    } else if (str == "strong") {
+        *out = CLUSTER_COMPRESSION_STRONG;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/* Each message on a compressed connection starts with one of these. A
+compressed message is followed by its uncompressed size and then by the
+compressed data; a raw one just by the data. */
+enum message_format_t {
+    MESSAGE_FORMAT_RAW = 0,
+    MESSAGE_FORMAT_COMPRESSED = 1
+};
+
+/* Neither compressor can expand its input by more than this factor, so we
+don't believe a peer that claims otherwise and try to allocate a huge
+buffer. */
+static const uint64_t max_compression_ratio = 1032;
+
+message_compressor_t::message_compressor_t(cluster_compression_t _compression)
+    : compression(_compression) {
+    if (compression == CLUSTER_COMPRESSION_STRONG) {
+        deflater.init(new z_stream_s);
+        memset(deflater.get(), 0, sizeof(z_stream_s));
+        int res = deflateInit(deflater.get(), Z_DEFAULT_COMPRESSION);
+        guarantee(res == Z_OK, "deflateInit() failed: %d", res);
+    }
+}
+
+message_compressor_t::~message_compressor_t() {
+    if (deflater.has()) {
+        deflateEnd(deflater.get());
+    }
+}
+
+void message_compressor_t::append(const std::string &message, write_message_t *msg) {
+    if (compression == CLUSTER_COMPRESSION_NONE) {
+        *msg << message;
+        return;
+    }
+
+    if (message.size() < CLUSTER_COMPRESSION_MIN_SIZE || message.size() > UINT_MAX) {
+        *msg << static_cast<int8_t>(MESSAGE_FORMAT_RAW);
+        *msg << message;
+        return;
+    }
+
+    if (compression == CLUSTER_COMPRESSION_FAST) {
+        lz_compress(message.data(), message.size(), &buffer);
+        if (buffer.size() >= message.size()) {
+            *msg << static_cast<int8_t>(MESSAGE_FORMAT_RAW);
+            *msg << message;
+            return;
+        }
+    } else {
+        /* The `Z_SYNC_FLUSH` makes the peer's inflater produce all of the
+        message without seeing the next one. The deflater's state carries over,
+        though, so that later messages can refer back to this one. */
+        rassert(compression == CLUSTER_COMPRESSION_STRONG);
+        deflater->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(message.data()));
+        deflater->avail_in = message.size();
+        buffer.clear();
+        do {
+            size_t old_size = buffer.size();
+            size_t chunk_size = message.size() / 2 + 64;
+            buffer.resize(old_size + chunk_size);
+            deflater->next_out = reinterpret_cast<Bytef *>(&buffer[old_size]);
+            deflater->avail_out = chunk_size;
+            int res = deflate(deflater.get(), Z_SYNC_FLUSH);
+            guarantee(res == Z_OK || res == Z_BUF_ERROR, "deflate() failed: %d", res);
+            buffer.resize(old_size + chunk_size - deflater->avail_out);
+        } while (deflater->avail_out == 0);
+        rassert(deflater->avail_in == 0);
+    }
+
+    *msg << static_cast<int8_t>(MESSAGE_FORMAT_COMPRESSED);
+    *msg << static_cast<uint64_t>(message.size());
+    *msg << buffer;
+}
+
+message_decompressor_t::message_decompressor_t(cluster_compression_t _compression)
+    : compression(_compression) {
+    if (compression == CLUSTER_COMPRESSION_STRONG) {
+        inflater.init(new z_stream_s);
+        memset(inflater.get(), 0, sizeof(z_stream_s));
+        int res = inflateInit(inflater.get());
+        guarantee(res == Z_OK, "inflateInit() failed: %d", res);
+    }
+}
+
+message_decompressor_t::~message_decompressor_t() {
+    if (inflater.has()) {
+        inflateEnd(inflater.get());
+    }
+}
+
+static bool inflate_message(z_stream_s *z, const std::string &in, char *out, size_t out_size) {
+    z->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in.data()));
+    z->avail_in = in.size();
+    z->next_out = reinterpret_cast<Bytef *>(out);
+    z->avail_out = out_size;
+    while (z->avail_in > 0 && z->avail_out > 0) {
+        if (inflate(z, Z_SYNC_FLUSH) != Z_OK) {
+            return false;
+        }
+    }
+    if (z->avail_out > 0) {
+        return false;
+    }
+
+    /* The flush marker at the end of the message produces no output, but
+    `inflate()` may have stopped before it once the output was full. */
+    char spill;
+    while (z->avail_in > 0) {
+        z->next_out = reinterpret_cast<Bytef *>(&spill);
+        z->avail_out = 1;
+        if (inflate(z, Z_SYNC_FLUSH) != Z_OK || z->avail_out == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Reads a message that was serialized as a `std::string` straight into a
+`data_buffer_t`, so that it's only copied once on its way off the wire. */
+static archive_result_t read_raw_message(read_stream_t *s, counted_t<data_buffer_t> *message_out) {
+    uint64_t size;
+    archive_result_t res = deserialize_varint_uint64(s, &size);
+    if (res != ARCHIVE_SUCCESS) {
+        return res;
+    }
+    if (size > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+        return ARCHIVE_RANGE_ERROR;
+    }
+
+    *message_out = data_buffer_t::create(size);
+    int64_t num_read = force_read(s, (*message_out)->buf(), size);
+    if (num_read == -1) {
+        return ARCHIVE_SOCK_ERROR;
+    }
+    if (static_cast<uint64_t>(num_read) < size) {
+        return ARCHIVE_SOCK_EOF;
+    }
+    return ARCHIVE_SUCCESS;
+}
+
+archive_result_t message_decompressor_t::read(read_stream_t *s, counted_t<data_buffer_t> *message_out) {
+    if (compression == CLUSTER_COMPRESSION_NONE) {
+        return read_raw_message(s, message_out);
+    }
+
+    int8_t format;
+    archive_result_t res = deserialize(s, &format);
+    if (res != ARCHIVE_SUCCESS) {
+        return res;
+    }
+    if (format == MESSAGE_FORMAT_RAW) {
+        return read_raw_message(s, message_out);
+    } else if (format != MESSAGE_FORMAT_COMPRESSED) {
+        return ARCHIVE_RANGE_ERROR;
+    }
+
+    uint64_t size;
+    res = deserialize(s, &size);
+    if (res != ARCHIVE_SUCCESS) {
+        return res;
+    }
+    res = deserialize(s, &buffer);
+    if (res != ARCHIVE_SUCCESS) {
+        return res;
+    }
+    if (size > buffer.size() * max_compression_ratio + CLUSTER_COMPRESSION_MIN_SIZE
+        || buffer.size() > UINT_MAX) {
+        return ARCHIVE_RANGE_ERROR;
+    }
+
+    *message_out = data_buffer_t::create(size);
+    bool ok;
+    if (compression == CLUSTER_COMPRESSION_FAST) {
+        ok = lz_decompress(buffer.data(), buffer.size(), (*message_out)->buf(), size);
+    } else {
+        rassert(compression == CLUSTER_COMPRESSION_STRONG);
+        ok = inflate_message(inflater.get(), buffer, (*message_out)->buf(), size);
+    }
+    return ok ? ARCHIVE_SUCCESS : ARCHIVE_RANGE_ERROR;
+}
+
+/* `lz_compress()` and `lz_decompress()` use the LZ4 block format: a series of
+sequences, each of which is a token byte, some literal bytes, and a match that
+copies earlier output. The token's high four bits are the number of literals and
+its low four bits the length of the match minus `lz_min_match`; either one is 15
+if more length bytes follow. The last sequence has no match. */
+static const size_t lz_min_match = 4;
+// The last match has to start this many bytes before the end of the input...
+static const size_t lz_match_start_limit = 12;
+// ... and end this many bytes before it.
+static const size_t lz_last_literals = 5;
+static const size_t lz_max_offset = 65535;
+static const int lz_hash_bits = 12;
+
+static uint32_t lz_read32(const char *p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static size_t lz_hash(uint32_t value) {
+    return (value * 2654435761U) >> (32 - lz_hash_bits);
+}
+
+static void lz_write_length(size_t length, std::string *out) {
+    for (; length >= 255; length -= 255) {
+        out->push_back(static_cast<char>(255));
+    }
+    out->push_back(static_cast<char>(length));
+}
+
+// A `match_length` of 0 means that this is the last sequence.
+static void lz_write_sequence(const char *literals, size_t num_literals,
+                              size_t offset, size_t match_length, std::string *out) {
+    size_t token_pos = out->size();
+    out->push_back(0);
+    uint8_t token;
+    if (num_literals >= 15) {
+        token = 15 << 4;
+        lz_write_length(num_literals - 15, out);
+    } else {
+        token = num_literals << 4;
+    }
+    out->append(literals, num_literals);
+    if (match_length > 0) {
+        out->push_back(static_cast<char>(offset & 0xff));
+        out->push_back(static_cast<char>(offset >> 8));
+        size_t length = match_length - lz_min_match;
+        if (length >= 15) {
+            token |= 15;
+            lz_write_length(length - 15, out);
+        } else {
+            token |= length;
+        }
+    }
+    (*out)[token_pos] = static_cast<char>(token);
+}
+
+void lz_compress(const char *in, size_t in_size, std::string *out) {
+    out->clear();
+    out->reserve(in_size + in_size / 255 + 16);
+    size_t anchor = 0;
+    if (in_size > lz_match_start_limit) {
+        // The last position each hashed four bytes were seen at.
+        std::vector<size_t> table(1 << lz_hash_bits, 0);
+        const size_t match_start_end = in_size - lz_match_start_limit;
+        const size_t match_end = in_size - lz_last_literals;
+        size_t pos = 0;
+        // Skip ahead faster the longer we go without finding a match.
+        size_t misses = 0;
+        while (pos < match_start_end) {
+            uint32_t sequence = lz_read32(in + pos);
+            size_t *entry = &table[lz_hash(sequence)];
+            size_t candidate = *entry;
+            *entry = pos;
+            if (candidate < pos && pos - candidate <= lz_max_offset
+                && lz_read32(in + candidate) == sequence) {
+                size_t length = lz_min_match;
+                while (pos + length < match_end && in[candidate + length] == in[pos + length]) {
+                    ++length;
+                }
+                lz_write_sequence(in + anchor, pos - anchor, pos - candidate, length, out);
+                pos += length;
+                anchor = pos;
+                misses = 0;
+            } else {
+                pos += 1 + (misses++ >> 6);
+            }
+        }
+    }
+    lz_write_sequence(in + anchor, in_size - anchor, 0, 0, out);
+}
+
+static bool lz_read_length(const uint8_t **p, const uint8_t *end, size_t *length) {
+    uint8_t byte;
+    do {
+        if (*p == end || *length > std::numeric_limits<size_t>::max() - 255) {
+            return false;
+        }
+        byte = *(*p)++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool lz_decompress(const char *in, size_t in_size, char *out, size_t out_size) {
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(in);
+    const uint8_t *const end = p + in_size;
+    size_t out_pos = 0;
+    while (true) {
+        if (p == end) {
+            return false;
+        }
+        uint8_t token = *p++;
+
+        size_t num_literals = token >> 4;
+        if (num_literals == 15 && !lz_read_length(&p, end, &num_literals)) {
+            return false;
+        }
+        if (num_literals > static_cast<size_t>(end - p)
+            || num_literals > out_size - out_pos) {
+            return false;
+        }
+        memcpy(out + out_pos, p, num_literals);
+        p += num_literals;
+        out_pos += num_literals;
+        if (p == end) {
+            return out_pos == out_size;
+        }
+
+        if (end - p < 2) {
+            return false;
+        }
+        size_t offset = p[0] | (p[1] << 8);
+        p += 2;
+        if (offset == 0 || offset > out_pos) {
+            return false;
+        }
+        size_t match_length = token & 15;
+        if (match_length == 15 && !lz_read_length(&p, end, &match_length)) {
+            return false;
+        }
+        match_length += lz_min_match;
+        if (match_length > out_size - out_pos) {
+            return false;
+        }
+        // The match may overlap the bytes it produces, so copy byte by byte.
+        const char *from = out + out_pos - offset;
+        for (size_t i = 0; i < match_length; ++i) {
+            out[out_pos + i] = from[i];
+        }
+        out_pos += match_length;
+    }
+}
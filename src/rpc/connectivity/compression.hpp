@@ -0,0 +1,94 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef RPC_CONNECTIVITY_COMPRESSION_HPP_
+#define RPC_CONNECTIVITY_COMPRESSION_HPP_
+
+#include <string>
+
+#include "errors.hpp"
+#include <boost/function.hpp>
+
+#include "containers/archive/archive.hpp"
+#include "containers/data_buffer.hpp"
+#include "containers/scoped.hpp"
+#include "containers/uuid.hpp"
+
+struct z_stream_s;
+
+/* How the messages sent over an intra-cluster connection are compressed.
+`FAST` is an LZ4-style compressor that compresses each message on its own; it
+costs little CPU and is meant for fast links. `STRONG` runs all of the messages
+sent over a connection through one deflate stream, so that messages can refer
+back to earlier ones; it is meant for slow links, such as ones between
+datacenters. The values are ordered: when the two ends of a connection want
+different kinds of compression, they use the lesser of the two. */
+enum cluster_compression_t {
+    CLUSTER_COMPRESSION_NONE = 0,
+    CLUSTER_COMPRESSION_FAST = 1,
+    CLUSTER_COMPRESSION_STRONG = 2
+};
+
+// Parses "none", "fast" or "strong". Returns false for anything else.
+MUST_USE bool parse_cluster_compression(const std::string &str,
+                                        cluster_compression_t *out);
+
+/* Which compression a node wants for its connections. Connections between two
+nodes in the same datacenter use `same_datacenter`; all others, including those
+to nodes that aren't in a datacenter, use `other_datacenters`. */
+struct cluster_compression_config_t {
+    cluster_compression_config_t()
+        : same_datacenter(CLUSTER_COMPRESSION_NONE),
+          other_datacenters(CLUSTER_COMPRESSION_NONE) { }
+
+    cluster_compression_t same_datacenter;
+    cluster_compression_t other_datacenters;
+
+    /* Returns the datacenter this node is in, or a nil uuid if it isn't in one.
+    It's called on the thread that accepts cluster connections. If it's empty,
+    the node isn't in a datacenter. */
+    boost::function<uuid_u()> get_datacenter;
+};
+
+/* Frames and compresses the messages sent over one connection. Messages must be
+appended in the order they will be sent in, because `STRONG` keeps state from
+one message to the next. */
+class message_compressor_t {
+public:
+    explicit message_compressor_t(cluster_compression_t compression);
+    ~message_compressor_t();
+
+    // Appends `message` to `msg`, compressed if it's big enough to bother.
+    void append(const std::string &message, write_message_t *msg);
+
+private:
+    const cluster_compression_t compression;
+    scoped_ptr_t<z_stream_s> deflater;
+    std::string buffer;
+
+    DISABLE_COPYING(message_compressor_t);
+};
+
+/* Reads the messages written by a `message_compressor_t` with the same
+compression back off of a connection. Each message is read into a buffer of its
+own, which the values deserialized from it may keep references into. */
+class message_decompressor_t {
+public:
+    explicit message_decompressor_t(cluster_compression_t compression);
+    ~message_decompressor_t();
+
+    MUST_USE archive_result_t read(read_stream_t *s, counted_t<data_buffer_t> *message_out);
+
+private:
+    const cluster_compression_t compression;
+    scoped_ptr_t<z_stream_s> inflater;
+    std::string buffer;
+
+    DISABLE_COPYING(message_decompressor_t);
+};
+
+/* An LZ4-style block compressor. `lz_compress()` replaces the contents of
+`out`. `lz_decompress()` fails unless `in` decompresses to exactly `out_size`
+bytes. */
+void lz_compress(const char *in, size_t in_size, std::string *out);
+MUST_USE bool lz_decompress(const char *in, size_t in_size, char *out, size_t out_size);
+
+#endif  // RPC_CONNECTIVITY_COMPRESSION_HPP_
@@ -39,13 +39,14 @@ private:
     void on_timer();
 
     // This is a stub, we do everything in message_from_peer instead
-    void on_message(UNUSED peer_id_t source_peer, UNUSED string_read_stream_t *stream) { }
+    void on_message(UNUSED peer_id_t source_peer, UNUSED data_buffer_read_stream_t *stream) { }
     void send_message_wrapper(const peer_id_t source_peer, UNUSED auto_drainer_t::lock_t keepalive);
     void kill_connection_wrapper(const peer_id_t source_peer, UNUSED auto_drainer_t::lock_t keepalive);
 
     class heartbeat_writer_t : public send_message_write_callback_t {
     public:
         void write(UNUSED write_stream_t *stream) { }
+        message_class_t get_message_class() const { return MESSAGE_CLASS_HEARTBEAT; }
     };
 
     struct per_thread_data_t {
@@ -6,6 +6,7 @@ class connectivity_service_t;
 class peer_id_t;
 class write_stream_t;
 
+#include "containers/archive/data_buffer_stream.hpp"
 #include "containers/archive/string_stream.hpp"
 
 namespace boost {
@@ -46,10 +47,30 @@ no further messages are delivered. This gives a natural way to make sure that no
 messages are still being delivered at the time that the `application_t`
 destructor is called. */
 
+/* What a message is for. When several messages are waiting to go out over the
+same connection, heartbeats go first and the others share the connection by
+weight (see `CLUSTER_*_MESSAGE_WEIGHT` in `config/args.hpp`), so that one kind
+of traffic can't hold up the rest. */
+enum message_class_t {
+    MESSAGE_CLASS_HEARTBEAT = 0,
+    MESSAGE_CLASS_QUERY,
+    MESSAGE_CLASS_REPLICATION,
+    MESSAGE_CLASS_METADATA,
+    MESSAGE_CLASS_BACKFILL,
+    NUM_MESSAGE_CLASSES
+};
+
 class send_message_write_callback_t {
 public:
     virtual ~send_message_write_callback_t() { }
     virtual void write(write_stream_t *stream) = 0;
+
+    /* Messages with the same ordering key go over the same connection, so they
+    arrive in the order in which they were sent. Messages with different keys
+    may be spread over several connections to the same peer. */
+    virtual uint64_t get_ordering_key() const { return 0; }
+
+    virtual message_class_t get_message_class() const { return MESSAGE_CLASS_QUERY; }
 };
 
 class message_service_t  {
@@ -63,7 +84,7 @@ protected:
 
 class message_handler_t {
 public:
-    virtual void on_message(peer_id_t source_peer, string_read_stream_t *) = 0;
+    virtual void on_message(peer_id_t source_peer, data_buffer_read_stream_t *) = 0;
 protected:
     virtual ~message_handler_t() { }
 };
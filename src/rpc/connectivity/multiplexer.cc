@@ -28,7 +28,7 @@ message_multiplexer_t::run_t::~run_t() {
     parent->run = NULL;
 }
 
-void message_multiplexer_t::run_t::on_message(peer_id_t source, string_read_stream_t *stream) {
+void message_multiplexer_t::run_t::on_message(peer_id_t source, data_buffer_read_stream_t *stream) {
     tag_t tag;
     archive_result_t res = deserialize(stream, &tag);
     if (res) { throw fake_archive_exc_t(); }
@@ -87,6 +87,14 @@ public:
         subwriter->write(os);
     }
 
+    uint64_t get_ordering_key() const {
+        return subwriter->get_ordering_key();
+    }
+
+    message_class_t get_message_class() const {
+        return subwriter->get_message_class();
+    }
+
 private:
     message_multiplexer_t::tag_t tag;
     send_message_write_callback_t *subwriter;
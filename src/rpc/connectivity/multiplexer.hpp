@@ -39,7 +39,7 @@ public:
         explicit run_t(message_multiplexer_t *);
         ~run_t();
     private:
-        void on_message(peer_id_t, string_read_stream_t *);
+        void on_message(peer_id_t, data_buffer_read_stream_t *);
         message_multiplexer_t *const parent;
     };
     class client_t : public message_service_t {
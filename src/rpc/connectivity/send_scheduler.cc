@@ -0,0 +1,80 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "rpc/connectivity/send_scheduler.hpp"
+
+#include <algorithm>
+
+#include "arch/runtime/coroutines.hpp"
+#include "config/args.hpp"
+
+static double message_class_weight(message_class_t message_class) {
+    switch (message_class) {
+    // Heartbeats don't wait for their turn, so their weight doesn't matter.
+    case MESSAGE_CLASS_HEARTBEAT: return CLUSTER_QUERY_MESSAGE_WEIGHT;
+    case MESSAGE_CLASS_QUERY: return CLUSTER_QUERY_MESSAGE_WEIGHT;
+    case MESSAGE_CLASS_REPLICATION: return CLUSTER_REPLICATION_MESSAGE_WEIGHT;
+    case MESSAGE_CLASS_METADATA: return CLUSTER_METADATA_MESSAGE_WEIGHT;
+    case MESSAGE_CLASS_BACKFILL: return CLUSTER_BACKFILL_MESSAGE_WEIGHT;
+    case NUM_MESSAGE_CLASSES:
+    default: unreachable();
+    }
+}
+
+send_scheduler_t::acq_t::acq_t(send_scheduler_t *_parent,
+                               message_class_t message_class,
+                               size_t size) :
+    parent(_parent) {
+    rassert(message_class >= 0 && message_class < NUM_MESSAGE_CLASSES);
+
+    double start_tag = std::max(parent->virtual_time,
+                                parent->last_finish_tags[message_class]);
+    parent->last_finish_tags[message_class] =
+        start_tag + std::max<size_t>(size, 1) / message_class_weight(message_class);
+
+    if (!parent->busy) {
+        parent->busy = true;
+        parent->virtual_time = start_tag;
+    } else {
+        parent->queues[message_class].push_back(waiter_t(coro_t::self(), start_tag));
+        // `release()` wakes us up when it's our turn, and leaves `busy` set.
+        coro_t::wait();
+    }
+}
+
+send_scheduler_t::acq_t::~acq_t() {
+    parent->release();
+}
+
+send_scheduler_t::send_scheduler_t() : busy(false), virtual_time(0) {
+    for (int i = 0; i < NUM_MESSAGE_CLASSES; ++i) {
+        last_finish_tags[i] = 0;
+    }
+}
+
+send_scheduler_t::~send_scheduler_t() {
+    rassert(!busy);
+}
+
+void send_scheduler_t::release() {
+    rassert(busy);
+
+    int next = -1;
+    if (!queues[MESSAGE_CLASS_HEARTBEAT].empty()) {
+        next = MESSAGE_CLASS_HEARTBEAT;
+    } else {
+        for (int i = 0; i < NUM_MESSAGE_CLASSES; ++i) {
+            if (!queues[i].empty()
+                && (next == -1 || queues[i].front().start_tag < queues[next].front().start_tag)) {
+                next = i;
+            }
+        }
+    }
+
+    if (next == -1) {
+        busy = false;
+    } else {
+        waiter_t waiter = queues[next].front();
+        queues[next].pop_front();
+        virtual_time = waiter.start_tag;
+        waiter.coro->notify_sometime();
+    }
+}
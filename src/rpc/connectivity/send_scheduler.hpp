@@ -0,0 +1,58 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef RPC_CONNECTIVITY_SEND_SCHEDULER_HPP_
+#define RPC_CONNECTIVITY_SEND_SCHEDULER_HPP_
+
+#include <deque>
+
+#include "rpc/connectivity/messages.hpp"
+#include "utils.hpp"
+
+class coro_t;
+
+/* `send_scheduler_t` is like a `mutex_t` for sending messages over one
+connection, except that it doesn't hand the connection out first come, first
+served. Each class of message waits in its own queue. Heartbeats go first;
+the other classes get turns in proportion to their weights and to the sizes of
+their messages (this is start-time fair queueing). So a backlog of backfill
+chunks can't hold up queries for long, and an idle class gets the connection
+right away.
+
+It only decides between messages; one that is already being sent isn't
+interrupted. Like `mutex_t`, it must only be used on one thread at a time. */
+class send_scheduler_t {
+public:
+    class acq_t {
+    public:
+        /* Blocks until it's the turn of a message of `message_class` that is
+        `size` bytes long. */
+        acq_t(send_scheduler_t *parent, message_class_t message_class, size_t size);
+        ~acq_t();
+    private:
+        send_scheduler_t *parent;
+        DISABLE_COPYING(acq_t);
+    };
+
+    send_scheduler_t();
+    ~send_scheduler_t();
+
+    bool is_busy() const { return busy; }
+
+private:
+    struct waiter_t {
+        waiter_t(coro_t *_coro, double _start_tag) : coro(_coro), start_tag(_start_tag) { }
+        coro_t *coro;
+        double start_tag;
+    };
+
+    void release();
+
+    bool busy;
+    /* The start tag of the message being sent, or of the last one. */
+    double virtual_time;
+    double last_finish_tags[NUM_MESSAGE_CLASSES];
+    std::deque<waiter_t> queues[NUM_MESSAGE_CLASSES];
+
+    DISABLE_COPYING(send_scheduler_t);
+};
+
+#endif  // RPC_CONNECTIVITY_SEND_SCHEDULER_HPP_
@@ -0,0 +1,105 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef RPC_DIRECTORY_DELTA_HPP_
+#define RPC_DIRECTORY_DELTA_HPP_
+
+#include <map>
+#include <vector>
+
+#include "containers/archive/archive.hpp"
+#include "containers/archive/stl_types.hpp"
+#include "containers/cow_ptr.hpp"
+
+/* `directory_write_manager_t` sends a peer our whole directory value when it
+connects, and after that just what changed. These functions say how to do that
+for each type:
+
+`serialize_directory_delta(msg, old_value, new_value)` writes something that
+`apply_directory_delta()` turns `old_value` into `new_value` with. The fallback
+writes all of `new_value`. `std::map` overloads it to leave out the entries that
+didn't change, so that one table's business card changing doesn't make us send
+everyone else's.
+
+`directory_value_unchanged(a, b)` says whether `a` and `b` are certainly the
+same. It has to be cheap, because it's called for every map entry; it may say
+`false` when it doesn't know, which just means we send more. The fallback
+always does. `cow_ptr_t` overloads it to compare pointers. That's only right
+because whoever calls it holds on to `a`: a `cow_ptr_t` only changes the object
+it points to in place if no one else points to it too, so as long as `a` is
+around, `b` pointing to the same object means that `b` hasn't changed. */
+
+template <class T>
+bool directory_value_unchanged(UNUSED const T &a, UNUSED const T &b) {
+    return false;
+}
+
+template <class T>
+bool directory_value_unchanged(const cow_ptr_t<T> &a, const cow_ptr_t<T> &b) {
+    return a.get() == b.get();
+}
+
+template <class T>
+void serialize_directory_delta(write_message_t *msg, UNUSED const T &old_value, const T &new_value) {
+    *msg << new_value;
+}
+
+template <class T>
+MUST_USE archive_result_t apply_directory_delta(read_stream_t *s, T *value) {
+    *value = T();
+    return deserialize(s, value);
+}
+
+template <class K, class V, class C>
+void serialize_directory_delta(write_message_t *msg, const std::map<K, V, C> &old_value,
+                               const std::map<K, V, C> &new_value) {
+    std::vector<K> erased;
+    for (typename std::map<K, V, C>::const_iterator it = old_value.begin(); it != old_value.end(); ++it) {
+        if (new_value.count(it->first) == 0) {
+            erased.push_back(it->first);
+        }
+    }
+    *msg << erased;
+
+    std::vector<typename std::map<K, V, C>::const_iterator> changed;
+    for (typename std::map<K, V, C>::const_iterator it = new_value.begin(); it != new_value.end(); ++it) {
+        typename std::map<K, V, C>::const_iterator old_it = old_value.find(it->first);
+        if (old_it == old_value.end() || !directory_value_unchanged(old_it->second, it->second)) {
+            changed.push_back(it);
+        }
+    }
+    *msg << static_cast<uint64_t>(changed.size());
+    for (size_t i = 0; i < changed.size(); ++i) {
+        *msg << changed[i]->first;
+        typename std::map<K, V, C>::const_iterator old_it = old_value.find(changed[i]->first);
+        if (old_it != old_value.end()) {
+            serialize_directory_delta(msg, old_it->second, changed[i]->second);
+        } else {
+            /* The peer starts new entries out default-constructed, so that's
+            what the delta has to be from. */
+            serialize_directory_delta(msg, V(), changed[i]->second);
+        }
+    }
+}
+
+template <class K, class V, class C>
+MUST_USE archive_result_t apply_directory_delta(read_stream_t *s, std::map<K, V, C> *value) {
+    std::vector<K> erased;
+    archive_result_t res = deserialize(s, &erased);
+    if (res) { return res; }
+    for (size_t i = 0; i < erased.size(); ++i) {
+        value->erase(erased[i]);
+    }
+
+    uint64_t num_changed;
+    res = deserialize(s, &num_changed);
+    if (res) { return res; }
+    for (uint64_t i = 0; i < num_changed; ++i) {
+        K key;
+        res = deserialize(s, &key);
+        if (res) { return res; }
+        res = apply_directory_delta(s, &(*value)[key]);
+        if (res) { return res; }
+    }
+    return ARCHIVE_SUCCESS;
+}
+
+#endif  // RPC_DIRECTORY_DELTA_HPP_
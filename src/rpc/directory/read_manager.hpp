@@ -3,6 +3,7 @@
 #define RPC_DIRECTORY_READ_MANAGER_HPP_
 
 #include <map>
+#include <string>
 
 #include "errors.hpp"
 #include <boost/ptr_container/ptr_map.hpp>
@@ -49,13 +50,13 @@ private:
 
     /* These will be called in a blocking fashion by the connectivity service
     (or message service, in the case of `on_message()`) */
-    void on_message(peer_id_t, string_read_stream_t *) THROWS_NOTHING;
+    void on_message(peer_id_t, data_buffer_read_stream_t *) THROWS_NOTHING;
     void on_connect(peer_id_t peer) THROWS_NOTHING;
     void on_disconnect(peer_id_t peer) THROWS_NOTHING;
 
     /* These are meant to be spawned in new coroutines */
     void propagate_initialization(peer_id_t peer, uuid_u session_id, metadata_t new_value, fifo_enforcer_state_t metadata_fifo_state, auto_drainer_t::lock_t per_thread_keepalive) THROWS_NOTHING;
-    void propagate_update(peer_id_t peer, uuid_u session_id, metadata_t new_value, fifo_enforcer_write_token_t metadata_fifo_token, auto_drainer_t::lock_t per_thread_keepalive) THROWS_NOTHING;
+    void propagate_update(peer_id_t peer, uuid_u session_id, std::string delta, fifo_enforcer_write_token_t metadata_fifo_token, auto_drainer_t::lock_t per_thread_keepalive) THROWS_NOTHING;
     void interrupt_updates_and_free_session(session_t *session, auto_drainer_t::lock_t global_keepalive) THROWS_NOTHING;
 
     /* The connectivity service telling us which peers are connected */
@@ -5,10 +5,14 @@
 #include "rpc/directory/read_manager.hpp"
 
 #include <map>
+#include <string>
 #include <utility>
 
 #include "concurrency/wait_any.hpp"
 #include "containers/archive/archive.hpp"
+#include "containers/archive/stl_types.hpp"
+#include "containers/archive/string_stream.hpp"
+#include "rpc/directory/delta.hpp"
 
 template<class metadata_t>
 directory_read_manager_t<metadata_t>::directory_read_manager_t(connectivity_service_t *conn_serv) THROWS_NOTHING :
@@ -33,7 +37,7 @@ void directory_read_manager_t<metadata_t>::on_connect(peer_id_t peer) THROWS_NOT
 }
 
 template<class metadata_t>
-void directory_read_manager_t<metadata_t>::on_message(peer_id_t source_peer, string_read_stream_t *s) THROWS_NOTHING {
+void directory_read_manager_t<metadata_t>::on_message(peer_id_t source_peer, data_buffer_read_stream_t *s) THROWS_NOTHING {
     uint8_t code = 0;
     {
         archive_result_t res = deserialize(s, &code);
@@ -65,12 +69,13 @@ void directory_read_manager_t<metadata_t>::on_message(peer_id_t source_peer, str
         }
 
         case 'U': {
-            /* Update from another peer */
-            metadata_t new_value = metadata_t();
+            /* Update from another peer. It's a delta from the peer's previous
+            value, so it can't be applied until we get there. */
+            std::string delta;
             fifo_enforcer_write_token_t metadata_fifo_token;
             {
-                archive_result_t res = deserialize(s, &new_value);
-                guarantee_deserialization(res, "metadata");
+                archive_result_t res = deserialize(s, &delta);
+                guarantee_deserialization(res, "metadata delta");
                 res = deserialize(s, &metadata_fifo_token);
                 guarantee_deserialization(res, "metadata fifo state");
 
@@ -82,7 +87,7 @@ void directory_read_manager_t<metadata_t>::on_message(peer_id_t source_peer, str
             coro_t::spawn_sometime(boost::bind(
                 &directory_read_manager_t::propagate_update, this,
                 source_peer, connectivity_service->get_connection_session_id(source_peer),
-                new_value, metadata_fifo_token,
+                delta, metadata_fifo_token,
                 auto_drainer_t::lock_t(per_thread_drainers.get())));
 
             break;
@@ -165,7 +170,7 @@ void directory_read_manager_t<metadata_t>::propagate_initialization(peer_id_t pe
 }
 
 template<class metadata_t>
-void directory_read_manager_t<metadata_t>::propagate_update(peer_id_t peer, uuid_u session_id, metadata_t new_value, fifo_enforcer_write_token_t metadata_fifo_token, auto_drainer_t::lock_t per_thread_keepalive) THROWS_NOTHING {
+void directory_read_manager_t<metadata_t>::propagate_update(peer_id_t peer, uuid_u session_id, std::string delta, fifo_enforcer_write_token_t metadata_fifo_token, auto_drainer_t::lock_t per_thread_keepalive) THROWS_NOTHING {
     per_thread_keepalive.assert_is_holding(per_thread_drainers.get());
     on_thread_t thread_switcher(home_thread());
 
@@ -210,7 +215,9 @@ void directory_read_manager_t<metadata_t>::propagate_update(peer_id_t peer, uuid
                 //The session was deleted we can ignore this update.
                 return;
             }
-            var_it->second = new_value;
+            string_read_stream_t stream(std::move(delta), 0);
+            archive_result_t res = apply_directory_delta(&stream, &var_it->second);
+            guarantee_deserialization(res, "metadata delta");
             variable.set_value(map);
         }
     } catch (const interrupted_exc_t &) {
@@ -2,13 +2,20 @@
 #ifndef RPC_DIRECTORY_WRITE_MANAGER_HPP_
 #define RPC_DIRECTORY_WRITE_MANAGER_HPP_
 
+#include <string>
+
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/fifo_enforcer.hpp"
 #include "concurrency/watchable.hpp"
+#include "perfmon/perfmon.hpp"
 #include "rpc/connectivity/connectivity.hpp"
 
 class message_service_t;
 
+/* `directory_write_manager_t` sends our directory value to our peers. A peer
+gets the whole value when it connects; after that, it gets updates that only
+carry what changed (see "rpc/directory/delta.hpp"). A change goes out right
+away, but changes that come close after an update are sent as one update. */
 template<class metadata_t>
 class directory_write_manager_t : private peers_list_callback_t {
 public:
@@ -17,20 +24,52 @@ public:
         const clone_ptr_t<watchable_t<metadata_t> > &value) THROWS_NOTHING;
     ~directory_write_manager_t();
 
+    /* How many updates we've sent, counting each one once no matter how many
+    peers it went to. Used in unit tests. */
+    int64_t get_num_updates_sent() const {
+        return num_updates_sent;
+    }
+
 private:
     void on_connect(peer_id_t peer) THROWS_NOTHING;
     void on_disconnect(UNUSED peer_id_t p) { }
     void on_change() THROWS_NOTHING;
 
+    void send_pending_update(auto_drainer_t::lock_t keepalive) THROWS_NOTHING;
+
     void send_initialization(peer_id_t peer, const metadata_t &initial_value, fifo_enforcer_state_t metadata_fifo_state, auto_drainer_t::lock_t keepalive) THROWS_NOTHING;
-    void send_update(peer_id_t peer, const metadata_t &new_value, fifo_enforcer_write_token_t metadata_fifo_token, auto_drainer_t::lock_t keepalive) THROWS_NOTHING;
+    void send_update(peer_id_t peer, const std::string &delta, fifo_enforcer_write_token_t metadata_fifo_token, auto_drainer_t::lock_t keepalive) THROWS_NOTHING;
 
     class initialization_writer_t;
     class update_writer_t;
 
     message_service_t *const message_service;
     clone_ptr_t<watchable_t<metadata_t> > value_watchable;
+
+    /* The value as of the last update we sent. New peers get this as their
+    initial value, and the next update is a delta from it. Holding on to it is
+    also what lets `directory_value_unchanged()` compare `cow_ptr_t`s by
+    pointer. */
+    metadata_t sent_value;
+
+    /* True if `value_watchable` has changed since we last sent an update and
+    `send_pending_update()` is about to send another one. */
+    bool update_pending;
+
+    /* When we sent the last update. Changes that come within
+    `DIRECTORY_UPDATE_COALESCE_MS` of it wait for the rest of that time. */
+    ticks_t last_update_time;
+    int64_t num_updates_sent;
+
     fifo_enforcer_source_t metadata_fifo_source;
+
+    perfmon_collection_t pm_collection;
+    /* How many bytes the messages we send to each peer take up, for initial
+    values and for updates. */
+    perfmon_sampler_t pm_initialization_bytes_sent, pm_update_bytes_sent;
+    perfmon_membership_t pm_collection_membership, pm_initialization_bytes_sent_membership,
+        pm_update_bytes_sent_membership;
+
     auto_drainer_t drainer;
     typename watchable_t<metadata_t>::subscription_t value_subscription;
     connectivity_service_t::peers_list_subscription_t connectivity_subscription;
@@ -5,9 +5,14 @@
 #include "rpc/directory/write_manager.hpp"
 
 #include <set>
+#include <string>
 
 #include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
+#include "config/args.hpp"
+#include "containers/archive/string_stream.hpp"
 #include "rpc/connectivity/messages.hpp"
+#include "rpc/directory/delta.hpp"
 
 template<class metadata_t>
 directory_write_manager_t<metadata_t>::directory_write_manager_t(
@@ -15,11 +20,20 @@ directory_write_manager_t<metadata_t>::directory_write_manager_t(
         const clone_ptr_t<watchable_t<metadata_t> > &value) THROWS_NOTHING :
     message_service(sub),
     value_watchable(value),
+    update_pending(false),
+    last_update_time(0),
+    num_updates_sent(0),
+    pm_initialization_bytes_sent(secs_to_ticks(1), true),
+    pm_update_bytes_sent(secs_to_ticks(1), true),
+    pm_collection_membership(&get_global_perfmon_collection(), &pm_collection, "directory"),
+    pm_initialization_bytes_sent_membership(&pm_collection, &pm_initialization_bytes_sent, "initialization_bytes_sent"),
+    pm_update_bytes_sent_membership(&pm_collection, &pm_update_bytes_sent, "update_bytes_sent"),
     value_subscription(boost::bind(&directory_write_manager_t::on_change, this)),
     connectivity_subscription(this) {
     typename watchable_t<metadata_t>::freeze_t value_freeze(value_watchable);
     connectivity_service_t::peers_list_freeze_t connectivity_freeze(message_service->get_connectivity_service());
     guarantee(message_service->get_connectivity_service()->get_peers_list().empty());
+    sent_value = value_watchable->get();
     value_subscription.reset(value_watchable, &value_freeze);
     connectivity_subscription.reset(message_service->get_connectivity_service(), &connectivity_freeze);
 }
@@ -29,28 +43,71 @@ directory_write_manager_t<metadata_t>::~directory_write_manager_t() { }
 
 template<class metadata_t>
 void directory_write_manager_t<metadata_t>::on_connect(peer_id_t peer) THROWS_NOTHING {
-    typename watchable_t<metadata_t>::freeze_t freeze(value_watchable);
+    /* Any changes since `sent_value` will reach the peer with the next
+    update. */
     coro_t::spawn_sometime(boost::bind(
         &directory_write_manager_t::send_initialization, this,
         peer,
-        value_watchable->get(), metadata_fifo_source.get_state(),
+        sent_value, metadata_fifo_source.get_state(),
         auto_drainer_t::lock_t(&drainer)));
 }
 
 template<class metadata_t>
 void directory_write_manager_t<metadata_t>::on_change() THROWS_NOTHING {
+    if (!update_pending) {
+        update_pending = true;
+        coro_t::spawn_sometime(boost::bind(
+            &directory_write_manager_t::send_pending_update, this,
+            auto_drainer_t::lock_t(&drainer)));
+    }
+}
+
+template<class metadata_t>
+void directory_write_manager_t<metadata_t>::send_pending_update(auto_drainer_t::lock_t keepalive) THROWS_NOTHING {
+    /* Changes tend to come in bursts, such as when a reactor goes through
+    several states in a row. The first change of a burst goes out right away;
+    the rest wait until a moment after it and go out together. */
+    ticks_t window_end = last_update_time + ms_to_ticks(DIRECTORY_UPDATE_COALESCE_MS);
+    ticks_t now = get_ticks();
+    if (now < window_end) {
+        try {
+            nap(ceil_divide(window_end - now, ms_to_ticks(1)), keepalive.get_drain_signal());
+        } catch (const interrupted_exc_t &) {
+            return;
+        }
+    }
+
     /* Acquire this lock to avoid the case where a new peer copies the metadata
     value after we change it but also gets an update sent. (That would lead to a
     crash on the receiving end because the receiving FIFO would get a duplicate
     update.) */
     connectivity_service_t::peers_list_freeze_t freeze(message_service->get_connectivity_service());
+    ASSERT_FINITE_CORO_WAITING;
+
+    update_pending = false;
+    metadata_t new_value = value_watchable->get();
+
+    /* Every peer gets the same delta, so we only serialize it once. */
+    std::string delta;
+    {
+        write_message_t msg;
+        serialize_directory_delta(&msg, sent_value, new_value);
+        string_stream_t stream;
+        int res = send_write_message(&stream, &msg);
+        guarantee(res == 0);
+        delta.swap(stream.str());
+    }
+    sent_value = new_value;
+    last_update_time = get_ticks();
+    ++num_updates_sent;
+
     fifo_enforcer_write_token_t metadata_fifo_token = metadata_fifo_source.enter_write();
     std::set<peer_id_t> peers = message_service->get_connectivity_service()->get_peers_list();
     for (std::set<peer_id_t>::iterator it = peers.begin(); it != peers.end(); it++) {
         coro_t::spawn_sometime(boost::bind(
             &directory_write_manager_t::send_update, this,
             *it,
-            value_watchable->get(), metadata_fifo_token,
+            delta, metadata_fifo_token,
             auto_drainer_t::lock_t(&drainer)));
     }
 }
@@ -58,8 +115,10 @@ void directory_write_manager_t<metadata_t>::on_change() THROWS_NOTHING {
 template <class metadata_t>
 class directory_write_manager_t<metadata_t>::initialization_writer_t : public send_message_write_callback_t {
 public:
-    initialization_writer_t(const metadata_t &_initial_value, fifo_enforcer_state_t _metadata_fifo_state) :
-        initial_value(_initial_value), metadata_fifo_state(_metadata_fifo_state) { }
+    initialization_writer_t(const metadata_t &_initial_value, fifo_enforcer_state_t _metadata_fifo_state,
+                            perfmon_sampler_t *_bytes_sent) :
+        initial_value(_initial_value), metadata_fifo_state(_metadata_fifo_state),
+        bytes_sent(_bytes_sent) { }
     ~initialization_writer_t() { }
 
     void write(write_stream_t *stream) {
@@ -68,48 +127,61 @@ public:
         msg << code;
         msg << initial_value;
         msg << metadata_fifo_state;
+        bytes_sent->record(msg.size());
         int res = send_write_message(stream, &msg);
         if (res) {
             throw fake_archive_exc_t();
         }
     }
+
+    message_class_t get_message_class() const {
+        return MESSAGE_CLASS_METADATA;
+    }
 private:
     const metadata_t &initial_value;
     fifo_enforcer_state_t metadata_fifo_state;
+    perfmon_sampler_t *bytes_sent;
 };
 
 template <class metadata_t>
 class directory_write_manager_t<metadata_t>::update_writer_t : public send_message_write_callback_t {
 public:
-    update_writer_t(const metadata_t &_new_value, fifo_enforcer_write_token_t _metadata_fifo_token) :
-        new_value(_new_value), metadata_fifo_token(_metadata_fifo_token) { }
+    update_writer_t(const std::string &_delta, fifo_enforcer_write_token_t _metadata_fifo_token,
+                    perfmon_sampler_t *_bytes_sent) :
+        delta(_delta), metadata_fifo_token(_metadata_fifo_token), bytes_sent(_bytes_sent) { }
     ~update_writer_t() { }
 
     void write(write_stream_t *stream) {
         write_message_t msg;
         uint8_t code = 'U';
         msg << code;
-        msg << new_value;
+        msg << delta;
         msg << metadata_fifo_token;
+        bytes_sent->record(msg.size());
         int res = send_write_message(stream, &msg);
         if (res) {
             throw fake_archive_exc_t();
         }
     }
+
+    message_class_t get_message_class() const {
+        return MESSAGE_CLASS_METADATA;
+    }
 private:
-    const metadata_t &new_value;
+    const std::string &delta;
     fifo_enforcer_write_token_t metadata_fifo_token;
+    perfmon_sampler_t *bytes_sent;
 };
 
 template<class metadata_t>
 void directory_write_manager_t<metadata_t>::send_initialization(peer_id_t peer, const metadata_t &initial_value, fifo_enforcer_state_t metadata_fifo_state, auto_drainer_t::lock_t) THROWS_NOTHING {
-    initialization_writer_t writer(initial_value, metadata_fifo_state);
+    initialization_writer_t writer(initial_value, metadata_fifo_state, &pm_initialization_bytes_sent);
     message_service->send_message(peer, &writer);
 }
 
 template<class metadata_t>
-void directory_write_manager_t<metadata_t>::send_update(peer_id_t peer, const metadata_t &new_value, fifo_enforcer_write_token_t metadata_fifo_token, auto_drainer_t::lock_t) THROWS_NOTHING {
-    update_writer_t writer(new_value, metadata_fifo_token);
+void directory_write_manager_t<metadata_t>::send_update(peer_id_t peer, const std::string &delta, fifo_enforcer_write_token_t metadata_fifo_token, auto_drainer_t::lock_t) THROWS_NOTHING {
+    update_writer_t writer(delta, metadata_fifo_token, &pm_update_bytes_sent);
     message_service->send_message(peer, &writer);
 }
 
@@ -16,10 +16,10 @@
 const int raw_mailbox_t::address_t::ANY_THREAD = -1;
 
 raw_mailbox_t::address_t::address_t() :
-    peer(peer_id_t()), thread(ANY_THREAD), mailbox_id(0) { }
+    peer(peer_id_t()), thread(ANY_THREAD), mailbox_id(0), message_class(MESSAGE_CLASS_QUERY) { }
 
 raw_mailbox_t::address_t::address_t(const address_t &a) :
-    peer(a.peer), thread(a.thread), mailbox_id(a.mailbox_id) { }
+    peer(a.peer), thread(a.thread), mailbox_id(a.mailbox_id), message_class(a.message_class) { }
 
 bool raw_mailbox_t::address_t::is_nil() const {
     return peer.is_nil();
@@ -34,9 +34,11 @@ std::string raw_mailbox_t::address_t::human_readable() const {
     return strprintf("%s:%d:%" PRIu64, uuid_to_str(peer.get_uuid()).c_str(), thread, mailbox_id);
 }
 
-raw_mailbox_t::raw_mailbox_t(mailbox_manager_t *m, mailbox_read_callback_t *_callback) :
+raw_mailbox_t::raw_mailbox_t(mailbox_manager_t *m, mailbox_read_callback_t *_callback,
+                             message_class_t _message_class) :
     manager(m),
     mailbox_id(manager->register_mailbox(this)),
+    message_class(_message_class),
     callback(_callback) {
     // Do nothing
 }
@@ -51,13 +53,16 @@ raw_mailbox_t::address_t raw_mailbox_t::get_address() const {
     a.peer = manager->get_connectivity_service()->get_me();
     a.thread = home_thread().threadnum;
     a.mailbox_id = mailbox_id;
+    a.message_class = message_class;
     return a;
 }
 
 class raw_mailbox_writer_t : public send_message_write_callback_t {
 public:
-    raw_mailbox_writer_t(int32_t _dest_thread, raw_mailbox_t::id_t _dest_mailbox_id, mailbox_write_callback_t *_subwriter) :
-        dest_thread(_dest_thread), dest_mailbox_id(_dest_mailbox_id), subwriter(_subwriter) { }
+    raw_mailbox_writer_t(int32_t _dest_thread, raw_mailbox_t::id_t _dest_mailbox_id,
+                         message_class_t _message_class, mailbox_write_callback_t *_subwriter) :
+        dest_thread(_dest_thread), dest_mailbox_id(_dest_mailbox_id),
+        message_class(_message_class), subwriter(_subwriter) { }
     virtual ~raw_mailbox_writer_t() { }
 
     void write(write_stream_t *stream) {
@@ -71,16 +76,33 @@ public:
 
         subwriter->write(stream);
     }
+
+    /* Messages to the same mailbox stay in order; messages to different
+    mailboxes can use different connections. */
+    uint64_t get_ordering_key() const {
+        uint64_t key = dest_mailbox_id ^ (static_cast<uint64_t>(dest_thread) << 56);
+        // Mix the bits, so that consecutive mailbox IDs get different keys
+        // whatever the number of connections.
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return key;
+    }
+
+    message_class_t get_message_class() const {
+        return message_class;
+    }
 private:
     int32_t dest_thread;
     raw_mailbox_t::id_t dest_mailbox_id;
+    message_class_t message_class;
     mailbox_write_callback_t *subwriter;
 };
 
 void send(mailbox_manager_t *src, raw_mailbox_t::address_t dest, mailbox_write_callback_t *callback) {
     guarantee(src);
     guarantee(!dest.is_nil());
-    raw_mailbox_writer_t writer(dest.thread, dest.mailbox_id, callback);
+    raw_mailbox_writer_t writer(dest.thread, dest.mailbox_id, dest.message_class, callback);
     src->message_service->send_message(dest.peer, &writer);
 }
 
@@ -105,7 +127,7 @@ raw_mailbox_t *mailbox_manager_t::mailbox_table_t::find_mailbox(raw_mailbox_t::i
     }
 }
 
-void mailbox_manager_t::on_message(UNUSED peer_id_t source_peer, string_read_stream_t *stream) {
+void mailbox_manager_t::on_message(UNUSED peer_id_t source_peer, data_buffer_read_stream_t *stream) {
     int32_t dest_thread;
     raw_mailbox_t::id_t dest_mailbox_id;
     {
@@ -126,16 +148,16 @@ void mailbox_manager_t::on_message(UNUSED peer_id_t source_peer, string_read_str
 
 void mailbox_manager_t::mailbox_read_coroutine(threadnum_t dest_thread,
                                                raw_mailbox_t::id_t dest_mailbox_id,
-                                               string_read_stream_t *stream) {
-    // Take the string from the read stream, so it can be deallocated in the caller
-    std::string stream_data;
+                                               data_buffer_read_stream_t *stream) {
+    // Take the buffer from the read stream, so it can be deallocated in the caller
+    counted_t<data_buffer_t> stream_data;
     int64_t data_offset = 0;
     stream->swap(&stream_data, &data_offset);
 
     on_thread_t rethreader(dest_thread);
 
     // Construct a new stream to use
-    string_read_stream_t new_stream(std::move(stream_data), data_offset);
+    data_buffer_read_stream_t new_stream(stream_data, data_offset);
 
     raw_mailbox_t *mbox = mailbox_tables.get()->find_mailbox(dest_mailbox_id);
     if (mbox != NULL) {
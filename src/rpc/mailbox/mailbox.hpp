@@ -10,9 +10,14 @@
 
 class mailbox_manager_t;
 
+ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(message_class_t, int8_t,
+                                      MESSAGE_CLASS_HEARTBEAT, NUM_MESSAGE_CLASSES - 1);
+
 /* `mailbox_t` is a receiver of messages. Construct it with a callback function
 to handle messages it receives. To send messages to the mailbox, call the
-`get_address()` method and then call `send()` on the address it returns. */
+`get_address()` method and then call `send()` on the address it returns. The
+`message_class_t` a mailbox is constructed with is part of its address, so that
+everything sent to it is scheduled as that kind of traffic. */
 
 class mailbox_write_callback_t {
 public:
@@ -41,6 +46,8 @@ private:
 
     const id_t mailbox_id;
 
+    const message_class_t message_class;
+
     mailbox_read_callback_t *callback;
 
     auto_drainer_t drainer;
@@ -70,7 +77,7 @@ public:
         friend struct raw_mailbox_t;
         friend class mailbox_manager_t;
 
-        RDB_MAKE_ME_SERIALIZABLE_3(peer, thread, mailbox_id);
+        RDB_MAKE_ME_SERIALIZABLE_4(peer, thread, mailbox_id, message_class);
 
         /* The peer on which the mailbox is located */
         peer_id_t peer;
@@ -81,9 +88,13 @@ public:
 
         /* The ID of the mailbox */
         id_t mailbox_id;
+
+        /* What kind of traffic messages to the mailbox are */
+        message_class_t message_class;
     };
 
-    raw_mailbox_t(mailbox_manager_t *, mailbox_read_callback_t *callback);
+    raw_mailbox_t(mailbox_manager_t *, mailbox_read_callback_t *callback,
+                  message_class_t message_class = MESSAGE_CLASS_QUERY);
     ~raw_mailbox_t();
 
     address_t get_address() const;
@@ -138,11 +149,11 @@ private:
                                       raw_mailbox_t::id_t dest_mailbox_id,
                                       mailbox_write_callback_t *callback);
 
-    void on_message(peer_id_t, string_read_stream_t *stream);
+    void on_message(peer_id_t, data_buffer_read_stream_t *stream);
 
     void mailbox_read_coroutine(threadnum_t dest_thread,
                                 raw_mailbox_t::id_t dest_mailbox_id,
-                                string_read_stream_t *stream);
+                                data_buffer_read_stream_t *stream);
 };
 
 #endif /* RPC_MAILBOX_MAILBOX_HPP_ */
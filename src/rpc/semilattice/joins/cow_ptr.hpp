@@ -3,6 +3,7 @@
 #define RPC_SEMILATTICE_JOINS_COW_PTR_HPP_
 
 #include "containers/cow_ptr.hpp"
+#include "rpc/semilattice/joins/delta.hpp"
 
 template <class T>
 void semilattice_join(cow_ptr_t<T> *a, const cow_ptr_t<T> &b) {
@@ -10,14 +11,21 @@ void semilattice_join(cow_ptr_t<T> *a, const cow_ptr_t<T> &b) {
     semilattice_join(change.get(), *b);
 }
 
+template <class T>
+cow_ptr_t<T> semilattice_delta(const cow_ptr_t<T> &base, const cow_ptr_t<T> &updated) {
+    return cow_ptr_t<T>(semilattice_delta(*base, *updated));
+}
+
 template <class T>
 bool operator==(const cow_ptr_t<T> &a, const cow_ptr_t<T> &b) {
-    return *a == *b;
+    /* Copies share the same `T` until one of them changes, and comparing a big
+    `T` with itself is a waste. */
+    return a.get() == b.get() || *a == *b;
 }
 
 template <class T>
 bool operator!=(const cow_ptr_t<T> &a, const cow_ptr_t<T> &b) {
-    return *a != *b;
+    return a.get() != b.get() && *a != *b;
 }
 
 #endif /* RPC_SEMILATTICE_JOINS_COW_PTR_HPP_ */
@@ -3,6 +3,7 @@
 #define RPC_SEMILATTICE_JOINS_DELETABLE_HPP_
 
 #include "containers/archive/boost_types.hpp"
+#include "rpc/semilattice/joins/delta.hpp"
 #include "rpc/serialize_macros.hpp"
 
 class printf_buffer_t;
@@ -63,6 +64,9 @@ bool operator==(const deletable_t<T> &, const deletable_t<T> &);
 template <class T>
 void semilattice_join(deletable_t<T> *, const deletable_t<T> &);
 
+template <class T>
+deletable_t<T> semilattice_delta(const deletable_t<T> &base, const deletable_t<T> &updated);
+
 template <class T>
 void debug_print(printf_buffer_t *buf, const deletable_t<T> &x);
 
@@ -23,6 +23,15 @@ void semilattice_join(deletable_t<T> *a, const deletable_t<T> &b) {
     }
 }
 
+template <class T>
+deletable_t<T> semilattice_delta(const deletable_t<T> &base, const deletable_t<T> &updated) {
+    if (base.is_deleted() || updated.is_deleted()) {
+        return updated;
+    } else {
+        return deletable_t<T>(semilattice_delta(base.get_ref(), updated.get_ref()));
+    }
+}
+
 template <class T>
 void debug_print(printf_buffer_t *buf, const deletable_t<T> &x) {
     buf->appendf("deletable{deleted=%s, t=", x.is_deleted() ? "true" : "false");
@@ -0,0 +1,24 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef RPC_SEMILATTICE_JOINS_DELTA_HPP_
+#define RPC_SEMILATTICE_JOINS_DELTA_HPP_
+
+#include "errors.hpp"
+
+/* `semilattice_delta(base, updated)` returns a value `d` such that for any `x`
+that is at least `base`, `semilattice_join(&x, d)` gives the same result as
+`semilattice_join(&x, updated)`. Usually `updated` is a later version of
+`base`, but it doesn't have to be; then the delta is the part of `updated` that
+`base` doesn't already have. It lets us send or store just the part of a value
+that changed.
+
+Returning all of `updated` always works, so that's what this fallback does.
+Types whose joins are unions (like `std::map` and `std::set`) overload it to
+leave out the entries that `base` already has, and types made with
+`RDB_MAKE_SEMILATTICE_DELTA_[n]()` compute it field by field. */
+
+template <class T>
+T semilattice_delta(UNUSED const T &base, const T &updated) {
+    return updated;
+}
+
+#endif /* RPC_SEMILATTICE_JOINS_DELTA_HPP_ */
@@ -25,12 +25,25 @@ You can also use this with templated types, but it's pretty hacky:
     };
     template<class T>
     RDB_MAKE_SEMILATTICE_JOINABLE_2(pair_t<T>, a, b)
+
+If the type is big and usually changes only a little at a time, you can also
+call `RDB_MAKE_SEMILATTICE_DELTA_[n]()` with the same parameters. It defines
+`semilattice_delta()` for the type field by field (see
+"rpc/semilattice/joins/delta.hpp"); the type must be default-constructible.
 */
 
+#include "rpc/semilattice/joins/delta.hpp"
+
 #define RDB_MAKE_SEMILATTICE_JOINABLE_0(type_t) \
     inline void semilattice_join(UNUSED type_t *_a_, UNUSED const type_t &_b_) { \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_0(type_t) \
+    inline type_t semilattice_delta(UNUSED const type_t &_base_, UNUSED const type_t &_updated_) { \
+        type_t _delta_; \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_0(type_t) \
     inline bool operator==(UNUSED const type_t &_a_, UNUSED const type_t &_b_) { \
         return true; \
@@ -42,6 +55,13 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field1, _b_.field1); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_1(type_t, field1) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_1(type_t, field1) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1; \
@@ -54,6 +74,14 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field2, _b_.field2); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_2(type_t, field1, field2) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        _delta_.field2 = semilattice_delta(_base_.field2, _updated_.field2); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_2(type_t, field1, field2) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2; \
@@ -67,6 +95,15 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field3, _b_.field3); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_3(type_t, field1, field2, field3) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        _delta_.field2 = semilattice_delta(_base_.field2, _updated_.field2); \
+        _delta_.field3 = semilattice_delta(_base_.field3, _updated_.field3); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_3(type_t, field1, field2, field3) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3; \
@@ -81,6 +118,16 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field4, _b_.field4); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_4(type_t, field1, field2, field3, field4) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        _delta_.field2 = semilattice_delta(_base_.field2, _updated_.field2); \
+        _delta_.field3 = semilattice_delta(_base_.field3, _updated_.field3); \
+        _delta_.field4 = semilattice_delta(_base_.field4, _updated_.field4); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_4(type_t, field1, field2, field3, field4) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4; \
@@ -96,6 +143,17 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field5, _b_.field5); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_5(type_t, field1, field2, field3, field4, field5) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        _delta_.field2 = semilattice_delta(_base_.field2, _updated_.field2); \
+        _delta_.field3 = semilattice_delta(_base_.field3, _updated_.field3); \
+        _delta_.field4 = semilattice_delta(_base_.field4, _updated_.field4); \
+        _delta_.field5 = semilattice_delta(_base_.field5, _updated_.field5); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_5(type_t, field1, field2, field3, field4, field5) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5; \
@@ -112,6 +170,18 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field6, _b_.field6); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_6(type_t, field1, field2, field3, field4, field5, field6) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        _delta_.field2 = semilattice_delta(_base_.field2, _updated_.field2); \
+        _delta_.field3 = semilattice_delta(_base_.field3, _updated_.field3); \
+        _delta_.field4 = semilattice_delta(_base_.field4, _updated_.field4); \
+        _delta_.field5 = semilattice_delta(_base_.field5, _updated_.field5); \
+        _delta_.field6 = semilattice_delta(_base_.field6, _updated_.field6); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_6(type_t, field1, field2, field3, field4, field5, field6) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6; \
@@ -129,6 +199,19 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field7, _b_.field7); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_7(type_t, field1, field2, field3, field4, field5, field6, field7) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        _delta_.field2 = semilattice_delta(_base_.field2, _updated_.field2); \
+        _delta_.field3 = semilattice_delta(_base_.field3, _updated_.field3); \
+        _delta_.field4 = semilattice_delta(_base_.field4, _updated_.field4); \
+        _delta_.field5 = semilattice_delta(_base_.field5, _updated_.field5); \
+        _delta_.field6 = semilattice_delta(_base_.field6, _updated_.field6); \
+        _delta_.field7 = semilattice_delta(_base_.field7, _updated_.field7); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_7(type_t, field1, field2, field3, field4, field5, field6, field7) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7; \
@@ -147,6 +230,20 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field8, _b_.field8); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_8(type_t, field1, field2, field3, field4, field5, field6, field7, field8) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        _delta_.field2 = semilattice_delta(_base_.field2, _updated_.field2); \
+        _delta_.field3 = semilattice_delta(_base_.field3, _updated_.field3); \
+        _delta_.field4 = semilattice_delta(_base_.field4, _updated_.field4); \
+        _delta_.field5 = semilattice_delta(_base_.field5, _updated_.field5); \
+        _delta_.field6 = semilattice_delta(_base_.field6, _updated_.field6); \
+        _delta_.field7 = semilattice_delta(_base_.field7, _updated_.field7); \
+        _delta_.field8 = semilattice_delta(_base_.field8, _updated_.field8); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_8(type_t, field1, field2, field3, field4, field5, field6, field7, field8) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8; \
@@ -166,6 +263,21 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field9, _b_.field9); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_9(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        _delta_.field2 = semilattice_delta(_base_.field2, _updated_.field2); \
+        _delta_.field3 = semilattice_delta(_base_.field3, _updated_.field3); \
+        _delta_.field4 = semilattice_delta(_base_.field4, _updated_.field4); \
+        _delta_.field5 = semilattice_delta(_base_.field5, _updated_.field5); \
+        _delta_.field6 = semilattice_delta(_base_.field6, _updated_.field6); \
+        _delta_.field7 = semilattice_delta(_base_.field7, _updated_.field7); \
+        _delta_.field8 = semilattice_delta(_base_.field8, _updated_.field8); \
+        _delta_.field9 = semilattice_delta(_base_.field9, _updated_.field9); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_9(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9; \
@@ -186,6 +298,22 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field10, _b_.field10); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_10(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        _delta_.field2 = semilattice_delta(_base_.field2, _updated_.field2); \
+        _delta_.field3 = semilattice_delta(_base_.field3, _updated_.field3); \
+        _delta_.field4 = semilattice_delta(_base_.field4, _updated_.field4); \
+        _delta_.field5 = semilattice_delta(_base_.field5, _updated_.field5); \
+        _delta_.field6 = semilattice_delta(_base_.field6, _updated_.field6); \
+        _delta_.field7 = semilattice_delta(_base_.field7, _updated_.field7); \
+        _delta_.field8 = semilattice_delta(_base_.field8, _updated_.field8); \
+        _delta_.field9 = semilattice_delta(_base_.field9, _updated_.field9); \
+        _delta_.field10 = semilattice_delta(_base_.field10, _updated_.field10); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_10(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10; \
@@ -207,6 +335,23 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field11, _b_.field11); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_11(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        _delta_.field2 = semilattice_delta(_base_.field2, _updated_.field2); \
+        _delta_.field3 = semilattice_delta(_base_.field3, _updated_.field3); \
+        _delta_.field4 = semilattice_delta(_base_.field4, _updated_.field4); \
+        _delta_.field5 = semilattice_delta(_base_.field5, _updated_.field5); \
+        _delta_.field6 = semilattice_delta(_base_.field6, _updated_.field6); \
+        _delta_.field7 = semilattice_delta(_base_.field7, _updated_.field7); \
+        _delta_.field8 = semilattice_delta(_base_.field8, _updated_.field8); \
+        _delta_.field9 = semilattice_delta(_base_.field9, _updated_.field9); \
+        _delta_.field10 = semilattice_delta(_base_.field10, _updated_.field10); \
+        _delta_.field11 = semilattice_delta(_base_.field11, _updated_.field11); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_11(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10 && _a_.field11 == _b_.field11; \
@@ -229,6 +374,24 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field12, _b_.field12); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_12(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        _delta_.field2 = semilattice_delta(_base_.field2, _updated_.field2); \
+        _delta_.field3 = semilattice_delta(_base_.field3, _updated_.field3); \
+        _delta_.field4 = semilattice_delta(_base_.field4, _updated_.field4); \
+        _delta_.field5 = semilattice_delta(_base_.field5, _updated_.field5); \
+        _delta_.field6 = semilattice_delta(_base_.field6, _updated_.field6); \
+        _delta_.field7 = semilattice_delta(_base_.field7, _updated_.field7); \
+        _delta_.field8 = semilattice_delta(_base_.field8, _updated_.field8); \
+        _delta_.field9 = semilattice_delta(_base_.field9, _updated_.field9); \
+        _delta_.field10 = semilattice_delta(_base_.field10, _updated_.field10); \
+        _delta_.field11 = semilattice_delta(_base_.field11, _updated_.field11); \
+        _delta_.field12 = semilattice_delta(_base_.field12, _updated_.field12); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_12(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10 && _a_.field11 == _b_.field11 && _a_.field12 == _b_.field12; \
@@ -252,6 +415,25 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field13, _b_.field13); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_13(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        _delta_.field2 = semilattice_delta(_base_.field2, _updated_.field2); \
+        _delta_.field3 = semilattice_delta(_base_.field3, _updated_.field3); \
+        _delta_.field4 = semilattice_delta(_base_.field4, _updated_.field4); \
+        _delta_.field5 = semilattice_delta(_base_.field5, _updated_.field5); \
+        _delta_.field6 = semilattice_delta(_base_.field6, _updated_.field6); \
+        _delta_.field7 = semilattice_delta(_base_.field7, _updated_.field7); \
+        _delta_.field8 = semilattice_delta(_base_.field8, _updated_.field8); \
+        _delta_.field9 = semilattice_delta(_base_.field9, _updated_.field9); \
+        _delta_.field10 = semilattice_delta(_base_.field10, _updated_.field10); \
+        _delta_.field11 = semilattice_delta(_base_.field11, _updated_.field11); \
+        _delta_.field12 = semilattice_delta(_base_.field12, _updated_.field12); \
+        _delta_.field13 = semilattice_delta(_base_.field13, _updated_.field13); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_13(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10 && _a_.field11 == _b_.field11 && _a_.field12 == _b_.field12 && _a_.field13 == _b_.field13; \
@@ -276,6 +458,26 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field14, _b_.field14); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_14(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        _delta_.field2 = semilattice_delta(_base_.field2, _updated_.field2); \
+        _delta_.field3 = semilattice_delta(_base_.field3, _updated_.field3); \
+        _delta_.field4 = semilattice_delta(_base_.field4, _updated_.field4); \
+        _delta_.field5 = semilattice_delta(_base_.field5, _updated_.field5); \
+        _delta_.field6 = semilattice_delta(_base_.field6, _updated_.field6); \
+        _delta_.field7 = semilattice_delta(_base_.field7, _updated_.field7); \
+        _delta_.field8 = semilattice_delta(_base_.field8, _updated_.field8); \
+        _delta_.field9 = semilattice_delta(_base_.field9, _updated_.field9); \
+        _delta_.field10 = semilattice_delta(_base_.field10, _updated_.field10); \
+        _delta_.field11 = semilattice_delta(_base_.field11, _updated_.field11); \
+        _delta_.field12 = semilattice_delta(_base_.field12, _updated_.field12); \
+        _delta_.field13 = semilattice_delta(_base_.field13, _updated_.field13); \
+        _delta_.field14 = semilattice_delta(_base_.field14, _updated_.field14); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_14(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10 && _a_.field11 == _b_.field11 && _a_.field12 == _b_.field12 && _a_.field13 == _b_.field13 && _a_.field14 == _b_.field14; \
@@ -301,6 +503,27 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field15, _b_.field15); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_15(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        _delta_.field2 = semilattice_delta(_base_.field2, _updated_.field2); \
+        _delta_.field3 = semilattice_delta(_base_.field3, _updated_.field3); \
+        _delta_.field4 = semilattice_delta(_base_.field4, _updated_.field4); \
+        _delta_.field5 = semilattice_delta(_base_.field5, _updated_.field5); \
+        _delta_.field6 = semilattice_delta(_base_.field6, _updated_.field6); \
+        _delta_.field7 = semilattice_delta(_base_.field7, _updated_.field7); \
+        _delta_.field8 = semilattice_delta(_base_.field8, _updated_.field8); \
+        _delta_.field9 = semilattice_delta(_base_.field9, _updated_.field9); \
+        _delta_.field10 = semilattice_delta(_base_.field10, _updated_.field10); \
+        _delta_.field11 = semilattice_delta(_base_.field11, _updated_.field11); \
+        _delta_.field12 = semilattice_delta(_base_.field12, _updated_.field12); \
+        _delta_.field13 = semilattice_delta(_base_.field13, _updated_.field13); \
+        _delta_.field14 = semilattice_delta(_base_.field14, _updated_.field14); \
+        _delta_.field15 = semilattice_delta(_base_.field15, _updated_.field15); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_15(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10 && _a_.field11 == _b_.field11 && _a_.field12 == _b_.field12 && _a_.field13 == _b_.field13 && _a_.field14 == _b_.field14 && _a_.field15 == _b_.field15; \
@@ -327,6 +550,28 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field16, _b_.field16); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_16(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15, field16) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        _delta_.field2 = semilattice_delta(_base_.field2, _updated_.field2); \
+        _delta_.field3 = semilattice_delta(_base_.field3, _updated_.field3); \
+        _delta_.field4 = semilattice_delta(_base_.field4, _updated_.field4); \
+        _delta_.field5 = semilattice_delta(_base_.field5, _updated_.field5); \
+        _delta_.field6 = semilattice_delta(_base_.field6, _updated_.field6); \
+        _delta_.field7 = semilattice_delta(_base_.field7, _updated_.field7); \
+        _delta_.field8 = semilattice_delta(_base_.field8, _updated_.field8); \
+        _delta_.field9 = semilattice_delta(_base_.field9, _updated_.field9); \
+        _delta_.field10 = semilattice_delta(_base_.field10, _updated_.field10); \
+        _delta_.field11 = semilattice_delta(_base_.field11, _updated_.field11); \
+        _delta_.field12 = semilattice_delta(_base_.field12, _updated_.field12); \
+        _delta_.field13 = semilattice_delta(_base_.field13, _updated_.field13); \
+        _delta_.field14 = semilattice_delta(_base_.field14, _updated_.field14); \
+        _delta_.field15 = semilattice_delta(_base_.field15, _updated_.field15); \
+        _delta_.field16 = semilattice_delta(_base_.field16, _updated_.field16); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_16(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15, field16) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10 && _a_.field11 == _b_.field11 && _a_.field12 == _b_.field12 && _a_.field13 == _b_.field13 && _a_.field14 == _b_.field14 && _a_.field15 == _b_.field15 && _a_.field16 == _b_.field16; \
@@ -354,6 +599,29 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field17, _b_.field17); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_17(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15, field16, field17) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        _delta_.field2 = semilattice_delta(_base_.field2, _updated_.field2); \
+        _delta_.field3 = semilattice_delta(_base_.field3, _updated_.field3); \
+        _delta_.field4 = semilattice_delta(_base_.field4, _updated_.field4); \
+        _delta_.field5 = semilattice_delta(_base_.field5, _updated_.field5); \
+        _delta_.field6 = semilattice_delta(_base_.field6, _updated_.field6); \
+        _delta_.field7 = semilattice_delta(_base_.field7, _updated_.field7); \
+        _delta_.field8 = semilattice_delta(_base_.field8, _updated_.field8); \
+        _delta_.field9 = semilattice_delta(_base_.field9, _updated_.field9); \
+        _delta_.field10 = semilattice_delta(_base_.field10, _updated_.field10); \
+        _delta_.field11 = semilattice_delta(_base_.field11, _updated_.field11); \
+        _delta_.field12 = semilattice_delta(_base_.field12, _updated_.field12); \
+        _delta_.field13 = semilattice_delta(_base_.field13, _updated_.field13); \
+        _delta_.field14 = semilattice_delta(_base_.field14, _updated_.field14); \
+        _delta_.field15 = semilattice_delta(_base_.field15, _updated_.field15); \
+        _delta_.field16 = semilattice_delta(_base_.field16, _updated_.field16); \
+        _delta_.field17 = semilattice_delta(_base_.field17, _updated_.field17); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_17(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15, field16, field17) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10 && _a_.field11 == _b_.field11 && _a_.field12 == _b_.field12 && _a_.field13 == _b_.field13 && _a_.field14 == _b_.field14 && _a_.field15 == _b_.field15 && _a_.field16 == _b_.field16 && _a_.field17 == _b_.field17; \
@@ -382,6 +650,30 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field18, _b_.field18); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_18(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15, field16, field17, field18) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        _delta_.field2 = semilattice_delta(_base_.field2, _updated_.field2); \
+        _delta_.field3 = semilattice_delta(_base_.field3, _updated_.field3); \
+        _delta_.field4 = semilattice_delta(_base_.field4, _updated_.field4); \
+        _delta_.field5 = semilattice_delta(_base_.field5, _updated_.field5); \
+        _delta_.field6 = semilattice_delta(_base_.field6, _updated_.field6); \
+        _delta_.field7 = semilattice_delta(_base_.field7, _updated_.field7); \
+        _delta_.field8 = semilattice_delta(_base_.field8, _updated_.field8); \
+        _delta_.field9 = semilattice_delta(_base_.field9, _updated_.field9); \
+        _delta_.field10 = semilattice_delta(_base_.field10, _updated_.field10); \
+        _delta_.field11 = semilattice_delta(_base_.field11, _updated_.field11); \
+        _delta_.field12 = semilattice_delta(_base_.field12, _updated_.field12); \
+        _delta_.field13 = semilattice_delta(_base_.field13, _updated_.field13); \
+        _delta_.field14 = semilattice_delta(_base_.field14, _updated_.field14); \
+        _delta_.field15 = semilattice_delta(_base_.field15, _updated_.field15); \
+        _delta_.field16 = semilattice_delta(_base_.field16, _updated_.field16); \
+        _delta_.field17 = semilattice_delta(_base_.field17, _updated_.field17); \
+        _delta_.field18 = semilattice_delta(_base_.field18, _updated_.field18); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_18(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15, field16, field17, field18) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10 && _a_.field11 == _b_.field11 && _a_.field12 == _b_.field12 && _a_.field13 == _b_.field13 && _a_.field14 == _b_.field14 && _a_.field15 == _b_.field15 && _a_.field16 == _b_.field16 && _a_.field17 == _b_.field17 && _a_.field18 == _b_.field18; \
@@ -411,6 +703,31 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field19, _b_.field19); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_19(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15, field16, field17, field18, field19) \
+    inline type_t semilattice_delta(const type_t &_base_, const type_t &_updated_) { \
+        type_t _delta_; \
+        _delta_.field1 = semilattice_delta(_base_.field1, _updated_.field1); \
+        _delta_.field2 = semilattice_delta(_base_.field2, _updated_.field2); \
+        _delta_.field3 = semilattice_delta(_base_.field3, _updated_.field3); \
+        _delta_.field4 = semilattice_delta(_base_.field4, _updated_.field4); \
+        _delta_.field5 = semilattice_delta(_base_.field5, _updated_.field5); \
+        _delta_.field6 = semilattice_delta(_base_.field6, _updated_.field6); \
+        _delta_.field7 = semilattice_delta(_base_.field7, _updated_.field7); \
+        _delta_.field8 = semilattice_delta(_base_.field8, _updated_.field8); \
+        _delta_.field9 = semilattice_delta(_base_.field9, _updated_.field9); \
+        _delta_.field10 = semilattice_delta(_base_.field10, _updated_.field10); \
+        _delta_.field11 = semilattice_delta(_base_.field11, _updated_.field11); \
+        _delta_.field12 = semilattice_delta(_base_.field12, _updated_.field12); \
+        _delta_.field13 = semilattice_delta(_base_.field13, _updated_.field13); \
+        _delta_.field14 = semilattice_delta(_base_.field14, _updated_.field14); \
+        _delta_.field15 = semilattice_delta(_base_.field15, _updated_.field15); \
+        _delta_.field16 = semilattice_delta(_base_.field16, _updated_.field16); \
+        _delta_.field17 = semilattice_delta(_base_.field17, _updated_.field17); \
+        _delta_.field18 = semilattice_delta(_base_.field18, _updated_.field18); \
+        _delta_.field19 = semilattice_delta(_base_.field19, _updated_.field19); \
+        return _delta_; \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_19(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15, field16, field17, field18, field19) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10 && _a_.field11 == _b_.field11 && _a_.field12 == _b_.field12 && _a_.field13 == _b_.field13 && _a_.field14 == _b_.field14 && _a_.field15 == _b_.field15 && _a_.field16 == _b_.field16 && _a_.field17 == _b_.field17 && _a_.field18 == _b_.field18 && _a_.field19 == _b_.field19; \
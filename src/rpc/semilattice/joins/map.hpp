@@ -4,8 +4,11 @@
 
 #include <map>
 
+#include "rpc/semilattice/joins/delta.hpp"
+
 /* We join `std::map`s by taking their union and resolving conflicts by doing a
-semilattice join on the values. */
+semilattice join on the values. So the delta between two maps only needs the
+entries that are new or have changed. */
 
 namespace std {
 
@@ -21,6 +24,23 @@ void semilattice_join(std::map<key_t, value_t> *a, const std::map<key_t, value_t
     }
 }
 
+template<class key_t, class value_t>
+std::map<key_t, value_t> semilattice_delta(const std::map<key_t, value_t> &base, const std::map<key_t, value_t> &updated) {
+    /* Our own overload hides the global fallback, so bring it back for value
+    types that don't have one of their own. */
+    using ::semilattice_delta;
+    std::map<key_t, value_t> delta;
+    for (typename std::map<key_t, value_t>::const_iterator it = updated.begin(); it != updated.end(); it++) {
+        typename std::map<key_t, value_t>::const_iterator it2 = base.find(it->first);
+        if (it2 == base.end()) {
+            delta.insert(delta.end(), *it);
+        } else if (!(it2->second == it->second)) {
+            delta.insert(delta.end(), std::make_pair(it->first, semilattice_delta(it2->second, it->second)));
+        }
+    }
+    return delta;
+}
+
 }   /* namespace std */
 
 #endif /* RPC_SEMILATTICE_JOINS_MAP_HPP_ */
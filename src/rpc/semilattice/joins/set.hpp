@@ -4,6 +4,7 @@
 
 #include <set>
 #include <algorithm>
+#include <iterator>
 
 namespace std {
 
@@ -16,6 +17,14 @@ void semilattice_join(std::set<T> *a, const std::set<T> &b) {
     }
 }
 
+template <class T>
+std::set<T> semilattice_delta(const std::set<T> &base, const std::set<T> &updated) {
+    std::set<T> delta;
+    std::set_difference(updated.begin(), updated.end(), base.begin(), base.end(),
+                        std::inserter(delta, delta.end()));
+    return delta;
+}
+
 }
 
 #endif /* RPC_SEMILATTICE_JOINS_SET_HPP_ */
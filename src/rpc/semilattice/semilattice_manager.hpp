@@ -6,6 +6,7 @@
 #include <utility>
 
 #include "rpc/mailbox/mailbox.hpp"
+#include "rpc/semilattice/joins/delta.hpp"
 #include "rpc/semilattice/view.hpp"
 
 class cond_t;
@@ -29,6 +30,11 @@ constraints:
     such that `metadata_t` is a semilattice and `semilattice_join(a, b)` sets
     `*a` to the semilattice-join of `*a` and `b`.
 
+4. `semilattice_delta()` must work on it (see
+    "rpc/semilattice/joins/delta.hpp"). The fallback, which sends the whole
+    value, works for any type, but big metadata should overload it so that
+    local changes are sent to peers as just the parts that changed.
+
 Currently it's not thread-safe at all; all accesses to the metadata must be on
 the home thread of the `semilattice_manager_t`. */
 
@@ -64,7 +70,7 @@ private:
 
     /* These are called in a blocking fashion by the message service or by the
     `connectivity_service_t`. */
-    void on_message(peer_id_t, string_read_stream_t *);
+    void on_message(peer_id_t, data_buffer_read_stream_t *);
     void on_connect(peer_id_t);
     void on_disconnect(peer_id_t);
 
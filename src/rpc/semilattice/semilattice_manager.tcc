@@ -60,8 +60,15 @@ void semilattice_manager_t<metadata_t>::root_view_t::join(const metadata_t &adde
     guarantee(parent, "accessing `semilattice_manager_t` root view when cluster no longer exists");
     parent->assert_thread();
 
+    /* Views usually join in the whole metadata even if they only changed a
+    little of it. Every peer we can see has already been sent what we have now
+    (or will have been, once its messages arrive), so all it needs is the part
+    of `added_metadata` that we don't have yet. Joining just that part is
+    enough for us, too. */
+    metadata_t delta = semilattice_delta(parent->metadata, added_metadata);
+
     metadata_version_t new_version = ++parent->metadata_version;
-    parent->join_metadata_locally(added_metadata);
+    parent->join_metadata_locally(delta);
 
     /* Distribute changes to all peers we can currently see. If we can't
     currently see a peer, that's OK; it will hear about the metadata change when
@@ -72,7 +79,7 @@ void semilattice_manager_t<metadata_t>::root_view_t::join(const metadata_t &adde
         if (*it != parent->message_service->get_connectivity_service()->get_me()) {
             coro_t::spawn_sometime(boost::bind(
                 &semilattice_manager_t<metadata_t>::send_metadata_to_peer, parent,
-                *it, added_metadata, new_version,
+                *it, delta, new_version,
                 auto_drainer_t::lock_t(parent->drainers.get())));
         }
     }
@@ -99,6 +106,10 @@ public:
         int res = send_write_message(stream, &msg);
         if (res) { throw fake_archive_exc_t(); }
     }
+
+    message_class_t get_message_class() const {
+        return MESSAGE_CLASS_METADATA;
+    }
 private:
     const metadata_t &md;
     metadata_version_t mdv;
@@ -118,6 +129,10 @@ public:
         int res = send_write_message(stream, &msg);
         if (res) { throw fake_archive_exc_t(); }
     }
+
+    message_class_t get_message_class() const {
+        return MESSAGE_CLASS_METADATA;
+    }
 private:
     sync_from_query_id_t query_id;
 };
@@ -137,6 +152,10 @@ public:
         int res = send_write_message(stream, &msg);
         if (res) { throw fake_archive_exc_t(); }
     }
+
+    message_class_t get_message_class() const {
+        return MESSAGE_CLASS_METADATA;
+    }
 private:
     sync_from_query_id_t query_id;
     metadata_version_t version;
@@ -157,6 +176,10 @@ public:
         int res = send_write_message(stream, &msg);
         if (res) { throw fake_archive_exc_t(); }
     }
+
+    message_class_t get_message_class() const {
+        return MESSAGE_CLASS_METADATA;
+    }
 private:
     sync_to_query_id_t query_id;
     metadata_version_t version;
@@ -176,6 +199,10 @@ public:
         int res = send_write_message(stream, &msg);
         if (res) { throw fake_archive_exc_t(); }
     }
+
+    message_class_t get_message_class() const {
+        return MESSAGE_CLASS_METADATA;
+    }
 private:
     sync_to_query_id_t query_id;
 };
@@ -224,7 +251,7 @@ publisher_t<boost::function<void()> > *semilattice_manager_t<metadata_t>::root_v
 }
 
 template<class metadata_t>
-void semilattice_manager_t<metadata_t>::on_message(peer_id_t sender, string_read_stream_t *stream) {
+void semilattice_manager_t<metadata_t>::on_message(peer_id_t sender, data_buffer_read_stream_t *stream) {
     uint8_t code;
     {
         int res = deserialize(stream, &code);
@@ -4,7 +4,9 @@
 #include "unittest/gtest.hpp"
 
 #include "containers/archive/boost_types.hpp"
+#include "containers/archive/data_buffer_stream.hpp"
 #include "containers/archive/stl_types.hpp"
+#include "containers/archive/string_stream.hpp"
 
 namespace unittest {
 
@@ -34,6 +36,55 @@ TEST(WriteMessageTest, Variant) {
     ASSERT_EQ(15u, s.size());
 }
 
+TEST(DataBufferReadStreamTest, ReadShared) {
+    counted_t<data_buffer_t> buffer = data_buffer_t::create(100);
+    for (int i = 0; i < 100; ++i) {
+        buffer->buf()[i] = static_cast<char>(i);
+    }
+
+    data_buffer_read_stream_t stream(buffer, 10);
+    char c;
+    ASSERT_EQ(1, force_read(&stream, &c, 1));
+    ASSERT_EQ(10, c);
+
+    counted_t<data_buffer_t> slice;
+    ASSERT_TRUE(stream.read_shared(50, &slice));
+    ASSERT_EQ(50, slice->size());
+    ASSERT_EQ(buffer->buf() + 11, slice->buf());
+
+    // A slice of a slice still points at the same bytes.
+    counted_t<data_buffer_t> inner = data_buffer_t::create_slice(slice, 5, 10);
+    ASSERT_EQ(buffer->buf() + 16, inner->buf());
+
+    // The slices keep the bytes alive after everything else lets go of them.
+    buffer.reset();
+    slice.reset();
+    ASSERT_EQ(16, inner->buf()[0]);
+
+    // Only 39 bytes are left.
+    ASSERT_FALSE(stream.read_shared(40, &slice));
+    char rest[40];
+    ASSERT_EQ(39, force_read(&stream, rest, 40));
+    ASSERT_EQ(61, rest[0]);
+}
+
+TEST(DataBufferReadStreamTest, StringsRoundTrip) {
+    write_message_t msg;
+    msg << std::string("");
+    msg << std::string(5000, 'x');
 
+    string_stream_t stream;
+    ASSERT_EQ(0, send_write_message(&stream, &msg));
+    counted_t<data_buffer_t> buffer = data_buffer_t::create(stream.str().size());
+    memcpy(buffer->buf(), stream.str().data(), stream.str().size());
+
+    data_buffer_read_stream_t read_stream(buffer, 0);
+    std::string s;
+    ASSERT_EQ(ARCHIVE_SUCCESS, deserialize(&read_stream, &s));
+    ASSERT_EQ("", s);
+    ASSERT_EQ(ARCHIVE_SUCCESS, deserialize(&read_stream, &s));
+    ASSERT_EQ(std::string(5000, 'x'), s);
+    ASSERT_EQ(ARCHIVE_SOCK_EOF, deserialize(&read_stream, &s));
+}
 
 }  // namespace unittest
@@ -0,0 +1,125 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "arch/io/disk.hpp"
+#include "arch/timing.hpp"
+#include "btree/node.hpp"
+#include "btree/operations.hpp"
+#include "btree/slice.hpp"
+#include "buffer_cache/buffer_cache.hpp"
+#include "clustering/immediate_consistency/branch/metadata.hpp"
+#include "memcached/protocol.hpp"
+#include "serializer/config.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+void set_memcached_value(memcached_protocol_t::store_t *store,
+                         const region_map_t<memcached_protocol_t, binary_blob_t> &metainfo,
+                         const std::string &key, const std::string &value) {
+    sarc_mutation_t set;
+    set.key = store_key_t(key);
+    set.data = data_buffer_t::create(value.size());
+    memcpy(set.data->buf(), value.data(), value.size());
+    set.flags = 0;
+    set.exptime = 0;
+    set.add_policy = add_policy_yes;
+    set.replace_policy = replace_policy_yes;
+    memcached_protocol_t::write_t write(set, time(NULL), 12345);
+    memcached_protocol_t::write_response_t response;
+
+    write_token_pair_t token_pair;
+    store->new_write_token_pair(&token_pair);
+#ifndef NDEBUG
+    trivial_metainfo_checker_callback_t<memcached_protocol_t> metainfo_checker_callback;
+    metainfo_checker_t<memcached_protocol_t> metainfo_checker(&metainfo_checker_callback, store->get_region());
+#endif
+    cond_t non_interruptor;
+    store->write(DEBUG_ONLY(metainfo_checker, ) metainfo, write, &response,
+                 WRITE_DURABILITY_SOFT,
+                 transition_timestamp_t::starting_from(state_timestamp_t::zero()),
+                 order_token_t::ignore, &token_pair, &non_interruptor);
+}
+
+// Returns the number of blocks on the btree's list of detached subtrees.
+int count_detached_blocks(cache_t *cache) {
+    transaction_t txn(cache, rwi_read, order_token_t::ignore);
+    buf_lock_t superblock_buf(&txn, SUPERBLOCK_ID, rwi_read);
+    real_superblock_t superblock(&superblock_buf);
+    block_id_t list_block_id = superblock.get_detached_list_block_id();
+    int count = 0;
+    while (list_block_id != NULL_BLOCK_ID) {
+        buf_lock_t list_buf(&txn, list_block_id, rwi_read);
+        const btree_detached_list_t *list = static_cast<const btree_detached_list_t *>(list_buf.get_data_read());
+        count += list->num_blocks;
+        list_block_id = list->next;
+    }
+    return count;
+}
+
+int64_t get_population(cache_t *cache) {
+    transaction_t txn(cache, rwi_read, order_token_t::ignore);
+    buf_lock_t superblock_buf(&txn, SUPERBLOCK_ID, rwi_read);
+    real_superblock_t superblock(&superblock_buf);
+    buf_lock_t stat_block(&txn, superblock.get_stat_block_id(), rwi_read);
+    return static_cast<const btree_statblock_t *>(stat_block.get_data_read())->population;
+}
+
+/* `ResumeFreeing` erases a store's whole range and shuts the store down before
+the unlinked subtrees have been freed, and checks that they are still on the
+list on disk and that a store opened on the same file frees them. */
+
+void run_resume_freeing_test() {
+    temp_file_t temp_file;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    cond_t non_interruptor;
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    standard_serializer_t::create(&file_opener, standard_serializer_t::static_config_t());
+    standard_serializer_t serializer(standard_serializer_t::dynamic_config_t(),
+                                     &file_opener, &get_global_perfmon_collection());
+
+    {
+        memcached_protocol_t::store_t store(&serializer, temp_file.name().permanent_path(),
+                                            GIGABYTE, true, &get_global_perfmon_collection(),
+                                            NULL, &io_backender, base_path_t("."));
+        const region_map_t<memcached_protocol_t, binary_blob_t> metainfo(
+            store.get_region(), binary_blob_t(version_range_t(version_t::zero())));
+
+        // Enough keys for the root to have children in the middle.
+        for (int i = 0; i < 3000; ++i) {
+            set_memcached_value(&store, metainfo, strprintf("key%06d", i), "value");
+        }
+
+        write_token_pair_t token_pair;
+        store.new_write_token_pair(&token_pair);
+        store.reset_data(store.get_region(), metainfo, &token_pair,
+                         WRITE_DURABILITY_SOFT, &non_interruptor);
+
+        // Destroying the store drains the coroutine that frees the subtrees
+        // before it gets to them.
+    }
+
+    {
+        mirrored_cache_config_t cache_dynamic_config;
+        cache_t cache(&serializer, cache_dynamic_config, &get_global_perfmon_collection());
+        EXPECT_LT(0, count_detached_blocks(&cache));
+    }
+
+    {
+        memcached_protocol_t::store_t store(&serializer, temp_file.name().permanent_path(),
+                                            GIGABYTE, false, &get_global_perfmon_collection(),
+                                            NULL, &io_backender, base_path_t("."));
+        cache_t *cache = store.btree->cache();
+        for (int i = 0; i < 1000 && count_detached_blocks(cache) != 0; ++i) {
+            nap(10);
+        }
+        EXPECT_EQ(0, count_detached_blocks(cache));
+        EXPECT_EQ(0, get_population(cache));
+    }
+}
+
+TEST(BtreeEraseRange, ResumeFreeing) {
+    run_in_thread_pool(&run_resume_freeing_test);
+}
+
+}  // namespace unittest
@@ -0,0 +1,88 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "arch/timing.hpp"
+#include "concurrency/cond_var.hpp"
+#include "config/args.hpp"
+#include "rdb_protocol/btree.hpp"
+#include "rdb_protocol/changefeed.hpp"
+#include "rpc/connectivity/cluster.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+rdb_modification_report_t changefeed_test_insert(int i) {
+    rdb_modification_report_t mod_report(store_key_t(strprintf("%d", i)));
+    mod_report.info.added.first = make_counted<const ql::datum_t>(static_cast<double>(i));
+    return mod_report;
+}
+
+void run_changefeed_delivery_test() {
+    connectivity_cluster_t c;
+    mailbox_manager_t m(&c);
+    connectivity_cluster_t::run_t r(&c, get_unittest_addresses(), peer_address_t(),
+                                    ANY_PORT, &m, 0, NULL);
+
+    ql::changefeed::server_t server(&m);
+    ql::changefeed::feed_t feed(&m);
+    server.add_feed(feed.get_id(), feed.get_addr());
+    std::vector<ql::changefeed::server_addr_t> servers(1, server.get_addr());
+    feed.add_servers(servers);
+
+    // More than fit in one batch, so they need acknowledgements to get through.
+    const int num_changes = CHANGEFEED_MAX_BATCH * 3 + 1;
+    for (int i = 0; i < num_changes; ++i) {
+        server.on_mod_report(changefeed_test_insert(i));
+    }
+    // Rewriting a row with the value it already has isn't a change.
+    rdb_modification_report_t unchanged = changefeed_test_insert(0);
+    unchanged.info.deleted.first = unchanged.info.added.first;
+    server.on_mod_report(unchanged);
+
+    cond_t interruptor;
+    for (int i = 0; i < num_changes; ++i) {
+        ASSERT_TRUE(feed.wait_for_changes(&interruptor));
+        ql::changefeed::change_t change = feed.pop_change();
+        EXPECT_EQ(ql::datum_t::R_NULL, change.old_val->get_type());
+        EXPECT_EQ(i, change.new_val->as_int());
+    }
+    let_stuff_happen();
+    EXPECT_FALSE(feed.has_changes());
+}
+
+TEST(Changefeed, Delivery) {
+    run_in_thread_pool(&run_changefeed_delivery_test);
+}
+
+void run_changefeed_overflow_test() {
+    connectivity_cluster_t c;
+    mailbox_manager_t m(&c);
+    connectivity_cluster_t::run_t r(&c, get_unittest_addresses(), peer_address_t(),
+                                    ANY_PORT, &m, 0, NULL);
+
+    ql::changefeed::server_t server(&m);
+    ql::changefeed::feed_t feed(&m);
+    server.add_feed(feed.get_id(), feed.get_addr());
+
+    /* Writes don't wait for the feed, so the server gives up on it.  The first
+    change goes out by itself, and the rest queue up behind it until there are too
+    many. */
+    for (int i = 0; i < CHANGEFEED_MAX_QUEUED + 2; ++i) {
+        server.on_mod_report(changefeed_test_insert(i));
+    }
+
+    // The feed still gets the change that was sent before it was stopped.
+    cond_t interruptor;
+    int num_received = 0;
+    while (feed.wait_for_changes(&interruptor)) {
+        feed.pop_change();
+        ++num_received;
+    }
+    EXPECT_EQ(1, num_received);
+    EXPECT_NE(std::string(), feed.stop_reason());
+}
+
+TEST(Changefeed, Overflow) {
+    run_in_thread_pool(&run_changefeed_overflow_test);
+}
+
+}  // namespace unittest
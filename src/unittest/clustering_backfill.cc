@@ -20,9 +20,25 @@ boost::optional<boost::optional<backfiller_business_card_t<dummy_protocol_t> > >
     return boost::optional<boost::optional<backfiller_business_card_t<dummy_protocol_t> > >(inner);
 }
 
+/* Counts the backfill chunks it receives for each key. */
+class chunk_counting_store_t : public dummy_protocol_t::store_t {
+public:
+    void receive_backfill(const dummy_protocol_t::backfill_chunk_t &chunk,
+                          write_token_pair_t *token_pair,
+                          signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+        ++chunks_received[chunk.key];
+        dummy_protocol_t::store_t::receive_backfill(chunk, token_pair, interruptor);
+    }
+
+    std::map<std::string, int> chunks_received;
+};
+
 }   /* anonymous namespace */
 
-void run_backfill_test() {
+/* If `resume` is true, the backfillee starts out with the first half of the
+keys already backfilled, as if an earlier backfill had been interrupted after
+finishing a slice. */
+void run_backfill_test(bool resume) {
 
     order_source_t order_source;
 
@@ -34,7 +50,7 @@ void run_backfill_test() {
     }
 
     dummy_protocol_t::store_t backfiller_store;
-    dummy_protocol_t::store_t backfillee_store;
+    chunk_counting_store_t backfillee_store;
 
     in_memory_branch_history_manager_t<mock::dummy_protocol_t> branch_history_manager;
     branch_id_t dummy_branch_id = generate_uuid();
@@ -100,16 +116,36 @@ void run_backfill_test() {
         }
     }
 
+    dummy_protocol_t::region_t done_region('a', 'm');
+    if (resume) {
+        for (std::set<std::string>::iterator it = done_region.keys.begin(); it != done_region.keys.end(); ++it) {
+            backfillee_store.values[*it] = backfiller_store.values[*it];
+            backfillee_store.timestamps[*it] = backfiller_store.timestamps[*it];
+        }
+
+        cond_t non_interruptor;
+        object_buffer_t<fifo_enforcer_sink_t::exit_write_t> token;
+        backfillee_store.new_write_token(&token);
+        backfillee_store.set_metainfo(
+            region_map_t<dummy_protocol_t, binary_blob_t>(done_region,
+                                                          binary_blob_t(version_range_t(version_t(dummy_branch_id, timestamp)))),
+            order_source.check_in("set_metainfo(resume)"),
+            &token,
+            &non_interruptor);
+    }
+
     // Set up a cluster so mailboxes can be created
 
     simple_mailbox_cluster_t cluster;
 
     /* Expose the backfiller to the cluster */
 
+    watchable_variable_t<int64_t> backfill_bytes_per_sec(DEFAULT_BACKFILL_BYTES_PER_SEC);
     backfiller_t<dummy_protocol_t> backfiller(
         cluster.get_mailbox_manager(),
         &branch_history_manager,
-        &backfiller_store);
+        &backfiller_store,
+        backfill_bytes_per_sec.get_watchable());
 
     watchable_variable_t<boost::optional<backfiller_business_card_t<dummy_protocol_t> > > pseudo_directory(
         boost::optional<backfiller_business_card_t<dummy_protocol_t> >(backfiller.get_business_card()));
@@ -132,6 +168,14 @@ void run_backfill_test() {
         std::string key(1, c);
         EXPECT_EQ(backfiller_store.values[key], backfillee_store.values[key]);
         EXPECT_TRUE(backfiller_store.timestamps[key] == backfillee_store.timestamps[key]);
+
+        /* Keys in the slice that was already finished must not be sent
+        again; every other key that was written must be. */
+        if (resume && done_region.keys.count(key) != 0) {
+            EXPECT_EQ(0, backfillee_store.chunks_received[key]) << "key " << key;
+        } else if (backfiller_store.timestamps[key] != state_timestamp_t::zero()) {
+            EXPECT_LE(1, backfillee_store.chunks_received[key]) << "key " << key;
+        }
     }
 
     object_buffer_t<fifo_enforcer_sink_t::exit_read_t> token1;
@@ -163,7 +207,11 @@ void run_backfill_test() {
     //EXPECT_EQ(timestamp, backfillee_metadata[0].second.earliest.timestamp);
 }
 TEST(ClusteringBackfill, BackfillTest) {
-    unittest::run_in_thread_pool(&run_backfill_test);
+    unittest::run_in_thread_pool(boost::bind(&run_backfill_test, false));
+}
+
+TEST(ClusteringBackfill, ResumeBackfillTest) {
+    unittest::run_in_thread_pool(boost::bind(&run_backfill_test, true));
 }
 
 }   /* namespace unittest */
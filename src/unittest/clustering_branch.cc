@@ -114,7 +114,8 @@ void run_read_write_test(UNUSED io_backender_t *io_backender,
                          order_source_t *order_source) {
     /* Set up a replier so the broadcaster can handle operations. */
     EXPECT_FALSE((*initial_listener)->get_broadcaster_lost_signal()->is_pulsed());
-    replier_t<dummy_protocol_t> replier(initial_listener->get(), cluster->get_mailbox_manager(), branch_history_manager);
+    watchable_variable_t<int64_t> backfill_bytes_per_sec(DEFAULT_BACKFILL_BYTES_PER_SEC);
+    replier_t<dummy_protocol_t> replier(initial_listener->get(), cluster->get_mailbox_manager(), branch_history_manager, backfill_bytes_per_sec.get_watchable());
 
     /* Give time for the broadcaster to see the replier. */
     let_stuff_happen();
@@ -162,6 +163,95 @@ TEST(ClusteringBranch, ReadWrite) {
     run_in_thread_pool_with_broadcaster(&run_read_write_test);
 }
 
+/* The `BatchedWrites` test starts many writes at once, so that the broadcaster
+sends them in batches to a second mirror that isn't readable, and checks that
+every write gets its own response from the readable mirror and that both
+mirrors perform them in order. */
+
+class counting_write_callback_t : public broadcaster_t<dummy_protocol_t>::write_callback_t, public cond_t {
+public:
+    counting_write_callback_t() : responses(0) { }
+    void on_response(peer_id_t, const dummy_protocol_t::write_response_t &) {
+        ++responses;
+    }
+    void on_done() {
+        pulse();
+    }
+    int responses;
+};
+
+void run_batched_writes_test(io_backender_t *io_backender,
+                             simple_mailbox_cluster_t *cluster,
+                             branch_history_manager_t<dummy_protocol_t> *branch_history_manager,
+                             clone_ptr_t<watchable_t<boost::optional<broadcaster_business_card_t<dummy_protocol_t> > > > broadcaster_metadata_view,
+                             scoped_ptr_t<broadcaster_t<dummy_protocol_t> > *broadcaster,
+                             test_store_t<dummy_protocol_t> *store,
+                             scoped_ptr_t<listener_t<dummy_protocol_t> > *initial_listener,
+                             order_source_t *order_source) {
+    watchable_variable_t<int64_t> backfill_bytes_per_sec(DEFAULT_BACKFILL_BYTES_PER_SEC);
+    replier_t<dummy_protocol_t> replier(initial_listener->get(), cluster->get_mailbox_manager(), branch_history_manager, backfill_bytes_per_sec.get_watchable());
+    watchable_variable_t<boost::optional<replier_business_card_t<dummy_protocol_t> > > replier_directory_controller(
+        boost::optional<replier_business_card_t<dummy_protocol_t> >(replier.get_business_card()));
+
+    /* The first mirror has a replier, so it gets write-reads. The second one
+    doesn't, so it gets plain writes, and those are the ones that are batched. */
+    test_store_t<dummy_protocol_t> store2(io_backender, order_source, static_cast<dummy_protocol_t::context_t *>(NULL));
+    cond_t interruptor;
+    listener_t<dummy_protocol_t> listener2(
+        base_path_t("."),
+        io_backender,
+        cluster->get_mailbox_manager(),
+        broadcaster_metadata_view->subview(&wrap_broadcaster_in_optional),
+        branch_history_manager,
+        &store2.store,
+        replier_directory_controller.get_watchable()->subview(&wrap_replier_in_optional),
+        generate_uuid(),
+        &get_global_perfmon_collection(),
+        &interruptor,
+        order_source);
+    let_stuff_happen();
+
+    /* Don't wait between writes, so they pile up for the mirror. There are
+    more of them than fit in one batch, and later writes overwrite the values
+    of earlier ones. */
+    const int num_writes = 200;
+    unittest::fake_fifo_enforcement_t enforce;
+    spawn_write_fake_ack_checker_t ack_checker;
+    cond_t non_interruptor;
+    boost::ptr_vector<counting_write_callback_t> write_callbacks;
+    std::map<std::string, std::string> values_inserted;
+    for (int i = 0; i < num_writes; i++) {
+        fifo_enforcer_sink_t::exit_write_t exiter(&enforce.sink, enforce.source.enter_write());
+        dummy_protocol_t::write_t w;
+        std::string key = std::string(1, 'a' + i % 26);
+        w.values[key] = values_inserted[key] = strprintf("%d", i);
+        write_callbacks.push_back(new counting_write_callback_t);
+        (*broadcaster)->spawn_write(w, &exiter, order_source->check_in("unittest::run_batched_writes_test(write)"), &write_callbacks.back(), &non_interruptor, &ack_checker);
+    }
+
+    for (int i = 0; i < num_writes; i++) {
+        write_callbacks[i].wait_lazily_unordered();
+        EXPECT_EQ(1, write_callbacks[i].responses);
+    }
+
+    for (std::map<std::string, std::string>::iterator it = values_inserted.begin();
+            it != values_inserted.end(); it++) {
+        EXPECT_EQ(it->second, store->store.values[it->first]);
+    }
+
+    /* A mirror acknowledges plain writes once it has queued them, before it
+    performs them, so give the second one a moment to catch up. */
+    let_stuff_happen();
+    for (std::map<std::string, std::string>::iterator it = values_inserted.begin();
+            it != values_inserted.end(); it++) {
+        EXPECT_EQ(it->second, store2.store.values[it->first]);
+    }
+}
+
+TEST(ClusteringBranch, BatchedWrites) {
+    run_in_thread_pool_with_broadcaster(&run_batched_writes_test);
+}
+
 /* The `Backfill` test starts up a node with one mirror, inserts some data, and
 then adds another mirror. */
 
@@ -196,7 +286,8 @@ void run_backfill_test(io_backender_t *io_backender,
                        order_source_t *order_source) {
     /* Set up a replier so the broadcaster can handle operations */
     EXPECT_FALSE((*initial_listener)->get_broadcaster_lost_signal()->is_pulsed());
-    replier_t<dummy_protocol_t> replier(initial_listener->get(), cluster->get_mailbox_manager(), branch_history_manager);
+    watchable_variable_t<int64_t> backfill_bytes_per_sec(DEFAULT_BACKFILL_BYTES_PER_SEC);
+    replier_t<dummy_protocol_t> replier(initial_listener->get(), cluster->get_mailbox_manager(), branch_history_manager, backfill_bytes_per_sec.get_watchable());
 
     watchable_variable_t<boost::optional<replier_business_card_t<dummy_protocol_t> > > replier_directory_controller(
         boost::optional<replier_business_card_t<dummy_protocol_t> >(replier.get_business_card()));
@@ -261,7 +352,8 @@ void run_partial_backfill_test(io_backender_t *io_backender,
                                order_source_t *order_source) {
     /* Set up a replier so the broadcaster can handle operations */
     EXPECT_FALSE((*initial_listener)->get_broadcaster_lost_signal()->is_pulsed());
-    replier_t<dummy_protocol_t> replier(initial_listener->get(), cluster->get_mailbox_manager(), branch_history_manager);
+    watchable_variable_t<int64_t> backfill_bytes_per_sec(DEFAULT_BACKFILL_BYTES_PER_SEC);
+    replier_t<dummy_protocol_t> replier(initial_listener->get(), cluster->get_mailbox_manager(), branch_history_manager, backfill_bytes_per_sec.get_watchable());
 
     watchable_variable_t<boost::optional<replier_business_card_t<dummy_protocol_t> > > replier_directory_controller(
         boost::optional<replier_business_card_t<dummy_protocol_t> >(replier.get_business_card()));
@@ -0,0 +1,201 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "unittest/gtest.hpp"
+
+#include "arch/io/disk.hpp"
+#include "arch/timing.hpp"
+#include "clustering/administration/persist.hpp"
+#include "clustering/administration/metadata.hpp"
+#include "containers/uuid.hpp"
+#include "mock/dummy_protocol.hpp"
+#include "rpc/semilattice/semilattice_manager.hpp"
+#include "unittest/unittest_utils.hpp"
+
+using mock::dummy_protocol_t;
+
+namespace unittest {
+
+namespace {
+
+cluster_semilattice_metadata_t make_metadata_with_tables(int num_tables, const machine_id_t &machine,
+                                                         std::vector<namespace_id_t> *table_ids_out) {
+    cluster_semilattice_metadata_t metadata;
+    cow_ptr_t<namespaces_semilattice_metadata_t<dummy_protocol_t> >::change_t change(&metadata.dummy_namespaces);
+    for (int i = 0; i < num_tables; ++i) {
+        name_string_t name;
+        bool assign_success = name.assign_value(strprintf("table%d", i));
+        guarantee(assign_success);
+        namespace_id_t table_id = generate_uuid();
+        change.get()->namespaces[table_id] = make_deletable(new_namespace<dummy_protocol_t>(
+            machine, generate_uuid(), generate_uuid(), name, "id", 0, GIGABYTE, DEFAULT_BTREE_BLOCK_SIZE));
+        table_ids_out->push_back(table_id);
+    }
+    return metadata;
+}
+
+/* Returns `metadata` with one table renamed, the way a small administrative
+change would look. */
+cluster_semilattice_metadata_t rename_table(const cluster_semilattice_metadata_t &metadata, const machine_id_t &machine,
+                                            const namespace_id_t &table_id, const std::string &new_name) {
+    cluster_semilattice_metadata_t updated = metadata;
+    cow_ptr_t<namespaces_semilattice_metadata_t<dummy_protocol_t> >::change_t change(&updated.dummy_namespaces);
+    namespace_semilattice_metadata_t<dummy_protocol_t> *ns = change.get()->namespaces[table_id].get_mutable();
+    name_string_t name;
+    bool assign_success = name.assign_value(new_name);
+    guarantee(assign_success);
+    ns->name = ns->name.make_new_version(name, machine);
+    return updated;
+}
+
+size_t serialized_size(const cluster_semilattice_metadata_t &metadata) {
+    write_message_t msg;
+    msg << metadata;
+    return msg.size();
+}
+
+void wait_for_connection(connectivity_cluster_t *cluster, peer_id_t peer) {
+    struct : public cond_t, public peers_list_callback_t {
+        void on_connect(UNUSED peer_id_t p) {
+            pulse();
+        }
+        void on_disconnect(UNUSED peer_id_t p) { }
+    } connection_established;
+    connectivity_service_t::peers_list_subscription_t subs(&connection_established);
+
+    {
+        ASSERT_FINITE_CORO_WAITING;
+        connectivity_service_t::peers_list_freeze_t freeze(cluster);
+        if (!cluster->get_peer_connected(peer)) {
+            subs.reset(cluster, &freeze);
+        } else {
+            connection_established.pulse();
+        }
+    }
+
+    connection_established.wait_lazily_unordered();
+}
+
+}   /* anonymous namespace */
+
+/* `Delta` checks that a delta of a small change carries just that change, and
+that joining it in gives the same result as joining the whole metadata. */
+
+TEST(ClusteringMetadataDelta, Delta) {
+    machine_id_t machine = generate_uuid();
+    std::vector<namespace_id_t> table_ids;
+    cluster_semilattice_metadata_t base = make_metadata_with_tables(100, machine, &table_ids);
+    cluster_semilattice_metadata_t updated = rename_table(base, machine, table_ids[17], "renamed");
+
+    cluster_semilattice_metadata_t delta = semilattice_delta(base, updated);
+    ASSERT_EQ(1u, delta.dummy_namespaces->namespaces.size());
+    EXPECT_EQ(table_ids[17], delta.dummy_namespaces->namespaces.begin()->first);
+    EXPECT_LT(serialized_size(delta) * 20, serialized_size(updated));
+
+    cluster_semilattice_metadata_t joined = base;
+    semilattice_join(&joined, delta);
+    EXPECT_TRUE(joined == updated);
+
+    /* A change made to an older version only needs what the newer one lacks:
+    the table it renamed, plus the one the newer version renamed differently. */
+    cluster_semilattice_metadata_t concurrent = rename_table(base, machine, table_ids[40], "concurrent");
+    cluster_semilattice_metadata_t concurrent_delta = semilattice_delta(updated, concurrent);
+    EXPECT_EQ(2u, concurrent_delta.dummy_namespaces->namespaces.size());
+    cluster_semilattice_metadata_t joined_delta = updated, joined_whole = updated;
+    semilattice_join(&joined_delta, concurrent_delta);
+    semilattice_join(&joined_whole, concurrent);
+    EXPECT_TRUE(joined_delta == joined_whole);
+
+    /* Deleting a table has to come through too. */
+    cluster_semilattice_metadata_t deleted = updated;
+    {
+        cow_ptr_t<namespaces_semilattice_metadata_t<dummy_protocol_t> >::change_t change(&deleted.dummy_namespaces);
+        change.get()->namespaces[table_ids[3]].mark_deleted();
+    }
+    semilattice_join(&joined, semilattice_delta(updated, deleted));
+    EXPECT_TRUE(joined == deleted);
+}
+
+/* `Persist` checks that metadata that was written as a series of deltas reads
+back the same, both before and after the deltas get folded into the full copy
+on disk. */
+
+void run_persist_test() {
+    temp_file_t temp_file;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+
+    machine_id_t machine = generate_uuid();
+    std::vector<namespace_id_t> table_ids;
+    cluster_semilattice_metadata_t metadata = make_metadata_with_tables(20, machine, &table_ids);
+
+    {
+        metadata_persistence::cluster_persistent_file_t file(&io_backender, temp_file.name(),
+            &get_global_perfmon_collection(), machine, metadata);
+        for (int i = 0; i < 200; ++i) {
+            metadata = rename_table(metadata, machine, table_ids[i % table_ids.size()], strprintf("renamed%d", i));
+            file.update_metadata(metadata);
+            if (i % 50 == 0) {
+                EXPECT_TRUE(file.read_metadata() == metadata);
+            }
+        }
+    }
+
+    metadata_persistence::cluster_persistent_file_t file(&io_backender, temp_file.name(),
+        &get_global_perfmon_collection());
+    EXPECT_EQ(machine, file.read_machine_id());
+    EXPECT_TRUE(file.read_metadata() == metadata);
+}
+
+TEST(ClusteringMetadataDelta, Persist) {
+    unittest::run_in_thread_pool(&run_persist_test);
+}
+
+/* `ChangeLatency` is a benchmark: it measures how long it takes for a change to
+one table to reach another node, with many tables in the metadata. It's
+disabled; run it with --gtest_also_run_disabled_tests. */
+
+void run_change_latency_test(int num_tables) {
+    machine_id_t machine = generate_uuid();
+    std::vector<namespace_id_t> table_ids;
+    cluster_semilattice_metadata_t metadata = make_metadata_with_tables(num_tables, machine, &table_ids);
+
+    connectivity_cluster_t cluster1, cluster2;
+    semilattice_manager_t<cluster_semilattice_metadata_t> slm1(&cluster1, metadata), slm2(&cluster2, metadata);
+    connectivity_cluster_t::run_t run1(&cluster1, get_unittest_addresses(), peer_address_t(), ANY_PORT, &slm1, 0, NULL);
+    connectivity_cluster_t::run_t run2(&cluster2, get_unittest_addresses(), peer_address_t(), ANY_PORT, &slm2, 0, NULL);
+
+    run1.join(cluster2.get_peer_address(cluster2.get_me()));
+    wait_for_connection(&cluster1, cluster2.get_me());
+
+    /* Let the full copies that get sent on connection go through first. */
+    cond_t non_interruptor;
+    slm1.get_root_view()->sync_to(cluster2.get_me(), &non_interruptor);
+
+    /* Making each version copies the whole metadata, so do it before we
+    start timing. */
+    static const int num_changes = 20;
+    std::vector<cluster_semilattice_metadata_t> versions;
+    for (int i = 0; i < num_changes; ++i) {
+        metadata = rename_table(metadata, machine, table_ids[i], strprintf("renamed%d", i));
+        versions.push_back(metadata);
+    }
+
+    ticks_t start = get_ticks();
+    for (int i = 0; i < num_changes; ++i) {
+        slm1.get_root_view()->join(versions[i]);
+        slm1.get_root_view()->sync_to(cluster2.get_me(), &non_interruptor);
+    }
+    ticks_t elapsed = get_ticks() - start;
+
+    EXPECT_TRUE(slm2.get_root_view()->get() == metadata);
+    printf("%d tables: %.3f ms per metadata change\n",
+           num_tables, ticks_to_secs(elapsed) * 1000 / num_changes);
+}
+
+TEST(ClusteringMetadataDelta, DISABLED_ChangeLatency1K) {
+    unittest::run_in_thread_pool(boost::bind(&run_change_latency_test, 1000), 2);
+}
+
+TEST(ClusteringMetadataDelta, DISABLED_ChangeLatency10K) {
+    unittest::run_in_thread_pool(boost::bind(&run_change_latency_test, 10000), 2);
+}
+
+}   /* namespace unittest */
@@ -7,6 +7,7 @@
 #include "clustering/immediate_consistency/query/master.hpp"
 #include "clustering/reactor/blueprint.hpp"
 #include "clustering/reactor/namespace_interface.hpp"
+#include "config/args.hpp"
 #include "unittest/branch_history_manager.hpp"
 #include "unittest/clustering_utils.hpp"
 #include "mock/dummy_protocol.hpp"
@@ -83,5 +84,84 @@ TEST(ClusteringNamespaceInterface, ReadOutdated) {
     unittest::run_in_thread_pool(&run_read_outdated_test);
 }
 
+/* Returns false if no replica was within `max_staleness_ms` of the primary. */
+static bool try_read_outdated_bounded(cluster_namespace_interface_t<dummy_protocol_t> *namespace_if,
+                                      int64_t max_staleness_ms) {
+    dummy_protocol_t::read_t r;
+    dummy_protocol_t::read_response_t rr;
+    r.keys.keys.insert("a");
+    cond_t non_interruptor;
+    try {
+        namespace_if->read_outdated_bounded(r, &rr, max_staleness_ms, &non_interruptor);
+    } catch (const cannot_perform_query_exc_t &) {
+        return false;
+    }
+    EXPECT_EQ("", rr.values["a"]);
+    return true;
+}
+
+/* Replicas don't know how far behind they are until the first heartbeat from
+the primary, so keep trying for a while. */
+static bool wait_for_read_outdated_bounded(cluster_namespace_interface_t<dummy_protocol_t> *namespace_if,
+                                           int64_t max_staleness_ms,
+                                           bool expected) {
+    for (int i = 0; i < 100; ++i) {
+        if (try_read_outdated_bounded(namespace_if, max_staleness_ms) == expected) {
+            return true;
+        }
+        nap(REPLICATION_HEARTBEAT_INTERVAL_MS);
+    }
+    return false;
+}
+
+static void run_read_outdated_bounded_test() {
+    test_cluster_group_t<dummy_protocol_t> cluster_group(2);
+
+    cluster_group.construct_all_reactors(cluster_group.compile_blueprint("p,s"));
+
+    cluster_group.wait_until_blueprint_is_satisfied("p,s");
+
+    scoped_ptr_t<cluster_namespace_interface_t<dummy_protocol_t> > namespace_if;
+    cluster_group.make_namespace_interface(0, &namespace_if);
+
+    /* Nothing is being written, so the replicas keep up with the heartbeats
+    and can serve a read that accepts data a minute old. */
+    EXPECT_TRUE(wait_for_read_outdated_bounded(namespace_if.get(), 60 * THOUSAND, true));
+}
+
+TEST(ClusteringNamespaceInterface, ReadOutdatedBounded) {
+    unittest::run_in_thread_pool(&run_read_outdated_bounded_test);
+}
+
+static void run_read_outdated_bounded_without_primary_test() {
+    test_cluster_group_t<dummy_protocol_t> cluster_group(2);
+
+    cluster_group.construct_all_reactors(cluster_group.compile_blueprint("p,s"));
+
+    cluster_group.wait_until_blueprint_is_satisfied("p,s");
+
+    scoped_ptr_t<cluster_namespace_interface_t<dummy_protocol_t> > namespace_if;
+    cluster_group.make_namespace_interface(1, &namespace_if);
+    ASSERT_TRUE(wait_for_read_outdated_bounded(namespace_if.get(), 60 * THOUSAND, true));
+
+    /* Take the primary away. The router still has the replicas' last good
+    status, so it tries them, and each one refuses because it can't tell how
+    far behind it is anymore. */
+    cluster_group.set_all_blueprints(cluster_group.compile_blueprint("s,s"));
+    EXPECT_TRUE(wait_for_read_outdated_bounded(namespace_if.get(), 60 * THOUSAND, false));
+
+    /* Reads that don't bound the staleness are still served. */
+    dummy_protocol_t::read_t r;
+    dummy_protocol_t::read_response_t rr;
+    r.keys.keys.insert("a");
+    cond_t non_interruptor;
+    namespace_if->read_outdated(r, &rr, &non_interruptor);
+    EXPECT_EQ("", rr.values["a"]);
+}
+
+TEST(ClusteringNamespaceInterface, ReadOutdatedBoundedWithoutPrimary) {
+    unittest::run_in_thread_pool(&run_read_outdated_bounded_without_primary_test);
+}
+
 }   /* namespace unittest */
 
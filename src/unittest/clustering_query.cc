@@ -62,7 +62,8 @@ static void run_read_write_test() {
         &interruptor,
         &order_source);
 
-    replier_t<dummy_protocol_t> initial_replier(&initial_listener, cluster.get_mailbox_manager(), &branch_history_manager);
+    watchable_variable_t<int64_t> backfill_bytes_per_sec(DEFAULT_BACKFILL_BYTES_PER_SEC);
+    replier_t<dummy_protocol_t> initial_replier(&initial_listener, cluster.get_mailbox_manager(), &branch_history_manager, backfill_bytes_per_sec.get_watchable());
 
     /* Set up a master */
     class : public ack_checker_t {
@@ -154,7 +155,8 @@ static void run_broadcaster_problem_test() {
         &interruptor,
         &order_source);
 
-    replier_t<dummy_protocol_t> initial_replier(&initial_listener, cluster.get_mailbox_manager(), &branch_history_manager);
+    watchable_variable_t<int64_t> backfill_bytes_per_sec(DEFAULT_BACKFILL_BYTES_PER_SEC);
+    replier_t<dummy_protocol_t> initial_replier(&initial_listener, cluster.get_mailbox_manager(), &branch_history_manager, backfill_bytes_per_sec.get_watchable());
 
     /* Set up a master. The ack checker is impossible to satisfy, so every
     write will return an error. */
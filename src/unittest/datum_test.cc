@@ -62,6 +62,78 @@ TEST(DatumTest, NumericSerialization) {
     test_datum_serialization(make_counted<ql::datum_t>(std::move(vec)));
 }
 
+void test_secondary_key_roundtrip(const counted_t<const ql::datum_t> &datum) {
+    const std::string key = datum->print_secondary(store_key_t("primary"));
+    counted_t<const ql::datum_t> extracted = ql::datum_t::extract_secondary_datum(key);
+    ASSERT_TRUE(extracted.has());
+    ASSERT_EQ(*datum, *extracted);
+}
+
+TEST(DatumTest, SecondaryKeyRoundtrip) {
+    std::vector<counted_t<const ql::datum_t> > inner;
+    inner.push_back(make_counted<const ql::datum_t>(-2.5));
+    inner.push_back(make_counted<const ql::datum_t>("nested"));
+    inner.push_back(make_counted<const ql::datum_t>(
+                        std::vector<counted_t<const ql::datum_t> >()));
+
+    std::vector<counted_t<const ql::datum_t> > outer;
+    outer.push_back(make_counted<const ql::datum_t>(ql::datum_t::R_BOOL, true));
+    outer.push_back(make_counted<const ql::datum_t>(std::move(inner)));
+    outer.push_back(make_counted<const ql::datum_t>(6.02214179e23));
+
+    std::vector<counted_t<const ql::datum_t> > values;
+    values.push_back(make_counted<const ql::datum_t>(0.0));
+    values.push_back(make_counted<const ql::datum_t>(-1.1));
+    values.push_back(make_counted<const ql::datum_t>(std::numeric_limits<double>::max()));
+    values.push_back(make_counted<const ql::datum_t>(""));
+    values.push_back(make_counted<const ql::datum_t>("a string"));
+    values.push_back(make_counted<const ql::datum_t>(ql::datum_t::R_BOOL, false));
+    values.push_back(make_counted<const ql::datum_t>(std::move(outer)));
+
+    for (auto it = values.begin(); it != values.end(); ++it) {
+        test_secondary_key_roundtrip(*it);
+    }
+}
+
+counted_t<const ql::datum_t> make_str_array(const std::string &a, const std::string &b) {
+    std::vector<counted_t<const ql::datum_t> > items;
+    items.push_back(make_counted<const ql::datum_t>(std::string(a)));
+    items.push_back(make_counted<const ql::datum_t>(std::string(b)));
+    return make_counted<const ql::datum_t>(std::move(items));
+}
+
+TEST(DatumTest, SecondaryKeyControlCharacters) {
+    // Array elements are separated by null characters, which strings can't
+    // contain, so strings with other control characters and strings that look
+    // like encoded elements must come back out as the same array.
+    const std::string escape(1, '\x01');
+    const std::string strs[] = { escape, escape + escape, escape + "\x02", "\x02",
+                                 "a" + escape + "Sb", "a" + escape + "\x01Sb" };
+    for (size_t i = 0; i < sizeof(strs) / sizeof(strs[0]); ++i) {
+        test_secondary_key_roundtrip(make_str_array(strs[i], "tail"));
+        test_secondary_key_roundtrip(make_str_array("head", strs[i]));
+
+        std::vector<counted_t<const ql::datum_t> > nested;
+        nested.push_back(make_str_array(strs[i], strs[i]));
+        nested.push_back(make_counted<const ql::datum_t>(std::string(strs[i])));
+        test_secondary_key_roundtrip(make_counted<const ql::datum_t>(std::move(nested)));
+    }
+
+    // Keys sort in the same order as the arrays they encode.
+    const std::string ordered[] = { "a", "a" + escape, "a" + escape + "b", "a\x02", "ab" };
+    for (size_t i = 0; i + 1 < sizeof(ordered) / sizeof(ordered[0]); ++i) {
+        counted_t<const ql::datum_t> lhs = make_str_array(ordered[i], "z");
+        counted_t<const ql::datum_t> rhs = make_str_array(ordered[i + 1], "");
+        ASSERT_LT(*lhs, *rhs);
+        ASSERT_LT(lhs->print_secondary(store_key_t("p")),
+                  rhs->print_secondary(store_key_t("p")));
+    }
+
+    // A null character can't get into a key in the first place.
+    ASSERT_THROW(make_counted<const ql::datum_t>(std::string("a\0Sb", 4)),
+                 ql::base_exc_t);
+}
+
 
 
 }  // namespace unittest
@@ -116,5 +116,39 @@ TEST(HashRegionTest, SpecialNonSquareRegionJoin) {
 
 
 
-}  // namespace unittest
+TEST(HashRegionTest, SplitByKeyCounts) {
+    hash_region_t<key_range_t> region(0, HASH_REGION_HASH_SIZE,
+                                      key_range_t(key_range_t::closed, store_key_t("b"), key_range_t::none, store_key_t()));
+    std::map<store_key_t, int64_t> key_counts;
+    key_counts[store_key_t("b")] = 100;
+    key_counts[store_key_t("c")] = 100;
+    key_counts[store_key_t("d")] = 100;
+    key_counts[store_key_t("e")] = 100;
+
+    // Too few keys to be worth splitting.
+    std::vector<hash_region_t<key_range_t> > pieces = region_split_by_key_counts(region, key_counts, 4, 1000);
+    ASSERT_EQ(1u, pieces.size());
+    ASSERT_TRUE(pieces[0] == region);
+
+    pieces = region_split_by_key_counts(region, key_counts, 2, 100);
+    ASSERT_EQ(2u, pieces.size());
+    assert_equal(key_range_t(key_range_t::closed, store_key_t("b"), key_range_t::open, store_key_t("d")), pieces[0].inner);
+    assert_equal(key_range_t(key_range_t::closed, store_key_t("d"), key_range_t::none, store_key_t()), pieces[1].inner);
+    ASSERT_EQ(region.beg, pieces[1].beg);
+    ASSERT_EQ(region.end, pieces[1].end);
+
+    pieces = region_split_by_key_counts(region, key_counts, 10, 100);
+    ASSERT_EQ(4u, pieces.size());
+    hash_region_t<key_range_t> joined;
+    ASSERT_EQ(REGION_JOIN_OK, region_join(pieces, &joined));
+    ASSERT_TRUE(joined == region);
+
+    // Cut points outside of the region are ignored.
+    hash_region_t<key_range_t> narrow(0, HASH_REGION_HASH_SIZE,
+                                      key_range_t(key_range_t::closed, store_key_t("b"), key_range_t::open, store_key_t("c")));
+    pieces = region_split_by_key_counts(narrow, key_counts, 4, 100);
+    ASSERT_EQ(1u, pieces.size());
+    ASSERT_TRUE(pieces[0] == narrow);
+}
 
+}  // namespace unittest
@@ -6,6 +6,7 @@
 
 #include "btree/internal_node.hpp"
 #include "btree/node.hpp"
+#include "containers/scoped.hpp"
 
 namespace unittest {
 
@@ -61,6 +62,59 @@ TEST(InternalNodeTest, Offsets) {
     EXPECT_EQ(9u, sizeof(btree_internal_pair));
 }
 
+TEST(InternalNodeTest, LookupWithSharedPrefixes) {
+    const block_size_t bs = block_size_t::unsafe_make(4096);
+    scoped_malloc_t<internal_node_t> node(bs.value());
+    internal_node::init(bs, node.get());
+
+    // Child i holds the keys in (key i - 1, key i].
+    const std::string prefix(60, 'p');
+    const int num_keys = 40;
+    for (int i = 0; i < num_keys; ++i) {
+        store_key_t key(strprintf("%s%04d", prefix.c_str(), i * 2));
+        ASSERT_TRUE(internal_node::insert(bs, node.get(), key.btree_key(), i, i + 1));
+    }
+    verify(bs, node.get());
+
+    for (int i = 0; i < num_keys * 2 + 1; ++i) {
+        store_key_t key(strprintf("%s%04d", prefix.c_str(), i));
+        EXPECT_EQ(static_cast<block_id_t>((i + 1) / 2),
+                  internal_node::lookup(node.get(), key.btree_key()));
+    }
+    EXPECT_EQ(0u, internal_node::lookup(node.get(), store_key_t("a").btree_key()));
+    EXPECT_EQ(0u, internal_node::lookup(node.get(), store_key_t(prefix).btree_key()));
+    EXPECT_EQ(static_cast<block_id_t>(num_keys),
+              internal_node::lookup(node.get(), store_key_t("q").btree_key()));
+}
+
+TEST(BtreeKeyTest, CmpSkipPrefix) {
+    const char *strings[] = { "", "a", "ab", "abc", "abcdefghij", "abcdefghijk",
+                              "abcdefghijklmnopqrstu", "abcdefghijklmnopqrstv",
+                              "abcdefgh", "abcdefgi", "b" };
+    const int num_strings = sizeof(strings) / sizeof(strings[0]);
+    for (int i = 0; i < num_strings; ++i) {
+        for (int j = 0; j < num_strings; ++j) {
+            store_key_t left(strings[i]);
+            store_key_t right(strings[j]);
+            const int expected = btree_key_cmp(left.btree_key(), right.btree_key());
+
+            int lcp = 0;
+            while (lcp < left.size() && lcp < right.size()
+                   && left.contents()[lcp] == right.contents()[lcp]) {
+                ++lcp;
+            }
+
+            for (int known = 0; known <= lcp; ++known) {
+                int common;
+                const int res = btree_key_cmp_skip_prefix(left.btree_key(), right.btree_key(),
+                                                          known, &common);
+                EXPECT_EQ(expected < 0, res < 0);
+                EXPECT_EQ(expected == 0, res == 0);
+                EXPECT_EQ(lcp, common);
+            }
+        }
+    }
+}
 
 }  // namespace unittest
 
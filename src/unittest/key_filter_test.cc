@@ -0,0 +1,390 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "arch/io/disk.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
+#include "btree/btree_store.hpp"
+#include "btree/key_filter.hpp"
+#include "btree/keys.hpp"
+#include "btree/operations.hpp"
+#include "btree/slice.hpp"
+#include "clustering/immediate_consistency/branch/metadata.hpp"
+#include "memcached/protocol.hpp"
+#include "rdb_protocol/btree.hpp"
+#include "rdb_protocol/protocol.hpp"
+#include "serializer/config.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TEST(BloomFilter, NoFalseNegatives) {
+    const int num_keys = 10000;
+    bloom_filter_t filter(num_keys);
+    for (int i = 0; i < num_keys; ++i) {
+        filter.add(store_key_t(strprintf("key %d", i)).btree_key());
+    }
+    EXPECT_EQ(num_keys, filter.num_added());
+
+    for (int i = 0; i < num_keys; ++i) {
+        EXPECT_TRUE(filter.may_contain(store_key_t(strprintf("key %d", i)).btree_key()));
+    }
+}
+
+TEST(BloomFilter, FalsePositiveRate) {
+    const int num_keys = 10000;
+    bloom_filter_t filter(num_keys);
+    for (int i = 0; i < num_keys; ++i) {
+        filter.add(store_key_t(strprintf("key %d", i)).btree_key());
+    }
+
+    int false_positives = 0;
+    for (int i = 0; i < num_keys; ++i) {
+        if (filter.may_contain(store_key_t(strprintf("missing %d", i)).btree_key())) {
+            ++false_positives;
+        }
+    }
+    // Ten bits per key should give about one percent.
+    EXPECT_LT(false_positives, num_keys * 3 / 100);
+}
+
+/* The tests below run the key filter of a store through `store_t::read()` and
+`store_t::write()`, which is where rebuilds get started. They use memcached
+stores because rdb reads and writes need a query context that the unit tests
+don't have; `memcached_get()` and the memcached sets use the filter the same way
+`rdb_get()` and `rdb_set()` do, and `RdbGetDuringRebuild` at the end calls
+those directly. */
+
+void set_filtered_key(memcached_protocol_t::store_t *store, const std::string &key) {
+    sarc_mutation_t set;
+    set.key = store_key_t(key);
+    set.data = data_buffer_t::create(key.size());
+    memcpy(set.data->buf(), key.data(), key.size());
+    set.flags = 0;
+    set.exptime = 0;
+    set.add_policy = add_policy_yes;
+    set.replace_policy = replace_policy_yes;
+    memcached_protocol_t::write_t write(set, time(NULL), 12345);
+    memcached_protocol_t::write_response_t response;
+
+    const region_map_t<memcached_protocol_t, binary_blob_t> metainfo(
+        store->get_region(), binary_blob_t(version_range_t(version_t::zero())));
+    write_token_pair_t token_pair;
+    store->new_write_token_pair(&token_pair);
+#ifndef NDEBUG
+    trivial_metainfo_checker_callback_t<memcached_protocol_t> metainfo_checker_callback;
+    metainfo_checker_t<memcached_protocol_t> metainfo_checker(&metainfo_checker_callback, store->get_region());
+#endif
+    cond_t non_interruptor;
+    store->write(DEBUG_ONLY(metainfo_checker, ) metainfo, write, &response,
+                 WRITE_DURABILITY_SOFT,
+                 transition_timestamp_t::starting_from(state_timestamp_t::zero()),
+                 order_token_t::ignore, &token_pair, &non_interruptor);
+}
+
+void delete_filtered_key(memcached_protocol_t::store_t *store, const std::string &key) {
+    memcached_protocol_t::write_t write(delete_mutation_t(store_key_t(key), false),
+                                        INVALID_CAS, time(NULL));
+    memcached_protocol_t::write_response_t response;
+
+    const region_map_t<memcached_protocol_t, binary_blob_t> metainfo(
+        store->get_region(), binary_blob_t(version_range_t(version_t::zero())));
+    write_token_pair_t token_pair;
+    store->new_write_token_pair(&token_pair);
+#ifndef NDEBUG
+    trivial_metainfo_checker_callback_t<memcached_protocol_t> metainfo_checker_callback;
+    metainfo_checker_t<memcached_protocol_t> metainfo_checker(&metainfo_checker_callback, store->get_region());
+#endif
+    cond_t non_interruptor;
+    store->write(DEBUG_ONLY(metainfo_checker, ) metainfo, write, &response,
+                 WRITE_DURABILITY_SOFT,
+                 transition_timestamp_t::starting_from(state_timestamp_t::zero()),
+                 order_token_t::ignore, &token_pair, &non_interruptor);
+}
+
+bool has_filtered_key(memcached_protocol_t::store_t *store, const std::string &key) {
+    memcached_protocol_t::read_t read(get_query_t(store_key_t(key)), time(NULL));
+    memcached_protocol_t::read_response_t response;
+
+    read_token_pair_t token_pair;
+    store->new_read_token_pair(&token_pair);
+#ifndef NDEBUG
+    trivial_metainfo_checker_callback_t<memcached_protocol_t> metainfo_checker_callback;
+    metainfo_checker_t<memcached_protocol_t> metainfo_checker(&metainfo_checker_callback, store->get_region());
+#endif
+    cond_t non_interruptor;
+    store->read(DEBUG_ONLY(metainfo_checker, ) read, &response,
+                order_token_t::ignore, &token_pair, &non_interruptor);
+    return boost::get<get_result_t>(response.result).value.has();
+}
+
+void wait_for_key_filter_rebuild(key_filter_t *key_filter) {
+    for (int i = 0; i < 1000 && key_filter->is_rebuilding(); ++i) {
+        nap(10);
+    }
+    ASSERT_FALSE(key_filter->is_rebuilding());
+}
+
+// How many of `num_keys` keys that were never inserted the filter rules out.
+int count_filtered_keys(key_filter_t *key_filter, const char *format, int num_keys) {
+    int filtered = 0;
+    for (int i = 0; i < num_keys; ++i) {
+        if (!key_filter->may_contain(store_key_t(strprintf(format, i)).btree_key())) {
+            ++filtered;
+        }
+    }
+    return filtered;
+}
+
+/* `InsertsDuringRebuild` keeps inserting while the first filter is built from
+a snapshot of the tree, so some of the keys land before `start_collecting()`
+and are picked up by the scan, and the others only get into the new filter
+through `on_insert()`. None of them may be filtered out afterwards. */
+
+void run_inserts_during_rebuild_test() {
+    const int num_old_keys = 20000;
+    const int max_new_keys = 20000;
+
+    temp_file_t temp_file;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    standard_serializer_t::create(&file_opener, standard_serializer_t::static_config_t());
+    standard_serializer_t serializer(standard_serializer_t::dynamic_config_t(),
+                                     &file_opener, &get_global_perfmon_collection());
+    memcached_protocol_t::store_t store(&serializer, temp_file.name().permanent_path(),
+                                        GIGABYTE, true, &get_global_perfmon_collection(),
+                                        NULL, &io_backender, base_path_t("."));
+
+    for (int i = 0; i < num_old_keys; ++i) {
+        set_filtered_key(&store, strprintf("old %d", i));
+    }
+
+    store.enable_key_filter();
+    key_filter_t *key_filter = store.btree->key_filter.get();
+    ASSERT_TRUE(key_filter->is_rebuilding());
+
+    int num_new_keys = 0;
+    while (key_filter->is_rebuilding() && num_new_keys < max_new_keys) {
+        set_filtered_key(&store, strprintf("new %d", num_new_keys));
+        ++num_new_keys;
+    }
+    ASSERT_FALSE(key_filter->is_rebuilding());
+    // Otherwise the test didn't test anything.
+    EXPECT_LT(0, num_new_keys);
+
+    for (int i = 0; i < num_old_keys; ++i) {
+        EXPECT_TRUE(has_filtered_key(&store, strprintf("old %d", i)));
+    }
+    for (int i = 0; i < num_new_keys; ++i) {
+        EXPECT_TRUE(has_filtered_key(&store, strprintf("new %d", i)));
+    }
+    EXPECT_LT(9000, count_filtered_keys(key_filter, "missing %d", 10000));
+}
+
+TEST(KeyFilter, InsertsDuringRebuild) {
+    run_in_thread_pool(&run_inserts_during_rebuild_test);
+}
+
+/* `AbandonRebuild` shuts the store down in the middle of a rebuild, which
+interrupts it, and checks that the filter built after the store is opened again
+still lets every key through. */
+
+void run_abandon_rebuild_test() {
+    const int num_old_keys = 20000;
+    // Few enough that the scan of the old keys is still running.
+    const int num_new_keys = 10;
+
+    temp_file_t temp_file;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    standard_serializer_t::create(&file_opener, standard_serializer_t::static_config_t());
+    standard_serializer_t serializer(standard_serializer_t::dynamic_config_t(),
+                                     &file_opener, &get_global_perfmon_collection());
+
+    {
+        memcached_protocol_t::store_t store(&serializer, temp_file.name().permanent_path(),
+                                            GIGABYTE, true, &get_global_perfmon_collection(),
+                                            NULL, &io_backender, base_path_t("."));
+        for (int i = 0; i < num_old_keys; ++i) {
+            set_filtered_key(&store, strprintf("old %d", i));
+        }
+
+        store.enable_key_filter();
+        for (int i = 0; i < num_new_keys; ++i) {
+            set_filtered_key(&store, strprintf("new %d", i));
+        }
+        ASSERT_TRUE(store.btree->key_filter->is_rebuilding());
+    }
+
+    memcached_protocol_t::store_t store(&serializer, temp_file.name().permanent_path(),
+                                        GIGABYTE, false, &get_global_perfmon_collection(),
+                                        NULL, &io_backender, base_path_t("."));
+    store.enable_key_filter();
+    key_filter_t *key_filter = store.btree->key_filter.get();
+    wait_for_key_filter_rebuild(key_filter);
+
+    for (int i = 0; i < num_old_keys; ++i) {
+        EXPECT_TRUE(has_filtered_key(&store, strprintf("old %d", i)));
+    }
+    for (int i = 0; i < num_new_keys; ++i) {
+        EXPECT_TRUE(has_filtered_key(&store, strprintf("new %d", i)));
+    }
+    EXPECT_LT(9000, count_filtered_keys(key_filter, "missing %d", 10000));
+}
+
+TEST(KeyFilter, AbandonRebuild) {
+    run_in_thread_pool(&run_abandon_rebuild_test);
+}
+
+/* `FalsePositiveRebuild` deletes most of the keys, which the filter can't
+forget, and looks them up until the false positive rate gets the filter rebuilt
+without them. */
+
+void run_false_positive_rebuild_test() {
+    const int num_keys = 20000;
+
+    temp_file_t temp_file;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    standard_serializer_t::create(&file_opener, standard_serializer_t::static_config_t());
+    standard_serializer_t serializer(standard_serializer_t::dynamic_config_t(),
+                                     &file_opener, &get_global_perfmon_collection());
+    memcached_protocol_t::store_t store(&serializer, temp_file.name().permanent_path(),
+                                        GIGABYTE, true, &get_global_perfmon_collection(),
+                                        NULL, &io_backender, base_path_t("."));
+
+    for (int i = 0; i < num_keys; ++i) {
+        set_filtered_key(&store, strprintf("key %d", i));
+    }
+    store.enable_key_filter();
+    key_filter_t *key_filter = store.btree->key_filter.get();
+    wait_for_key_filter_rebuild(key_filter);
+
+    // Keep every tenth key.
+    for (int i = 0; i < num_keys; ++i) {
+        if (i % 10 != 0) {
+            delete_filtered_key(&store, strprintf("key %d", i));
+        }
+    }
+    EXPECT_FALSE(key_filter->is_rebuilding());
+
+    // Every one of these lookups is a false positive, and the last one starts
+    // the rebuild.
+    int lookups = 0;
+    for (int i = 0; lookups < 2 * KEY_FILTER_MIN_NEGATIVE_LOOKUPS; ++i) {
+        if (i % 10 != 0) {
+            EXPECT_FALSE(has_filtered_key(&store, strprintf("key %d", i % num_keys)));
+            ++lookups;
+            if (key_filter->is_rebuilding()) {
+                break;
+            }
+        }
+    }
+    EXPECT_EQ(KEY_FILTER_MIN_NEGATIVE_LOOKUPS, lookups);
+    wait_for_key_filter_rebuild(key_filter);
+
+    int deleted_filtered = 0;
+    for (int i = 0; i < num_keys; ++i) {
+        if (i % 10 == 0) {
+            EXPECT_TRUE(has_filtered_key(&store, strprintf("key %d", i)));
+        } else if (!key_filter->may_contain(store_key_t(strprintf("key %d", i)).btree_key())) {
+            ++deleted_filtered;
+        }
+    }
+    EXPECT_LT(num_keys * 9 / 10 * 9 / 10, deleted_filtered);
+}
+
+TEST(KeyFilter, FalsePositiveRebuild) {
+    run_in_thread_pool(&run_false_positive_rebuild_test);
+}
+
+store_key_t rdb_filtered_key(const std::string &prefix, int i) {
+    return store_key_t(make_counted<const ql::datum_t>(strprintf("%s %d", prefix.c_str(), i))->print_primary());
+}
+
+void rdb_set_filtered_key(btree_store_t<rdb_protocol_t> *store, const store_key_t &key) {
+    cond_t non_interruptor;
+    scoped_ptr_t<transaction_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    write_token_pair_t token_pair;
+    store->new_write_token_pair(&token_pair);
+    store->acquire_superblock_for_write(repli_timestamp_t::invalid,
+                                        1, WRITE_DURABILITY_SOFT,
+                                        &token_pair, &txn, &superblock, &non_interruptor);
+
+    point_write_response_t response;
+    rdb_modification_info_t mod_info;
+    rdb_set(key, make_counted<const ql::datum_t>(1.0), false, store->btree.get(),
+            repli_timestamp_t::invalid, txn.get(), superblock.get(), &response,
+            &mod_info, static_cast<profile::trace_t *>(NULL));
+}
+
+bool rdb_has_filtered_key(btree_store_t<rdb_protocol_t> *store, const store_key_t &key) {
+    cond_t non_interruptor;
+    scoped_ptr_t<transaction_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    object_buffer_t<fifo_enforcer_sink_t::exit_read_t> token;
+    store->new_read_token(&token);
+    store->acquire_superblock_for_read(rwi_read, &token, &txn, &superblock,
+                                       &non_interruptor, false);
+
+    point_read_response_t response;
+    rdb_get(key, store->btree.get(), txn.get(), superblock.get(), &response,
+            static_cast<profile::trace_t *>(NULL));
+    return response.data->get_type() != ql::datum_t::R_NULL;
+}
+
+/* `RdbGetDuringRebuild` is `InsertsDuringRebuild` on an rdb btree. The inserts
+don't go through the store, so they yield to let the rebuild make progress. */
+
+void run_rdb_get_during_rebuild_test() {
+    const int num_old_keys = 20000;
+    const int max_new_keys = 20000;
+
+    temp_file_t temp_file;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    standard_serializer_t::create(&file_opener, standard_serializer_t::static_config_t());
+    standard_serializer_t serializer(standard_serializer_t::dynamic_config_t(),
+                                     &file_opener, &get_global_perfmon_collection());
+    rdb_protocol_t::store_t store(&serializer, temp_file.name().permanent_path(),
+                                  GIGABYTE, true, &get_global_perfmon_collection(),
+                                  NULL, &io_backender, base_path_t("."));
+
+    for (int i = 0; i < num_old_keys; ++i) {
+        rdb_set_filtered_key(&store, rdb_filtered_key("old", i));
+    }
+
+    store.enable_key_filter();
+    key_filter_t *key_filter = store.btree->key_filter.get();
+    ASSERT_TRUE(key_filter->is_rebuilding());
+
+    int num_new_keys = 0;
+    while (key_filter->is_rebuilding() && num_new_keys < max_new_keys) {
+        rdb_set_filtered_key(&store, rdb_filtered_key("new", num_new_keys));
+        ++num_new_keys;
+        coro_t::yield();
+    }
+    ASSERT_FALSE(key_filter->is_rebuilding());
+    // Otherwise the test didn't test anything.
+    EXPECT_LT(0, num_new_keys);
+
+    for (int i = 0; i < num_old_keys; ++i) {
+        EXPECT_TRUE(rdb_has_filtered_key(&store, rdb_filtered_key("old", i)));
+    }
+    for (int i = 0; i < num_new_keys; ++i) {
+        EXPECT_TRUE(rdb_has_filtered_key(&store, rdb_filtered_key("new", i)));
+    }
+    int filtered = 0;
+    for (int i = 0; i < 10000; ++i) {
+        if (!key_filter->may_contain(rdb_filtered_key("missing", i).btree_key())) {
+            ++filtered;
+        }
+    }
+    EXPECT_LT(9000, filtered);
+}
+
+TEST(KeyFilter, RdbGetDuringRebuild) {
+    run_in_thread_pool(&run_rdb_get_during_rebuild_test);
+}
+
+}  // namespace unittest
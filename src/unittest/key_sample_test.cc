@@ -0,0 +1,138 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <set>
+
+#include "btree/key_sample.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+store_key_t sample_test_key(int i) {
+    return store_key_t(strprintf("key %06d", i));
+}
+
+void insert_sample_test_key(btree_statblock_t *stat_block, int i) {
+    ++stat_block->population;
+    key_sample_on_insert(stat_block, sample_test_key(i).btree_key());
+}
+
+void delete_sample_test_key(btree_statblock_t *stat_block, int i) {
+    --stat_block->population;
+    key_sample_on_delete(stat_block, sample_test_key(i).btree_key());
+}
+
+TEST(KeySample, StaysUniformUnderDeletes) {
+    scoped_ptr_t<btree_statblock_t> stat_block(new btree_statblock_t);
+    const int num_keys = 20000;
+    for (int i = 0; i < num_keys; ++i) {
+        insert_sample_test_key(stat_block.get(), i);
+    }
+    // Delete the lower half of the keys, and insert as many new ones above.
+    for (int i = 0; i < num_keys / 2; ++i) {
+        delete_sample_test_key(stat_block.get(), i);
+        insert_sample_test_key(stat_block.get(), num_keys + i);
+    }
+
+    std::vector<store_key_t> keys;
+    get_key_sample(stat_block.get(), &keys);
+    EXPECT_EQ(btree_key_sample_t::max_keys, static_cast<int>(keys.size()));
+
+    int in_upper_half = 0;
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        EXPECT_TRUE(sample_test_key(num_keys / 2) <= *it);
+        if (sample_test_key(num_keys) <= *it) {
+            ++in_upper_half;
+        }
+    }
+    // About half of the sample should be among the keys inserted last.
+    EXPECT_LT(static_cast<int>(keys.size()) / 4, in_upper_half);
+    EXPECT_GT(static_cast<int>(keys.size()) * 3 / 4, in_upper_half);
+}
+
+TEST(KeySample, RangeErase) {
+    scoped_ptr_t<btree_statblock_t> stat_block(new btree_statblock_t);
+    const int num_keys = 1000;
+    for (int i = 0; i < num_keys; ++i) {
+        insert_sample_test_key(stat_block.get(), i);
+    }
+
+    key_sample_eraser_t eraser;
+    eraser.init(stat_block.get());
+    for (int i = 0; i < num_keys / 2; ++i) {
+        eraser.on_erase(sample_test_key(i).btree_key());
+        --stat_block->population;
+    }
+    eraser.apply(stat_block.get());
+
+    std::vector<store_key_t> keys;
+    get_key_sample(stat_block.get(), &keys);
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        EXPECT_TRUE(sample_test_key(num_keys / 2) <= *it);
+    }
+    EXPECT_EQ(num_keys / 2, stat_block->key_sample.deleted_from_sample
+                            + stat_block->key_sample.deleted_outside_sample);
+
+    // Emptying the tree resets the sample.
+    for (int i = num_keys / 2; i < num_keys; ++i) {
+        delete_sample_test_key(stat_block.get(), i);
+    }
+    EXPECT_EQ(0, stat_block->key_sample.num_keys);
+    EXPECT_EQ(0, stat_block->key_sample.deleted_from_sample);
+    EXPECT_EQ(0, stat_block->key_sample.deleted_outside_sample);
+}
+
+TEST(KeySample, IgnoresStatBlocksWithoutSample) {
+    scoped_ptr_t<btree_statblock_t> stat_block(new btree_statblock_t);
+    // Stat blocks from before the sample have something else where its magic is.
+    memset(&stat_block->key_sample.magic, 0, sizeof(stat_block->key_sample.magic));
+    stat_block->population = 10;
+    EXPECT_FALSE(key_sample_is_valid(stat_block.get()));
+
+    insert_sample_test_key(stat_block.get(), 10);
+    EXPECT_FALSE(key_sample_is_valid(stat_block.get()));
+
+    // Once the tree is empty, the sample can start over.
+    stat_block->population = 0;
+    insert_sample_test_key(stat_block.get(), 0);
+    EXPECT_TRUE(key_sample_is_valid(stat_block.get()));
+    EXPECT_EQ(1, stat_block->key_sample.num_keys);
+}
+
+TEST(KeySample, Seeding) {
+    scoped_ptr_t<btree_statblock_t> stat_block(new btree_statblock_t);
+    memset(&stat_block->key_sample.magic, 0, sizeof(stat_block->key_sample.magic));
+    const int num_keys = 10000;
+    stat_block->population = num_keys;
+
+    key_sample_seeder_t seeder;
+    for (int i = 0; i < num_keys; ++i) {
+        seeder.add(sample_test_key(i).btree_key());
+    }
+    seeder.apply(stat_block.get());
+    ASSERT_TRUE(key_sample_is_valid(stat_block.get()));
+
+    std::vector<store_key_t> keys;
+    get_key_sample(stat_block.get(), &keys);
+    EXPECT_EQ(btree_key_sample_t::max_keys, static_cast<int>(keys.size()));
+    int in_lower_half = 0;
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        if (*it < sample_test_key(num_keys / 2)) {
+            ++in_lower_half;
+        }
+    }
+    EXPECT_LT(static_cast<int>(keys.size()) / 4, in_lower_half);
+    EXPECT_GT(static_cast<int>(keys.size()) * 3 / 4, in_lower_half);
+
+    // The seeded sample is kept up to date like any other.
+    delete_sample_test_key(stat_block.get(), 0);
+    insert_sample_test_key(stat_block.get(), num_keys);
+    EXPECT_EQ(0, stat_block->key_sample.deleted_from_sample
+                 + stat_block->key_sample.deleted_outside_sample);
+
+    // A sample that became valid while the seeding pass ran is left alone.
+    key_sample_seeder_t late_seeder;
+    late_seeder.add(sample_test_key(0).btree_key());
+    late_seeder.apply(stat_block.get());
+    EXPECT_EQ(btree_key_sample_t::max_keys, stat_block->key_sample.num_keys);
+}
+
+}  // namespace unittest
@@ -1,6 +1,10 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
+#include <math.h>
+
+#include <algorithm>
 #include <map>
 
+#include "btree/internal_node.hpp"
 #include "btree/leaf_node.hpp"
 #include "btree/node.hpp"
 #include "containers/scoped.hpp"
@@ -158,16 +162,13 @@ public:
                 // Copy keys from front of sibling until and including replacement key.
 
                 std::map<store_key_t, std::string>::iterator p = sibling->kv_.begin();
-                while (p != sibling->kv_.end() && p->first < replacement) {
+                while (p != sibling->kv_.end() && p->first <= replacement) {
                     kv_[p->first] = p->second;
                     std::map<store_key_t, std::string>::iterator prev = p;
                     ++p;
                     sibling->kv_.erase(prev);
                 }
                 ASSERT_TRUE(p != sibling->kv_.end());
-                ASSERT_EQ(key_to_unescaped_str(p->first), key_to_unescaped_str(replacement));
-                kv_[p->first] = p->second;
-                sibling->kv_.erase(p);
             } else {
                 // Copy keys from end of sibling until but not including replacement key.
 
@@ -180,7 +181,7 @@ public:
                     sibling->kv_.erase(prev);
                 }
 
-                ASSERT_EQ(key_to_unescaped_str(p->first), key_to_unescaped_str(replacement));
+                ASSERT_TRUE(p->first <= replacement);
             }
         }
 
@@ -190,7 +191,7 @@ public:
         sibling->Verify();
     }
 
-    void Split(LeafNodeTracker *right) {
+    void Split(LeafNodeTracker *right, store_key_t *median_out = NULL) {
         ASSERT_EQ(bs_.ser_value(), right->bs_.ser_value());
 
         ASSERT_TRUE(leaf::is_empty(right->node()));
@@ -207,7 +208,11 @@ public:
             kv_.erase(prev);
         }
 
-        ASSERT_EQ(key_to_unescaped_str(p->first), key_to_unescaped_str(median));
+        ASSERT_TRUE(p->first <= median);
+
+        if (median_out != NULL) {
+            *median_out = median;
+        }
     }
 
     bool IsFull(const store_key_t& key, const std::string& value) {
@@ -605,6 +610,26 @@ TEST(LeafNodeTest, Splitting) {
     left.Split(&right);
 }
 
+TEST(LeafNodeTest, SplittingTruncatesSeparator) {
+    LeafNodeTracker left;
+    const std::string prefix(100, 'p');
+    for (int i = 0; i < 30; ++i) {
+        left.Insert(store_key_t(strprintf("%s%03d", prefix.c_str(), i)), std::string(100, 'v'));
+    }
+
+    LeafNodeTracker right;
+    store_key_t median;
+    left.Split(&right, &median);
+
+    // The separator is the common prefix of the keys around the split point
+    // plus one distinguishing byte, not a whole key.
+    ASSERT_LT(median.size(), static_cast<int>(prefix.size()) + 3);
+    ASSERT_FALSE(left.kv_.empty());
+    ASSERT_FALSE(right.kv_.empty());
+    ASSERT_TRUE(left.kv_.rbegin()->first <= median);
+    ASSERT_TRUE(median < right.kv_.begin()->first);
+}
+
 TEST(LeafNodeTest, Fullness) {
     LeafNodeTracker node;
     int i;
@@ -615,4 +640,349 @@ TEST(LeafNodeTest, Fullness) {
     ASSERT_TRUE(node.IsFull(store_key_t(strprintf("a%d", i)), strprintf("A%d", i)));
 }
 
+// The low bits of `rng_t::randint()` repeat after about a million draws, so
+// these take theirs from `randdouble()`.
+std::string random_uuid_key(rng_t *rng) {
+    std::string key;
+    for (int i = 0; i < 36; ++i) {
+        key += (i == 8 || i == 13 || i == 18 || i == 23)
+            ? '-' : "0123456789abcdef"[static_cast<int>(rng->randdouble() * 16)];
+    }
+    return key;
+}
+
+// Shaped like the keys `print_secondary()` makes for a string index value
+// with few distinct values: the value, then the primary key, then its size.
+std::string random_secondary_key(rng_t *rng) {
+    std::string primary = "S" + random_uuid_key(rng);
+    return strprintf("Scustomer_%06d", static_cast<int>(rng->randdouble() * 1000)) + primary
+        + std::string(1, static_cast<char>(primary.size()));
+}
+
+// Splits leaves the way the btree does while `num_keys` keys from `make_key`
+// are inserted in random order, and collects the keys that end up separating
+// the leaves: the shortest separators `leaf::split()` produces, and the last
+// key of each leaf but the last one, which is what it used to produce.  The
+// leaves go to `leaves_out` if it isn't null, and are freed otherwise.
+void build_leaf_level(block_size_t bs, std::string (*make_key)(rng_t *), int num_keys,
+                      std::vector<store_key_t> *separators_out,
+                      std::vector<store_key_t> *full_separators_out,
+                      std::vector<leaf_node_t *> *leaves_out) {
+    rng_t rng(0);
+    value_sizer_t<short_value_t> sizer(bs);
+    short_value_buffer_t value(std::string(16, 'v'));
+    repli_timestamp_t tstamp = repli_timestamp_t::distant_past;
+
+    std::vector<leaf_node_t *> leaves;
+    leaves.push_back(static_cast<leaf_node_t *>(malloc(bs.value())));
+    leaf::init(&sizer, leaves.back());
+    // `(*separators_out)[i]` separates `leaves[i]` and `leaves[i + 1]`.
+    separators_out->clear();
+    full_separators_out->clear();
+
+    for (int i = 0; i < num_keys; ++i) {
+        store_key_t key(make_key(&rng));
+        size_t index = std::lower_bound(separators_out->begin(), separators_out->end(), key)
+            - separators_out->begin();
+        if (leaf::is_full(&sizer, leaves[index], key.btree_key(), value.data())) {
+            leaf_node_t *rnode = static_cast<leaf_node_t *>(malloc(bs.value()));
+            leaf::init(&sizer, rnode);
+            store_key_t separator;
+            leaf::split(&sizer, leaves[index], rnode, separator.btree_key());
+            leaves.insert(leaves.begin() + index + 1, rnode);
+            separators_out->insert(separators_out->begin() + index, separator);
+            if (separator < key) {
+                ++index;
+            }
+        }
+        ++tstamp.longtime;
+        leaf::insert(&sizer, leaves[index], key.btree_key(), value.data(), tstamp,
+                     key_modification_proof_t::real_proof());
+    }
+
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        if (i + 1 < leaves.size()) {
+            store_key_t last_key;
+            for (auto it = leaf::begin(*leaves[i]); it != leaf::end(*leaves[i]); ++it) {
+                last_key.assign((*it).first);
+            }
+            full_separators_out->push_back(last_key);
+        }
+        if (leaves_out == NULL) {
+            free(leaves[i]);
+        }
+    }
+    if (leaves_out != NULL) {
+        leaves_out->swap(leaves);
+    }
+}
+
+// Packs `separators` into as few internal nodes as they fit in, and times
+// looking up `probes` in them.  Returns the number of nodes.
+size_t pack_and_probe(block_size_t bs, const std::vector<store_key_t> &separators,
+                      const std::vector<store_key_t> &probes, double *ns_per_lookup_out) {
+    std::vector<internal_node_t *> nodes;
+    // `node_bounds[i]` separates `nodes[i]` and `nodes[i + 1]`.
+    std::vector<store_key_t> node_bounds;
+    size_t i = 0;
+    block_id_t child = 0;
+    for (;;) {
+        nodes.push_back(static_cast<internal_node_t *>(malloc(bs.value())));
+        internal_node::init(bs, nodes.back());
+        while (i < separators.size() && !internal_node::is_full(nodes.back())) {
+            internal_node::insert(bs, nodes.back(), separators[i].btree_key(), child, child + 1);
+            ++i;
+            ++child;
+        }
+        if (i == separators.size()) {
+            break;
+        }
+        // This one would go into the node above.
+        node_bounds.push_back(separators[i]);
+        ++i;
+        ++child;
+    }
+
+    ticks_t start = get_ticks();
+    block_id_t max_found = 0;
+    for (size_t j = 0; j < probes.size(); ++j) {
+        size_t index = std::lower_bound(node_bounds.begin(), node_bounds.end(), probes[j])
+            - node_bounds.begin();
+        if (nodes[index]->npairs > 0) {
+            max_found = std::max(max_found, internal_node::lookup(nodes[index], probes[j].btree_key()));
+        }
+    }
+    *ns_per_lookup_out = static_cast<double>(get_ticks() - start) / probes.size();
+    EXPECT_LE(max_found, child);
+
+    const size_t num_nodes = nodes.size();
+    for (size_t j = 0; j < nodes.size(); ++j) {
+        free(nodes[j]);
+    }
+    return num_nodes;
+}
+
+void run_separator_benchmark(const char *name, std::string (*make_key)(rng_t *)) {
+    const int num_keys = 200000;
+    const block_size_t bs = block_size_t::unsafe_make(4096);
+    std::vector<store_key_t> separators, full_separators;
+    build_leaf_level(bs, make_key, num_keys, &separators, &full_separators, NULL);
+
+    double bytes = 0, full_bytes = 0;
+    for (size_t i = 0; i < separators.size(); ++i) {
+        ASSERT_LE(full_separators[i], separators[i]);
+        bytes += separators[i].size();
+        full_bytes += full_separators[i].size();
+    }
+
+    rng_t rng(1);
+    std::vector<store_key_t> probes;
+    for (int i = 0; i < 1000000; ++i) {
+        probes.push_back(store_key_t(make_key(&rng)));
+    }
+    double ns, full_ns;
+    const size_t nodes = pack_and_probe(bs, separators, probes, &ns);
+    const size_t full_nodes = pack_and_probe(bs, full_separators, probes, &full_ns);
+
+    printf("%s: %d keys in %zu leaves (%.1f per leaf)\n", name, num_keys,
+           separators.size() + 1, static_cast<double>(num_keys) / (separators.size() + 1));
+    printf("  separator bytes: %.1f shortest, %.1f last key\n",
+           bytes / separators.size(), full_bytes / separators.size());
+    printf("  entries per internal node: %.1f shortest, %.1f last key\n",
+           static_cast<double>(separators.size()) / nodes,
+           static_cast<double>(separators.size()) / full_nodes);
+    printf("  internal lookup: %.0f ns shortest, %.0f ns last key\n", ns, full_ns);
+}
+
+// Measures what `shortest_separator()` buys.  Disabled, since it's a
+// benchmark; run it with --gtest_also_run_disabled_tests.
+TEST(LeafNodeTest, DISABLED_SeparatorBenchmark) {
+    run_separator_benchmark("uuid primary keys", &random_uuid_key);
+    run_separator_benchmark("secondary index keys", &random_secondary_key);
+}
+
+// Binary searches the sorted `keys` for `key` the way `leaf::find_key()` does.
+// With `skip_prefix`, each comparison skips the prefix that `key` shares with
+// the keys at both ends of the remaining range, and otherwise it compares whole
+// keys, the way `find_key()` used to.  Returns the index of the first key that
+// isn't less than `key`.
+template <bool skip_prefix>
+int search_keys(const std::vector<const btree_key_t *> &keys, const btree_key_t *key) {
+    int beg = 0;
+    int end = keys.size();
+    int beg_common = 0;
+    int end_common = 0;
+    while (beg < end) {
+        int test_point = beg + (end - beg) / 2;
+        int common = 0;
+        int res = skip_prefix
+            ? btree_key_cmp_skip_prefix(key, keys[test_point], std::min(beg_common, end_common), &common)
+            : btree_key_cmp(key, keys[test_point]);
+        if (res < 0) {
+            end = test_point;
+            end_common = common;
+        } else if (res > 0) {
+            beg = test_point + 1;
+            beg_common = common;
+        } else {
+            return test_point;
+        }
+    }
+    return beg;
+}
+
+// Times searching the leaves that `probe_leaves` says hold `probes`, the way
+// `search_keys()` does and with `leaf::find_key()`, and prints the best times
+// out of a few rounds.
+void time_key_searches(const char *name,
+                       const std::vector<leaf_node_t *> &leaves,
+                       const std::vector<std::vector<const btree_key_t *> > &leaf_keys,
+                       const std::vector<store_key_t> &probes,
+                       const std::vector<size_t> &probe_leaves) {
+    double whole_ns = HUGE_VAL, skip_ns = HUGE_VAL, find_key_ns = HUGE_VAL;
+    for (int round = 0; round < 3; ++round) {
+        int64_t whole_sum = 0, skip_sum = 0;
+        ticks_t start = get_ticks();
+        for (size_t i = 0; i < probes.size(); ++i) {
+            whole_sum += search_keys<false>(leaf_keys[probe_leaves[i]], probes[i].btree_key());
+        }
+        whole_ns = std::min(whole_ns, static_cast<double>(get_ticks() - start) / probes.size());
+
+        start = get_ticks();
+        for (size_t i = 0; i < probes.size(); ++i) {
+            skip_sum += search_keys<true>(leaf_keys[probe_leaves[i]], probes[i].btree_key());
+        }
+        skip_ns = std::min(skip_ns, static_cast<double>(get_ticks() - start) / probes.size());
+        EXPECT_EQ(whole_sum, skip_sum);
+
+        int found = 0;
+        start = get_ticks();
+        for (size_t i = 0; i < probes.size(); ++i) {
+            int index;
+            found += leaf::find_key(leaves[probe_leaves[i]], probes[i].btree_key(), &index);
+        }
+        find_key_ns = std::min(find_key_ns, static_cast<double>(get_ticks() - start) / probes.size());
+        EXPECT_EQ(static_cast<int>(probes.size()), found);
+    }
+    printf("  %s: %.0f ns comparing whole keys, %.0f ns skipping shared prefixes; "
+           "leaf::find_key(): %.0f ns\n", name, whole_ns, skip_ns, find_key_ns);
+}
+
+void run_key_search_benchmark(const char *name, std::string (*make_key)(rng_t *)) {
+    const int num_keys = 200000;
+    const block_size_t bs = block_size_t::unsafe_make(4096);
+    std::vector<store_key_t> separators, full_separators;
+    std::vector<leaf_node_t *> leaves;
+    build_leaf_level(bs, make_key, num_keys, &separators, &full_separators, &leaves);
+
+    // The keys of each leaf, in order, pointing into the leaf itself.
+    std::vector<std::vector<const btree_key_t *> > leaf_keys(leaves.size());
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        for (auto it = leaf::begin(*leaves[i]); it != leaf::end(*leaves[i]); ++it) {
+            leaf_keys[i].push_back((*it).first);
+        }
+    }
+
+    printf("%s: %.1f keys per leaf\n", name, static_cast<double>(num_keys) / leaves.size());
+
+    // Look up keys that are there, in random order: first from every leaf, so
+    // that most lookups miss the cache, and then from only a few leaves, so
+    // that the comparisons are most of what is left.
+    const size_t leaf_counts[] = { leaves.size(), 8 };
+    const char *leaf_count_names[] = { "all leaves", "8 leaves" };
+    for (int j = 0; j < 2; ++j) {
+        rng_t rng(1);
+        std::vector<store_key_t> probes;
+        std::vector<size_t> probe_leaves;
+        for (int i = 0; i < 1000000; ++i) {
+            const size_t leaf_index = rng.randint(leaf_counts[j]) * (leaves.size() / leaf_counts[j]);
+            const std::vector<const btree_key_t *> &keys = leaf_keys[leaf_index];
+            probes.push_back(store_key_t(keys[rng.randint(keys.size())]));
+            probe_leaves.push_back(leaf_index);
+        }
+        time_key_searches(leaf_count_names[j], leaves, leaf_keys, probes, probe_leaves);
+    }
+
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        free(leaves[i]);
+    }
+}
+
+// Measures what `btree_key_cmp_skip_prefix()` saves in a leaf's binary search
+// over comparing whole keys with `btree_key_cmp()`.  Disabled, since it's a
+// benchmark; run it with --gtest_also_run_disabled_tests.
+TEST(LeafNodeTest, DISABLED_KeySearchBenchmark) {
+    run_key_search_benchmark("uuid primary keys", &random_uuid_key);
+    run_key_search_benchmark("secondary index keys", &random_secondary_key);
+}
+
+void run_block_size_benchmark(int block_size, int num_keys,
+                              const std::vector<store_key_t> &internal_separators) {
+    const block_size_t bs = block_size_t::unsafe_make(block_size);
+    std::vector<store_key_t> separators, full_separators;
+    std::vector<leaf_node_t *> leaves;
+    build_leaf_level(bs, &random_uuid_key, num_keys, &separators, &full_separators, &leaves);
+
+    // Look up keys that are there, in random order.
+    rng_t key_rng(0);
+    std::vector<store_key_t> keys;
+    for (int i = 0; i < num_keys; ++i) {
+        keys.push_back(store_key_t(random_uuid_key(&key_rng)));
+    }
+    rng_t rng(1);
+    std::vector<store_key_t> probes;
+    std::vector<size_t> probe_leaves;
+    for (int i = 0; i < 1000000; ++i) {
+        probes.push_back(keys[rng.randint(num_keys)]);
+        probe_leaves.push_back(std::lower_bound(separators.begin(), separators.end(), probes.back())
+                               - separators.begin());
+    }
+
+    value_sizer_t<short_value_t> sizer(bs);
+    char value[256];
+    int found = 0;
+    ticks_t start = get_ticks();
+    for (size_t i = 0; i < probes.size(); ++i) {
+        found += leaf::lookup(&sizer, leaves[probe_leaves[i]], probes[i].btree_key(), value);
+    }
+    const double leaf_ns = static_cast<double>(get_ticks() - start) / probes.size();
+    EXPECT_EQ(static_cast<int>(probes.size()), found);
+
+    double internal_ns;
+    const size_t internal_nodes = pack_and_probe(bs, internal_separators, probes, &internal_ns);
+    ASSERT_LT(1u, internal_nodes);
+    const double fanout = static_cast<double>(internal_separators.size()) / internal_nodes;
+    const double keys_per_leaf = static_cast<double>(num_keys) / leaves.size();
+    int height = 1;
+    for (double nodes = ceil(100e6 / keys_per_leaf); nodes > 1; nodes = ceil(nodes / fanout)) {
+        ++height;
+    }
+
+    printf("%2d KB blocks: %5.1f keys per leaf, fan-out %6.1f, height %d at 100M keys\n",
+           static_cast<int>(block_size / KILOBYTE), keys_per_leaf, fanout, height);
+    printf("    lookup %3.0f ns per leaf, %3.0f ns per internal node; "
+           "%5.1f KB read per uncached point read, %5.1f KB per 1000-key scan\n",
+           leaf_ns, internal_ns, static_cast<double>(height * block_size) / KILOBYTE,
+           ceil(1000 / keys_per_leaf + 1) * block_size / KILOBYTE);
+
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        free(leaves[i]);
+    }
+}
+
+// Compares btree shapes and node lookup costs across the block sizes a table
+// can be created with.  Larger blocks make too few leaves to fill one of their
+// internal nodes, so those are filled with the separators of the smallest
+// blocks.  Disabled, since it's a benchmark; run it with
+// --gtest_also_run_disabled_tests.
+TEST(LeafNodeTest, DISABLED_BlockSizeBenchmark) {
+    const int num_keys = 500000;
+    std::vector<store_key_t> separators, full_separators;
+    build_leaf_level(block_size_t::unsafe_make(MIN_BTREE_BLOCK_SIZE), &random_uuid_key, num_keys,
+                     &separators, &full_separators, NULL);
+    for (int block_size = MIN_BTREE_BLOCK_SIZE; block_size <= MAX_BTREE_BLOCK_SIZE; block_size *= 2) {
+        run_block_size_benchmark(block_size, num_keys, separators);
+    }
+}
+
 }  // namespace unittest
@@ -4,6 +4,9 @@
 #include <math.h>
 
 #include <cmath>  // for std::isnan -- read the comment below.
+#include <set>
+#include <string>
+#include <vector>
 
 #include "perfmon/perfmon.hpp"
 #include "unittest/gtest.hpp"
@@ -57,4 +60,85 @@ TEST(PerfmonTest, StddevComputation) {
     }
 }
 
+TEST(PerfmonTest, LatencyHistogramBuckets) {
+    typedef latency_histogram_t h;
+
+    // Small values get a bucket each.
+    for (uint64_t i = 0; i < h::sub_buckets; ++i) {
+        EXPECT_EQ(i, h::bucket_for_value(i));
+        EXPECT_EQ(i, h::bucket_upper_bound(i));
+    }
+
+    // Every value lands in a bucket whose bounds contain it, the buckets are
+    // monotonic, and the relative bucket width stays below 1/sub_buckets.
+    size_t last_bucket = 0;
+    for (uint64_t v = 1; v < (static_cast<uint64_t>(1) << 30); v = v * 1.01 + 1) {
+        size_t bucket = h::bucket_for_value(v);
+        ASSERT_LT(bucket, h::num_buckets);
+        EXPECT_LE(last_bucket, bucket);
+        EXPECT_LE(v, h::bucket_upper_bound(bucket));
+        if (bucket > 0) {
+            EXPECT_GT(v, h::bucket_upper_bound(bucket - 1));
+        }
+        EXPECT_LE(h::bucket_upper_bound(bucket) - v, v / h::sub_buckets);
+        last_bucket = bucket;
+    }
+
+    // Huge values are clamped into the last bucket.
+    EXPECT_EQ(h::num_buckets - 1, h::bucket_for_value(UINT64_MAX));
+}
+
+TEST(PerfmonTest, LatencyHistogramPercentiles) {
+    latency_histogram_t first, second;
+    EXPECT_EQ(0u, first.count());
+
+    // 1ms through 1000ms, split across two histograms as if recorded on two
+    // different threads.
+    for (int i = 1; i <= 1000; ++i) {
+        (i % 2 == 0 ? first : second).record(i / 1000.0);
+    }
+    latency_histogram_t combined;
+    combined.aggregate(first);
+    combined.aggregate(second);
+
+    EXPECT_EQ(1000u, combined.count());
+    EXPECT_DOUBLE_EQ(1.0, combined.max());
+    const double tolerance = 1.0 / latency_histogram_t::sub_buckets;
+    EXPECT_NEAR(0.5, combined.percentile(0.5), 0.5 * tolerance);
+    EXPECT_NEAR(0.9, combined.percentile(0.9), 0.9 * tolerance);
+    EXPECT_NEAR(0.99, combined.percentile(0.99), 0.99 * tolerance);
+    EXPECT_DOUBLE_EQ(1.0, combined.percentile(1.0));
+    // Percentiles never understate the true value.
+    EXPECT_LE(0.5, combined.percentile(0.5));
+
+    combined.reset();
+    EXPECT_EQ(0u, combined.count());
+    combined.record(0.000003);
+    EXPECT_DOUBLE_EQ(0.000003, combined.percentile(0.999));
+}
+
+TEST(PerfmonTest, FilterPruning) {
+    std::set<std::string> paths;
+    paths.insert("serializers/.*_read");
+    paths.insert("query_latency");
+    perfmon_filter_t filter(paths);
+
+    std::vector<bool> active = filter.all_active();
+    ASSERT_EQ(2u, active.size());
+    EXPECT_FALSE(filter.keeps_everything(0, active));
+
+    std::vector<bool> subactive;
+    EXPECT_FALSE(filter.may_keep(0, active, "cache", &subactive));
+
+    EXPECT_TRUE(filter.may_keep(0, active, "query_latency", &subactive));
+    EXPECT_TRUE(filter.keeps_everything(1, subactive));
+
+    EXPECT_TRUE(filter.may_keep(0, active, "serializers", &subactive));
+    EXPECT_FALSE(filter.keeps_everything(1, subactive));
+    std::vector<bool> subsubactive;
+    EXPECT_TRUE(filter.may_keep(1, subactive, "disk_read", &subsubactive));
+    EXPECT_TRUE(filter.keeps_everything(2, subsubactive));
+    EXPECT_FALSE(filter.may_keep(1, subactive, "disk_write", &subsubactive));
+}
+
 }  // namespace unittest
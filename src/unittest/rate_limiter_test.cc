@@ -0,0 +1,114 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "unittest/gtest.hpp"
+
+#include "concurrency/cond_var.hpp"
+#include "concurrency/rate_limiter.hpp"
+#include "unittest/unittest_utils.hpp"
+#include "utils.hpp"
+
+namespace unittest {
+
+static ticks_t ms_after(ticks_t start, int64_t ms) {
+    return start + ms * MILLION;
+}
+
+void run_burst_test() {
+    rate_limiter_t limiter(1000);
+    ticks_t start = get_ticks();
+
+    // A second's worth goes through right away...
+    EXPECT_EQ(0, limiter.consume(1000, start));
+
+    // ... but then we have to wait for more.
+    EXPECT_EQ(200, limiter.consume(200, start));
+}
+
+TEST(RateLimiterTest, Burst) {
+    unittest::run_in_thread_pool(run_burst_test);
+}
+
+void run_refill_test() {
+    rate_limiter_t limiter(1000);
+    ticks_t start = get_ticks();
+    EXPECT_EQ(0, limiter.consume(1000, start));
+
+    // A quarter of a second pays for a quarter of the rate.
+    EXPECT_EQ(0, limiter.consume(250, ms_after(start, 250)));
+    EXPECT_EQ(100, limiter.consume(100, ms_after(start, 250)));
+
+    // Being idle for longer than a second doesn't save up more than a second.
+    EXPECT_EQ(500, limiter.consume(1500, ms_after(start, 10000)));
+}
+
+TEST(RateLimiterTest, Refill) {
+    unittest::run_in_thread_pool(run_refill_test);
+}
+
+void run_shared_test() {
+    rate_limiter_t limiter(1000);
+    ticks_t start = get_ticks();
+    EXPECT_EQ(0, limiter.consume(1000, start));
+
+    // Whoever comes later waits for everyone before them, too.
+    for (int i = 1; i <= 20; ++i) {
+        EXPECT_EQ(20 * i, limiter.consume(20, start));
+    }
+
+    // Once the debt is paid off, there's no more waiting.
+    EXPECT_EQ(0, limiter.consume(0, ms_after(start, 400)));
+}
+
+TEST(RateLimiterTest, Shared) {
+    unittest::run_in_thread_pool(run_shared_test);
+}
+
+void run_unlimited_test() {
+    rate_limiter_t limiter(0);
+    ticks_t start = get_ticks();
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(0, limiter.consume(GIGABYTE, start));
+    }
+}
+
+TEST(RateLimiterTest, Unlimited) {
+    unittest::run_in_thread_pool(run_unlimited_test);
+}
+
+void run_set_rate_test() {
+    rate_limiter_t limiter(1000);
+    EXPECT_EQ(0, limiter.consume(1000, get_ticks()));
+
+    // Lowering the rate makes the debt take longer to pay off.
+    limiter.set_rate(100);
+    EXPECT_EQ(100, limiter.get_rate());
+    EXPECT_LE(limiter.consume(10, get_ticks()), 100);
+    EXPECT_GT(limiter.consume(10, get_ticks()), 100);
+
+    // Without a limit, nothing is counted...
+    limiter.set_rate(0);
+    EXPECT_EQ(0, limiter.consume(GIGABYTE, get_ticks()));
+
+    // ... so a new limit starts with a full second's worth.
+    limiter.set_rate(1000);
+    ticks_t start = get_ticks();
+    EXPECT_EQ(0, limiter.consume(1000, start));
+    EXPECT_EQ(1, limiter.consume(1, start));
+}
+
+TEST(RateLimiterTest, SetRate) {
+    unittest::run_in_thread_pool(run_set_rate_test);
+}
+
+void run_interrupt_test() {
+    rate_limiter_t limiter(1000);
+    cond_t interruptor;
+    limiter.co_consume(1000, &interruptor);
+    interruptor.pulse();
+    EXPECT_THROW(limiter.co_consume(1000, &interruptor), interrupted_exc_t);
+}
+
+TEST(RateLimiterTest, Interrupt) {
+    unittest::run_in_thread_pool(run_interrupt_test);
+}
+
+}  // namespace unittest
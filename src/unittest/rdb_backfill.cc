@@ -63,7 +63,7 @@ void run_with_broadcaster(
 
     boost::shared_ptr<semilattice_readwrite_view_t<auth_semilattice_metadata_t> > dummy_auth;
     rdb_protocol_t::context_t ctx(&extproc_pool, NULL, slm.get_root_view(),
-                                  dummy_auth, &read_manager, generate_uuid());
+                                  dummy_auth, &read_manager, NULL, generate_uuid());
 
     /* Set up a broadcaster and initial listener */
     test_store_t<rdb_protocol_t> initial_store(&io_backender, &order_source, &ctx);
@@ -172,7 +172,8 @@ void run_backfill_test(size_t value_padding_length,
     recreate_temporary_directory(base_path_t("."));
     /* Set up a replier so the broadcaster can handle operations */
     EXPECT_FALSE((*initial_listener)->get_broadcaster_lost_signal()->is_pulsed());
-    replier_t<rdb_protocol_t> replier(initial_listener->get(), cluster->get_mailbox_manager(), branch_history_manager);
+    watchable_variable_t<int64_t> backfill_bytes_per_sec(DEFAULT_BACKFILL_BYTES_PER_SEC);
+    replier_t<rdb_protocol_t> replier(initial_listener->get(), cluster->get_mailbox_manager(), branch_history_manager, backfill_bytes_per_sec.get_watchable());
 
     watchable_variable_t<boost::optional<boost::optional<replier_business_card_t<rdb_protocol_t> > > >
         replier_business_card_variable(boost::optional<boost::optional<replier_business_card_t<rdb_protocol_t> > >(boost::optional<replier_business_card_t<rdb_protocol_t> >(replier.get_business_card())));
@@ -254,7 +255,8 @@ void run_sindex_backfill_test(std::pair<io_backender_t *, simple_mailbox_cluster
     recreate_temporary_directory(base_path_t("."));
     /* Set up a replier so the broadcaster can handle operations */
     EXPECT_FALSE((*initial_listener)->get_broadcaster_lost_signal()->is_pulsed());
-    replier_t<rdb_protocol_t> replier(initial_listener->get(), cluster->get_mailbox_manager(), branch_history_manager);
+    watchable_variable_t<int64_t> backfill_bytes_per_sec(DEFAULT_BACKFILL_BYTES_PER_SEC);
+    replier_t<rdb_protocol_t> replier(initial_listener->get(), cluster->get_mailbox_manager(), branch_history_manager, backfill_bytes_per_sec.get_watchable());
 
     watchable_variable_t<boost::optional<boost::optional<replier_business_card_t<rdb_protocol_t> > > >
         replier_business_card_variable(boost::optional<boost::optional<replier_business_card_t<rdb_protocol_t> > >(boost::optional<replier_business_card_t<rdb_protocol_t> >(replier.get_business_card())));
@@ -426,7 +426,7 @@ void run_erase_range_test() {
                                            &dummy_interruptor);
 
         const hash_region_t<key_range_t> test_range = hash_region_t<key_range_t>::universe();
-        rdb_protocol_details::range_key_tester_t tester(&test_range);
+        rdb_protocol_details::range_key_tester_t tester(&test_range, store.get_region());
         rdb_erase_range(store.btree.get(), &tester,
                 key_range_t::universe(),
             txn.get(), super_block.get(), &store, &token_pair,
@@ -113,6 +113,10 @@ void NORETURN mock_namespace_interface_t::read_visitor_t::operator()(UNUSED cons
     throw cannot_perform_query_exc_t("unimplemented");
 }
 
+void NORETURN mock_namespace_interface_t::read_visitor_t::operator()(UNUSED const rdb_protocol_t::changefeed_subscribe_t &cs) {
+    throw cannot_perform_query_exc_t("unimplemented");
+}
+
 mock_namespace_interface_t::read_visitor_t::read_visitor_t(std::map<store_key_t, scoped_cJSON_t *> *_data,
                                                            rdb_protocol_t::read_response_t *_response) :
     data(_data), response(_response) {
@@ -267,7 +271,8 @@ namespace_id_t test_rdb_env_t::add_table(const std::string &table_name,
                                       table_name_string,
                                       primary_key,
                                       port_defaults::reql_port,
-                                      GIGABYTE);
+                                      GIGABYTE,
+                                      DEFAULT_BTREE_BLOCK_SIZE);
 
     // Set up initial data
     std::map<store_key_t, scoped_cJSON_t*> *data = new std::map<store_key_t, scoped_cJSON_t*>();
@@ -318,6 +323,7 @@ test_rdb_env_t::instance_t::instance_t(test_rdb_env_t *test_env) :
                            databases_metadata,
                            dummy_semilattice_controller.get_view(),
                            NULL,
+                           NULL,
                            &interruptor,
                            test_env->machine_id,
                            ql::protob_t<Query>()));
@@ -70,6 +70,7 @@ private:
         void NORETURN operator()(UNUSED const rdb_protocol_t::distribution_read_t &dg);
         void NORETURN operator()(UNUSED const rdb_protocol_t::sindex_list_t &sl);
         void NORETURN operator()(UNUSED const rdb_protocol_t::sindex_status_t &ss);
+        void NORETURN operator()(UNUSED const rdb_protocol_t::changefeed_subscribe_t &cs);
 
         read_visitor_t(std::map<store_key_t, scoped_cJSON_t*> *_data, rdb_protocol_t::read_response_t *_response);
 
@@ -0,0 +1,82 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "clustering/immediate_consistency/branch/replication_lag.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+state_timestamp_t lag_test_timestamp(int n) {
+    state_timestamp_t ts = state_timestamp_t::zero();
+    for (int i = 0; i < n; ++i) {
+        ts = transition_timestamp_t::starting_from(ts).timestamp_after();
+    }
+    return ts;
+}
+
+// Times are in microseconds; the local clock runs 5 seconds ahead of the
+// primary's, and messages take 1 ms to arrive.  The tracker can't tell the
+// usual delivery time from clock skew, so it doesn't count as lag.
+const microtime_t primary_start = 1000000000;
+const microtime_t local_start = primary_start + 5000000;
+const microtime_t delivery = 1000;
+
+TEST(ReplicationLag, UnknownUntilInSync) {
+    replication_lag_tracker_t tracker;
+    EXPECT_EQ(-1, tracker.get_lag_ms(local_start));
+
+    // Heartbeats before the replica knows where it is don't count yet.
+    tracker.on_stamp(lag_test_timestamp(3), primary_start, local_start + delivery);
+    EXPECT_EQ(-1, tracker.get_lag_ms(local_start + delivery));
+
+    // Once it has reached the heartbeat's timestamp, its lag is the time
+    // since the heartbeat arrived.
+    tracker.on_reached(lag_test_timestamp(3));
+    EXPECT_EQ(0, tracker.get_lag_ms(local_start + delivery));
+    EXPECT_EQ(100, tracker.get_lag_ms(local_start + delivery + 100000));
+}
+
+TEST(ReplicationLag, GrowsWhenDisconnected) {
+    replication_lag_tracker_t tracker;
+    tracker.on_reached(lag_test_timestamp(0));
+    tracker.on_stamp(lag_test_timestamp(0), primary_start, local_start + delivery);
+    EXPECT_EQ(0, tracker.get_lag_ms(local_start + delivery));
+
+    // No more heartbeats arrive, and nothing is being written; nothing tells
+    // us that we are still in sync.
+    EXPECT_EQ(10000, tracker.get_lag_ms(local_start + delivery + 10000000));
+}
+
+TEST(ReplicationLag, GrowsWhenBehind) {
+    replication_lag_tracker_t tracker;
+    tracker.on_reached(lag_test_timestamp(0));
+    tracker.on_stamp(lag_test_timestamp(0), primary_start, local_start + delivery);
+
+    // Writes and heartbeats keep arriving, but none of the writes gets
+    // applied, so the replica has been behind since the first of them.
+    for (int i = 1; i <= 10; ++i) {
+        microtime_t sent = primary_start + i * 100000;
+        tracker.on_stamp(lag_test_timestamp(i), sent, sent + 5000000 + delivery);
+    }
+    const microtime_t now = local_start + 1000000 + delivery;
+    EXPECT_EQ(1000, tracker.get_lag_ms(now));
+
+    // Applying half of them makes it a 500 ms-old copy; applying the rest
+    // catches it up.
+    tracker.on_reached(lag_test_timestamp(5));
+    EXPECT_EQ(500, tracker.get_lag_ms(now));
+    tracker.on_reached(lag_test_timestamp(10));
+    EXPECT_EQ(0, tracker.get_lag_ms(now));
+}
+
+TEST(ReplicationLag, SlowDeliveryCountsAsLag) {
+    replication_lag_tracker_t tracker;
+    tracker.on_reached(lag_test_timestamp(0));
+    tracker.on_stamp(lag_test_timestamp(0), primary_start, local_start + delivery);
+
+    // A heartbeat that spent two seconds in a queue only tells us that we were
+    // in sync two seconds ago.
+    tracker.on_stamp(lag_test_timestamp(0), primary_start + 1000000,
+                     local_start + 3000000 + delivery);
+    EXPECT_EQ(2000, tracker.get_lag_ms(local_start + 3000000 + delivery));
+}
+
+}  // namespace unittest
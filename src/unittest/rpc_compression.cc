@@ -0,0 +1,168 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <string>
+#include <vector>
+
+#include "containers/archive/stl_types.hpp"
+#include "containers/archive/string_stream.hpp"
+#include "rpc/connectivity/compression.hpp"
+#include "unittest/gtest.hpp"
+#include "utils.hpp"
+
+namespace unittest {
+
+std::vector<std::string> compression_test_messages() {
+    std::vector<std::string> messages;
+    messages.push_back("");
+    messages.push_back("short");
+    // Repetitive, like most of what nodes send each other.
+    std::string repetitive;
+    for (int i = 0; i < 2000; ++i) {
+        repetitive += strprintf("{\"id\": %d, \"name\": \"row number %d\"}", i, i % 17);
+    }
+    messages.push_back(repetitive);
+    // One long run, for matches that overlap what they copy.
+    messages.push_back(std::string(100000, 'x'));
+    // Every octet.
+    std::string spectrum;
+    for (int i = 0; i < 4096; ++i) {
+        spectrum.push_back(static_cast<char>(i * 7919 % 256));
+    }
+    messages.push_back(spectrum);
+    // Next to incompressible.
+    std::string noise;
+    uint32_t state = 12345;
+    for (int i = 0; i < 10000; ++i) {
+        state = state * 1103515245 + 12345;
+        noise.push_back(static_cast<char>(state >> 16));
+    }
+    messages.push_back(noise);
+    // The same message again, which `STRONG` can refer back to.
+    messages.push_back(repetitive);
+    return messages;
+}
+
+// Returns how many bytes the messages took up.
+size_t run_compression_round_trip(cluster_compression_t compression,
+                                  const std::vector<std::string> &messages) {
+    message_compressor_t compressor(compression);
+    string_stream_t stream;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        write_message_t msg;
+        compressor.append(messages[i], &msg);
+        EXPECT_EQ(0, send_write_message(&stream, &msg));
+    }
+    size_t wire_size = stream.str().size();
+
+    message_decompressor_t decompressor(compression);
+    string_read_stream_t read_stream(std::move(stream.str()), 0);
+    for (size_t i = 0; i < messages.size(); ++i) {
+        counted_t<data_buffer_t> message;
+        EXPECT_EQ(ARCHIVE_SUCCESS, decompressor.read(&read_stream, &message));
+        EXPECT_TRUE(std::string(message->buf(), message->size()) == messages[i]) << "message " << i;
+    }
+    char c;
+    EXPECT_EQ(0, force_read(&read_stream, &c, 1));
+    return wire_size;
+}
+
+TEST(RPCCompressionTest, RoundTrip) {
+    std::vector<std::string> messages = compression_test_messages();
+    size_t total_size = 0;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        total_size += messages[i].size();
+    }
+
+    size_t none_size = run_compression_round_trip(CLUSTER_COMPRESSION_NONE, messages);
+    size_t fast_size = run_compression_round_trip(CLUSTER_COMPRESSION_FAST, messages);
+    size_t strong_size = run_compression_round_trip(CLUSTER_COMPRESSION_STRONG, messages);
+    EXPECT_LT(total_size, none_size);
+    EXPECT_LT(fast_size, total_size / 2);
+    EXPECT_LT(strong_size, fast_size);
+}
+
+TEST(RPCCompressionTest, LzRoundTrip) {
+    std::vector<std::string> messages = compression_test_messages();
+    for (size_t i = 0; i < messages.size(); ++i) {
+        const std::string &in = messages[i];
+        std::string compressed;
+        lz_compress(in.data(), in.size(), &compressed);
+        std::string out(in.size(), '\0');
+        ASSERT_TRUE(lz_decompress(compressed.data(), compressed.size(), &out[0], out.size()));
+        EXPECT_TRUE(out == in) << "message " << i;
+
+        // The size has to match exactly.
+        std::string bigger(in.size() + 1, '\0');
+        EXPECT_FALSE(lz_decompress(compressed.data(), compressed.size(),
+                                   &bigger[0], bigger.size()));
+    }
+}
+
+TEST(RPCCompressionTest, LzRejectsCorruptInput) {
+    std::string in(5000, 'a');
+    for (int i = 0; i < 5000; i += 3) {
+        in[i] = 'b';
+    }
+    std::string compressed;
+    lz_compress(in.data(), in.size(), &compressed);
+    ASSERT_LT(compressed.size(), in.size());
+
+    // No corruption may make us read or write out of bounds. Most of them
+    // should make us fail, too.
+    std::string out(in.size(), '\0');
+    int num_rejected = 0;
+    for (size_t i = 0; i < compressed.size(); ++i) {
+        for (int bit = 0; bit < 8; ++bit) {
+            std::string corrupt = compressed;
+            corrupt[i] ^= (1 << bit);
+            if (!lz_decompress(corrupt.data(), corrupt.size(), &out[0], out.size())) {
+                ++num_rejected;
+            }
+        }
+    }
+    EXPECT_LT(0, num_rejected);
+
+    for (size_t size = 0; size < compressed.size(); ++size) {
+        EXPECT_FALSE(lz_decompress(compressed.data(), size, &out[0], out.size()));
+    }
+}
+
+TEST(RPCCompressionTest, RejectsBogusFrames) {
+    {
+        // An unknown format.
+        write_message_t msg;
+        msg << static_cast<int8_t>(7);
+        msg << std::string("hello");
+        string_stream_t stream;
+        ASSERT_EQ(0, send_write_message(&stream, &msg));
+        string_read_stream_t read_stream(std::move(stream.str()), 0);
+        message_decompressor_t decompressor(CLUSTER_COMPRESSION_FAST);
+        counted_t<data_buffer_t> message;
+        EXPECT_EQ(ARCHIVE_RANGE_ERROR, decompressor.read(&read_stream, &message));
+    }
+    {
+        // A compressed message that claims to be far larger than it could be.
+        write_message_t msg;
+        msg << static_cast<int8_t>(1);
+        msg << (static_cast<uint64_t>(1) << 40);
+        msg << std::string("hello");
+        string_stream_t stream;
+        ASSERT_EQ(0, send_write_message(&stream, &msg));
+        string_read_stream_t read_stream(std::move(stream.str()), 0);
+        message_decompressor_t decompressor(CLUSTER_COMPRESSION_STRONG);
+        counted_t<data_buffer_t> message;
+        EXPECT_EQ(ARCHIVE_RANGE_ERROR, decompressor.read(&read_stream, &message));
+    }
+}
+
+TEST(RPCCompressionTest, Parse) {
+    cluster_compression_t compression;
+    ASSERT_TRUE(parse_cluster_compression("none", &compression));
+    EXPECT_EQ(CLUSTER_COMPRESSION_NONE, compression);
+    ASSERT_TRUE(parse_cluster_compression("fast", &compression));
+    EXPECT_EQ(CLUSTER_COMPRESSION_FAST, compression);
+    ASSERT_TRUE(parse_cluster_compression("strong", &compression));
+    EXPECT_EQ(CLUSTER_COMPRESSION_STRONG, compression);
+    EXPECT_FALSE(parse_cluster_compression("zstd", &compression));
+}
+
+}  // namespace unittest
@@ -24,9 +24,13 @@ public:
         sequence_number(0)
         { }
     void send(int message, peer_id_t peer) {
+        send_with_ordering_key(message, peer, 0);
+    }
+    void send_with_ordering_key(int message, peer_id_t peer, uint64_t ordering_key) {
         class writer_t : public send_message_write_callback_t {
         public:
-            explicit writer_t(int _data) : data(_data) { }
+            writer_t(int _data, uint64_t _ordering_key) :
+                data(_data), ordering_key(_ordering_key) { }
             virtual ~writer_t() { }
             void write(write_stream_t *stream) {
                 write_message_t msg;
@@ -34,8 +38,12 @@ public:
                 int res = send_write_message(stream, &msg);
                 if (res) { throw fake_archive_exc_t(); }
             }
+            uint64_t get_ordering_key() const {
+                return ordering_key;
+            }
             int32_t data;
-        } writer(message);
+            uint64_t ordering_key;
+        } writer(message, ordering_key);
         service->send_message(peer, &writer);
     }
     void expect(int message, peer_id_t peer) {
@@ -59,7 +67,7 @@ public:
     }
 
 private:
-    void on_message(peer_id_t peer, string_read_stream_t *stream) {
+    void on_message(peer_id_t peer, data_buffer_read_stream_t *stream) {
         int i;
         int res = deserialize(stream, &i);
         if (res) { throw fake_archive_exc_t(); }
@@ -197,6 +205,158 @@ TEST(RPCConnectivityTest, OrderingMultiThread) {
     unittest::run_in_thread_pool(&run_ordering_test, 3);
 }
 
+/* `ExtraConnections` checks that nodes that open several connections to each
+other can still talk to each other and to nodes that only open one, and that
+messages with the same ordering key arrive in order. */
+
+void run_extra_connections_test() {
+    connectivity_cluster_t c1, c2, c3;
+    recording_test_application_t a1(&c1), a2(&c2), a3(&c3);
+    connectivity_cluster_t::run_t cr1(&c1, get_unittest_addresses(), peer_address_t(), ANY_PORT, &a1, 0, NULL, 4);
+    connectivity_cluster_t::run_t cr2(&c2, get_unittest_addresses(), peer_address_t(), ANY_PORT, &a2, 0, NULL, 3);
+    connectivity_cluster_t::run_t cr3(&c3, get_unittest_addresses(), peer_address_t(), ANY_PORT, &a3, 0, NULL, 1);
+    cr2.join(c1.get_peer_address(c1.get_me()));
+    cr3.join(c1.get_peer_address(c1.get_me()));
+
+    let_stuff_happen();
+
+    EXPECT_EQ(3u, c1.get_peers_list().size());
+    EXPECT_EQ(3u, c2.get_peers_list().size());
+    EXPECT_EQ(3u, c3.get_peers_list().size());
+
+    const int num_keys = 7;
+    const int per_key = 20;
+    for (int i = 0; i < per_key; ++i) {
+        for (int key = 0; key < num_keys; ++key) {
+            a1.send_with_ordering_key(i * num_keys + key, c2.get_me(), key);
+            a2.send_with_ordering_key(i * num_keys + key, c1.get_me(), key);
+            a3.send_with_ordering_key(10000 + i * num_keys + key, c2.get_me(), key);
+        }
+    }
+
+    let_stuff_happen();
+
+    for (int i = 0; i < per_key - 1; ++i) {
+        for (int key = 0; key < num_keys; ++key) {
+            a1.expect_order(i * num_keys + key, (i + 1) * num_keys + key);
+            a2.expect_order(i * num_keys + key, (i + 1) * num_keys + key);
+            a2.expect_order(10000 + i * num_keys + key, 10000 + (i + 1) * num_keys + key);
+        }
+    }
+}
+TEST(RPCConnectivityTest, ExtraConnections) {
+    unittest::run_in_thread_pool(&run_extra_connections_test);
+}
+TEST(RPCConnectivityTest, ExtraConnectionsMultiThread) {
+    unittest::run_in_thread_pool(&run_extra_connections_test, 3);
+}
+
+/* `Compression` checks that nodes with different compression settings agree on
+how to compress each connection, and that messages of all sizes get through
+intact with every kind of compression. */
+
+class string_test_application_t : public home_thread_mixin_t, public message_handler_t {
+public:
+    explicit string_test_application_t(message_service_t *s) : service(s) { }
+    void send(const std::string &message, peer_id_t peer) {
+        class writer_t : public send_message_write_callback_t {
+        public:
+            explicit writer_t(const std::string &_data) : data(_data) { }
+            virtual ~writer_t() { }
+            void write(write_stream_t *stream) {
+                write_message_t msg;
+                msg << data;
+                int res = send_write_message(stream, &msg);
+                if (res) { throw fake_archive_exc_t(); }
+            }
+            const std::string &data;
+        } writer(message);
+        service->send_message(peer, &writer);
+    }
+    void on_message(peer_id_t peer, data_buffer_read_stream_t *stream) {
+        std::string message;
+        archive_result_t res = deserialize(stream, &message);
+        if (res) { throw fake_archive_exc_t(); }
+        on_thread_t th(home_thread());
+        inbox[peer].push_back(message);
+    }
+    std::map<peer_id_t, std::vector<std::string> > inbox;
+private:
+    message_service_t *service;
+};
+
+uuid_u compression_test_datacenter(uuid_u datacenter) {
+    return datacenter;
+}
+
+cluster_compression_config_t compression_test_config(cluster_compression_t same_datacenter,
+                                                     cluster_compression_t other_datacenters,
+                                                     uuid_u datacenter) {
+    cluster_compression_config_t config;
+    config.same_datacenter = same_datacenter;
+    config.other_datacenters = other_datacenters;
+    config.get_datacenter = boost::bind(&compression_test_datacenter, datacenter);
+    return config;
+}
+
+void run_compression_test() {
+    uuid_u dc_a = generate_uuid(), dc_b = generate_uuid();
+    connectivity_cluster_t c1, c2, c3, c4;
+    string_test_application_t a1(&c1), a2(&c2), a3(&c3), a4(&c4);
+    /* `c1` and `c2` agree on `FAST`, `c1` and `c3` and `c2` and `c3` on
+    `STRONG`, and `c4` doesn't compress at all. */
+    connectivity_cluster_t::run_t cr1(&c1, get_unittest_addresses(), peer_address_t(), ANY_PORT, &a1, 0, NULL, 2,
+        compression_test_config(CLUSTER_COMPRESSION_FAST, CLUSTER_COMPRESSION_STRONG, dc_a));
+    connectivity_cluster_t::run_t cr2(&c2, get_unittest_addresses(), peer_address_t(), ANY_PORT, &a2, 0, NULL, 2,
+        compression_test_config(CLUSTER_COMPRESSION_STRONG, CLUSTER_COMPRESSION_STRONG, dc_a));
+    connectivity_cluster_t::run_t cr3(&c3, get_unittest_addresses(), peer_address_t(), ANY_PORT, &a3, 0, NULL, 2,
+        compression_test_config(CLUSTER_COMPRESSION_NONE, CLUSTER_COMPRESSION_STRONG, dc_b));
+    connectivity_cluster_t::run_t cr4(&c4, get_unittest_addresses(), peer_address_t(), ANY_PORT, &a4, 0, NULL, 2);
+    cr2.join(c1.get_peer_address(c1.get_me()));
+    cr3.join(c1.get_peer_address(c1.get_me()));
+    cr4.join(c1.get_peer_address(c1.get_me()));
+
+    let_stuff_happen();
+
+    EXPECT_EQ(4u, c1.get_peers_list().size());
+    EXPECT_EQ(4u, c4.get_peers_list().size());
+
+    std::vector<std::string> messages;
+    messages.push_back("small");
+    messages.push_back(std::string(50000, 'z'));
+    std::string rows;
+    for (int i = 0; i < 1000; ++i) {
+        rows += strprintf("{\"id\": %d}", i);
+    }
+    messages.push_back(rows);
+    messages.push_back(rows);
+
+    string_test_application_t *apps[] = { &a1, &a2, &a3, &a4 };
+    connectivity_cluster_t *clusters[] = { &c1, &c2, &c3, &c4 };
+    for (int from = 0; from < 4; ++from) {
+        for (int to = 0; to < 4; ++to) {
+            for (size_t i = 0; i < messages.size(); ++i) {
+                apps[from]->send(messages[i], clusters[to]->get_me());
+            }
+        }
+    }
+
+    let_stuff_happen();
+
+    for (int from = 0; from < 4; ++from) {
+        for (int to = 0; to < 4; ++to) {
+            EXPECT_TRUE(apps[to]->inbox[clusters[from]->get_me()] == messages)
+                << "from " << from << " to " << to;
+        }
+    }
+}
+TEST(RPCConnectivityTest, Compression) {
+    unittest::run_in_thread_pool(&run_compression_test);
+}
+TEST(RPCConnectivityTest, CompressionMultiThread) {
+    unittest::run_in_thread_pool(&run_compression_test, 3);
+}
+
 /* `GetPeersList` confirms that the behavior of `cluster_t::get_peers_list()` is
 correct. */
 
@@ -506,7 +666,7 @@ public:
         } writer;
         service->send_message(peer, &writer);
     }
-    void on_message(peer_id_t, string_read_stream_t *stream) {
+    void on_message(peer_id_t, data_buffer_read_stream_t *stream) {
         char spectrum[CHAR_MAX - CHAR_MIN + 1];
         int64_t res = force_read(stream, spectrum, CHAR_MAX - CHAR_MIN + 1);
         if (res != CHAR_MAX - CHAR_MIN + 1) { throw fake_archive_exc_t(); }
@@ -2,9 +2,12 @@
 #include "unittest/gtest.hpp"
 
 #include "arch/timing.hpp"
+#include "containers/archive/cow_ptr_type.hpp"
+#include "containers/archive/string_stream.hpp"
 #include "rpc/connectivity/cluster.hpp"
-#include "rpc/directory/read_manager.hpp"
-#include "rpc/directory/write_manager.hpp"
+#include "rpc/directory/delta.hpp"
+#include "rpc/directory/read_manager.tcc"
+#include "rpc/directory/write_manager.tcc"
 #include "unittest/unittest_utils.hpp"
 
 namespace unittest {
@@ -108,4 +111,111 @@ TEST(RPCDirectoryTest, DestructorRace) {
     unittest::run_in_thread_pool(&run_destructor_race_test, 1);
 }
 
+/* `Coalesce` tests that the first of a burst of changes is sent right away,
+that the rest are sent together, and that a peer ends up with the last one. */
+
+void run_coalesce_test() {
+    connectivity_cluster_t c1, c2;
+    directory_read_manager_t<int> rm1(&c1), rm2(&c2);
+    watchable_variable_t<int> w1(0), w2(0);
+    directory_write_manager_t<int> wm1(&c1, w1.get_watchable()), wm2(&c2, w2.get_watchable());
+    connectivity_cluster_t::run_t cr1(&c1, get_unittest_addresses(), peer_address_t(), ANY_PORT, &rm1, 0, NULL);
+    connectivity_cluster_t::run_t cr2(&c2, get_unittest_addresses(), peer_address_t(), ANY_PORT, &rm2, 0, NULL);
+    cr2.join(c1.get_peer_address(c1.get_me()));
+    let_stuff_happen();
+    EXPECT_EQ(0, wm1.get_num_updates_sent());
+
+    /* The update is sent as soon as the sending coroutine gets to run. */
+    w1.set_value(1);
+    coro_t::yield();
+    EXPECT_EQ(1, wm1.get_num_updates_sent());
+
+    /* Each update covers every change since the last one, and updates can only
+    be sent while we yield, so there's at most one per yield and one after. */
+    for (int i = 2; i <= 1000; ++i) {
+        w1.set_value(i);
+        if (i % 100 == 0) {
+            coro_t::yield();
+        }
+    }
+    let_stuff_happen();
+    EXPECT_GE(wm1.get_num_updates_sent(), 2);
+    EXPECT_LE(wm1.get_num_updates_sent(), 1 + 10 + 1);
+    ASSERT_EQ(1u, rm2.get_root_view()->get().count(c1.get_me()));
+    EXPECT_EQ(1000, rm2.get_root_view()->get().find(c1.get_me())->second);
+}
+TEST(RPCDirectoryTest, Coalesce) {
+    unittest::run_in_thread_pool(&run_coalesce_test, 1);
+}
+
+typedef std::map<int, cow_ptr_t<std::string> > big_directory_t;
+
+std::string serialize_for_test(const big_directory_t &value) {
+    write_message_t msg;
+    msg << value;
+    string_stream_t stream;
+    int res = send_write_message(&stream, &msg);
+    guarantee(res == 0);
+    return stream.str();
+}
+
+/* `Delta` tests that a delta only carries the map entries that changed, and
+that applying it gives the new value. */
+
+TEST(RPCDirectoryTest, Delta) {
+    big_directory_t old_value;
+    for (int i = 0; i < 1000; ++i) {
+        old_value[i] = cow_ptr_t<std::string>(std::string(100, 'a' + i % 26));
+    }
+    big_directory_t new_value = old_value;
+    new_value[17] = cow_ptr_t<std::string>("changed");
+    new_value[2000] = cow_ptr_t<std::string>("added");
+    new_value.erase(500);
+
+    write_message_t msg;
+    serialize_directory_delta(&msg, old_value, new_value);
+    string_stream_t stream;
+    ASSERT_EQ(0, send_write_message(&stream, &msg));
+    EXPECT_LT(stream.str().size(), 100u);
+
+    big_directory_t applied = old_value;
+    string_read_stream_t read_stream(std::move(stream.str()), 0);
+    ASSERT_EQ(ARCHIVE_SUCCESS, apply_directory_delta(&read_stream, &applied));
+    EXPECT_EQ(serialize_for_test(new_value), serialize_for_test(applied));
+}
+
+/* `DeltaUpdates` tests that peers follow a series of changes that are each
+sent as deltas. */
+
+void run_delta_updates_test() {
+    connectivity_cluster_t c1, c2;
+    directory_read_manager_t<big_directory_t> rm1(&c1), rm2(&c2);
+    watchable_variable_t<big_directory_t> w1((big_directory_t())), w2((big_directory_t()));
+    directory_write_manager_t<big_directory_t> wm1(&c1, w1.get_watchable()), wm2(&c2, w2.get_watchable());
+    connectivity_cluster_t::run_t cr1(&c1, get_unittest_addresses(), peer_address_t(), ANY_PORT, &rm1, 0, NULL);
+    connectivity_cluster_t::run_t cr2(&c2, get_unittest_addresses(), peer_address_t(), ANY_PORT, &rm2, 0, NULL);
+    cr2.join(c1.get_peer_address(c1.get_me()));
+    let_stuff_happen();
+
+    big_directory_t value;
+    for (int i = 0; i < 50; ++i) {
+        value[i % 7] = cow_ptr_t<std::string>(strprintf("value %d", i));
+        value.erase((i + 3) % 7);
+        w1.set_value(value);
+        if (i % 10 == 0) {
+            let_stuff_happen();
+        }
+    }
+    let_stuff_happen();
+
+    ASSERT_EQ(1u, rm2.get_root_view()->get().count(c1.get_me()));
+    EXPECT_EQ(serialize_for_test(value), serialize_for_test(rm2.get_root_view()->get().find(c1.get_me())->second));
+}
+TEST(RPCDirectoryTest, DeltaUpdates) {
+    unittest::run_in_thread_pool(&run_delta_updates_test, 1);
+}
+
 }   /* namespace unittest */
+
+template class directory_read_manager_t<unittest::big_directory_t>;
+template class directory_write_manager_t<unittest::big_directory_t>;
@@ -6,6 +6,7 @@
 #include "unittest/unittest_utils.hpp"
 #include "rpc/semilattice/semilattice_manager.hpp"
 #include "rpc/semilattice/joins/map.hpp"
+#include "rpc/semilattice/joins/set.hpp"
 #include "rpc/semilattice/view/field.hpp"
 #include "rpc/semilattice/view/member.hpp"
 #include "unittest/dummy_metadata_controller.hpp"
@@ -281,6 +282,27 @@ TEST(RPCSemilatticeTest, MemberViewMultiThread) {
     unittest::run_in_thread_pool(&run_member_view_test, 3);
 }
 
+/* `MapDelta` tests `semilattice_delta()` on maps: only new and changed entries
+should be in the delta. */
+
+TEST(RPCSemilatticeTest, MapDelta) {
+    std::map<std::string, std::set<int> > base, updated;
+    base["foo"].insert(1);
+    base["bar"].insert(2);
+    updated = base;
+    updated["bar"].insert(3);
+    updated["baz"].insert(4);
+
+    std::map<std::string, std::set<int> > delta = semilattice_delta(base, updated);
+    EXPECT_EQ(2u, delta.size());
+    EXPECT_EQ(0u, delta.count("foo"));
+    EXPECT_EQ(std::set<int>(updated["bar"].find(3), updated["bar"].end()), delta["bar"]);
+    EXPECT_EQ(updated["baz"], delta["baz"]);
+
+    semilattice_join(&base, delta);
+    EXPECT_TRUE(base == updated);
+}
+
 }   /* namespace unittest */
 
 #include "rpc/semilattice/semilattice_manager.tcc"
@@ -0,0 +1,117 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <vector>
+
+#include "errors.hpp"
+#include <boost/bind.hpp>
+
+#include "arch/runtime/coroutines.hpp"
+#include "concurrency/cond_var.hpp"
+#include "rpc/connectivity/send_scheduler.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+struct send_scheduler_test_t {
+    send_scheduler_test_t() : num_outstanding(0) { }
+
+    void send(message_class_t message_class, size_t size) {
+        ++num_outstanding;
+        coro_t::spawn_sometime(boost::bind(&send_scheduler_test_t::do_send, this,
+                                           message_class, size));
+    }
+
+    void do_send(message_class_t message_class, size_t size) {
+        send_scheduler_t::acq_t acq(&scheduler, message_class, size);
+        order.push_back(message_class);
+        sizes.push_back(size);
+        if (--num_outstanding == 0) {
+            done.pulse();
+        }
+    }
+
+    send_scheduler_t scheduler;
+    std::vector<message_class_t> order;
+    std::vector<size_t> sizes;
+    int num_outstanding;
+    cond_t done;
+};
+
+void run_priority_test() {
+    send_scheduler_test_t test;
+    {
+        // Hold the connection while everything queues up behind us.
+        send_scheduler_t::acq_t acq(&test.scheduler, MESSAGE_CLASS_METADATA, 1);
+        for (int i = 0; i < 4; ++i) {
+            test.send(MESSAGE_CLASS_BACKFILL, 1000);
+        }
+        for (int i = 0; i < 4; ++i) {
+            test.send(MESSAGE_CLASS_QUERY, 1000);
+        }
+        test.send(MESSAGE_CLASS_HEARTBEAT, 1000);
+        // Let them all get in line.
+        for (int i = 0; i < 20; ++i) {
+            coro_t::yield();
+        }
+        EXPECT_TRUE(test.order.empty());
+    }
+    test.done.wait();
+    EXPECT_FALSE(test.scheduler.is_busy());
+
+    /* The heartbeat jumps the queue. Then the first backfill chunk gets its
+    turn right after the first query, because backfill hadn't used the
+    connection yet; but after that, queries go first until they've used as much
+    of it as their weight allows. */
+    message_class_t expected[] = {
+        MESSAGE_CLASS_HEARTBEAT,
+        MESSAGE_CLASS_QUERY, MESSAGE_CLASS_BACKFILL,
+        MESSAGE_CLASS_QUERY, MESSAGE_CLASS_QUERY, MESSAGE_CLASS_QUERY,
+        MESSAGE_CLASS_BACKFILL, MESSAGE_CLASS_BACKFILL, MESSAGE_CLASS_BACKFILL
+    };
+    ASSERT_EQ(sizeof(expected) / sizeof(expected[0]), test.order.size());
+    for (size_t i = 0; i < test.order.size(); ++i) {
+        EXPECT_EQ(expected[i], test.order[i]) << "message " << i;
+    }
+}
+TEST(RPCSendSchedulerTest, Priority) {
+    run_in_thread_pool(&run_priority_test);
+}
+
+/* Within a class, messages go out in the order they were sent, which is what
+keeps messages to one mailbox in order. */
+void run_fifo_test() {
+    send_scheduler_test_t test;
+    {
+        send_scheduler_t::acq_t acq(&test.scheduler, MESSAGE_CLASS_QUERY, 1);
+        for (int i = 0; i < 10; ++i) {
+            test.send(MESSAGE_CLASS_REPLICATION, 10 * (10 - i));
+        }
+        for (int i = 0; i < 20; ++i) {
+            coro_t::yield();
+        }
+    }
+    test.done.wait();
+    ASSERT_EQ(10u, test.sizes.size());
+    for (size_t i = 0; i < test.sizes.size(); ++i) {
+        EXPECT_EQ(10 * (10 - i), test.sizes[i]);
+    }
+    EXPECT_FALSE(test.scheduler.is_busy());
+}
+TEST(RPCSendSchedulerTest, Fifo) {
+    run_in_thread_pool(&run_fifo_test);
+}
+
+/* An idle connection doesn't make anyone wait. */
+void run_uncontended_test() {
+    send_scheduler_t scheduler;
+    for (int i = 0; i < 10; ++i) {
+        send_scheduler_t::acq_t acq(&scheduler, MESSAGE_CLASS_BACKFILL, 1000000);
+        EXPECT_TRUE(scheduler.is_busy());
+    }
+    EXPECT_FALSE(scheduler.is_busy());
+}
+TEST(RPCSendSchedulerTest, Uncontended) {
+    run_in_thread_pool(&run_uncontended_test);
+}
+
+}  // namespace unittest
@@ -96,6 +96,7 @@ public:
     }
 
     watchable_variable_t<blueprint_t<protocol_t> > blueprint_watchable;
+    watchable_variable_t<int64_t> backfill_bytes_per_sec;
     reactor_t<protocol_t> reactor;
     field_copier_t<boost::optional<directory_echo_wrapper_t<cow_ptr_t<reactor_business_card_t<protocol_t> > > >, test_cluster_directory_t<protocol_t> > reactor_directory_copier;
 
@@ -150,9 +151,11 @@ peer_id_t reactor_test_cluster_t<protocol_t>::get_me() {
 template <class protocol_t>
 test_reactor_t<protocol_t>::test_reactor_t(const base_path_t &base_path, io_backender_t *io_backender, reactor_test_cluster_t<protocol_t> *r, const blueprint_t<protocol_t> &initial_blueprint, multistore_ptr_t<protocol_t> *svs) :
     blueprint_watchable(initial_blueprint),
+    backfill_bytes_per_sec(DEFAULT_BACKFILL_BYTES_PER_SEC),
     reactor(base_path, io_backender, &r->mailbox_manager, this,
             r->directory_read_manager.get_root_view()->subview(&test_reactor_t<protocol_t>::extract_reactor_directory),
-            &r->branch_history_manager, blueprint_watchable.get_watchable(), svs, &get_global_perfmon_collection(), &ctx),
+            &r->branch_history_manager, blueprint_watchable.get_watchable(), backfill_bytes_per_sec.get_watchable(),
+            svs, &get_global_perfmon_collection(), &ctx),
     reactor_directory_copier(&test_cluster_directory_t<protocol_t>::reactor_directory, reactor.get_reactor_directory()->subview(&test_reactor_t<protocol_t>::wrap_in_optional), &r->our_directory_variable) {
     rassert(svs->get_region() == mock::a_thru_z_region());
 }
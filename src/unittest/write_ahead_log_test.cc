@@ -0,0 +1,252 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <iterator>
+
+#include "arch/io/disk.hpp"
+#include "btree/write_ahead_log.hpp"
+#include "clustering/immediate_consistency/branch/metadata.hpp"
+#include "concurrency/cond_var.hpp"
+#include "memcached/protocol.hpp"
+#include "serializer/config.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+std::vector<char> make_payload(uint64_t seqno) {
+    std::string s = strprintf("record %" PRIu64, seqno);
+    return std::vector<char>(s.begin(), s.end());
+}
+
+void run_append_and_reload_test() {
+    temp_file_t temp_file;
+    const std::string path = temp_file.name().permanent_path() + ".wal";
+    cond_t non_interruptor;
+
+    EXPECT_FALSE(write_ahead_log_t::exists(path));
+    {
+        std::vector<write_ahead_log_t::record_t> records;
+        write_ahead_log_t log(path, &records);
+        EXPECT_TRUE(records.empty());
+        log.discard_all();
+
+        for (uint64_t seqno = 1; seqno <= 100; ++seqno) {
+            log.append(seqno, make_payload(seqno));
+        }
+        log.wait_durable(100, &non_interruptor);
+    }
+
+    // Append a torn record by hand; it must be ignored and cut off.
+    {
+        const std::string filename = path + ".0";
+        const int fd = ::open(filename.c_str(), O_WRONLY | O_APPEND);
+        ASSERT_NE(-1, fd);
+        const char garbage[] = "torn record";
+        EXPECT_EQ(static_cast<ssize_t>(sizeof(garbage)), ::write(fd, garbage, sizeof(garbage)));
+        ::close(fd);
+    }
+
+    {
+        std::vector<write_ahead_log_t::record_t> records;
+        write_ahead_log_t log(path, &records);
+        ASSERT_EQ(100u, records.size());
+        for (uint64_t i = 0; i < records.size(); ++i) {
+            EXPECT_EQ(i + 1, records[i].seqno);
+            EXPECT_TRUE(make_payload(i + 1) == records[i].payload);
+        }
+    }
+
+    EXPECT_TRUE(write_ahead_log_t::exists(path));
+    write_ahead_log_t::remove(path);
+    EXPECT_FALSE(write_ahead_log_t::exists(path));
+}
+
+TEST(WriteAheadLog, AppendAndReload) {
+    run_in_thread_pool(&run_append_and_reload_test);
+}
+
+void run_retire_test() {
+    temp_file_t temp_file;
+    const std::string path = temp_file.name().permanent_path() + ".wal";
+    cond_t non_interruptor;
+
+    {
+        std::vector<write_ahead_log_t::record_t> records;
+        write_ahead_log_t log(path, &records);
+        log.discard_all();
+
+        log.append(1, make_payload(1));
+        log.append(2, make_payload(2));
+        // Records that are still buffered go to whichever file is active when
+        // they're written out, so make sure these two are in the retired one.
+        log.wait_durable(2, &non_interruptor);
+        EXPECT_EQ(2u, log.retire_active_file());
+        log.append(3, make_payload(3));
+        log.wait_durable(3, &non_interruptor);
+    }
+
+    // Both files are read back, and records come out sorted.
+    {
+        std::vector<write_ahead_log_t::record_t> records;
+        write_ahead_log_t log(path, &records);
+        ASSERT_EQ(3u, records.size());
+        EXPECT_EQ(1u, records[0].seqno);
+        EXPECT_EQ(2u, records[1].seqno);
+        EXPECT_EQ(3u, records[2].seqno);
+
+        log.discard_all();
+        log.append(4, make_payload(4));
+        log.wait_durable(4, &non_interruptor);
+        log.retire_active_file();
+        log.append(5, make_payload(5));
+        log.truncate_retired_file(&non_interruptor);
+        log.wait_durable(5, &non_interruptor);
+    }
+
+    // Only the record that was written to the new active file survives.
+    {
+        std::vector<write_ahead_log_t::record_t> records;
+        write_ahead_log_t log(path, &records);
+        ASSERT_EQ(1u, records.size());
+        EXPECT_EQ(5u, records[0].seqno);
+    }
+
+    write_ahead_log_t::remove(path);
+}
+
+TEST(WriteAheadLog, Retire) {
+    run_in_thread_pool(&run_retire_test);
+}
+
+/* `ReplayBackfill` simulates a crash in which none of the soft changes after a
+hard metainfo update made it into the btree file: it copies the file right after
+the update and the logs once a backfill chunk and a later write have been
+applied, and checks that a store opened on the copies gets back both. */
+
+void copy_file(const std::string &from, const std::string &to) {
+    std::ifstream in(from.c_str(), std::ios::binary);
+    ASSERT_TRUE(in.good());
+    const std::vector<char> contents((std::istreambuf_iterator<char>(in)),
+                                     std::istreambuf_iterator<char>());
+    std::ofstream out(to.c_str(), std::ios::binary | std::ios::trunc);
+    out.write(contents.data(), contents.size());
+    ASSERT_TRUE(out.good());
+}
+
+counted_t<data_buffer_t> make_data_buffer(const std::string &value) {
+    counted_t<data_buffer_t> data = data_buffer_t::create(value.size());
+    memcpy(data->buf(), value.data(), value.size());
+    return data;
+}
+
+std::string get_value(memcached_protocol_t::store_t *store, const std::string &key) {
+    get_query_t get;
+    get.key = store_key_t(key);
+    memcached_protocol_t::read_t read(get, time(NULL));
+    memcached_protocol_t::read_response_t response;
+
+    read_token_pair_t token_pair;
+    store->new_read_token_pair(&token_pair);
+#ifndef NDEBUG
+    trivial_metainfo_checker_callback_t<memcached_protocol_t> metainfo_checker_callback;
+    metainfo_checker_t<memcached_protocol_t> metainfo_checker(&metainfo_checker_callback, store->get_region());
+#endif
+    cond_t non_interruptor;
+    store->read(DEBUG_ONLY(metainfo_checker, ) read, &response,
+                order_token_t::ignore, &token_pair, &non_interruptor);
+
+    get_result_t result = boost::get<get_result_t>(response.result);
+    return result.value.has() ? std::string(result.value->buf(), result.value->size()) : "";
+}
+
+void run_replay_backfill_test() {
+    temp_file_t temp_file;
+    temp_file_t crashed_file;
+    const std::string log_path = temp_file.name().permanent_path() + ".wal";
+    const std::string crashed_log_path = crashed_file.name().permanent_path() + ".wal";
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    cond_t non_interruptor;
+
+    {
+        filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+        standard_serializer_t::create(&file_opener, standard_serializer_t::static_config_t());
+        file_opener.move_serializer_file_to_permanent_location();
+        standard_serializer_t serializer(standard_serializer_t::dynamic_config_t(),
+                                         &file_opener, &get_global_perfmon_collection());
+        memcached_protocol_t::store_t store(&serializer, temp_file.name().permanent_path(),
+                                            GIGABYTE, true, &get_global_perfmon_collection(),
+                                            NULL, &io_backender, base_path_t("."));
+        store.enable_write_ahead_log(log_path);
+
+        // This has hard durability, so the copy of the btree file taken right
+        // after it has everything up to here.
+        const region_map_t<memcached_protocol_t, binary_blob_t> metainfo(
+            store.get_region(), binary_blob_t(version_range_t(version_t::zero())));
+        {
+            object_buffer_t<fifo_enforcer_sink_t::exit_write_t> token;
+            store.new_write_token(&token);
+            store.set_metainfo(metainfo, order_token_t::ignore, &token, &non_interruptor);
+        }
+        copy_file(temp_file.name().permanent_path(), crashed_file.name().permanent_path());
+
+        {
+            write_token_pair_t token_pair;
+            store.new_write_token_pair(&token_pair);
+            backfill_atom_t atom(store_key_t("backfilled"), make_data_buffer("chunk"),
+                                 0, 0, repli_timestamp_t::distant_past, 0);
+            store.receive_backfill(memcached_protocol_t::backfill_chunk_t::set_key(atom),
+                                   &token_pair, &non_interruptor);
+        }
+
+        {
+            sarc_mutation_t set;
+            set.key = store_key_t("written");
+            set.data = make_data_buffer("write");
+            set.flags = 0;
+            set.exptime = 0;
+            set.add_policy = add_policy_yes;
+            set.replace_policy = replace_policy_yes;
+            memcached_protocol_t::write_t write(set, time(NULL), 12345);
+            memcached_protocol_t::write_response_t response;
+
+            write_token_pair_t token_pair;
+            store.new_write_token_pair(&token_pair);
+#ifndef NDEBUG
+            trivial_metainfo_checker_callback_t<memcached_protocol_t> metainfo_checker_callback;
+            metainfo_checker_t<memcached_protocol_t> metainfo_checker(&metainfo_checker_callback, store.get_region());
+#endif
+            store.write(DEBUG_ONLY(metainfo_checker, ) metainfo, write, &response,
+                        WRITE_DURABILITY_SOFT,
+                        transition_timestamp_t::starting_from(state_timestamp_t::zero()),
+                        order_token_t::ignore, &token_pair, &non_interruptor);
+        }
+
+        copy_file(log_path + ".0", crashed_log_path + ".0");
+        copy_file(log_path + ".1", crashed_log_path + ".1");
+    }
+
+    {
+        filepath_file_opener_t file_opener(crashed_file.name(), &io_backender);
+        standard_serializer_t serializer(standard_serializer_t::dynamic_config_t(),
+                                         &file_opener, &get_global_perfmon_collection());
+        memcached_protocol_t::store_t store(&serializer, crashed_file.name().permanent_path(),
+                                            GIGABYTE, false, &get_global_perfmon_collection(),
+                                            NULL, &io_backender, base_path_t("."));
+        store.enable_write_ahead_log(crashed_log_path);
+
+        EXPECT_EQ("chunk", get_value(&store, "backfilled"));
+        EXPECT_EQ("write", get_value(&store, "written"));
+    }
+
+    write_ahead_log_t::remove(log_path);
+    write_ahead_log_t::remove(crashed_log_path);
+}
+
+TEST(WriteAheadLog, ReplayBackfill) {
+    run_in_thread_pool(&run_replay_backfill_test);
+}
+
+}  // namespace unittest
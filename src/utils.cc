@@ -528,6 +528,10 @@ ticks_t secs_to_ticks(time_t secs) {
     return static_cast<ticks_t>(secs) * BILLION;
 }
 
+ticks_t ms_to_ticks(int64_t ms) {
+    return static_cast<ticks_t>(ms) * MILLION;
+}
+
 #ifdef __MACH__
 __thread mach_timebase_info_data_t mach_time_info;
 #endif  // __MACH__
@@ -585,6 +589,10 @@ double ticks_to_secs(ticks_t ticks) {
     return ticks / static_cast<double>(BILLION);
 }
 
+int64_t ticks_to_ms(ticks_t ticks) {
+    return ticks / MILLION;
+}
+
 
 bool notf(bool x) {
     return !x;
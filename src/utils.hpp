@@ -111,9 +111,12 @@ timespec clock_realtime();
 
 typedef uint64_t ticks_t;
 ticks_t secs_to_ticks(time_t secs);
+ticks_t ms_to_ticks(int64_t ms);
 ticks_t get_ticks();
 time_t get_secs();
 double ticks_to_secs(ticks_t ticks);
+// Rounds down.
+int64_t ticks_to_ms(ticks_t ticks);
 
 
 #ifndef NDEBUG